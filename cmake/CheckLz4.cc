@@ -0,0 +1,37 @@
+/** -*- C++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <lz4.h>
+#include <lz4hc.h>
+
+
+int main() {
+  char output[64];
+  int len = LZ4_compress_HC("hello world", output, 12, sizeof(output),
+                            LZ4HC_CLEVEL_DEFAULT);
+  if (len <= 0) {
+    printf("LZ4 compress failed\n");
+    return 1;
+  }
+  printf("%d.%d.%d\n", LZ4_VERSION_MAJOR, LZ4_VERSION_MINOR,
+         LZ4_VERSION_RELEASE);
+  return 0;
+}
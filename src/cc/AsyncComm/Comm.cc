@@ -47,6 +47,7 @@
 #include <chrono>
 #include <iostream>
 #include <thread>
+#include <vector>
 
 extern "C" {
 #if defined(__APPLE__) || defined(__sun__) || defined(__FreeBSD__)
@@ -61,6 +62,7 @@ extern "C" {
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <arpa/inet.h>
+#include <unistd.h>
 }
 
 using namespace Hypertable;
@@ -241,11 +243,85 @@ void
 Comm::listen(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
              const DispatchHandlerPtr &default_handler) {
   IOHandlerAccept *handler;
-  int one = 1;
-  int sd;
+  int32_t error;
 
   HT_ASSERT(addr.is_inet());
 
+  size_t listener_count = 1;
+#if defined(__linux__) && defined(SO_REUSEPORT)
+  if (ReactorFactory::reuse_port)
+    listener_count = ReactorFactory::io_reactor_count();
+#else
+  if (ReactorFactory::reuse_port && m_verbose)
+    HT_WARN("Per-reactor listen sockets not supported on this platform");
+#endif
+
+  if (listener_count <= 1) {
+    handler = new IOHandlerAccept(create_listen_socket(addr, false),
+                                  default_handler, m_handler_map, chf);
+    m_handler_map->insert_handler(handler);
+
+    if ((error = handler->start_polling()) != Error::OK) {
+      delete handler;
+      HT_THROWF(error, "Problem polling on listen socket bound to %s",
+                addr.to_str().c_str());
+    }
+    return;
+  }
+
+  // One listen socket per I/O reactor; the kernel spreads incoming
+  // connections over them and each connection stays on its reactor
+  vector<int> sds;
+  try {
+    CommAddress bind_addr = addr;
+    while (sds.size() < listener_count) {
+      sds.push_back(create_listen_socket(bind_addr, true));
+      if (bind_addr.inet.sin_port == 0) {
+        // Remaining sockets must bind to the ephemeral port just chosen
+        socklen_t namelen = sizeof(bind_addr.inet);
+        getsockname(sds.back(), (sockaddr *)&bind_addr.inet, &namelen);
+      }
+    }
+  }
+  catch (Exception &e) {
+    for (int sd : sds)
+      ::close(sd);
+    throw;
+  }
+
+  IOHandlerAccept::GroupPtr group = make_shared<IOHandlerAccept::Group>();
+  for (size_t i=0; i<sds.size(); i++) {
+    handler = new IOHandlerAccept(sds[i], default_handler, m_handler_map, chf,
+                                  ReactorFactory::ms_reactors[i]);
+    handler->set_group(group);
+    group->push_back(handler);
+  }
+  m_handler_map->insert_handler(group->front());
+
+  for (size_t i=0; i<group->size(); i++) {
+    if ((error = (*group)[i]->start_polling()) != Error::OK) {
+      // Members that never started polling are unknown to their reactors,
+      // so drop them from the group and delete them (closing their sockets)
+      // here; only the polled members go through decomissioning
+      IOHandlerAccept::Group unpolled(group->begin() + i, group->end());
+      group->resize(i);
+      if (group->empty())
+        m_handler_map->remove_handler(unpolled.front());
+      else
+        m_handler_map->decomission_handler(group->front());
+      for (auto member : unpolled)
+        delete member;
+      HT_THROWF(error, "Problem polling on listen socket bound to %s",
+                addr.to_str().c_str());
+    }
+  }
+}
+
+
+int Comm::create_listen_socket(const CommAddress &addr, bool reuse_port) {
+  int one = 1;
+  int sd;
+
   if ((sd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0)
     HT_THROW(Error::COMM_SOCKET_ERROR, strerror(errno));
 
@@ -255,6 +331,14 @@ Comm::listen(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
 #if defined(__linux__)
   if (setsockopt(sd, SOL_TCP, TCP_NODELAY, &one, sizeof(one)) < 0 && m_verbose)
     HT_ERRORF("setting TCP_NODELAY: %s", strerror(errno));
+#if defined(SO_REUSEPORT)
+  if (reuse_port &&
+      setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+    ::close(sd);
+    HT_THROWF(Error::COMM_SOCKET_ERROR, "setting SO_REUSEPORT: %s",
+              strerror(errno));
+  }
+#endif
 #elif defined(__sun__)
   if (setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, (char*)&one, sizeof(one)) < 0 && m_verbose)
     HT_ERRORF("setting TCP_NODELAY: %s", strerror(errno));
@@ -270,9 +354,11 @@ Comm::listen(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
 
   int bind_attempts = 0;
   while ((::bind(sd, (const sockaddr *)&addr.inet, sizeof(sockaddr_in))) < 0) {
-    if (bind_attempts == 24)
+    if (bind_attempts == 24) {
+      ::close(sd);
       HT_THROWF(Error::COMM_BIND_ERROR, "binding to %s: %s",
                 addr.to_str().c_str(), strerror(errno));
+    }
     if (m_verbose)
       HT_INFOF("Unable to bind to %s: %s, will retry in 10 seconds...",
                addr.to_str().c_str(), strerror(errno));
@@ -280,18 +366,12 @@ Comm::listen(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
     bind_attempts++;
   }
 
-  if (::listen(sd, 1000) < 0)
+  if (::listen(sd, 1000) < 0) {
+    ::close(sd);
     HT_THROWF(Error::COMM_LISTEN_ERROR, "listening: %s", strerror(errno));
-
-  handler = new IOHandlerAccept(sd, default_handler, m_handler_map, chf);
-  m_handler_map->insert_handler(handler);
-
-  int32_t error;
-  if ((error = handler->start_polling()) != Error::OK) {
-    delete handler;
-    HT_THROWF(error, "Problem polling on listen socket bound to %s",
-              addr.to_str().c_str());
   }
+
+  return sd;
 }
 
 
@@ -248,7 +248,11 @@ namespace Hypertable {
      * factory pointed to by <code>chf</code>.  <code>default_handler</code>
      * is registered as the default dispatch handler for the newly created
      * listen (accept) socket and Event::CONNECTION_ESTABLISHED events will be
-     * delivered to the application via this handler.
+     * delivered to the application via this handler.  If
+     * ReactorFactory::reuse_port is set (Linux only), one listen socket is
+     * created per I/O reactor with <code>SO_REUSEPORT</code>, so the kernel
+     * distributes incoming connections over the reactors, and each connection
+     * is handled by the reactor that accepted it.
      * @param addr IP address and port on which to listen for connections
      * @param chf Smart pointer to connection handler factory
      * @param default_handler Smart pointer to default dispatch handler
@@ -474,6 +478,20 @@ namespace Hypertable {
     int send_request(IOHandlerData *data_handler, uint32_t timeout_ms,
                      CommBufPtr &cbuf, DispatchHandler *response_handler);
 
+    /** Creates listen socket bound to <code>addr</code>.
+     * Sets <code>O_NONBLOCK</code>, <code>TCP_NODELAY</code> (Linux and Sun),
+     * <code>SO_NOSIGPIPE</code> and <code>SO_REUSEPORT</code> (Apple and
+     * FreeBSD) and <code>SO_REUSEADDR</code>, binds the socket, retrying for
+     * up to four minutes, and calls <code>listen</code>.
+     * @param addr Address to bind to
+     * @param reuse_port Set <code>SO_REUSEPORT</code> so that multiple sockets
+     * can listen on <code>addr</code> (Linux)
+     * @return Socket descriptor
+     * @throws Exception Code set to Error::COMM_SOCKET_ERROR,
+     * Error::COMM_BIND_ERROR, or Error::COMM_LISTEN_ERROR
+     */
+    int create_listen_socket(const CommAddress &addr, bool reuse_port);
+
     /** Creates a TCP socket connection.
      * This method is called by the #connect methods to setup a socket,
      * connect to a remote address, and attach a data handler.
@@ -30,6 +30,7 @@
 #define AsyncComm_CommBuf_h
 
 #include "CommHeader.h"
+#include "GatherBuffer.h"
 
 #include <Common/ByteString.h>
 #include <Common/InetAddr.h>
@@ -39,6 +40,7 @@
 
 #include <boost/shared_array.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -137,6 +139,25 @@ namespace Hypertable {
       ext_ptr = ext.base;
     }
 
+    /** Constructor. This constructor initializes the CommBuf object by
+     * allocating a primary buffer of length len and writing the header into it.
+     * It also sets the extended data to the segments of <code>gather</code>,
+     * which are written to the socket in place, without being copied.  The
+     * total length written into the header is len plus the length of
+     * <code>gather</code>.  The internal pointer into the primary buffer is
+     * positioned to just after the header.
+     * @param hdr Comm header
+     * @param len Length of the primary buffer to allocate
+     * @param gather Extended data segments
+     */
+    CommBuf(CommHeader &hdr, uint32_t len, GatherBufferPtr &gather)
+      : header(hdr), ext_ptr(0), ext_gather(gather) {
+      len += header.encoded_length();
+      data.set(new uint8_t [len], len, true);
+      data_ptr = data.base + header.encoded_length();
+      header.set_total_length(len+gather->length());
+    }
+
     /** Encodes the header at the beginning of the primary buffer.
      * This method resets the primary and extended data pointers to point to the
      * beginning of their respective buffers.  The AsyncComm layer
@@ -149,6 +170,105 @@ namespace Hypertable {
       header.encode(&buf);
       data_ptr = data.base;
       ext_ptr = ext.base;
+      ext_gather_index = 0;
+      ext_gather_offset = 0;
+    }
+
+    /** Fills iovec array with extended data not yet sent.
+     * Adds the unsent portion of the extended buffer followed by the unsent
+     * segments of the extended gather buffer, stopping when <code>max</code>
+     * entries have been filled.
+     * @param vec iovec array to fill
+     * @param max Maximum number of entries to fill
+     * @param lenp Address of variable to add number of bytes described to
+     * @return Number of entries filled
+     */
+    int fill_ext_iovec(struct iovec *vec, int max, ssize_t *lenp) {
+      int count = 0;
+      if (ext.base != 0) {
+        size_t remaining = ext.size - (ext_ptr - ext.base);
+        if (remaining > 0 && count < max) {
+          vec[count].iov_base = (void *)ext_ptr;
+          vec[count].iov_len = remaining;
+          *lenp += remaining;
+          ++count;
+        }
+      }
+      if (ext_gather) {
+        const std::vector<struct iovec> &segments = ext_gather->segments();
+        size_t offset = ext_gather_offset;
+        for (size_t i=ext_gather_index; i<segments.size() && count<max; ++i) {
+          vec[count].iov_base = (uint8_t *)segments[i].iov_base + offset;
+          vec[count].iov_len = segments[i].iov_len - offset;
+          *lenp += vec[count].iov_len;
+          offset = 0;
+          ++count;
+        }
+      }
+      return count;
+    }
+
+    /** Advances extended data pointers past data that has been sent.
+     * @param len Number of extended data bytes sent
+     * @return <i>true</i> if all extended data has been sent, <i>false</i>
+     * otherwise
+     */
+    bool advance_ext(size_t len) {
+      if (ext.base != 0) {
+        size_t n = std::min(len, (size_t)(ext.size - (ext_ptr - ext.base)));
+        ext_ptr += n;
+        len -= n;
+        if (ext_ptr < ext.base + ext.size)
+          return false;
+      }
+      if (ext_gather) {
+        const std::vector<struct iovec> &segments = ext_gather->segments();
+        while (len > 0 && ext_gather_index < segments.size()) {
+          size_t remaining = segments[ext_gather_index].iov_len - ext_gather_offset;
+          if (len < remaining) {
+            ext_gather_offset += len;
+            return false;
+          }
+          len -= remaining;
+          ++ext_gather_index;
+          ext_gather_offset = 0;
+        }
+        return ext_gather_index == segments.size();
+      }
+      return true;
+    }
+
+    /** Fills iovec array with data not yet sent.
+     * Adds the unsent portion of the primary buffer followed by the
+     * entries filled in by fill_ext_iovec().
+     * @param vec iovec array to fill
+     * @param max Maximum number of entries to fill
+     * @param lenp Address of variable to add number of bytes described to
+     * @return Number of entries filled
+     */
+    int fill_iovec(struct iovec *vec, int max, ssize_t *lenp) {
+      int count = 0;
+      size_t remaining = data.size - (data_ptr - data.base);
+      if (remaining > 0 && max > 0) {
+        vec[0].iov_base = (void *)data_ptr;
+        vec[0].iov_len = remaining;
+        *lenp += remaining;
+        ++count;
+      }
+      return count + fill_ext_iovec(&vec[count], max - count, lenp);
+    }
+
+    /** Advances data pointers past data that has been sent.
+     * @param len Number of bytes sent (primary buffer first, then extended
+     * data)
+     * @return <i>true</i> if all data has been sent, <i>false</i> otherwise
+     */
+    bool advance(size_t len) {
+      size_t n = std::min(len, (size_t)(data.size - (data_ptr - data.base)));
+      data_ptr += n;
+      if (data_ptr < data.base + data.size)
+        return false;
+      return advance_ext(len - n);
     }
 
     /** Returns the primary buffer internal data pointer
@@ -299,6 +419,15 @@ namespace Hypertable {
 
     /// Smart pointer to extended buffer memory
     boost::shared_array<uint8_t> ext_shared_array;
+
+    /// Extended data segments, sent after #ext
+    GatherBufferPtr ext_gather;
+
+    /// Index of first segment of #ext_gather not completely sent
+    size_t ext_gather_index {};
+
+    /// Number of bytes sent of segment #ext_gather_index
+    size_t ext_gather_offset {};
   };
 
   /// Smart pointer to CommBuf
@@ -0,0 +1,119 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Declarations for GatherBuffer.
+/// This file contains type declarations for GatherBuffer, a class that
+/// describes message data held in several, possibly shared, memory segments.
+
+#ifndef AsyncComm_GatherBuffer_h
+#define AsyncComm_GatherBuffer_h
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+extern "C" {
+#include <sys/uio.h>
+}
+
+namespace Hypertable {
+
+  /// @addtogroup AsyncComm
+  /// @{
+
+  /// List of memory segments to be transmitted as a single buffer.
+  /// A GatherBuffer can be attached to a CommBuf as its extended buffer, in
+  /// which case the segments are handed to <code>writev()</code> directly
+  /// rather than being copied into one contiguous buffer first.  The memory
+  /// referenced by the segments is kept valid by a set of <i>pins</i>, which
+  /// are opaque shared pointers released when the GatherBuffer is destroyed
+  /// (i.e. once the message has been sent).
+  class GatherBuffer {
+  public:
+
+    /// Appends segment.
+    /// Empty segments are ignored and a segment that immediately follows the
+    /// previous one in memory is merged with it.
+    /// @param base Starting address of segment
+    /// @param len Length of segment
+    void add(const void *base, size_t len) {
+      if (len == 0)
+        return;
+      if (!m_segments.empty() &&
+          (const uint8_t *)m_segments.back().iov_base +
+          m_segments.back().iov_len == (const uint8_t *)base)
+        m_segments.back().iov_len += len;
+      else {
+        struct iovec vec;
+        vec.iov_base = (void *)base;
+        vec.iov_len = len;
+        m_segments.push_back(vec);
+      }
+      m_length += len;
+    }
+
+    /// Holds a reference that keeps segment memory valid.
+    /// The reference is released when this object is destroyed.  Consecutive
+    /// duplicate pins are only held once.
+    /// @param pin Reference to memory referenced by one or more segments
+    void add_pin(const std::shared_ptr<void> &pin) {
+      if (m_pins.empty() || m_pins.back() != pin)
+        m_pins.push_back(pin);
+    }
+
+    /// Copies segments into contiguous memory.
+    /// @param dst Destination, must have room for length() bytes
+    void flatten(uint8_t *dst) const {
+      for (auto &vec : m_segments) {
+        memcpy(dst, vec.iov_base, vec.iov_len);
+        dst += vec.iov_len;
+      }
+    }
+
+    /// Returns segment list.
+    /// @return Segment list
+    const std::vector<struct iovec> &segments() const { return m_segments; }
+
+    /// Returns total length of all segments.
+    /// @return Total length of all segments
+    size_t length() const { return m_length; }
+
+  private:
+
+    /// Segments in transmission order
+    std::vector<struct iovec> m_segments;
+
+    /// References keeping segment memory valid
+    std::vector<std::shared_ptr<void>> m_pins;
+
+    /// Total length of all segments
+    size_t m_length {};
+  };
+
+  /// Smart pointer to GatherBuffer
+  typedef std::shared_ptr<GatherBuffer> GatherBufferPtr;
+
+  /// @}
+}
+
+#endif // AsyncComm_GatherBuffer_h
@@ -193,7 +193,7 @@ int HandlerMap::remove_handler_unlocked(IOHandler *handler) {
   }
   else if ((aiter = m_accept_handler_map.find(local_addr))
            != m_accept_handler_map.end()) {
-    HT_ASSERT(handler == aiter->second);
+    HT_ASSERT(handler == aiter->second || aiter->second->in_group(handler));
     m_accept_handler_map.erase(aiter);
   }
   else if ((riter = m_raw_handler_map.find(remote_addr))
@@ -218,6 +218,18 @@ void HandlerMap::decomission_handler_unlocked(IOHandler *handler) {
   }
   m_decomissioned_handlers.insert(handler);
   handler->decomission();
+  IOHandlerAccept *accept_handler = dynamic_cast<IOHandlerAccept *>(handler);
+  if (accept_handler)
+    decomission_group_unlocked(accept_handler);
+}
+
+void HandlerMap::decomission_group_unlocked(IOHandlerAccept *handler) {
+  if (!handler->get_group())
+    return;
+  for (auto member : *handler->get_group()) {
+    if (m_decomissioned_handlers.insert(member).second)
+      member->decomission();
+  }
 }
 
 void HandlerMap::decomission_all() {
@@ -247,6 +259,7 @@ void HandlerMap::decomission_all() {
        aiter != m_accept_handler_map.end(); ++aiter) {
     m_decomissioned_handlers.insert(aiter->second);
     aiter->second->decomission();
+    decomission_group_unlocked(aiter->second);
   }
   m_accept_handler_map.clear();
 
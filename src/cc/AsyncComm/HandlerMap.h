@@ -205,7 +205,9 @@ namespace Hypertable {
      * #m_decomissioned_handlers set and marking it decomissioned.  Once there
      * are no more references to the handler, it may be safely removed.  The
      * removal is accomplished via #purge_handler which is called by the reactor
-     * thread after it has been removed from the polling interface.
+     * thread after it has been removed from the polling interface.  If
+     * <code>handler</code> is an accept handler belonging to a group, the
+     * other members of the group are decomissioned as well.
      * @param handler Pointer to IOHandler to decomission
      */
     void decomission_handler_unlocked(IOHandler *handler);
@@ -355,6 +357,14 @@ namespace Hypertable {
      */
     int translate_address(const CommAddress &addr, InetAddr *inet_addr);
 
+    /** Decomissions group of accept handlers without locking #m_mutex.
+     * Adds the members of <code>handler</code>'s group (see
+     * IOHandlerAccept::set_group) that haven't been decomissioned yet to
+     * #m_decomissioned_handlers and decomissions them.
+     * @param handler Accept handler
+     */
+    void decomission_group_unlocked(IOHandlerAccept *handler);
+
     /** Removes <code>handler</code> from map without locking #m_mutex.  This
      * method removes <code>handler</code> from the data, datagram, or accept
      * map, depending on the type of handler.  If <code>handler</code> refers to
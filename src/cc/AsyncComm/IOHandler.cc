@@ -89,6 +89,13 @@ void IOHandler::display_event(struct pollfd *event) {
 }
 
 int IOHandler::start_polling(int mode) {
+#if defined(HT_WITH_IO_URING)
+  if (ReactorFactory::use_io_uring) {
+    m_poll_interest = mode;
+    m_reactor->ring_update(this);
+    return Error::OK;
+  }
+#endif
   if (ReactorFactory::use_poll) {
     m_poll_interest = mode;
     return m_reactor->add_poll_interest(m_sd, poll_events(mode), this);
@@ -122,6 +129,13 @@ int IOHandler::add_poll_interest(int mode) {
 
   m_poll_interest |= mode;
 
+#if defined(HT_WITH_IO_URING)
+  if (ReactorFactory::use_io_uring) {
+    m_reactor->ring_update(this);
+    return Error::OK;
+  }
+#endif
+
   HANDLE_POLL_INTERFACE_ADD;
 
   if (!ReactorFactory::ms_epollet) {
@@ -149,6 +163,11 @@ int IOHandler::add_poll_interest(int mode) {
 int IOHandler::remove_poll_interest(int mode) {
   m_poll_interest &= ~mode;
 
+  // Armed io_uring operations are left to complete; their events are
+  // dropped by handle_ring_event()
+  if (ReactorFactory::use_io_uring)
+    return Error::OK;
+
   HANDLE_POLL_INTERFACE_MODIFY;
 
   if (!ReactorFactory::ms_epollet) {
@@ -204,6 +223,114 @@ void IOHandler::display_event(struct epoll_event *event) {
   return;
 }
 
+#if defined(HT_WITH_IO_URING)
+
+void IOHandler::ring_arm() {
+  if (m_ring_draining)
+    return;
+
+  IoUring *ring = m_reactor->ring.get();
+  uint64_t user_data = (uint64_t)(uintptr_t)this;
+  io_uring_sqe *sqe;
+
+  if (m_poll_interest & PollEvent::READ) {
+    if (uses_ring_receive()) {
+      if (!m_ring_recv_armed) {
+        sqe = ring->get_sqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = m_sd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = IoUring::BUFFER_GROUP;
+        sqe->user_data = user_data | RING_RECV;
+        m_ring_recv_armed = true;
+        m_ring_pending++;
+      }
+    }
+    else if (!m_ring_poll_in_armed) {
+      sqe = ring->get_sqe();
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = m_sd;
+      sqe->poll32_events = POLLIN;
+      sqe->user_data = user_data | RING_POLL_IN;
+      m_ring_poll_in_armed = true;
+      m_ring_pending++;
+    }
+  }
+
+  if ((m_poll_interest & PollEvent::WRITE) && !m_ring_poll_out_armed) {
+    sqe = ring->get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_sd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = user_data | RING_POLL_OUT;
+    m_ring_poll_out_armed = true;
+    m_ring_pending++;
+  }
+}
+
+
+bool IOHandler::ring_op_done(int op, unsigned flags) {
+  switch (op) {
+  case RING_POLL_IN:
+    m_ring_poll_in_armed = false;
+    break;
+  case RING_POLL_OUT:
+    m_ring_poll_out_armed = false;
+    break;
+  case RING_RECV:
+    if (flags & IORING_CQE_F_MORE)
+      return false;
+    m_ring_recv_armed = false;
+    break;
+  default:
+    HT_FATALF("Unexpected io_uring operation %d", op);
+  }
+  HT_ASSERT(m_ring_pending > 0);
+  m_ring_pending--;
+  return true;
+}
+
+
+bool IOHandler::handle_ring_event(int op, int res, const uint8_t *buf,
+                                  ClockT::time_point arrival_time) {
+  struct pollfd event;
+
+  if (op == RING_RECV)
+    return handle_ring_recv(res, buf, arrival_time);
+
+  event.fd = m_sd;
+  if (op == RING_POLL_IN) {
+    if ((m_poll_interest & PollEvent::READ) == 0)
+      return false;
+    event.events = POLLIN;
+  }
+  else {
+    if ((m_poll_interest & PollEvent::WRITE) == 0)
+      return false;
+    event.events = POLLOUT;
+  }
+  event.revents = (res < 0) ? POLLERR : (res & (event.events|POLLERR|POLLHUP));
+  if (event.revents == 0)
+    return false;
+  return handle_event(&event, arrival_time);
+}
+
+
+bool IOHandler::ring_drain() {
+  m_ring_draining = true;
+  if (m_ring_pending == 0)
+    return true;
+  io_uring_sqe *sqe = m_reactor->ring->get_sqe();
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = m_sd;
+  sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+  sqe->user_data = RING_CANCEL;
+  return false;
+}
+
+#endif // HT_WITH_IO_URING
+
 #elif defined(__sun__)
 
 int IOHandler::add_poll_interest(int mode) {
@@ -80,14 +80,20 @@ namespace Hypertable {
     /** Constructor.
      * Initializes the I/O handler, assigns it a Reactor, and sets #m_local_addr
      * to the locally bound address (IPv4:port) of <code>sd</code> (see
-     * <code>getsockname</code>).
+     * <code>getsockname</code>).  If <code>reactor</code> is empty, the
+     * reactor is assigned round-robin by ReactorFactory::get_reactor.
      * @param sd Socket descriptor
      * @param dhp Dispatch handler
+     * @param reactor Reactor to handle I/O events on
      */
-    IOHandler(int sd, const DispatchHandlerPtr &dhp)
+    IOHandler(int sd, const DispatchHandlerPtr &dhp,
+              const ReactorPtr &reactor=ReactorPtr())
       : m_reference_count(0), m_free_flag(0), m_error(Error::OK),
         m_sd(sd), m_dispatch_handler(dhp), m_decomissioned(false) {
-      ReactorFactory::get_reactor(m_reactor);
+      if (reactor)
+        m_reactor = reactor;
+      else
+        ReactorFactory::get_reactor(m_reactor);
       m_poll_interest = 0;
       socklen_t namelen = sizeof(m_local_addr);
       getsockname(m_sd, (sockaddr *)&m_local_addr, &namelen);
@@ -220,6 +226,94 @@ namespace Hypertable {
       return add_poll_interest(m_poll_interest);
     }
 
+#if defined(HT_WITH_IO_URING)
+    /** Operations submitted to <code>io_uring</code> on behalf of a handler.
+     * The operation is stored in the low bits of the submission user data,
+     * the remaining bits hold the handler pointer.
+     */
+    enum RingOp {
+      RING_POLL_IN = 0,   //!< Oneshot poll for <code>POLLIN</code>
+      RING_POLL_OUT = 1,  //!< Oneshot poll for <code>POLLOUT</code>
+      RING_RECV = 2,      //!< Multishot receive into provided buffers
+      RING_CANCEL = 3,    //!< Cancelation of handler operations
+      RING_INTERRUPT = 4  //!< Multishot poll of reactor interrupt socket
+    };
+
+    /// Mask of RingOp bits in submission user data
+    static const uint64_t RING_OP_MASK = 7;
+
+    /** Arms <code>io_uring</code> operations for current poll interest.
+     * Must be called from the reactor thread (see Reactor#ring_update).
+     * Interest in PollEvent::READ is served with a multishot receive if
+     * #uses_ring_receive returns <i>true</i>, otherwise with a oneshot poll;
+     * interest in PollEvent::WRITE is served with a oneshot poll.  Operations
+     * that are already armed are left in place.
+     */
+    void ring_arm();
+
+    /** Records completion of <code>io_uring</code> operation.
+     * @param op Operation
+     * @param flags Completion flags
+     * @return <i>true</i> if the operation is finished and needs to be armed
+     * again to get further completions, <i>false</i> otherwise
+     */
+    bool ring_op_done(int op, unsigned flags);
+
+    /** Handles completion of <code>io_uring</code> operation.
+     * Poll completions are translated into a <code>pollfd</code> event,
+     * restricted to the current poll interest, and passed to the
+     * <code>poll()</code> version of #handle_event.  Receive completions are
+     * passed to #handle_ring_recv.
+     * @param op Operation
+     * @param res Completion result
+     * @param buf Provided buffer holding received data (RING_RECV only)
+     * @param arrival_time Arrival time of event
+     * @return <i>true</i> if socket should be closed, <i>false</i> otherwise
+     */
+    bool handle_ring_event(int op, int res, const uint8_t *buf,
+                           ClockT::time_point arrival_time);
+
+    /** Handles completion of multishot receive.
+     * @param res Number of bytes received, 0 on EOF, or -errno on failure
+     * @param buf Buffer holding received data
+     * @param arrival_time Arrival time of event
+     * @return <i>true</i> if socket should be closed, <i>false</i> otherwise
+     */
+    virtual bool handle_ring_recv(int res, const uint8_t *buf,
+                                  ClockT::time_point arrival_time) {
+      HT_FATAL("Unexpected io_uring receive completion");
+      return true;
+    }
+
+    /** Checks if read interest is served with a multishot receive.
+     * @return <i>true</i> if handler reads via #handle_ring_recv,
+     * <i>false</i> if it reads from the socket on poll events
+     */
+    virtual bool uses_ring_receive() { return false; }
+
+    /** Cancels outstanding <code>io_uring</code> operations.
+     * Called by the reactor thread when the handler is about to be purged.
+     * Marks the handler as draining so that no further operations are
+     * armed and, if operations are outstanding, submits a cancelation for
+     * all of them.
+     * @return <i>true</i> if no operations are outstanding and the handler
+     * can be purged now, <i>false</i> if it must be purged once
+     * #ring_idle returns <i>true</i>
+     */
+    bool ring_drain();
+
+    /** Checks if handler is draining (see #ring_drain).
+     * @return <i>true</i> if handler is draining, <i>false</i> otherwise
+     */
+    bool ring_draining() { return m_ring_draining; }
+
+    /** Checks if handler has no outstanding <code>io_uring</code>
+     * operations.
+     * @return <i>true</i> if no operations are outstanding
+     */
+    bool ring_idle() { return m_ring_pending == 0; }
+#endif
+
     /** Gets the handler socket address.  The socket address is the
      * address of the remote end of the connection for data (TCP) handlers,
      * and the local socket address for datagram and accept handlers.
@@ -417,6 +511,11 @@ namespace Hypertable {
      * Clears #m_poll_interest.
      */
     void stop_polling() {
+      if (ReactorFactory::use_io_uring) {
+        // Armed operations complete as ignored events
+        m_poll_interest = 0;
+        return;
+      }
       if (ReactorFactory::use_poll) {
         m_poll_interest = 0;
         m_reactor->modify_poll_interest(m_sd, 0);
@@ -483,6 +582,24 @@ namespace Hypertable {
 
     /// Socket was internally created and should be closed on destroy.
     bool m_socket_internally_created {true};
+
+#if defined(HT_WITH_IO_URING)
+    /// Number of outstanding <code>io_uring</code> operations (reactor
+    /// thread only)
+    int m_ring_pending {};
+
+    /// Set if RING_POLL_IN operation is outstanding (reactor thread only)
+    bool m_ring_poll_in_armed {};
+
+    /// Set if RING_POLL_OUT operation is outstanding (reactor thread only)
+    bool m_ring_poll_out_armed {};
+
+    /// Set if RING_RECV operation is outstanding (reactor thread only)
+    bool m_ring_recv_armed {};
+
+    /// Set once handler is being removed (reactor thread only)
+    bool m_ring_draining {};
+#endif
   };
   /** @}*/
 }
@@ -144,7 +144,9 @@ bool IOHandlerAccept::handle_incoming_connection() {
     DispatchHandlerPtr dhp;
     m_handler_factory->get_instance(dhp);
 
-    handler = new IOHandlerData(sd, addr, dhp, true);
+    // Connections accepted on a reactor's own listen socket stay there
+    handler = new IOHandlerData(sd, addr, dhp, true,
+                                m_group ? m_reactor : ReactorPtr());
 
     m_handler_map->insert_handler(handler, true);
 
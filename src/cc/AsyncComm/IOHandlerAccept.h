@@ -32,6 +32,10 @@
 #include "IOHandler.h"
 #include "ConnectionHandlerFactory.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 namespace Hypertable {
 
   /** @addtogroup AsyncComm
@@ -44,19 +48,54 @@ namespace Hypertable {
 
   public:
 
+    /// Accept handlers listening on the same address with
+    /// <code>SO_REUSEPORT</code>, one per I/O reactor
+    typedef std::vector<IOHandlerAccept *> Group;
+
+    /// Smart pointer to Group
+    typedef std::shared_ptr<Group> GroupPtr;
+
     /** Constructor.  Initializes member variables and sets #m_local_addr
      * to the address of <code>sd</code> obtained via <code>getsockname</code>.
      * @param sd Socket descriptor on which <code>listen</code> has been called
      * @param dhp Reference to default dispatch handler
      * @param hmap Reference to Handler map
      * @param chfp Reference to connection handler factory
+     * @param reactor Reactor to handle I/O events on (assigned round-robin
+     * if empty)
      */
     IOHandlerAccept(int sd, const DispatchHandlerPtr &dhp,
-                    HandlerMapPtr &hmap, ConnectionHandlerFactoryPtr &chfp)
-      : IOHandler(sd, dhp), m_handler_map(hmap), m_handler_factory(chfp) {
+                    HandlerMapPtr &hmap, ConnectionHandlerFactoryPtr &chfp,
+                    const ReactorPtr &reactor=ReactorPtr())
+      : IOHandler(sd, dhp, reactor), m_handler_map(hmap),
+        m_handler_factory(chfp) {
       memcpy(&m_addr, &m_local_addr, sizeof(InetAddr));
     }
 
+    /** Sets group of accept handlers sharing this handler's address.  Only
+     * one member of the group is registered in the HandlerMap; when any
+     * member is decomissioned, the whole group is decomissioned.  Connections
+     * accepted by a group member are handled on the member's reactor.  Must
+     * be called before polling is started.
+     * @param group Group of accept handlers, including this one
+     */
+    void set_group(const GroupPtr &group) { m_group = group; }
+
+    /** Gets group of accept handlers sharing this handler's address.
+     * @return Group of accept handlers, or empty pointer if this handler
+     * is the only handler listening on its address
+     */
+    const GroupPtr &get_group() const { return m_group; }
+
+    /** Checks if handler belongs to this handler's group.
+     * @param handler Handler to check
+     * @return <i>true</i> if <code>handler</code> is a member of the group
+     */
+    bool in_group(const IOHandler *handler) const {
+      return m_group && std::find(m_group->begin(), m_group->end(), handler)
+        != m_group->end();
+    }
+
     /** Destructor */
     virtual ~IOHandlerAccept() { }
 
@@ -125,7 +164,9 @@ namespace Hypertable {
      *     - Sets socket send and receive buffers to <code>4*32768</code>
      *   - Creates a default dispatch handler using #m_handler_factory
      *   - Creates an IOHandlerData object with socket returned by
-     *     <code>accept</code> and default dispatch handler
+     *     <code>accept</code> and default dispatch handler.  If this handler
+     *     is a member of a group, the IOHandlerData object is assigned
+     *     this handler's reactor
      *   - Inserts newly created handler in #m_handler_map
      *   - If <i>proxy master</i>, propagate proxy map over newly established
      *     connection.
@@ -142,6 +183,9 @@ namespace Hypertable {
      * for incoming connections.
      */
     ConnectionHandlerFactoryPtr m_handler_factory;
+
+    /// Group of accept handlers sharing this handler's address
+    GroupPtr m_group;
   };
   /** @}*/
 }
@@ -35,6 +35,7 @@
 #include <Common/InetAddr.h>
 #include <Common/Time.h>
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
@@ -57,6 +58,13 @@ using namespace std;
 
 namespace {
 
+  /// Maximum number of iovecs passed to a single writev() call
+  const int MAX_SEND_IOVECS = 64;
+
+  /// Maximum number of bytes of queued messages coalesced into a single
+  /// writev() call (the first message is always included in full)
+  const ssize_t MAX_SEND_BYTES = 262144;
+
   /**
    * Used to read data off a socket that is monotored with edge-triggered epoll.
    * When this function returns with *errnop set to EAGAIN, it is safe to call
@@ -106,13 +114,66 @@ namespace {
     return nwritten;
   }
 
+  /**
+   * Fills iovec array with unsent data of messages in send queue.  Messages
+   * are added until #MAX_SEND_IOVECS or #MAX_SEND_BYTES is reached.  A message
+   * is only followed by the next one if all of its data was added, so the
+   * last message added may be incomplete.
+   * @param queue Send queue
+   * @param vec iovec array with room for #MAX_SEND_IOVECS entries
+   * @param lengths Array filled with number of bytes added for each message
+   * @param countp Address of variable set to number of messages added
+   * @param towritep Address of variable set to total number of bytes added
+   * @return Number of iovec entries filled in
+   */
+  int fill_send_iovec(list<CommBufPtr> &queue, struct iovec *vec,
+                      ssize_t *lengths, int *countp, ssize_t *towritep) {
+    int count = 0;
+    *countp = 0;
+    *towritep = 0;
+    for (auto &cbp : queue) {
+      if (count == MAX_SEND_IOVECS ||
+          (*countp > 0 && *towritep >= MAX_SEND_BYTES))
+        break;
+      ssize_t len = 0;
+      count += cbp->fill_iovec(&vec[count], MAX_SEND_IOVECS - count, &len);
+      lengths[(*countp)++] = len;
+      *towritep += len;
+      // Message data may not have fit
+      if (count == MAX_SEND_IOVECS)
+        break;
+    }
+    return count;
+  }
+
+  /**
+   * Advances send pointers of messages written by a writev() call set up with
+   * fill_send_iovec() and removes completely sent messages from the send
+   * queue.
+   * @param queue Send queue
+   * @param lengths Number of bytes added to writev() call for each message
+   * @param count Number of messages added to writev() call
+   * @param nwritten Number of bytes written
+   */
+  void advance_send_queue(list<CommBufPtr> &queue, const ssize_t *lengths,
+                          int count, ssize_t nwritten) {
+    for (int i=0; i<count; i++) {
+      ssize_t len = std::min(nwritten, lengths[i]);
+      nwritten -= len;
+      // Message data may not have fit in a single writev()
+      if (!queue.front()->advance(len))
+        return;
+      // buffer written successfully, now remove from queue (destroys buffer)
+      queue.pop_front();
+    }
+  }
+
 } // local namespace
 
 
 bool
 IOHandlerData::handle_event(struct pollfd *event,
                             ClockT::time_point arrival_time) {
-  int error = 0;
   bool eof = false;
 
   //DisplayEvent(event);
@@ -126,62 +187,8 @@ IOHandlerData::handle_event(struct pollfd *event,
     }
 
     if (event->revents & POLLIN) {
-      size_t nread;
-      while (true) {
-        if (!m_got_header) {
-          nread = et_socket_read(m_sd, m_message_header_ptr,
-                                 m_message_header_remaining, &error, &eof);
-          if (nread == (size_t)-1) {
-            if (errno != ECONNREFUSED) {
-              if (ReactorFactory::verbose)
-                HT_INFOF("socket read(%d, len=%d) failure : %s", m_sd,
-                         (int)m_message_header_remaining, strerror(errno));
-            }
-            else
-              test_and_set_error(Error::COMM_CONNECT_ERROR);
-
-            handle_disconnect();
-            return true;
-          }
-          else if (nread < m_message_header_remaining) {
-            m_message_header_remaining -= nread;
-            m_message_header_ptr += nread;
-            if (error == EAGAIN)
-              break;
-            error = 0;
-          }
-          else {
-            m_message_header_ptr += nread;
-            handle_message_header(arrival_time);
-          }
-
-          if (eof)
-            break;
-        }
-        else { // got header
-          nread = et_socket_read(m_sd, m_message_ptr, m_message_remaining,
-                                 &error, &eof);
-          if (nread == (size_t)-1) {
-            if (ReactorFactory::verbose)
-              HT_INFOF("socket read(%d, len=%d) failure : %s", m_sd,
-                       (int)m_message_header_remaining, strerror(errno));
-            handle_disconnect();
-            return true;
-          }
-          else if (nread < m_message_remaining) {
-            m_message_ptr += nread;
-            m_message_remaining -= nread;
-            if (error == EAGAIN)
-              break;
-            error = 0;
-          }
-          else
-            handle_message_body();
-
-          if (eof)
-            break;
-        }
-      }
+      if (read_socket(arrival_time, false, &eof))
+        return true;
     }
 
     if (eof) {
@@ -224,7 +231,6 @@ IOHandlerData::handle_event(struct pollfd *event,
 bool
 IOHandlerData::handle_event(struct epoll_event *event,
                             ClockT::time_point arrival_time) {
-  int error = 0;
   bool eof = false;
 
   //DisplayEvent(event);
@@ -238,62 +244,8 @@ IOHandlerData::handle_event(struct epoll_event *event,
     }
 
     if (event->events & EPOLLIN) {
-      size_t nread;
-      while (true) {
-        if (!m_got_header) {
-          nread = et_socket_read(m_sd, m_message_header_ptr,
-                                 m_message_header_remaining, &error, &eof);
-          if (nread == (size_t)-1) {
-            if (errno != ECONNREFUSED) {
-              if (ReactorFactory::verbose)
-                HT_INFOF("socket read(%d, len=%d) failure : %s", m_sd,
-                         (int)m_message_header_remaining, strerror(errno));
-            }
-            else
-              test_and_set_error(Error::COMM_CONNECT_ERROR);
-
-            handle_disconnect();
-            return true;
-          }
-          else if (nread < m_message_header_remaining) {
-            m_message_header_remaining -= nread;
-            m_message_header_ptr += nread;
-            if (error == EAGAIN)
-              break;
-            error = 0;
-          }
-          else {
-            m_message_header_ptr += nread;
-            handle_message_header(arrival_time);
-          }
-
-          if (eof)
-            break;
-        }
-        else { // got header
-          nread = et_socket_read(m_sd, m_message_ptr, m_message_remaining,
-                                 &error, &eof);
-          if (nread == (size_t)-1) {
-            if (ReactorFactory::verbose)
-              HT_INFOF("socket read(%d, len=%d) failure : %s", m_sd,
-                       (int)m_message_header_remaining, strerror(errno));
-            handle_disconnect();
-            return true;
-          }
-          else if (nread < m_message_remaining) {
-            m_message_ptr += nread;
-            m_message_remaining -= nread;
-            if (error == EAGAIN)
-              break;
-            error = 0;
-          }
-          else
-            handle_message_body();
-
-          if (eof)
-            break;
-        }
-      }
+      if (read_socket(arrival_time, ReactorFactory::ms_epollet, &eof))
+        return true;
     }
 
     if (ReactorFactory::ms_epollet) {
@@ -342,7 +294,6 @@ IOHandlerData::handle_event(struct epoll_event *event,
 
 bool IOHandlerData::handle_event(port_event_t *event,
                                  ClockT::time_point arrival_time) {
-  int error = 0;
   bool eof = false;
 
   //display_event(event);
@@ -359,62 +310,8 @@ bool IOHandlerData::handle_event(port_event_t *event,
     }
 
     if (event->portev_events & POLLIN) {
-      size_t nread;
-      while (true) {
-        if (!m_got_header) {
-          nread = et_socket_read(m_sd, m_message_header_ptr,
-                                 m_message_header_remaining, &error, &eof);
-          if (nread == (size_t)-1) {
-            if (errno != ECONNREFUSED) {
-              if (ReactorFactory::verbose)
-                HT_INFOF("socket read(%d, len=%d) failure : %s", m_sd,
-                         (int)m_message_header_remaining, strerror(errno));
-            }
-            else
-              test_and_set_error(Error::COMM_CONNECT_ERROR);
-
-            handle_disconnect();
-            return true;
-          }
-          else if (nread < m_message_header_remaining) {
-            m_message_header_remaining -= nread;
-            m_message_header_ptr += nread;
-            if (error == EAGAIN)
-              break;
-            error = 0;
-          }
-          else {
-            m_message_header_ptr += nread;
-            handle_message_header(arrival_time);
-          }
-
-          if (eof)
-            break;
-        }
-        else { // got header
-          nread = et_socket_read(m_sd, m_message_ptr, m_message_remaining,
-                                 &error, &eof);
-          if (nread == (size_t)-1) {
-            if (ReactorFactory::verbose)
-              HT_INFOF("socket read(%d, len=%d) failure : %s", m_sd,
-                       (int)m_message_header_remaining, strerror(errno));
-            handle_disconnect();
-            return true;
-          }
-          else if (nread < m_message_remaining) {
-            m_message_ptr += nread;
-            m_message_remaining -= nread;
-            if (error == EAGAIN)
-              break;
-            error = 0;
-          }
-          else
-            handle_message_body();
-
-          if (eof)
-            break;
-        }
-      }
+      if (read_socket(arrival_time, false, &eof))
+        return true;
     }
 
     if (eof) {
@@ -563,6 +460,141 @@ bool IOHandlerData::handle_event(struct kevent *event,
 #endif
 
 
+#if defined(HT_WITH_IO_URING)
+
+bool IOHandlerData::handle_ring_recv(int res, const uint8_t *buf,
+                                     ClockT::time_point arrival_time) {
+
+  if (res < 0) {
+    if (res == -ENOBUFS || res == -ECANCELED)
+      return false;  // receive is re-armed or handler is being removed
+    if (res != -ECONNREFUSED) {
+      if (ReactorFactory::verbose)
+        HT_INFOF("socket recv(%d) failure : %s", m_sd, strerror(-res));
+    }
+    else
+      test_and_set_error(Error::COMM_CONNECT_ERROR);
+    handle_disconnect();
+    return true;
+  }
+
+  if (res == 0) {
+    HT_DEBUGF("Received EOF on descriptor %d (%s:%d)", m_sd,
+              inet_ntoa(m_addr.sin_addr), ntohs(m_addr.sin_port));
+    handle_disconnect();
+    return true;
+  }
+
+  try {
+    handle_received_data(buf, (size_t)res, arrival_time);
+  }
+  catch (Hypertable::Exception &e) {
+    if (ReactorFactory::verbose)
+      HT_ERROR_OUT << e << HT_END;
+    handle_disconnect();
+    return true;
+  }
+
+  return false;
+}
+
+#endif // HT_WITH_IO_URING
+
+
+bool IOHandlerData::read_socket(ClockT::time_point arrival_time, bool drain,
+                                bool *eofp) {
+  uint8_t *buf = m_reactor->receive_buffer.get();
+  ssize_t nread;
+  int error = 0;
+
+  while (!*eofp) {
+
+    // Large payload, read it directly into the message buffer
+    if (m_got_header && m_message_remaining >= Reactor::RECEIVE_BUFFER_SIZE) {
+      nread = et_socket_read(m_sd, m_message_ptr, m_message_remaining,
+                             &error, eofp);
+      if (nread == (ssize_t)-1)
+        break;
+      m_message_ptr += nread;
+      m_message_remaining -= nread;
+      if (m_message_remaining == 0)
+        handle_message_body();
+      if (error == EAGAIN)
+        return false;
+      error = 0;
+      continue;
+    }
+
+    if ((nread = ::read(m_sd, buf, Reactor::RECEIVE_BUFFER_SIZE)) < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN)
+        return false;
+      error = errno;
+      break;
+    }
+    else if (nread == 0) {
+      *eofp = true;
+      break;
+    }
+
+    handle_received_data(buf, (size_t)nread, arrival_time);
+
+    // A short read drained the socket; with level-triggered polling there
+    // is no need to read until EAGAIN
+    if (!drain && (size_t)nread < Reactor::RECEIVE_BUFFER_SIZE)
+      return false;
+  }
+
+  if (*eofp)
+    return false;
+
+  if (error != ECONNREFUSED) {
+    if (ReactorFactory::verbose)
+      HT_INFOF("socket read(%d) failure : %s", m_sd, strerror(error));
+  }
+  else
+    test_and_set_error(Error::COMM_CONNECT_ERROR);
+
+  handle_disconnect();
+  return true;
+}
+
+
+void IOHandlerData::handle_received_data(const uint8_t *buf, size_t len,
+                                         ClockT::time_point arrival_time) {
+  size_t n;
+
+  while (true) {
+    if (!m_got_header) {
+      if (len == 0)
+        break;
+      n = std::min(len, m_message_header_remaining);
+      memcpy(m_message_header_ptr, buf, n);
+      buf += n;
+      len -= n;
+      m_message_header_ptr += n;
+      m_message_header_remaining -= n;
+      if (m_message_header_remaining == 0)
+        handle_message_header(arrival_time);
+    }
+    else { // got header
+      n = std::min(len, m_message_remaining);
+      if (n) {
+        memcpy(m_message_ptr, buf, n);
+        buf += n;
+        len -= n;
+        m_message_ptr += n;
+        m_message_remaining -= n;
+      }
+      if (m_message_remaining)
+        break;
+      handle_message_body();
+    }
+  }
+}
+
+
 void IOHandlerData::handle_message_header(ClockT::time_point arrival_time) {
   size_t header_len = (size_t)m_message_header[1];
 
@@ -755,7 +787,10 @@ IOHandlerData::send_message(CommBufPtr &cbp, uint32_t timeout_ms,
 
   m_send_queue.push_back(cbp);
 
-  if (m_connected) {
+  // If messages are still queued, the socket buffer is full and write
+  // interest is registered, so the message is left for
+  // handle_write_readiness() to write out together with the others
+  if (m_connected && initially_empty) {
     if ((error = flush_send_queue()) != Error::OK) {
       if (ReactorFactory::verbose)
         HT_WARNF("Problem flushing send queue - %s", Error::get_text(error));
@@ -771,11 +806,6 @@ IOHandlerData::send_message(CommBufPtr &cbp, uint32_t timeout_ms,
     if (error && ReactorFactory::verbose)
       HT_ERRORF("Adding Write interest failed; error=%u", (unsigned)error);
   }
-  else if (!initially_empty && m_send_queue.empty()) {
-    error = remove_poll_interest(PollEvent::WRITE);
-    if (error && ReactorFactory::verbose)
-      HT_INFOF("Removing Write interest failed; error=%u", (unsigned)error);
-  }
 
   // Set m_error if not already set
   if (error != Error::OK && m_error == Error::OK)
@@ -788,33 +818,15 @@ IOHandlerData::send_message(CommBufPtr &cbp, uint32_t timeout_ms,
 #if defined(__linux__)
 
 int IOHandlerData::flush_send_queue() {
-  ssize_t nwritten, towrite, remaining;
-  struct iovec vec[2];
-  int count;
+  ssize_t nwritten, towrite;
+  struct iovec vec[MAX_SEND_IOVECS];
+  ssize_t lengths[MAX_SEND_IOVECS];
+  int count, messages;
   int error = 0;
 
   while (!m_send_queue.empty()) {
 
-    CommBufPtr &cbp = m_send_queue.front();
-
-    count = 0;
-    towrite = 0;
-    remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-    if (remaining > 0) {
-      vec[0].iov_base = (void *)cbp->data_ptr;
-      vec[0].iov_len = remaining;
-      towrite = remaining;
-      ++count;
-    }
-    if (cbp->ext.base != 0) {
-      remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
-      if (remaining > 0) {
-        vec[count].iov_base = (void *)cbp->ext_ptr;
-        vec[count].iov_len = remaining;
-        towrite += remaining;
-        ++count;
-      }
-    }
+    count = fill_send_iovec(m_send_queue, vec, lengths, &messages, &towrite);
 
     nwritten = et_socket_writev(m_sd, vec, count, &error);
     if (nwritten == (ssize_t)-1) {
@@ -825,43 +837,8 @@ int IOHandlerData::flush_send_queue() {
                  strerror(errno));
       return Error::COMM_BROKEN_CONNECTION;
     }
-    else if (nwritten < towrite) {
-      if (nwritten == 0) {
-        if (error == EAGAIN)
-          break;
-        if (error) {
-          if (ReactorFactory::verbose)
-            HT_WARNF("FileUtils::writev(%d, len=%d) failed : %s", m_sd,
-                     (int)towrite, strerror(error));
-          return Error::COMM_BROKEN_CONNECTION;
-        }
-        continue;
-      }
-      remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-      if (remaining > 0) {
-        if (nwritten < remaining) {
-          cbp->data_ptr += nwritten;
-          if (error == EAGAIN)
-            break;
-          error = 0;
-          continue;
-        }
-        else {
-          nwritten -= remaining;
-          cbp->data_ptr += remaining;
-        }
-      }
-      if (cbp->ext.base != 0) {
-        cbp->ext_ptr += nwritten;
-        if (error == EAGAIN)
-          break;
-        error = 0;
-        continue;
-      }
-    }
 
-    // buffer written successfully, now remove from queue (destroys buffer)
-    m_send_queue.pop_front();
+    advance_send_queue(m_send_queue, lengths, messages, nwritten);
   }
 
   return Error::OK;
@@ -870,32 +847,14 @@ int IOHandlerData::flush_send_queue() {
 #elif defined(__APPLE__) || defined (__sun__) || defined(__FreeBSD__)
 
 int IOHandlerData::flush_send_queue() {
-  ssize_t nwritten, towrite, remaining;
-  struct iovec vec[2];
-  int count;
+  ssize_t nwritten, towrite;
+  struct iovec vec[MAX_SEND_IOVECS];
+  ssize_t lengths[MAX_SEND_IOVECS];
+  int count, messages;
 
   while (!m_send_queue.empty()) {
 
-    CommBufPtr &cbp = m_send_queue.front();
-
-    count = 0;
-    towrite = 0;
-    remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-    if (remaining > 0) {
-      vec[0].iov_base = (void *)cbp->data_ptr;
-      vec[0].iov_len = remaining;
-      towrite = remaining;
-      ++count;
-    }
-    if (cbp->ext.base != 0) {
-      remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
-      if (remaining > 0) {
-        vec[count].iov_base = (void *)cbp->ext_ptr;
-        vec[count].iov_len = remaining;
-        towrite += remaining;
-        ++count;
-      }
-    }
+    count = fill_send_iovec(m_send_queue, vec, lengths, &messages, &towrite);
 
     nwritten = FileUtils::writev(m_sd, vec, count);
     if (nwritten == (ssize_t)-1) {
@@ -904,28 +863,12 @@ int IOHandlerData::flush_send_queue() {
                  strerror(errno));
       return Error::COMM_BROKEN_CONNECTION;
     }
-    else if (nwritten < towrite) {
-      if (nwritten == 0)
-        break;
-      remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-      if (remaining > 0) {
-        if (nwritten < remaining) {
-          cbp->data_ptr += nwritten;
-          break;
-        }
-        else {
-          nwritten -= remaining;
-          cbp->data_ptr += remaining;
-        }
-      }
-      if (cbp->ext.base != 0) {
-        cbp->ext_ptr += nwritten;
-        break;
-      }
-    }
 
-    // buffer written successfully, now remove from queue (destroys buffer)
-    m_send_queue.pop_front();
+    advance_send_queue(m_send_queue, lengths, messages, nwritten);
+
+    // Socket buffer is full
+    if (nwritten < towrite)
+      break;
   }
 
   return Error::OK;
@@ -57,10 +57,13 @@ namespace Hypertable {
      * @param addr Address of remote end of connection
      * @param dhp Default dispatch handler for connection
      * @param connected Initial connection state for handler
+     * @param reactor Reactor to handle I/O events on (assigned round-robin
+     * if empty)
      */
     IOHandlerData(int sd, const InetAddr &addr,
-                  const DispatchHandlerPtr &dhp, bool connected=false)
-      : IOHandler(sd, dhp) {
+                  const DispatchHandlerPtr &dhp, bool connected=false,
+                  const ReactorPtr &reactor=ReactorPtr())
+      : IOHandler(sd, dhp, reactor) {
       memcpy(&m_addr, &addr, sizeof(InetAddr));
       m_connected = connected;
       reset_incoming_message_state();
@@ -141,9 +144,9 @@ namespace Hypertable {
      * #handle_write_readiness.  If #handle_write_readiness returns <i>true</i>
      * the handler is disconnected with a call to #handle_disconnect and
      * <i>true</i> is returned.  <code>POLLIN</code> events are handled by
-     * reading message data off the socket.  First the message header is read
-     * and decoded with #handle_message_header and then the message payload is
-     * read and delivered to the application with #handle_message_body.  If a
+     * reading message data off the socket with #read_socket, which decodes
+     * message headers with #handle_message_header and delivers complete
+     * messages to the application with #handle_message_body.  If a
      * read error is encountered, #m_error is set to the approprate error
      * code (if not already set) and the handler is disconnected with
      * a call to #handle_disconnect and <i>true</i> is returned. 
@@ -192,9 +195,9 @@ namespace Hypertable {
      * #handle_write_readiness.  If #handle_write_readiness returns <i>true</i>
      * the handler is disconnected with a call to #handle_disconnect and
      * <i>true</i> is returned.  <code>EPOLLIN</code> events are handled by
-     * reading message data off the socket.  First the message header is read
-     * and decoded with #handle_message_header and then the message payload is
-     * read and delivered to the application with #handle_message_body.  If a
+     * reading message data off the socket with #read_socket, which decodes
+     * message headers with #handle_message_header and delivers complete
+     * messages to the application with #handle_message_body.  If a
      * read error is encountered, #m_error is set to the approprate error
      * code (if not already set) and the handler is disconnected with
      * a call to #handle_disconnect and <i>true</i> is returned.
@@ -219,9 +222,9 @@ namespace Hypertable {
      * #handle_write_readiness.  If #handle_write_readiness returns <i>true</i>
      * the handler is disconnected with a call to #handle_disconnect and
      * <i>true</i> is returned.  <code>POLLIN</code> events are handled by
-     * reading message data off the socket.  First the message header is read
-     * and decoded with #handle_message_header and then the message payload is
-     * read and delivered to the application with #handle_message_body.  If a
+     * reading message data off the socket with #read_socket, which decodes
+     * message headers with #handle_message_header and delivers complete
+     * messages to the application with #handle_message_body.  If a
      * read error is encountered, #m_error is set to the approprate error
      * code (if not already set) and the handler is disconnected with
      * a call to #handle_disconnect and <i>true</i> is returned. 
@@ -242,6 +245,27 @@ namespace Hypertable {
     ImplementMe;
 #endif
 
+#if defined(HT_WITH_IO_URING)
+    /** Handle data received by <code>io_uring</code> multishot receive.
+     * Copies the received bytes into the message header and body buffers,
+     * calling #handle_message_header and #handle_message_body as they fill
+     * up, the same way the <code>read()</code> loop of #handle_event does.
+     * A result of 0 (EOF) or a negative result disconnects the handler.
+     * @param res Number of bytes received, 0 on EOF, or -errno on failure
+     * @param buf Buffer holding received data
+     * @param arrival_time Time of event arrival
+     * @return <i>false</i> on success, <i>true</i> if error encountered and
+     * handler was decomissioned
+     */
+    bool handle_ring_recv(int res, const uint8_t *buf,
+                          ClockT::time_point arrival_time) override;
+
+    /** Reads are done with a multishot receive.
+     * @return <i>true</i>
+     */
+    bool uses_ring_receive() override { return true; }
+#endif
+
     /** Handles write readiness by completing connection and flushing send
      * queue.  When a data handler is created after a call to
      * <code>connect</code> it is in the disconnected state.  Once the socket
@@ -264,6 +288,37 @@ namespace Hypertable {
 
   private:
 
+    /** Reads data off the socket and processes the messages it contains.
+     * Data is read into the reactor's receive buffer (Reactor::receive_buffer)
+     * so that a single <code>read()</code> can pick up several small
+     * messages, which are then parsed out of the buffer with
+     * #handle_received_data.  Once a message header has been received and
+     * the remaining payload is at least as big as the receive buffer, the
+     * payload is read directly into the message buffer.  Reading stops when
+     * the socket returns <code>EAGAIN</code> or <i>EOF</i>, or, if
+     * <code>drain</code> is <i>false</i>, after a short read.  If a read
+     * error is encountered, #m_error is set to the approprate error code (if
+     * not already set) and the handler is disconnected with a call to
+     * #handle_disconnect.
+     * @param arrival_time Time of event arrival
+     * @param drain Read until <code>EAGAIN</code> (edge-triggered polling)
+     * @param eofp Address of variable set to <i>true</i> on <i>EOF</i>
+     * @return <i>false</i> on success, <i>true</i> if error encountered and
+     * handler was decomissioned
+     */
+    bool read_socket(ClockT::time_point arrival_time, bool drain, bool *eofp);
+
+    /** Processes received message data.  Copies <code>len</code> bytes from
+     * <code>buf</code> into the message header and payload buffers, calling
+     * #handle_message_header and #handle_message_body as they fill up.  The
+     * data may contain any number of complete or partial messages.
+     * @param buf Received data
+     * @param len Length of received data
+     * @param arrival_time Time of event arrival
+     */
+    void handle_received_data(const uint8_t *buf, size_t len,
+                              ClockT::time_point arrival_time);
+
     /** Processes a message header.  This method is called when the fixed
      * length portion of a header has been completely received.  It first
      * checks to see if there is a variable portion of the header that has
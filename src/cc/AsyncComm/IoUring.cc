@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for IoUring.
+ * This file contains method definitions for IoUring, a thin wrapper around
+ * a Linux <code>io_uring</code> submission/completion ring pair and its
+ * pool of provided receive buffers.
+ */
+
+#include <Common/Compat.h>
+
+#include "IoUring.h"
+
+#if defined(HT_WITH_IO_URING)
+
+#include <Common/Error.h>
+#include <Common/Logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+extern "C" {
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace std;
+
+IoUring::IoUring(unsigned entries, unsigned buffer_count,
+                 unsigned buffer_size)
+  : m_buffer_count(buffer_count), m_buffer_size(buffer_size) {
+  struct io_uring_params params;
+
+  HT_ASSERT(buffer_count <= 65536);
+
+  // Completion queue is sized so that a burst of multishot receive
+  // completions does not overflow it
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = entries * 4;
+
+  if ((m_fd = (int)syscall(__NR_io_uring_setup, entries, &params)) < 0)
+    HT_THROWF(Error::COMM_POLL_ERROR, "io_uring_setup(%u) failure: %s",
+              entries, strerror(errno));
+
+  if ((params.features & IORING_FEAT_EXT_ARG) == 0) {
+    release();
+    HT_THROW(Error::COMM_POLL_ERROR, "io_uring lacks IORING_FEAT_EXT_ARG");
+  }
+
+  m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  m_cq_ring_size = params.cq_off.cqes +
+    params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    m_sq_ring_size = m_cq_ring_size = max(m_sq_ring_size, m_cq_ring_size);
+
+  m_sq_ring = mmap(0, m_sq_ring_size, PROT_READ|PROT_WRITE,
+                   MAP_SHARED|MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+  if (m_sq_ring == MAP_FAILED) {
+    m_sq_ring = 0;
+    int saved_errno = errno;
+    release();
+    HT_THROWF(Error::COMM_POLL_ERROR, "mmap(IORING_OFF_SQ_RING) failure: %s",
+              strerror(saved_errno));
+  }
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    m_cq_ring = m_sq_ring;
+  else {
+    m_cq_ring = mmap(0, m_cq_ring_size, PROT_READ|PROT_WRITE,
+                     MAP_SHARED|MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+    if (m_cq_ring == MAP_FAILED) {
+      m_cq_ring = 0;
+      int saved_errno = errno;
+      release();
+      HT_THROWF(Error::COMM_POLL_ERROR, "mmap(IORING_OFF_CQ_RING) failure: %s",
+                strerror(saved_errno));
+    }
+  }
+
+  m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  m_sqes = (io_uring_sqe *)mmap(0, m_sqes_size, PROT_READ|PROT_WRITE,
+                                MAP_SHARED|MAP_POPULATE, m_fd,
+                                IORING_OFF_SQES);
+  if (m_sqes == MAP_FAILED) {
+    m_sqes = 0;
+    int saved_errno = errno;
+    release();
+    HT_THROWF(Error::COMM_POLL_ERROR, "mmap(IORING_OFF_SQES) failure: %s",
+              strerror(saved_errno));
+  }
+
+  uint8_t *sq = (uint8_t *)m_sq_ring;
+  m_sq_head = (unsigned *)(sq + params.sq_off.head);
+  m_sq_tail_ptr = (unsigned *)(sq + params.sq_off.tail);
+  m_sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+  m_sq_entries = params.sq_entries;
+  m_sq_tail = m_sq_submitted = *m_sq_tail_ptr;
+
+  // Submission queue slots map one-to-one onto entries
+  unsigned *array = (unsigned *)(sq + params.sq_off.array);
+  for (unsigned i=0; i<m_sq_entries; i++)
+    array[i] = i;
+
+  uint8_t *cq = (uint8_t *)m_cq_ring;
+  m_cq_head_ptr = (unsigned *)(cq + params.cq_off.head);
+  m_cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  m_cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+  m_cq_head = *m_cq_head_ptr;
+  m_cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+  if (m_buffer_count == 0)
+    return;
+
+  // Provide all receive buffers and wait for the kernel to take them
+  m_buffers.reset(new uint8_t [(size_t)m_buffer_count * m_buffer_size]);
+  io_uring_sqe *sqe = get_sqe();
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->fd = (int)m_buffer_count;
+  sqe->addr = (uint64_t)(uintptr_t)m_buffers.get();
+  sqe->len = m_buffer_size;
+  sqe->off = 0;
+  sqe->buf_group = BUFFER_GROUP;
+  sqe->user_data = INTERNAL_USER_DATA;
+
+  int ret = submit_and_wait(0);
+  io_uring_cqe *cqe = peek_cqe();
+  if (ret < 0 || cqe == nullptr || cqe->res < 0) {
+    int error = (ret < 0) ? -ret : (cqe ? -cqe->res : EAGAIN);
+    release();
+    HT_THROWF(Error::COMM_POLL_ERROR,
+              "io_uring IORING_OP_PROVIDE_BUFFERS failure: %s",
+              strerror(error));
+  }
+  cqe_seen();
+}
+
+
+IoUring::~IoUring() {
+  release();
+}
+
+
+bool IoUring::supported() {
+  try {
+    IoUring ring(8, 1, 64);
+  }
+  catch (Exception &e) {
+    HT_INFOF("io_uring not available - %s", e.what());
+    return false;
+  }
+  return true;
+}
+
+
+io_uring_sqe *IoUring::get_sqe() {
+  while (m_sq_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE)
+         >= m_sq_entries) {
+    int ret = submit_and_wait(0, false);
+    if (ret < 0)
+      HT_FATALF("io_uring_enter() failure: %s", strerror(-ret));
+  }
+  io_uring_sqe *sqe = &m_sqes[m_sq_tail & m_sq_mask];
+  memset(sqe, 0, sizeof(*sqe));
+  m_sq_tail++;
+  return sqe;
+}
+
+
+int IoUring::submit_and_wait(const struct timespec *timeout, bool wait) {
+  unsigned to_submit = m_sq_tail - m_sq_submitted;
+  unsigned flags = 0;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  long ret;
+
+  if (to_submit)
+    __atomic_store_n(m_sq_tail_ptr, m_sq_tail, __ATOMIC_RELEASE);
+
+  if (wait) {
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeout) {
+      ts.tv_sec = timeout->tv_sec;
+      ts.tv_nsec = timeout->tv_nsec;
+      arg.ts = (uint64_t)(uintptr_t)&ts;
+    }
+    flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    ret = syscall(__NR_io_uring_enter, m_fd, to_submit, 1, flags, &arg,
+                  sizeof(arg));
+  }
+  else if (to_submit)
+    ret = syscall(__NR_io_uring_enter, m_fd, to_submit, 0, 0, 0, 0);
+  else
+    return 0;
+
+  if (ret < 0) {
+    if (errno == ETIME || errno == EINTR)
+      return 0;
+    return -errno;
+  }
+  m_sq_submitted += (unsigned)ret;
+  return (int)ret;
+}
+
+
+int IoUring::wait(const struct timespec *timeout) {
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+
+  memset(&arg, 0, sizeof(arg));
+  arg.sigmask_sz = _NSIG / 8;
+  if (timeout) {
+    ts.tv_sec = timeout->tv_sec;
+    ts.tv_nsec = timeout->tv_nsec;
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+  }
+  if (syscall(__NR_io_uring_enter, m_fd, 0, 1,
+              IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+              sizeof(arg)) < 0) {
+    if (errno == ETIME || errno == EINTR)
+      return 0;
+    return -errno;
+  }
+  return 0;
+}
+
+
+void IoUring::recycle_buffer(uint16_t bid) {
+  io_uring_sqe *sqe = get_sqe();
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+  sqe->fd = 1;
+  sqe->addr = (uint64_t)(uintptr_t)buffer(bid);
+  sqe->len = m_buffer_size;
+  sqe->off = bid;
+  sqe->buf_group = BUFFER_GROUP;
+  sqe->user_data = INTERNAL_USER_DATA;
+}
+
+
+void IoUring::release() {
+  if (m_sqes) {
+    munmap(m_sqes, m_sqes_size);
+    m_sqes = 0;
+  }
+  if (m_cq_ring && m_cq_ring != m_sq_ring)
+    munmap(m_cq_ring, m_cq_ring_size);
+  m_cq_ring = 0;
+  if (m_sq_ring) {
+    munmap(m_sq_ring, m_sq_ring_size);
+    m_sq_ring = 0;
+  }
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+}
+
+#endif // HT_WITH_IO_URING
@@ -0,0 +1,218 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for IoUring.
+ * This file contains type declarations for IoUring, a thin wrapper around
+ * a Linux <code>io_uring</code> submission/completion ring pair and its
+ * pool of provided receive buffers.
+ */
+
+#ifndef AsyncComm_IoUring_h
+#define AsyncComm_IoUring_h
+
+#if defined(HT_WITH_IO_URING)
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+extern "C" {
+#include <linux/io_uring.h>
+#include <time.h>
+}
+
+namespace Hypertable {
+
+  /** @addtogroup AsyncComm
+   *  @{
+   */
+
+  /** Linux <code>io_uring</code> instance used by a Reactor.
+   * The ring is driven with the raw <code>io_uring_setup()</code> and
+   * <code>io_uring_enter()</code> system calls.  It also provides a pool of fixed size receive buffers
+   * (buffer group #BUFFER_GROUP) to the kernel, which picks a buffer for
+   * each completion of a multishot receive.  Buffers are handed back with
+   * <code>IORING_OP_PROVIDE_BUFFERS</code> entries that go out with the next
+   * submission.  The object is not thread safe; it is only used by the
+   * reactor thread that owns it.  Other users may submit from several
+   * threads by serializing the submission side (get_sqe() and
+   * submit_and_wait() with <i>wait</i> set to <i>false</i>) while a single
+   * thread reaps completions with wait(), peek_cqe() and cqe_seen().
+   */
+  class IoUring {
+
+  public:
+
+    /// Provided buffer group ID used for receives
+    static const uint16_t BUFFER_GROUP = 0;
+
+    /// User data of entries submitted by the ring itself; their completions
+    /// are to be skipped
+    static const uint64_t INTERNAL_USER_DATA = 0;
+
+    /** Constructor.
+     * Sets up the rings and provides the receive buffers.  Throws
+     * Exception with code Error::COMM_POLL_ERROR on failure.
+     * @param entries Number of submission queue entries
+     * @param buffer_count Number of receive buffers (0 for none)
+     * @param buffer_size Size of each receive buffer
+     */
+    IoUring(unsigned entries, unsigned buffer_count, unsigned buffer_size);
+
+    /// Destructor.  Unmaps the rings and closes the ring descriptor.
+    ~IoUring();
+
+    /** Checks if the running kernel supports the features used.
+     * Sets up a small ring to find out.
+     * @return <i>true</i> if io_uring can be used, <i>false</i> otherwise
+     */
+    static bool supported();
+
+    /** Gets next free submission queue entry.
+     * The returned entry is zeroed.  If the submission queue is full,
+     * the queued entries are submitted first.
+     * @return Pointer to submission queue entry
+     */
+    io_uring_sqe *get_sqe();
+
+    /** Submits queued entries and waits for completions.
+     * @param timeout Wait timeout, or 0 to wait indefinitely
+     * @param wait If <i>false</i>, return without waiting
+     * @return Number of entries submitted, or -errno on failure (-ETIME and
+     * -EINTR are returned as 0)
+     */
+    int submit_and_wait(const struct timespec *timeout, bool wait=true);
+
+    /** Waits for completions without submitting.
+     * Only touches the completion side of the ring, so it may be called
+     * while other threads submit entries.
+     * @param timeout Wait timeout, or 0 to wait indefinitely
+     * @return 0 on success or timeout, or -errno on failure
+     */
+    int wait(const struct timespec *timeout);
+
+    /** Returns next completion queue entry.
+     * @return Pointer to completion queue entry, or <i>nullptr</i> if there
+     * are no unseen completions
+     */
+    io_uring_cqe *peek_cqe() {
+      if (m_cq_head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE))
+        return nullptr;
+      return &m_cqes[m_cq_head & m_cq_mask];
+    }
+
+    /** Marks completion returned by peek_cqe() as seen.
+     */
+    void cqe_seen() {
+      __atomic_store_n(m_cq_head_ptr, ++m_cq_head, __ATOMIC_RELEASE);
+    }
+
+    /** Returns receive buffer.
+     * @param bid Buffer ID (from completion flags)
+     * @return Pointer to buffer
+     */
+    uint8_t *buffer(uint16_t bid) {
+      return m_buffers.get() + (size_t)bid * m_buffer_size;
+    }
+
+    /** Hands receive buffer back to the kernel.
+     * Queues an <code>IORING_OP_PROVIDE_BUFFERS</code> entry that only
+     * produces a completion if it fails.
+     * @param bid Buffer ID
+     */
+    void recycle_buffer(uint16_t bid);
+
+  private:
+
+    /// Unmaps rings and closes ring descriptor
+    void release();
+
+    /// Ring descriptor
+    int m_fd {-1};
+
+    /// Submission queue ring mapping
+    void *m_sq_ring {};
+
+    /// Size of #m_sq_ring mapping
+    size_t m_sq_ring_size {};
+
+    /// Completion queue ring mapping (may equal #m_sq_ring)
+    void *m_cq_ring {};
+
+    /// Size of #m_cq_ring mapping
+    size_t m_cq_ring_size {};
+
+    /// Submission queue entries
+    io_uring_sqe *m_sqes {};
+
+    /// Size of #m_sqes mapping
+    size_t m_sqes_size {};
+
+    /// Kernel submission queue head
+    unsigned *m_sq_head {};
+
+    /// Kernel submission queue tail
+    unsigned *m_sq_tail_ptr {};
+
+    /// Submission queue index mask
+    unsigned m_sq_mask {};
+
+    /// Number of submission queue entries
+    unsigned m_sq_entries {};
+
+    /// Local submission queue tail
+    unsigned m_sq_tail {};
+
+    /// Submission queue tail at last io_uring_enter()
+    unsigned m_sq_submitted {};
+
+    /// Kernel completion queue head
+    unsigned *m_cq_head_ptr {};
+
+    /// Kernel completion queue tail
+    unsigned *m_cq_tail {};
+
+    /// Completion queue index mask
+    unsigned m_cq_mask {};
+
+    /// Local completion queue head
+    unsigned m_cq_head {};
+
+    /// Completion queue entries
+    io_uring_cqe *m_cqes {};
+
+    /// Number of receive buffers
+    unsigned m_buffer_count {};
+
+    /// Size of each receive buffer
+    unsigned m_buffer_size {};
+
+    /// Receive buffer memory
+    std::unique_ptr<uint8_t[]> m_buffers;
+  };
+
+  /// @}
+}
+
+#endif // HT_WITH_IO_URING
+
+#endif // AsyncComm_IoUring_h
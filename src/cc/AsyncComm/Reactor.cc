@@ -60,9 +60,36 @@ extern "C" {
 using namespace Hypertable;
 using namespace std;
 
+#if defined(HT_WITH_IO_URING)
+namespace {
+  /// Submission queue entries per reactor ring
+  const unsigned RING_ENTRIES = 1024;
+  /// Number of provided receive buffers per reactor ring
+  const unsigned RING_BUFFER_COUNT = 256;
+  /// Size of each provided receive buffer
+  const unsigned RING_BUFFER_SIZE = 16384;
+}
+#endif
+
 Reactor::Reactor() {
   struct sockaddr_in addr;
 
+  receive_buffer.reset(new uint8_t [RECEIVE_BUFFER_SIZE]);
+
+#if defined(HT_WITH_IO_URING)
+  if (ReactorFactory::use_io_uring) {
+    try {
+      ring = make_unique<IoUring>(RING_ENTRIES, RING_BUFFER_COUNT,
+                                  RING_BUFFER_SIZE);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      exit(EXIT_FAILURE);
+    }
+    poll_fd = -1;
+  }
+  else
+#endif
   if (!ReactorFactory::use_poll) {
 #if defined(__linux__)
     if ((poll_fd = epoll_create(256)) < 0) {
@@ -137,6 +164,11 @@ Reactor::Reactor() {
     m_polldata[m_interrupt_sd].pollfd.events = POLLIN;
     HT_ASSERT(poll_loop_interrupt() == Error::OK);
   }
+#if defined(HT_WITH_IO_URING)
+  else if (ReactorFactory::use_io_uring) {
+    // Interrupt socket is polled by ReactorRunner once the ring is in use
+  }
+#endif
   else {
 #if defined(__linux__)
     if (ReactorFactory::ms_epollet) {
@@ -256,7 +288,7 @@ int Reactor::poll_loop_interrupt() {
 
   m_interrupt_in_progress = true;
 
-  if (ReactorFactory::use_poll) {
+  if (ReactorFactory::use_poll || ReactorFactory::use_io_uring) {
     ssize_t n;
 
     // Send 1 byte to ourselves to cause epoll_wait to return
@@ -330,7 +362,8 @@ int Reactor::poll_loop_interrupt() {
  */
 int Reactor::poll_loop_continue() {
 
-  if (!m_interrupt_in_progress || ReactorFactory::use_poll) {
+  if (!m_interrupt_in_progress || ReactorFactory::use_poll ||
+      ReactorFactory::use_io_uring) {
     m_interrupt_in_progress = false;
     return Error::OK;
   }
@@ -29,16 +29,19 @@
 #define AsyncComm_Reactor_h
 
 #include "Clock.h"
+#include "IoUring.h"
 #include "PollTimeout.h"
 #include "RequestCache.h"
 #include "ExpireTimer.h"
 
 #include <boost/thread/thread.hpp>
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <set>
+#include <thread>
 #include <vector>
 
 extern "C" {
@@ -72,9 +75,11 @@ namespace Hypertable {
     /** Constructor.
      * Initializes polling interface and creates interrupt socket.
      * If ReactorFactory::use_poll is set to <i>true</i>, then the reactor will
-     * use the POSIX <code>poll()</code> interface, otherwise <code>epoll</code>
-     * is used on Linux, <code>kqueue</code> on OSX and FreeBSD, and
-     * <code>port_associate</code> on Solaris.  For polling mechanisms that
+     * use the POSIX <code>poll()</code> interface.  If
+     * ReactorFactory::use_io_uring is set to <i>true</i>, then the reactor
+     * will use an <code>io_uring</code> instance (#ring), otherwise
+     * <code>epoll</code> is used on Linux, <code>kqueue</code> on OSX and
+     * FreeBSD, and <code>port_associate</code> on Solaris.  For polling mechanisms that
      * do not provide an interface for breaking out of the poll wait, a UDP
      * socket #m_interrupt_sd is created (and connected to itself) and
      * added to the poll set.
@@ -258,6 +263,62 @@ namespace Hypertable {
      */
     int interrupt_sd() { return m_interrupt_sd; }
 
+#if defined(HT_WITH_IO_URING)
+    /** Requests update of io_uring operations for handler
+     * (<code>io_uring</code> only).
+     * Queues <code>handler</code> so that the reactor thread arms the
+     * operations needed for its current poll interest (see
+     * IOHandler#ring_arm).  The submission queue is only touched by the
+     * reactor thread, so if called from another thread, the polling loop
+     * is interrupted.
+     * @param handler I/O handler whose poll interest changed
+     */
+    void ring_update(IOHandler *handler) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_ring_updates.push_back(handler);
+      if (std::this_thread::get_id() != m_ring_thread)
+        poll_loop_interrupt();
+    }
+
+    /** Fetches handlers queued with #ring_update (<code>io_uring</code> only).
+     * @param dst Vector filled in with queued handlers
+     */
+    void get_ring_updates(std::vector<IOHandler *> &dst) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      dst.clear();
+      dst.swap(m_ring_updates);
+    }
+
+    /** Drops queued updates for handler (<code>io_uring</code> only).
+     * Called before the handler is purged.
+     * @param handler I/O handler being removed
+     */
+    void ring_forget(IOHandler *handler) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_ring_updates.erase(std::remove(m_ring_updates.begin(),
+                                       m_ring_updates.end(), handler),
+                           m_ring_updates.end());
+    }
+
+    /** Records calling thread as reactor thread (<code>io_uring</code> only).
+     */
+    void set_ring_thread() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_ring_thread = std::this_thread::get_id();
+    }
+
+    /// <code>io_uring</code> instance (ReactorFactory::use_io_uring only)
+    std::unique_ptr<IoUring> ring;
+#endif
+
+    /// Size of #receive_buffer
+    static const size_t RECEIVE_BUFFER_SIZE = 65536;
+
+    /// Buffer that data handlers read socket data into.  Several messages
+    /// are read with one <code>read()</code> and parsed out of it; it is
+    /// only accessed by the reactor thread
+    std::unique_ptr<uint8_t[]> receive_buffer;
+
   protected:
 
     /** Priority queue for timers.
@@ -283,6 +344,14 @@ namespace Hypertable {
 
     /// Set of IOHandler objects scheduled for removal
     std::set<IOHandler *> m_removed_handlers;
+
+#if defined(HT_WITH_IO_URING)
+    /// Handlers whose io_uring operations need updating
+    std::vector<IOHandler *> m_ring_updates;
+
+    /// Reactor thread ID
+    std::thread::id m_ring_thread;
+#endif
   };
 
   /// Shared smart pointer to Reactor
@@ -22,16 +22,26 @@
 #include <Common/Compat.h>
 
 #include "HandlerMap.h"
+#include "IoUring.h"
 #include "ReactorFactory.h"
 #include "ReactorRunner.h"
 
 #include <Common/Config.h>
+#include <Common/FileUtils.h>
+#include <Common/Logger.h>
 #include <Common/SystemInfo.h>
 
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 
 extern "C" {
 #include <signal.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 }
 
 using namespace Hypertable;
@@ -39,13 +49,40 @@ using namespace std;
 
 std::vector<ReactorPtr> ReactorFactory::ms_reactors;
 boost::thread_group ReactorFactory::ms_threads;
+vector<boost::thread *> ReactorFactory::ms_reactor_threads;
 default_random_engine ReactorFactory::rng {1};
 mutex ReactorFactory::ms_mutex;
 atomic<int> ReactorFactory::ms_next_reactor(0);
 bool ReactorFactory::ms_epollet = true;
 bool ReactorFactory::use_poll = false;
+bool ReactorFactory::use_io_uring = false;
 bool ReactorFactory::proxy_master = false;
 bool ReactorFactory::verbose {};
+bool ReactorFactory::reuse_port {};
+ReactorFactory::Affinity ReactorFactory::affinity {ReactorFactory::Affinity::NONE};
+
+#if defined(__linux__)
+namespace {
+
+  /// Parses CPU list (e.g. "0-3,8-11") into CPU set
+  void parse_cpu_list(const char *str, cpu_set_t *cpus) {
+    char *end;
+    CPU_ZERO(cpus);
+    while (*str) {
+      long first = strtol(str, &end, 10);
+      if (end == str)
+        break;
+      long last = first;
+      if (*end == '-')
+        last = strtol(end + 1, &end, 10);
+      for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+        CPU_SET(cpu, cpus);
+      str = (*end == ',') ? end + 1 : end;
+    }
+  }
+
+}
+#endif
 
 void ReactorFactory::initialize(uint16_t reactor_count) {
   lock_guard<mutex> lock(ms_mutex);
@@ -73,12 +110,106 @@ void ReactorFactory::initialize(uint16_t reactor_count) {
       Config::properties->get_bool("Comm.UsePoll"))
     use_poll = true;
 
+  if (Config::properties->has("Comm.UseIoUring") &&
+      Config::properties->get_bool("Comm.UseIoUring"))
+    use_io_uring = true;
+
+  if (use_io_uring && !use_poll) {
+#if defined(HT_WITH_IO_URING)
+    // Multishot receive needs Linux 6.0
+    if (System::os_info().version_major < 6) {
+      HT_WARN("io_uring reactor requires Linux 6.0 or later, using epoll");
+      use_io_uring = false;
+    }
+    else if (!IoUring::supported()) {
+      HT_WARN("io_uring setup failed, using epoll");
+      use_io_uring = false;
+    }
+#else
+    HT_WARN("Built without io_uring support, using epoll");
+    use_io_uring = false;
+#endif
+  }
+  else
+    use_io_uring = false;
+
+  if (Config::properties->has("Comm.ReusePort") &&
+      Config::properties->get_bool("Comm.ReusePort"))
+    reuse_port = true;
+
+  if (Config::properties->has("Comm.ReactorAffinity")) {
+    String value = Config::properties->get_str("Comm.ReactorAffinity");
+    if (value == "core")
+      affinity = Affinity::CORE;
+    else if (value == "node")
+      affinity = Affinity::NODE;
+    else if (value != "none")
+      HT_WARNF("Unrecognized value for Comm.ReactorAffinity: %s",
+               value.c_str());
+  }
+
   for (uint16_t i=0; i<=reactor_count; i++) {
     reactor = make_shared<Reactor>();
     ms_reactors.push_back(reactor);
     rrunner.set_reactor(reactor);
-    ms_threads.create_thread(rrunner);
+    ms_reactor_threads.push_back(ms_threads.create_thread(rrunner));
   }
+
+  if (affinity != Affinity::NONE)
+    set_affinity();
+}
+
+void ReactorFactory::set_affinity() {
+#if defined(__linux__)
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    HT_WARNF("sched_getaffinity() failure: %s", strerror(errno));
+    return;
+  }
+
+  // Each entry holds the allowed CPUs of one pinning unit
+  vector<cpu_set_t> units;
+
+  if (affinity == Affinity::NODE) {
+    for (int node=0; ; node++) {
+      String fname = format("/sys/devices/system/node/node%d/cpulist", node);
+      if (!FileUtils::exists(fname))
+        break;
+      cpu_set_t cpus;
+      parse_cpu_list(FileUtils::file_to_string(fname).c_str(), &cpus);
+      CPU_AND(&cpus, &cpus, &allowed);
+      if (CPU_COUNT(&cpus))
+        units.push_back(cpus);
+    }
+    if (units.empty())
+      units.push_back(allowed);
+  }
+  else {
+    for (int cpu=0; cpu<CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        units.push_back(cpus);
+      }
+    }
+  }
+
+  if (units.empty())
+    return;
+
+  // Timer reactor (last) is left unpinned
+  for (size_t i=0; i+1<ms_reactor_threads.size(); i++) {
+    cpu_set_t &cpus = units[i % units.size()];
+    int ret = pthread_setaffinity_np(ms_reactor_threads[i]->native_handle(),
+                                     sizeof(cpus), &cpus);
+    if (ret != 0)
+      HT_WARNF("pthread_setaffinity_np() failure: %s", strerror(ret));
+    else if (verbose)
+      HT_INFOF("Pinned reactor %d to %d CPU(s) of unit %d", (int)i,
+               (int)CPU_COUNT(&cpus), (int)(i % units.size()));
+  }
+#endif
 }
 
 void ReactorFactory::destroy() {
@@ -87,6 +218,7 @@ void ReactorFactory::destroy() {
     ms_reactors[i]->poll_loop_interrupt();
   ms_threads.join_all();
   ms_reactors.clear();
+  ms_reactor_threads.clear();
   ReactorRunner::handler_map = 0;
 }
 
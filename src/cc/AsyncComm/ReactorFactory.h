@@ -53,13 +53,30 @@ namespace Hypertable {
 
   public:
 
+    /// CPU affinity of I/O reactor threads
+    enum class Affinity {
+      /// Reactor threads may run on any CPU
+      NONE,
+      /// Each reactor thread is pinned to one CPU, round-robin
+      CORE,
+      /// Each reactor thread is pinned to the CPUs of one NUMA node,
+      /// round-robin
+      NODE
+    };
+
     /** Initializes I/O reactors.  This method creates and initializes
      * <code>reactor_count</code> reactors, plus an additional dedicated timer
      * reactor.  It also initializes the #use_poll member based on the
      * <code>Comm.UsePoll</code> property and sets the #ms_epollet
      * ("edge triggered") flag to <i>false</i> if running on Linux version older
      * than 2.6.17.  It also allocates a HandlerMap and initializes
-     * ReactorRunner::handler_map to point to it.
+     * ReactorRunner::handler_map to point to it.  The #reuse_port and
+     * #affinity members can be enabled with the <code>Comm.ReusePort</code>
+     * and <code>Comm.ReactorAffinity</code> properties.  The I/O reactor
+     * threads are pinned to CPUs according to #affinity.  If the
+     * <code>Comm.UseIoUring</code> property is set, #use_io_uring is set
+     * to <i>true</i> when built with <code>io_uring</code> support and the
+     * running kernel (6.0 or later) supports it.
      * @param reactor_count number of reactor threads to create
      */
     static void initialize(uint16_t reactor_count);
@@ -83,6 +100,13 @@ namespace Hypertable {
       reactor = ms_reactors[ms_next_reactor++ % (ms_reactors.size() - 1)];
     }
 
+    /** Returns the number of I/O reactors (not counting the timer reactor).
+     * @return Number of I/O reactors
+     */
+    static size_t io_reactor_count() {
+      return ms_reactors.empty() ? 0 : ms_reactors.size() - 1;
+    }
+
     /** This method returns the timer reactor.
      * @param reactor Smart pointer reference to returned Reactor
      */
@@ -106,17 +130,38 @@ namespace Hypertable {
     // Use POSIX poll() as polling mechanism
     static bool use_poll;
 
+    /// Use <code>io_uring</code> as polling mechanism (Linux only)
+    static bool use_io_uring;
+
     /// Set to <i>true</i> if this process is acting as "Proxy Master"
     static bool proxy_master;
 
     /// Verbose mode
     static bool verbose;
 
+    /// Give each I/O reactor its own <code>SO_REUSEPORT</code> listen socket
+    /// in Comm::listen, and keep accepted connections on that reactor
+    static bool reuse_port;
+
+    /// CPU affinity of I/O reactor threads
+    static Affinity affinity;
+
   private:
 
+    /** Pins I/O reactor threads to CPUs according to #affinity.  Only the
+     * CPUs in the affinity mask of the process are used.  NUMA nodes are read
+     * from <code>/sys/devices/system/node</code>; if they can't be read, all
+     * CPUs are considered one node.  Does nothing on platforms other than
+     * Linux.
+     */
+    static void set_affinity();
+
     /// Mutex to serialize calls to #initialize
     static std::mutex ms_mutex;
 
+    /// Reactor threads, in the same order as #ms_reactors
+    static std::vector<boost::thread *> ms_reactor_threads;
+
     /// Atomic integer used for round-robin assignment of reactors
     static std::atomic<int> ms_next_reactor;
 
@@ -144,6 +144,13 @@ void ReactorRunner::operator()() {
     return;
   }
 
+#if defined(HT_WITH_IO_URING)
+  if (ReactorFactory::use_io_uring) {
+    ring_loop(dispatch_delay);
+    return;
+  }
+#endif
+
 #if defined(__linux__)
   struct epoll_event events[256];
 
@@ -308,6 +315,18 @@ ReactorRunner::cleanup_and_remove_handlers(std::set<IOHandler *> &handlers) {
 
     m_reactor->cancel_requests(handler);
 
+#if defined(HT_WITH_IO_URING)
+    if (ReactorFactory::use_io_uring) {
+      if (handler->ring_draining())
+        continue;
+      m_reactor->ring_forget(handler);
+      // Handler is purged once its last operation completes
+      if (handler->ring_drain())
+        handler_map->purge_handler(handler);
+      continue;
+    }
+#endif
+
     if (ReactorFactory::use_poll)
       m_reactor->remove_poll_interest(handler->get_sd());
     else {
@@ -335,3 +354,124 @@ ReactorRunner::cleanup_and_remove_handlers(std::set<IOHandler *> &handlers) {
     handler_map->purge_handler(handler);
   }
 }
+
+
+#if defined(HT_WITH_IO_URING)
+
+void ReactorRunner::ring_loop(uint32_t dispatch_delay) {
+  IoUring *ring = m_reactor->ring.get();
+  std::set<IOHandler *> removed_handlers;
+  std::vector<IOHandler *> updates;
+  PollTimeout timeout;
+  bool did_delay = false;
+  ClockT::time_point arrival_time;
+  bool got_arrival_time = false;
+  io_uring_cqe *cqe;
+  int n;
+
+  m_reactor->set_ring_thread();
+  ring_arm_interrupt();
+
+  while (true) {
+
+    m_reactor->get_ring_updates(updates);
+    for (auto handler : updates)
+      handler->ring_arm();
+
+    if ((n = ring->submit_and_wait(timeout.get_timespec())) < 0)
+      break;
+
+    if (record_arrival_time)
+      got_arrival_time = false;
+
+    if (dispatch_delay)
+      did_delay = false;
+
+    m_reactor->get_removed_handlers(removed_handlers);
+
+    while ((cqe = ring->peek_cqe()) != nullptr) {
+      uint64_t user_data = cqe->user_data;
+      int res = cqe->res;
+      unsigned flags = cqe->flags;
+      ring->cqe_seen();
+
+      if (user_data == IoUring::INTERNAL_USER_DATA) {
+        if (res < 0)
+          HT_ERRORF("io_uring buffer update failed - %s", strerror(-res));
+        continue;
+      }
+
+      int op = (int)(user_data & IOHandler::RING_OP_MASK);
+
+      if (op == IOHandler::RING_CANCEL)
+        continue;
+
+      if (op == IOHandler::RING_INTERRUPT) {
+        char buf[8];
+        errno = 0;
+        if (FileUtils::recv(m_reactor->interrupt_sd(), buf, 8) == -1 &&
+            errno != EAGAIN && errno != EINTR) {
+          HT_ERRORF("recv(interrupt_sd) failed - %s", strerror(errno));
+          exit(EXIT_FAILURE);
+        }
+        if ((flags & IORING_CQE_F_MORE) == 0)
+          ring_arm_interrupt();
+        continue;
+      }
+
+      IOHandler *handler =
+        (IOHandler *)(uintptr_t)(user_data & ~IOHandler::RING_OP_MASK);
+      bool done = handler->ring_op_done(op, flags);
+      uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+      const uint8_t *buf = (flags & IORING_CQE_F_BUFFER) ?
+        ring->buffer(bid) : 0;
+
+      if (handler->ring_draining()) {
+        // Purge deferred by cleanup_and_remove_handlers()
+        if (handler->ring_idle())
+          handler_map->purge_handler(handler);
+      }
+      else if (removed_handlers.count(handler) == 0 && res != -ECANCELED) {
+        bool input = op == IOHandler::RING_RECV ||
+          op == IOHandler::RING_POLL_IN;
+        // dispatch delay for testing
+        if (dispatch_delay && !did_delay && input) {
+          this_thread::sleep_for(chrono::milliseconds((int)dispatch_delay));
+          did_delay = true;
+        }
+        if (record_arrival_time && !got_arrival_time && input) {
+          arrival_time = ClockT::now();
+          got_arrival_time = true;
+        }
+        if (handler->handle_ring_event(op, res, buf, arrival_time))
+          removed_handlers.insert(handler);
+        else if (done)
+          handler->ring_arm();
+      }
+
+      if (buf)
+        ring->recycle_buffer(bid);
+    }
+
+    if (!removed_handlers.empty())
+      cleanup_and_remove_handlers(removed_handlers);
+    m_reactor->handle_timeouts(timeout);
+    if (shutdown)
+      return;
+  }
+
+  if (!shutdown)
+    HT_ERRORF("io_uring_enter() failed : %s", strerror(-n));
+}
+
+
+void ReactorRunner::ring_arm_interrupt() {
+  io_uring_sqe *sqe = m_reactor->ring->get_sqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = m_reactor->interrupt_sd();
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->poll32_events = POLLIN;
+  sqe->user_data = IOHandler::RING_INTERRUPT;
+}
+
+#endif // HT_WITH_IO_URING
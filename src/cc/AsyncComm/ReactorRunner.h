@@ -80,6 +80,21 @@ namespace Hypertable {
      */
     void cleanup_and_remove_handlers(std::set<IOHandler *> &handlers);
 
+#if defined(HT_WITH_IO_URING)
+    /** Polling loop for <code>io_uring</code>.
+     * Each iteration arms the operations requested with
+     * Reactor#ring_update, submits them and waits for completions with a
+     * single <code>io_uring_enter()</code> call, and then dispatches the
+     * completions to the handlers.  Provided receive buffers are handed back
+     * to the kernel as soon as their completion has been handled.
+     * @param dispatch_delay Delay before dispatching input events (testing)
+     */
+    void ring_loop(uint32_t dispatch_delay);
+
+    /// Arms multishot poll on the reactor interrupt socket
+    void ring_arm_interrupt();
+#endif
+
     ReactorPtr m_reactor; //!< Smart pointer to reactor state object
   };
   /** @}*/
@@ -36,6 +36,7 @@
 
 #include <boost/thread/thread.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <cstdio>
@@ -45,6 +46,7 @@
 #include <queue>
 #include <string>
 #include <thread>
+#include <vector>
 
 extern "C" {
 #include <netdb.h>
@@ -52,6 +54,9 @@ extern "C" {
 #include <pthread.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
 }
 
 using namespace Hypertable;
@@ -64,10 +69,18 @@ namespace {
   const int DEFAULT_TIMEOUT = 10000;
   const char *usage[] = {
     "usage: sampleClient [OPTIONS] <input-file>",
+    "       sampleClient [OPTIONS] --connections=<n>",
     "",
     "OPTIONS:",
+    "  --connections=<n>  Measure request latency over <n> concurrent",
+    "                  connections instead of echoing an input file.  Each",
+    "                  connection is made from its own client process and",
+    "                  issues one request at a time.  (TCP only)",
     "  --host=<name>   Specifies the host to connect to (default = localhost)",
+    "  --io-uring      Use io_uring reactor instead of epoll (Linux only)",
     "  --port=<n>      Specifies the port to connect to (default = 11255)",
+    "  --requests=<n>  Requests per connection in latency mode (default=1000)",
+    "  --size=<n>      Request payload size in latency mode (default=64)",
     "  --recv-addr=<addr>  Let the server connect to us by listening for",
     "                  connection request on <addr> (host:port).  The address",
     "                  that the server is connecting from should be the same",
@@ -79,7 +92,9 @@ namespace {
     "",
     "This is a sample program to test the AsyncComm library.  It establishes",
     "a connection with the sampleServer and sends each line of the input file",
-    "to the server.  Each reply from the server is echoed to stdout.",
+    "to the server.  Each reply from the server is echoed to stdout.  In",
+    "latency mode, the request round-trip latency percentiles over all",
+    "connections are printed instead.",
     (const char *)0
   };
   bool g_verbose = false;
@@ -234,6 +249,182 @@ public:
 
 
 
+namespace {
+
+  /**
+   * Runs one latency mode connection.  Once connected, writes a byte to
+   * <code>ready_fd</code> and waits for <code>start_fd</code> to be closed by
+   * the parent, so that all connections start issuing requests at the same
+   * time.  Then sends <code>requests</code> requests one at a time and writes
+   * the round-trip latency of each in microseconds to <code>out_fd</code>.
+   */
+  int run_latency_client(const InetAddr &addr, time_t timeout, int requests,
+                         size_t size, int ready_fd, int start_fd, int out_fd) {
+    ReactorFactory::initialize(1);
+    Comm *comm = Comm::instance();
+    DispatchHandlerPtr dhp = make_shared<ResponseHandlerTCP>();
+    ResponseHandlerTCP *resp_handler = static_cast<ResponseHandlerTCP *>(dhp.get());
+    int error;
+
+    if ((error = comm->connect(addr, dhp)) != Error::OK) {
+      HT_ERRORF("Comm::connect error - %s", Error::get_text(error));
+      return 1;
+    }
+    if (!resp_handler->wait_for_connection())
+      return 1;
+
+    char c = 0;
+    while (write(ready_fd, &c, 1) < 0 && errno == EINTR)
+      ;
+    close(ready_fd);
+    while (read(start_fd, &c, 1) < 0 && errno == EINTR)
+      ;
+
+    string payload(size, 'x');
+    CommHeader header;
+    EventPtr event_ptr;
+    vector<uint32_t> latencies;
+    latencies.reserve(requests);
+
+    for (int i=0; i<requests; i++) {
+      CommBufPtr cbp(new CommBuf(header, encoded_length_str16(payload)));
+      cbp->append_str16(payload);
+      auto start = chrono::steady_clock::now();
+      if ((error = comm->send_request(addr, timeout, cbp, resp_handler))
+          != Error::OK) {
+        HT_ERRORF("Comm::send_request returned '%s'", Error::get_text(error));
+        return 1;
+      }
+      if (!resp_handler->get_response(event_ptr))
+        return 1;
+      auto elapsed = chrono::steady_clock::now() - start;
+      latencies.push_back(chrono::duration_cast<chrono::microseconds>(elapsed).count());
+    }
+
+    const char *ptr = (const char *)latencies.data();
+    size_t remain = latencies.size() * sizeof(uint32_t);
+    while (remain) {
+      ssize_t nwritten = write(out_fd, ptr, remain);
+      if (nwritten < 0) {
+        if (errno == EINTR)
+          continue;
+        return 1;
+      }
+      ptr += nwritten;
+      remain -= nwritten;
+    }
+    return 0;
+  }
+
+  /**
+   * Measures request latency over <code>connections</code> concurrent
+   * connections.  Since Comm holds one connection per remote address, each
+   * connection is run in its own child process (see run_latency_client).
+   * Latency percentiles over all requests are printed to stdout.
+   */
+  int run_latency_test(const InetAddr &addr, time_t timeout, int connections,
+                       int requests, size_t size) {
+    int ready_pipe[2];
+    int start_pipe[2];
+    vector<int> out_fds;
+    vector<pid_t> pids;
+
+    if (pipe(ready_pipe) < 0 || pipe(start_pipe) < 0) {
+      HT_ERRORF("pipe() failure - %s", strerror(errno));
+      return 1;
+    }
+
+    for (int i=0; i<connections; i++) {
+      int out_pipe[2];
+      if (pipe(out_pipe) < 0) {
+        HT_ERRORF("pipe() failure - %s", strerror(errno));
+        return 1;
+      }
+      pid_t pid = fork();
+      if (pid < 0) {
+        HT_ERRORF("fork() failure - %s", strerror(errno));
+        return 1;
+      }
+      if (pid == 0) {
+        close(ready_pipe[0]);
+        close(start_pipe[1]);
+        close(out_pipe[0]);
+        for (int fd : out_fds)
+          close(fd);
+        _exit(run_latency_client(addr, timeout, requests, size, ready_pipe[1],
+                                 start_pipe[0], out_pipe[1]));
+      }
+      close(out_pipe[1]);
+      out_fds.push_back(out_pipe[0]);
+      pids.push_back(pid);
+    }
+
+    // Wait until all connections are established (or their client exited),
+    // then start them together
+    close(ready_pipe[1]);
+    char buf[256];
+    ssize_t nread;
+    while ((nread = read(ready_pipe[0], buf, sizeof(buf))) > 0 ||
+           (nread < 0 && errno == EINTR))
+      ;
+    close(ready_pipe[0]);
+    close(start_pipe[0]);
+    auto start = chrono::steady_clock::now();
+    close(start_pipe[1]);
+
+    vector<uint32_t> latencies;
+    for (int fd : out_fds) {
+      vector<char> data;
+      while ((nread = read(fd, buf, sizeof(buf))) > 0 ||
+             (nread < 0 && errno == EINTR)) {
+        if (nread > 0)
+          data.insert(data.end(), buf, buf + nread);
+      }
+      close(fd);
+      const uint32_t *ptr = (const uint32_t *)data.data();
+      latencies.insert(latencies.end(), ptr,
+                       ptr + data.size() / sizeof(uint32_t));
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int failed = 0;
+    for (pid_t pid : pids) {
+      int status;
+      if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+          WEXITSTATUS(status) != 0)
+        failed++;
+    }
+
+    if (latencies.empty()) {
+      HT_ERROR("No requests completed");
+      return 1;
+    }
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+      return latencies[min(latencies.size() - 1,
+                           (size_t)(p * latencies.size()))];
+    };
+    double sum = 0;
+    for (uint32_t latency : latencies)
+      sum += latency;
+
+    cout << "connections=" << connections << " requests=" << latencies.size()
+         << " failed-connections=" << failed << endl;
+    cout << "throughput=" << (size_t)(latencies.size() / elapsed) << " req/s"
+         << endl;
+    cout << "latency (us): mean=" << (size_t)(sum / latencies.size())
+         << " p50=" << percentile(0.5) << " p90=" << percentile(0.9)
+         << " p99=" << percentile(0.99) << " p99.9=" << percentile(0.999)
+         << " max=" << latencies.back() << endl;
+
+    return failed ? 1 : 0;
+  }
+
+}
+
+
+
 /**
  * main function
  */
@@ -256,6 +447,9 @@ int main(int argc, char **argv) {
   const char *str;
   CommAddress udp_send_addr;
   sockaddr_in inet_addr;
+  int connections = 0;
+  int requests = 1000;
+  size_t size = 64;
 
   Config::init(0, 0);
 
@@ -264,8 +458,6 @@ int main(int argc, char **argv) {
   if (argc == 1)
     Usage::dump_and_exit(usage);
 
-  ReactorFactory::initialize(1);
-
   for (int i=1; i<argc; i++) {
     if (!strncmp(argv[i], "--host=", 7))
       host = &argv[i][7];
@@ -288,18 +480,32 @@ int main(int argc, char **argv) {
     else if (!strcmp(argv[i], "--verbose")) {
       g_verbose = true;
     }
+    else if (!strncmp(argv[i], "--connections=", 14))
+      connections = atoi(&argv[i][14]);
+    else if (!strncmp(argv[i], "--requests=", 11))
+      requests = atoi(&argv[i][11]);
+    else if (!strncmp(argv[i], "--size=", 7))
+      size = (size_t)atoi(&argv[i][7]);
+    else if (!strcmp(argv[i], "--io-uring"))
+      ReactorFactory::use_io_uring = true;
     else if (in_file == 0)
       in_file = argv[i];
     else
       Usage::dump_and_exit(usage);
   }
 
-  if (in_file == 0)
+  if (in_file == 0 && connections == 0)
     Usage::dump_and_exit(usage);
 
   if (!InetAddr::initialize(&addr, host, port))
     exit(EXIT_FAILURE);
 
+  // Forks client processes, so must run before the reactors are started
+  if (connections > 0)
+    return run_latency_test(addr, timeout, connections, requests, size);
+
+  ReactorFactory::initialize(1);
+
   comm = Comm::instance();
 
   ifstream myfile(in_file);
@@ -69,6 +69,9 @@ namespace {
     "  --port=<n>      Specifies the port to listen on (default=11255)",
     "  --app-queue     Use an application queue for handling requests",
     "  --reactors=<n>  Specifies the number of reactors (default=1)",
+    "  --reuse-port    Give each reactor its own SO_REUSEPORT listen socket",
+    "  --affinity=<a>  Pin reactors to CPUs: none, core or node (default=none)",
+    "  --io-uring      Use io_uring reactors instead of epoll (Linux only)",
     "  --delay=<ms>    Milliseconds to wait before echoing message (default=0)",
     "  --udp           Operate in UDP mode instead of TCP",
     "  --verbose,-v    Generate verbose output",
@@ -251,6 +254,16 @@ int main(int argc, char **argv) {
     }
     else if (!strncmp(argv[i], "--reactors=", 11))
       reactor_count = atoi(&argv[i][11]);
+    else if (!strcmp(argv[i], "--reuse-port"))
+      ReactorFactory::reuse_port = true;
+    else if (!strcmp(argv[i], "--affinity=core"))
+      ReactorFactory::affinity = ReactorFactory::Affinity::CORE;
+    else if (!strcmp(argv[i], "--affinity=node"))
+      ReactorFactory::affinity = ReactorFactory::Affinity::NODE;
+    else if (!strcmp(argv[i], "--affinity=none"))
+      ReactorFactory::affinity = ReactorFactory::Affinity::NONE;
+    else if (!strcmp(argv[i], "--io-uring"))
+      ReactorFactory::use_io_uring = true;
     else if (!strncmp(argv[i], "--delay=", 8))
       g_delay = atoi(&argv[i][8]);
     else if (!strcmp(argv[i], "--udp"))
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <AsyncComm/CommBuf.h>
+#include <AsyncComm/GatherBuffer.h>
+
+#include <Common/Logger.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Hypertable;
+
+namespace {
+
+  /// Sends extended data (or all data if <code>whole</code> is set) of
+  /// <code>cbuf</code> into <code>output</code> using partial writes of
+  /// random length over at most <code>max_iovecs</code> segments at a time
+  void drain(CommBuf &cbuf, int max_iovecs, string &output,
+             bool whole=false) {
+    vector<struct iovec> vec(max_iovecs);
+    bool done = false;
+    while (!done) {
+      ssize_t towrite = 0;
+      int count = whole ?
+        cbuf.fill_iovec(vec.data(), max_iovecs, &towrite) :
+        cbuf.fill_ext_iovec(vec.data(), max_iovecs, &towrite);
+      HT_ASSERT(count > 0 && count <= max_iovecs);
+      size_t nwritten = (random() % 4) ? 1 + random() % towrite : towrite;
+      size_t remaining = nwritten;
+      for (int i=0; i<count && remaining; i++) {
+        size_t n = std::min(remaining, vec[i].iov_len);
+        output.append((const char *)vec[i].iov_base, n);
+        remaining -= n;
+      }
+      done = whole ? cbuf.advance(nwritten) : cbuf.advance_ext(nwritten);
+    }
+  }
+
+}
+
+int main(int argc, char **argv) {
+  srandom(1);
+
+  for (int iteration=0; iteration<200; iteration++) {
+    // Segments referencing independently pinned memory
+    GatherBufferPtr gather = make_shared<GatherBuffer>();
+    size_t nsegments = 1 + random() % 300;
+    for (size_t i=0; i<nsegments; i++) {
+      size_t len = random() % 5000;
+      shared_ptr<uint8_t> mem(new uint8_t [len+1], default_delete<uint8_t[]>());
+      for (size_t j=0; j<len; j++)
+        mem.get()[j] = (uint8_t)random();
+      gather->add(mem.get(), len);
+      gather->add_pin(mem);
+    }
+
+    string expected(gather->length(), '\0');
+    gather->flatten((uint8_t *)&expected[0]);
+
+    CommHeader header(1);
+    CommBuf cbuf(header, 0, gather);
+    HT_ASSERT(cbuf.header.total_len == header.encoded_length() + gather->length());
+
+    if (gather->length() == 0) {
+      HT_ASSERT(cbuf.advance_ext(0));
+      continue;
+    }
+
+    string output;
+    drain(cbuf, 1 + random() % 64, output);
+    HT_ASSERT(output == expected);
+
+    // Resending starts over from the beginning
+    cbuf.write_header_and_reset();
+    output.clear();
+    drain(cbuf, 64, output);
+    HT_ASSERT(output == expected);
+
+    // Header and extended data sent together
+    cbuf.write_header_and_reset();
+    output.clear();
+    drain(cbuf, 1 + random() % 64, output, true);
+    HT_ASSERT(output == string((const char *)cbuf.data.base, cbuf.data.size)
+              + expected);
+  }
+
+  cout << "SUCCESS" << endl;
+  return 0;
+}
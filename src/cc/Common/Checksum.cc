@@ -19,7 +19,7 @@
 
 /** @file
  * Implementation of checksum routines.
- * This file implements the fletcher32 checksum algorithm.
+ * This file implements the fletcher32 and CRC32C checksum algorithms.
  */
 
 #include "Compat.h"
@@ -27,6 +27,8 @@
 #include <zlib.h>
 #include "Checksum.h"
 
+#include <cstring>
+
 namespace Hypertable {
 
 #define HT_F32_DO1(buf,i) \
@@ -83,6 +85,98 @@ fletcher32(const void *data8, size_t len8) {
   return (sum2 << 16) | sum1;
 }
 
+namespace {
+
+  /// CRC32C polynomial (reversed)
+  const uint32_t CRC32C_POLY = 0x82f63b78;
+
+  /// Lookup tables for slicing-by-8 CRC32C
+  struct Crc32cTables {
+    Crc32cTables() {
+      for (uint32_t i=0; i<256; i++) {
+        uint32_t crc = i;
+        for (int j=0; j<8; j++)
+          crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        table[0][i] = crc;
+      }
+      for (uint32_t i=0; i<256; i++)
+        for (int k=1; k<8; k++)
+          table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xff];
+    }
+    uint32_t table[8][256];
+  };
+
+  const Crc32cTables crc32c_tables;
+
+  uint32_t crc32c_sw(uint32_t crc, const uint8_t *p, size_t len) {
+    const uint32_t (*t)[256] = crc32c_tables.table;
+    while (len && ((uintptr_t)p & 7)) {
+      crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+      len--;
+    }
+    while (len >= 8) {
+      uint32_t lo, hi;
+      memcpy(&lo, p, 4);
+      memcpy(&hi, p+4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      lo = __builtin_bswap32(lo);
+      hi = __builtin_bswap32(hi);
+#endif
+      lo ^= crc;
+      crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^
+        t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+        t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+        t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+      p += 8;
+      len -= 8;
+    }
+    while (len--)
+      crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+    return crc;
+  }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+  __attribute__((target("sse4.2")))
+  uint32_t crc32c_hw(uint32_t crc, const uint8_t *p, size_t len) {
+    while (len && ((uintptr_t)p & 7)) {
+      crc = __builtin_ia32_crc32qi(crc, *p++);
+      len--;
+    }
+    uint64_t crc64 = crc;
+    while (len >= 8) {
+      uint64_t word;
+      memcpy(&word, p, 8);
+      crc64 = __builtin_ia32_crc32di(crc64, word);
+      p += 8;
+      len -= 8;
+    }
+    crc = (uint32_t)crc64;
+    while (len--)
+      crc = __builtin_ia32_crc32qi(crc, *p++);
+    return crc;
+  }
+
+  typedef uint32_t (*Crc32cFunction)(uint32_t, const uint8_t *, size_t);
+
+  Crc32cFunction select_crc32c() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") ? crc32c_hw : crc32c_sw;
+  }
+
+#endif
+
+}
+
+uint32_t crc32c(const void *data, size_t len) {
+#if defined(__x86_64__) && defined(__GNUC__)
+  static const Crc32cFunction crc32c_function = select_crc32c();
+  return ~crc32c_function(~0U, (const uint8_t *)data, len);
+#else
+  return ~crc32c_sw(~0U, (const uint8_t *)data, len);
+#endif
+}
+
 } // namespace Hypertable
 
 /* vim: et sw=2
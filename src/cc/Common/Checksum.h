@@ -19,7 +19,7 @@
 
 /** @file
  * Implementation of checksum routines.
- * This file implements the fletcher32 checksum algorithm.
+ * This file implements the fletcher32 and CRC32C checksum algorithms.
  */
 
 #ifndef HYPERTABLE_CHECKSUM_H
@@ -41,6 +41,19 @@ namespace Hypertable {
    */
   extern uint32_t fletcher32(const void *data, size_t len);
 
+  /** Compute CRC32C (Castagnoli) checksum for arbitrary data.  On x86-64
+   * processors that support SSE4.2 the checksum is computed with the
+   * <code>crc32</code> instruction, eight bytes at a time.  Otherwise a
+   * table driven slicing-by-8 implementation is used.  Both produce the
+   * same result, so data checksummed on one machine can be verified on
+   * any other.
+   *
+   * @param data Pointer to the input data
+   * @param len Input data length in bytes
+   * @return The calculated checksum
+   */
+  extern uint32_t crc32c(const void *data, size_t len);
+
   /** @}*/
 
 } // namespace Hypertable
@@ -170,6 +170,15 @@ void DefaultPolicy::init_options() {
     ("Comm.DispatchDelay", i32()->default_value(0), "[TESTING ONLY] "
         "Delay dispatching of read requests by this number of milliseconds")
     ("Comm.UsePoll", boo()->default_value(false), "Use POSIX poll() interface")
+    ("Comm.UseIoUring", boo()->default_value(false), "Use io_uring interface "
+        "with multishot receive, falls back to epoll if unsupported (Linux "
+        "6.0 or later)")
+    ("Comm.ReusePort", boo()->default_value(false), "Give each reactor its own "
+        "SO_REUSEPORT listen socket and handle accepted connections on the "
+        "accepting reactor (Linux only)")
+    ("Comm.ReactorAffinity", str()->default_value("none"), "Pin reactor "
+        "threads to CPUs: none, core (one CPU per reactor) or node (CPUs of "
+        "one NUMA node per reactor)")
     ("Hypertable.Cluster.Name", str(),
      "Name of cluster used in Monitoring UI and admin notification messages")
     ("Hypertable.Verbose", boo()->default_value(false),
@@ -268,6 +277,17 @@ void DefaultPolicy::init_options() {
         "Number of local broker worker threads created")
     ("FsBroker.Local.Reactors", i32(),
         "Number of local broker communication reactor threads created")
+    ("FsBroker.Local.UseIoUring", boo()->default_value(false),
+        "Submit appends and preads to an io_uring and send responses as "
+        "they complete, instead of doing blocking i/o in worker threads "
+        "(Linux only, falls back to blocking i/o if unsupported)")
+    ("FsBroker.Local.IoUringEntries", i32()->default_value(256),
+        "Size of local broker io_uring submission queue, which is also the "
+        "maximum number of appends and preads in flight")
+    ("FsBroker.Local.InProcess", boo()->default_value(false),
+        "Access files under the local broker root directory directly from "
+        "the RangeServer process instead of through the FS broker (only "
+        "valid when the FS broker is the local broker on the same host)")
     ("FsBroker.Host", str()->default_value("localhost"),
         "Host on which the FS broker is running (read by clients only)")
     ("FsBroker.Port", i16()->default_value(15863),
@@ -283,6 +303,12 @@ void DefaultPolicy::init_options() {
         " when logs exceed this size limit")
     ("Hyperspace.Client.Datagram.SendPort", i16()->default_value(0),
         "Client UDP send port for keepalive packets")
+    ("Hyperspace.Client.Cache.Enable", boo()->default_value(true),
+        "Cache attributes and directory listings of nodes opened with "
+        "notifying event masks")
+    ("Hyperspace.Client.Cache.MaxWatches", i32()->default_value(1024),
+        "Maximum number of watch handles a session opens to cache attributes "
+        "read by pathname (0 disables)")
     ("Hyperspace.LogGc.Interval", i32()->default_value(60000), "Check for unused BerkeleyDB "
         "log files after this much time")
     ("Hyperspace.LogGc.MaxUnusedLogs", i32()->default_value(200), "Number of unused BerkeleyDB "
@@ -419,6 +445,18 @@ void DefaultPolicy::init_options() {
         "CellStores in which merges will be considered")
     ("Hypertable.RangeServer.CellStore.Merge.RunLengthThreshold", i32()->default_value(5),
         "Trigger a merge if an adjacent run of merge candidate CellStores exceeds this length")
+    ("Hypertable.RangeServer.CellStore.BlockIndex.PrefixLayout",
+        boo()->default_value(true), "Keep an Eytzinger-ordered copy of fixed-"
+        "width key prefixes alongside each CellStore block index to speed up "
+        "block lookups")
+    ("Hypertable.RangeServer.CellStore.CompressionWorkers",
+        i32()->default_value(4), "Number of threads, shared by all CellStores "
+        "being written, used to compress CellStore blocks (0 compresses "
+        "inline)")
+    ("Hypertable.RangeServer.CellStore.PrefetchBlocks",
+        i32()->default_value(4), "Number of blocks following a block that "
+        "misses the block cache which a scan reads along with it in one "
+        "vectored read (0 disables prefetch)")
     ("Hypertable.RangeServer.CellStore.DefaultBlockSize",
         i32()->default_value(64*KiB), "Default block size for cell stores")
     ("Hypertable.RangeServer.Data.DefaultReplication",
@@ -434,13 +472,23 @@ void DefaultPolicy::init_options() {
     ("Hypertable.RangeServer.IgnoreClockSkewErrors",
         boo()->default_value(false), "Ignore clock skew errors")
     ("Hypertable.RangeServer.CommitInterval", i32()->default_value(50),
-     "Default minimum group commit interval in milliseconds")
+     "Maximum time in milliseconds between checks for group commit batches "
+     "that are due")
     ("Hypertable.RangeServer.BlockCache.Compressed", boo()->default_value(true),
         "Controls whether or not block cache stores compressed blocks")
     ("Hypertable.RangeServer.BlockCache.MinMemory", i64()->default_value(0),
         "Minimum size of block cache")
     ("Hypertable.RangeServer.BlockCache.MaxMemory", i64()->default_value(-1),
         "Maximum (target) size of block cache")
+    ("Hypertable.RangeServer.BlockCache.Shards", i32()->default_value(16),
+        "Number of independently locked block cache shards")
+    ("Hypertable.RangeServer.BlockCache.MinShardMemory",
+        i64()->default_value(16*M), "Minimum memory limit of a block cache "
+        "shard; the shard count is reduced for small caches so that large "
+        "blocks remain cacheable")
+    ("Hypertable.RangeServer.BlockCache.ProtectedPercentage",
+        i32()->default_value(80), "Percentage of block cache reserved for "
+        "blocks that have been accessed more than once (0 for plain LRU)")
     ("Hypertable.RangeServer.QueryCache.EnableMutexStatistics",
      boo()->default_value(true), "Enable query cache mutex statistics")
     ("Hypertable.RangeServer.QueryCache.MaxMemory", i64()->default_value(50*M),
@@ -474,15 +522,21 @@ void DefaultPolicy::init_options() {
     ("Hypertable.RangeServer.CommitLog.PruneThreshold.Max.MemoryPercentage",
         i32()->default_value(50), "Upper threshold in terms of % RAM for "
         "amount of outstanding commit log before pruning")
+    ("Hypertable.RangeServer.CommitLog.ReplayThreads", i32()->default_value(4),
+        "Number of threads used to decompress, and number of threads used to "
+        "apply, commit log blocks during recovery replay")
     ("Hypertable.RangeServer.CommitLog.RollLimit", i64()->default_value(100*M),
         "Roll commit log after this many bytes")
     ("Hypertable.RangeServer.CommitLog.Compressor",
         str()->default_value("quicklz"),
-       "Commit log compressor to use (zlib, lzo, quicklz, snappy, bmz, none)")
+       "Commit log compressor to use (zlib, lzo, quicklz, snappy, zstd, lz4, bmz, none)")
     ("Hypertable.RangeServer.Testing.MaintenanceNeeded.PauseInterval", i32()->default_value(0),
         "TESTING:  After update, if range needs maintenance, pause for this number of milliseconds")
     ("Hypertable.RangeServer.UpdateCoalesceLimit", i64()->default_value(5*M),
         "Amount of update data to coalesce into single commit log sync")
+    ("Hypertable.RangeServer.UpdatePipeline.UserLanes", i32()->default_value(1),
+        "Number of independent update pipelines, each with its own commit "
+        "log, that USER table updates are spread over (keyed by range)")
     ("Hypertable.RangeServer.Failover.FlushLimit.PerRange",
      i32()->default_value(10*M), "Amount of updates (bytes) accumulated for a "
         "single range to trigger a replay buffer flush")
@@ -496,13 +550,19 @@ void DefaultPolicy::init_options() {
     ("Hypertable.CommitLog.RollLimit", i64()->default_value(100*M),
         "Roll commit log after this many bytes")
     ("Hypertable.CommitLog.Compressor", str()->default_value("quicklz"),
-        "Commit log compressor to use (zlib, lzo, quicklz, snappy, bmz, none)")
+        "Commit log compressor to use (zlib, lzo, quicklz, snappy, zstd, lz4, bmz, none)")
+    ("Hypertable.CommitLog.MaxOutstandingAppends", i32()->default_value(8),
+        "Maximum number of commit log appends in flight at once")
     ("Hypertable.CommitLog.SkipErrors", boo()->default_value(false),
         "Skip over any corruption encountered in the commit log")
     ("Hypertable.RangeServer.Scanner.Ttl", i32()->default_value(1800*K),
         "Number of milliseconds of inactivity before destroying scanners")
     ("Hypertable.RangeServer.Scanner.BufferSize", i64()->default_value(1*M),
         "Size of transfer buffer for scan results")
+    ("Hypertable.RangeServer.Scanner.ZeroCopyThreshold",
+        i32()->default_value(4*K), "Values of at least this many bytes are "
+        "sent from block cache or cell cache memory without being copied into "
+        "the transfer buffer (0 to always copy)")
     ("Hypertable.RangeServer.Timer.Interval", i32()->default_value(20000),
         "Timer interval in milliseconds (reaping scanners, purging commit logs, etc.)")
     ("Hypertable.RangeServer.Maintenance.Interval", i32()->default_value(30000),
@@ -114,6 +114,23 @@ namespace Hypertable {
       
     };
 
+    /// File extent for vectored reads
+    class Extent {
+    public:
+      /// Default constructor.
+      Extent() { }
+      /// Constructor.
+      /// @param off File offset
+      /// @param len Length in bytes
+      Extent(uint64_t off, uint32_t len) : offset(off), length(len) { }
+      /// File offset
+      uint64_t offset {};
+      /// Length in bytes
+      uint32_t length {};
+      /// Extent data, set by decode_response_preadv()
+      const void *data {};
+    };
+
     virtual ~Filesystem() { }
 
     /** Opens a file asynchronously.  Issues an open file request.  The caller
@@ -380,6 +397,30 @@ namespace Hypertable {
     virtual void decode_response_pread(EventPtr &event, const void **buffer,
                                        uint64_t *offset, uint32_t *length) = 0;
 
+    /** Reads several extents of a file asynchronously.  Issues a preadv
+     * request which reads all of the extents and returns them together in a
+     * single response.  The caller will get notified of successful
+     * completion or error via the given dispatch handler and can decode the
+     * response with decode_response_preadv().  EOF is indicated by a short
+     * extent.
+     *
+     * @param fd The open file descriptor
+     * @param extents Extents to read
+     * @param verify_checksum Tells filesystem to perform checksum verification
+     * @param handler The dispatch handler
+     */
+    virtual void preadv(int fd, const std::vector<Extent> &extents,
+                        bool verify_checksum, DispatchHandler *handler) = 0;
+
+    /// Decodes the response from a preadv request.
+    /// The <code>data</code> member of each extent is set to point into the
+    /// payload of <code>event</code>, which must be kept alive for as long as
+    /// the data is accessed.
+    /// @param event A reference to the response event
+    /// @param extents Vector to hold the extents read
+    virtual void decode_response_preadv(EventPtr &event,
+                                        std::vector<Extent> &extents) = 0;
+
     /** Creates a directory asynchronously.  Issues a mkdirs request which
      * creates a directory, including all its missing parents.  The caller
      * will get notified of successful completion or error via the given
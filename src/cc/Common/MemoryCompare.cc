@@ -0,0 +1,133 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+ */
+
+/// @file
+/// Definitions for vectorized memory comparison.
+/// This file contains the scalar, SSE2, and AVX2 implementations of
+/// mismatch() and the runtime selection between them.
+
+#include <Common/Compat.h>
+
+#include "MemoryCompare.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace Hypertable;
+
+namespace {
+
+  /// Returns offset of first differing byte of two differing 8-byte words
+  inline size_t first_difference(uint64_t wa, uint64_t wb) {
+    // Words were loaded big-endian, so the first byte is the most significant
+    return __builtin_clzll(wa ^ wb) >> 3;
+  }
+
+  const char *selected_name = "scalar";
+
+  MemoryCompare::MismatchFunc select() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      selected_name = "avx2";
+      return MemoryCompare::mismatch_avx2;
+    }
+    selected_name = "sse2";
+    return MemoryCompare::mismatch_sse2;
+#else
+    selected_name = "scalar";
+    return MemoryCompare::mismatch_scalar;
+#endif
+  }
+
+  /// Initial value of MemoryCompare::mismatch.  Concurrent first calls may
+  /// each store the selection, which is harmless since they store the same
+  /// value.
+  size_t mismatch_resolve(const uint8_t *a, const uint8_t *b, size_t len) {
+    MemoryCompare::mismatch = select();
+    return MemoryCompare::mismatch(a, b, len);
+  }
+
+}
+
+MemoryCompare::MismatchFunc MemoryCompare::mismatch = mismatch_resolve;
+
+
+const char *MemoryCompare::implementation() {
+  if (mismatch == mismatch_resolve)
+    mismatch = select();
+  return selected_name;
+}
+
+
+size_t MemoryCompare::mismatch_scalar(const uint8_t *a, const uint8_t *b,
+                                      size_t len) {
+  size_t i = 0;
+  for (; i+8 <= len; i += 8) {
+    uint64_t wa = load_be64(a+i), wb = load_be64(b+i);
+    if (wa != wb)
+      return i + first_difference(wa, wb);
+  }
+  for (; i<len; i++) {
+    if (a[i] != b[i])
+      return i;
+  }
+  return len;
+}
+
+#if defined(__x86_64__)
+
+size_t MemoryCompare::mismatch_sse2(const uint8_t *a, const uint8_t *b,
+                                    size_t len) {
+  size_t i = 0;
+  for (; i+16 <= len; i += 16) {
+    __m128i va = _mm_loadu_si128((const __m128i *)(a+i));
+    __m128i vb = _mm_loadu_si128((const __m128i *)(b+i));
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+    if (mask != 0xFFFF)
+      return i + __builtin_ctz(~mask);
+  }
+  return i + mismatch_scalar(a+i, b+i, len-i);
+}
+
+
+__attribute__((target("avx2")))
+size_t MemoryCompare::mismatch_avx2(const uint8_t *a, const uint8_t *b,
+                                    size_t len) {
+  size_t i = 0;
+  for (; i+32 <= len; i += 32) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(a+i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b+i));
+    unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+    if (mask != 0xFFFFFFFF)
+      return i + __builtin_ctz(~mask);
+  }
+  if (i+16 <= len) {
+    __m128i va = _mm_loadu_si128((const __m128i *)(a+i));
+    __m128i vb = _mm_loadu_si128((const __m128i *)(b+i));
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+    if (mask != 0xFFFF)
+      return i + __builtin_ctz(~mask);
+    i += 16;
+  }
+  return i + mismatch_scalar(a+i, b+i, len-i);
+}
+
+#endif
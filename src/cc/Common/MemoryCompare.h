@@ -0,0 +1,124 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+ */
+
+/// @file
+/// Declarations for vectorized memory comparison.
+/// This file contains declarations for mismatch(), which locates the first
+/// differing byte of two buffers using the widest vector instructions
+/// supported by the CPU, and compare(), a memcmp() replacement built on it.
+
+#ifndef Common_MemoryCompare_h
+#define Common_MemoryCompare_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Hypertable {
+
+  /// @addtogroup Common
+  /// @{
+
+  /// Vectorized memory comparison.
+  namespace MemoryCompare {
+
+    /// Function returning offset of first differing byte.
+    typedef size_t (*MismatchFunc)(const uint8_t *a, const uint8_t *b,
+                                   size_t len);
+
+    /// Finds first differing byte, 8 bytes at a time.
+    /// @param a First buffer
+    /// @param b Second buffer
+    /// @param len Number of bytes to compare
+    /// @return Offset of first differing byte, or <code>len</code> if the
+    /// buffers are equal
+    extern size_t mismatch_scalar(const uint8_t *a, const uint8_t *b,
+                                  size_t len);
+
+#if defined(__x86_64__)
+    /// Finds first differing byte, 16 bytes at a time (SSE2).
+    /// @see mismatch_scalar()
+    extern size_t mismatch_sse2(const uint8_t *a, const uint8_t *b,
+                                size_t len);
+
+    /// Finds first differing byte, 32 bytes at a time (AVX2).
+    /// Must only be called if the CPU supports AVX2.
+    /// @see mismatch_scalar()
+    extern size_t mismatch_avx2(const uint8_t *a, const uint8_t *b,
+                                size_t len);
+#endif
+
+    /// Best mismatch implementation for this CPU.
+    /// Initially points to a resolver that selects the implementation on
+    /// first use, so it is safe to call during static initialization.
+    extern MismatchFunc mismatch;
+
+    /// Returns name of implementation selected for #mismatch.
+    /// @return Implementation name ("avx2", "sse2", or "scalar")
+    extern const char *implementation();
+
+    /// Loads eight bytes as a big-endian integer.
+    /// @param p Pointer to bytes (need not be aligned)
+    /// @return Big-endian value of bytes
+    inline uint64_t load_be64(const uint8_t *p) {
+      uint64_t v;
+      memcpy(&v, p, 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      v = __builtin_bswap64(v);
+#endif
+      return v;
+    }
+
+    /// Compares two buffers.
+    /// Buffers of up to 16 bytes are compared inline as two big-endian
+    /// words; longer buffers are handed to #mismatch.  The sign of the result
+    /// matches memcmp().
+    /// @param a First buffer
+    /// @param b Second buffer
+    /// @param len Number of bytes to compare
+    /// @return Negative, zero, or positive if <code>a</code> is less than,
+    /// equal to, or greater than <code>b</code>
+    inline int compare(const uint8_t *a, const uint8_t *b, size_t len) {
+      if (len <= 16) {
+        if (len >= 8) {
+          uint64_t wa = load_be64(a), wb = load_be64(b);
+          if (wa != wb)
+            return wa < wb ? -1 : 1;
+          // Overlapping load of last eight bytes
+          wa = load_be64(a + len - 8);
+          wb = load_be64(b + len - 8);
+          return wa == wb ? 0 : (wa < wb ? -1 : 1);
+        }
+        for (size_t i=0; i<len; i++) {
+          if (a[i] != b[i])
+            return (int)a[i] - (int)b[i];
+        }
+        return 0;
+      }
+      size_t i = mismatch(a, b, len);
+      return i == len ? 0 : (int)a[i] - (int)b[i];
+    }
+
+  }
+
+  /// @}
+
+}
+
+#endif // Common_MemoryCompare_h
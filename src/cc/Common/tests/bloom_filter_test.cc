@@ -118,25 +118,51 @@ struct BloomFilterTest {
     cout << "  false positive rate: expected "<< fp_prob <<", got "
          << false_positives / nfalses << endl;
 
+    test_with_checksum<HashT>(label, BasicBloomFilterWithChecksum<HashT>::STANDARD);
+    test_with_checksum<HashT>(label + " blocked",
+                              BasicBloomFilterWithChecksum<HashT>::BLOCKED);
+  }
+
+  /// Reports probe latency and false positive rate of <code>filter</code>
+  template <class FilterT>
+  void probe(FilterT *filter) {
+    size_t nitems = items.size() / 2;
+    size_t nfalses = items.size() - nitems;
+    double false_positives = 0.;
+
+    MEASURE("  true positives", for (size_t i = 0; i < nitems; ++i)
+      HT_ASSERT(filter->may_contain(items[i].data)), nitems);
+
+    Stopwatch w;
+    for (size_t i = nitems, n = items.size(); i < n; ++i)
+      if (filter->may_contain(items[i].data))
+        ++false_positives;
+    w.stop();
+
+    cout << "  false positives: " << nfalses / w.elapsed() << "/s, "
+         << w.elapsed() * 1e9 / nfalses << " ns/probe" << endl;
+    cout << "  false positive rate: expected "<< fp_prob <<", got "
+         << false_positives / nfalses << endl;
+    HT_ASSERT(false_positives / nfalses < 2 * fp_prob);
+  }
+
+  template <class HashT>
+  void test_with_checksum(const String &label,
+      typename BasicBloomFilterWithChecksum<HashT>::Encoding encoding) {
+    size_t nitems = items.size() / 2;
+
     /*** With Checksum ***/
 
-    BasicBloomFilterWithChecksum<HashT> *filter_with_checksum = new BasicBloomFilterWithChecksum<HashT>(nitems, fp_prob);
+    BasicBloomFilterWithChecksum<HashT> *filter_with_checksum = new BasicBloomFilterWithChecksum<HashT>(nitems, fp_prob, encoding);
 
     cout << label << " (with checksum)" << endl;
 
     MEASURE("  insert", for (size_t i = 0; i < nitems; ++i)
       filter_with_checksum->insert(items[i].data), nitems);
 
-    MEASURE("  true positives", for (size_t i = 0; i < nitems; ++i)
-      HT_ASSERT(filter_with_checksum->may_contain(items[i].data)), nitems);
-
-    MEASURE("  false positives",
-      for (size_t i = nitems, n = items.size(); i < n; ++i)
-        if (filter_with_checksum->may_contain(items[i].data))
-          ++false_positives, nfalses);
-
-    cout << "  false positive rate: expected "<< fp_prob <<", got "
-         << false_positives / nfalses << endl;
+    probe(filter_with_checksum);
+    cout << "  size: " << filter_with_checksum->total_size() << " bytes, "
+         << filter_with_checksum->get_num_hashes() << " hashes" << endl;
 
     StaticBuffer sbuf;
     filter_with_checksum->serialize(sbuf);
@@ -153,25 +179,18 @@ struct BloomFilterTest {
 
     /*** With Checksum after Deserialization ***/
 
-    filter_with_checksum = new BasicBloomFilterWithChecksum<HashT>(items_estimate, items_actual, length, num_hashes);
+    filter_with_checksum = new BasicBloomFilterWithChecksum<HashT>(items_estimate, items_actual, length, num_hashes, encoding);
 
     memcpy(filter_with_checksum->base(), serialized_buf.base, serialized_buf.size);
 
-    cout << label << " (with checksum deserialized)" << endl;
+    String filename = "bloom_filter_test";
+    filter_with_checksum->validate(filename);
 
-    MEASURE("  true positives", for (size_t i = 0; i < nitems; ++i)
-      HT_ASSERT(filter_with_checksum->may_contain(items[i].data)), nitems);
-
-    MEASURE("  false positives",
-      for (size_t i = nitems, n = items.size(); i < n; ++i)
-        if (filter_with_checksum->may_contain(items[i].data))
-          ++false_positives, nfalses);
+    cout << label << " (with checksum deserialized)" << endl;
 
-    cout << "  false positive rate: expected "<< fp_prob <<", got "
-         << false_positives / nfalses << endl;
+    probe(filter_with_checksum);
 
     delete filter_with_checksum;
-
   }
 
   void run() {
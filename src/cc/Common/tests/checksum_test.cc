@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include <Common/Compat.h>
+#include <Common/Checksum.h>
+#include <Common/Init.h>
+#include <Common/Logger.h>
+#include <Common/Stopwatch.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+struct MyPolicy : Config::Policy {
+  static void init_options() {
+    cmdline_desc("Usage: %s [Options]\n\n"
+                 "Checks CRC32C against known values and reports the\n"
+                 "throughput of fletcher32 and crc32c over block sized\n"
+                 "buffers.\n\nOptions").add_options()
+      ("total", i32()->default_value(256*M),
+       "bytes to checksum for each block size")
+      ;
+  }
+};
+
+typedef Meta::list<MyPolicy, DefaultPolicy> Policies;
+
+#define MEASURE(_label_, _size_, _code_, _n_) do { \
+  Stopwatch w; _code_; w.stop(); \
+  cout << _label_ << " (" << (_size_) << " bytes): " \
+       << ((_n_) / w.elapsed()) / (1024*1024) << " MB/s" << endl; \
+} while (0)
+
+void check_known_values() {
+  // Check values from RFC 3720 appendix B.4
+  uint8_t buf[32];
+  HT_ASSERT(crc32c("123456789", 9) == 0xe3069283);
+  memset(buf, 0, sizeof(buf));
+  HT_ASSERT(crc32c(buf, sizeof(buf)) == 0x8a9136aa);
+  memset(buf, 0xff, sizeof(buf));
+  HT_ASSERT(crc32c(buf, sizeof(buf)) == 0x62a8ab43);
+  for (size_t i=0; i<sizeof(buf); i++)
+    buf[i] = i;
+  HT_ASSERT(crc32c(buf, sizeof(buf)) == 0x46dd794e);
+  HT_ASSERT(crc32c(buf, 0) == 0);
+}
+
+void check_alignment(const vector<uint8_t> &data) {
+  // Unaligned starts and odd lengths must not change the result
+  vector<uint8_t> copy(data.size() + 8);
+  for (size_t offset=0; offset<8; offset++) {
+    memcpy(&copy[offset], data.data(), data.size());
+    for (size_t len=0; len<67; len++)
+      HT_ASSERT(crc32c(&copy[offset], len) == crc32c(data.data(), len));
+  }
+}
+
+} // local namespace
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    check_known_values();
+
+    size_t total = get_i32("total");
+    vector<uint8_t> data(1024*1024);
+    for (auto &c : data)
+      c = random();
+
+    check_alignment(data);
+
+    uint32_t sum = 0;   // keep the optimizer from dropping the loops
+    for (size_t size : { 4*1024, 64*1024, 1024*1024 }) {
+      size_t n = total / size;
+      MEASURE("fletcher32", size, for (size_t i=0; i<n; i++)
+        sum += fletcher32(data.data(), size), n*size);
+      MEASURE("crc32c", size, for (size_t i=0; i<n; i++)
+        sum += crc32c(data.data(), size), n*size);
+    }
+    cout << "sum=" << sum << endl;
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
@@ -25,6 +25,7 @@
 #include "OpenFileMap.h"
 #include "Response/Callback/Open.h"
 #include "Response/Callback/Read.h"
+#include "Response/Callback/Preadv.h"
 #include "Response/Callback/Append.h"
 #include "Response/Callback/Length.h"
 #include "Response/Callback/Readdir.h"
@@ -34,6 +35,7 @@
 #include <Common/StaticBuffer.h>
 
 #include <memory>
+#include <vector>
 
 namespace Hypertable {
 
@@ -140,6 +142,21 @@ namespace Lib {
     virtual void pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
                        uint32_t amount, bool verify_checksum) = 0;
 
+    /**
+     * Read several extents from file, returning them in one response.
+     * Brokers that do not implement it respond with
+     * Error::NOT_IMPLEMENTED, in which case clients fall back to pread.
+     * @param fd Open fd to read from.
+     * @param extents Extents to read.
+     * @param verify_checksum Verify checksum of data read
+     * @param cb
+     */
+    virtual void preadv(Response::Callback::Preadv *cb, uint32_t fd,
+                        const std::vector<Filesystem::Extent> &extents,
+                        bool verify_checksum) {
+      cb->error(Error::NOT_IMPLEMENTED, "preadv");
+    }
+
 
     /**
      * Make a directory hierarcy, If the parent dirs are not,
@@ -39,6 +39,7 @@
 #include "Request/Parameters/Mkdirs.h"
 #include "Request/Parameters/Open.h"
 #include "Request/Parameters/Pread.h"
+#include "Request/Parameters/Preadv.h"
 #include "Request/Parameters/Readdir.h"
 #include "Request/Parameters/Read.h"
 #include "Request/Parameters/Remove.h"
@@ -51,6 +52,7 @@
 #include "Response/Parameters/Exists.h"
 #include "Response/Parameters/Length.h"
 #include "Response/Parameters/Open.h"
+#include "Response/Parameters/Preadv.h"
 #include "Response/Parameters/Read.h"
 #include "Response/Parameters/Readdir.h"
 #include "Response/Parameters/Status.h"
@@ -717,6 +719,46 @@ void Client::decode_response_pread(EventPtr &event, const void **buffer,
   decode_response_read(event, buffer, offset, length);
 }
 
+
+void
+Client::preadv(int32_t fd, const std::vector<Extent> &extents,
+               bool verify_checksum, DispatchHandler *handler) {
+  CommHeader header(Request::Handler::Factory::FUNCTION_PREADV);
+  header.gid = fd;
+  Request::Parameters::Preadv params(fd, extents, verify_checksum);
+  CommBufPtr cbuf( new CommBuf(header, params.encoded_length()) );
+  params.encode(cbuf->get_data_ptr_address());
+
+  try { send_message(cbuf, handler); }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error sending preadv request for %d extents "
+               "on FS fd %d", (int)extents.size(), (int)fd);
+  }
+}
+
+void Client::decode_response_preadv(EventPtr &event,
+                                    std::vector<Extent> &extents) {
+  int error = Protocol::response_code(event);
+  if (error != Error::OK)
+    HT_THROW(error, Protocol::string_format_message(event));
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Preadv params;
+  params.decode(&ptr, &remain);
+  extents.swap(params.get_extents());
+
+  for (Extent &extent : extents) {
+    if (remain < (size_t)extent.length)
+      HT_THROWF(Error::RESPONSE_TRUNCATED, "%lu < %lu", (Lu)remain,
+                (Lu)extent.length);
+    extent.data = ptr;
+    ptr += extent.length;
+    remain -= extent.length;
+  }
+}
+
 void Client::mkdirs(const String &name, DispatchHandler *handler) {
   CommHeader header(Request::Handler::Factory::FUNCTION_MKDIRS);
   Request::Parameters::Mkdirs params(name);
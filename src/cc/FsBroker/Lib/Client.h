@@ -159,6 +159,11 @@ namespace Lib {
     void decode_response_pread(EventPtr &event, const void **buffer,
                                uint64_t *offset, uint32_t *length) override;
 
+    void preadv(int32_t fd, const std::vector<Extent> &extents,
+                bool verify_checksum, DispatchHandler *handler) override;
+    void decode_response_preadv(EventPtr &event,
+                                std::vector<Extent> &extents) override;
+
     void mkdirs(const String &name, DispatchHandler *handler) override;
     void mkdirs(const String &name) override;
 
@@ -0,0 +1,891 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for LocalFilesystem.
+/// This file contains definitions for LocalFilesystem, an in-process
+/// implementation of the local broker's filesystem.
+
+#include <Common/Compat.h>
+
+#include "LocalFilesystem.h"
+#include "LocalIo.h"
+
+#include "Response/Parameters/Append.h"
+#include "Response/Parameters/Exists.h"
+#include "Response/Parameters/Length.h"
+#include "Response/Parameters/Open.h"
+#include "Response/Parameters/Preadv.h"
+#include "Response/Parameters/Read.h"
+#include "Response/Parameters/Readdir.h"
+#include "Response/Parameters/Status.h"
+
+#include <AsyncComm/DispatchHandler.h>
+#include <AsyncComm/Protocol.h>
+
+#include <Common/Error.h>
+#include <Common/FileUtils.h>
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+#include <dirent.h>
+#include <fcntl.h>
+#if defined(__sun__)
+#include <sys/fcntl.h>
+#endif
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace Hypertable::FsBroker::Lib;
+using namespace std;
+
+namespace {
+
+  /// Allocates MESSAGE event with a payload of <code>len</code> bytes
+  EventPtr make_event(size_t len) {
+    EventPtr event = make_shared<Event>(Event::MESSAGE);
+    event->payload = new uint8_t [len];
+    event->payload_len = len;
+    return event;
+  }
+
+  /// Delivers successful response carrying <code>params</code>
+  void respond(DispatchHandler *handler, const Serializable &params) {
+    EventPtr event = make_event(4 + params.encoded_length());
+    uint8_t *ptr = (uint8_t *)event->payload;
+    Serialization::encode_i32(&ptr, Error::OK);
+    params.encode(&ptr);
+    handler->handle(event);
+  }
+
+  /// Delivers successful response without parameters
+  void respond_ok(DispatchHandler *handler) {
+    EventPtr event = make_event(4);
+    uint8_t *ptr = (uint8_t *)event->payload;
+    Serialization::encode_i32(&ptr, Error::OK);
+    handler->handle(event);
+  }
+
+  /// Delivers error response for exception <code>e</code>
+  void respond_error(DispatchHandler *handler, Exception &e) {
+    String msg = e.what();
+    if (msg.length() >= 32767)
+      msg.resize(32766);
+    EventPtr event = make_event(4 + Serialization::encoded_length_str16(msg));
+    uint8_t *ptr = (uint8_t *)event->payload;
+    Serialization::encode_i32(&ptr, e.code());
+    Serialization::encode_str16(&ptr, msg);
+    handler->handle(event);
+  }
+
+  /// Throws exception if response event holds an error
+  void check_response(EventPtr &event) {
+    int error = Protocol::response_code(event);
+    if (error != Error::OK)
+      HT_THROW(error, Protocol::string_format_message(event));
+  }
+
+}
+
+
+LocalFilesystem::OpenFile::~OpenFile() {
+  ::close(fd);
+}
+
+
+LocalFilesystem::LocalFilesystem(PropertiesPtr &cfg) {
+  m_no_removal = cfg->get_bool("FsBroker.DisableFileRemoval");
+  m_directio = local_directio_enabled(cfg);
+  m_rootdir = local_root_directory(cfg,
+                                   cfg->get_str("FsBroker.Local.Root",
+                                                "fs/local"));
+
+  if (!FileUtils::mkdirs(m_rootdir))
+    HT_THROWF(Error::FSBROKER_IO_ERROR, "Unable to create root directory %s",
+              m_rootdir.c_str());
+
+  HT_INFOF("Using in-process local filesystem rooted at %s",
+           m_rootdir.c_str());
+}
+
+
+LocalFilesystem::~LocalFilesystem() {
+  lock_guard<mutex> lock(m_mutex);
+  m_files.clear();
+}
+
+
+void
+LocalFilesystem::open(const String &name, uint32_t flags,
+                      DispatchHandler *handler) {
+  try {
+    respond(handler, Response::Parameters::Open(open(name, flags)));
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+int LocalFilesystem::open(const String &name, uint32_t flags) {
+  HT_DEBUGF("open file='%s' flags=%u", name.c_str(), flags);
+  return open_file(name, O_RDONLY, flags);
+}
+
+
+int
+LocalFilesystem::open_buffered(const String &name, uint32_t flags,
+                               uint32_t buf_size, uint32_t outstanding,
+                               uint64_t start_offset, uint64_t end_offset) {
+  HT_ASSERT((flags & Filesystem::OPEN_FLAG_DIRECTIO) == 0 ||
+            (HT_IO_ALIGNED(buf_size) &&
+             HT_IO_ALIGNED(start_offset) &&
+             HT_IO_ALIGNED(end_offset)));
+  try {
+    // Reads are of arbitrary size, so direct i/o is not used
+    int32_t fd = open_file(name, O_RDONLY, flags & ~OPEN_FLAG_DIRECTIO);
+    OpenFilePtr file = get_file(fd);
+    if (start_offset && lseek(file->fd, start_offset, SEEK_SET) == (off_t)-1) {
+      int saved_errno = errno;
+      close(fd);
+      HT_THROWF(errno_to_error(saved_errno), "lseek(%llu) failed - %s",
+                (Llu)start_offset, strerror(saved_errno));
+    }
+    file->end_offset = end_offset;
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(file->fd, start_offset,
+                  end_offset ? end_offset - start_offset : 0,
+                  POSIX_FADV_SEQUENTIAL);
+#endif
+    return fd;
+  }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error opening buffered FS file=%s buf_size=%u "
+               "outstanding=%u start_offset=%llu end_offset=%llu", name.c_str(),
+               buf_size, outstanding, (Llu)start_offset, (Llu)end_offset);
+  }
+}
+
+
+void LocalFilesystem::decode_response_open(EventPtr &event, int32_t *fd) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Open params;
+  params.decode(&ptr, &remain);
+  *fd = params.get_fd();
+}
+
+
+void
+LocalFilesystem::create(const String &name, uint32_t flags, int32_t bufsz,
+                        int32_t replication, int64_t blksz,
+                        DispatchHandler *handler) {
+  try {
+    respond(handler, Response::Parameters::Open(create(name, flags, bufsz,
+                                                       replication, blksz)));
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+int
+LocalFilesystem::create(const String &name, uint32_t flags, int32_t bufsz,
+                        int32_t replication, int64_t blksz) {
+  int oflags = O_WRONLY | O_CREAT;
+
+  HT_DEBUGF("create file='%s' flags=%u bufsz=%d replication=%d blksz=%lld",
+            name.c_str(), flags, bufsz, (int)replication, (Lld)blksz);
+
+  if (flags & Filesystem::OPEN_FLAG_OVERWRITE)
+    oflags |= O_TRUNC;
+  else
+    oflags |= O_APPEND;
+
+  return open_file(name, oflags, flags);
+}
+
+
+void LocalFilesystem::decode_response_create(EventPtr &event, int32_t *fd) {
+  decode_response_open(event, fd);
+}
+
+
+void LocalFilesystem::close(int32_t fd, DispatchHandler *handler) {
+  try {
+    close(fd);
+    respond_ok(handler);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::close(int32_t fd) {
+  OpenFilePtr file;
+  HT_DEBUGF("close fd=%d", (int)fd);
+  {
+    lock_guard<mutex> lock(m_mutex);
+    auto iter = m_files.find(fd);
+    if (iter != m_files.end()) {
+      file = iter->second;
+      m_files.erase(iter);
+    }
+  }
+  // Wait for commands in progress on the file
+  if (file)
+    lock_guard<mutex> lock(file->mutex);
+}
+
+
+void LocalFilesystem::read(int32_t fd, size_t amount, DispatchHandler *handler) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    lock_guard<mutex> lock(file->mutex);
+    off_t offset = lseek(file->fd, 0, SEEK_CUR);
+    if (offset == (off_t)-1)
+      HT_THROWF(errno_to_error(errno), "lseek failed: fd=%d offset=0 SEEK_CUR"
+                " - %s", file->fd, strerror(errno));
+    Response::Parameters::Read params(offset, 0);
+    size_t header_len = 4 + params.encoded_length();
+    EventPtr event = make_event(header_len + amount);
+    uint8_t *ptr = (uint8_t *)event->payload;
+    size_t nread = read_file(file.get(), ptr + header_len, amount, offset);
+    if (lseek(file->fd, offset + nread, SEEK_SET) == (off_t)-1)
+      HT_THROWF(errno_to_error(errno), "lseek failed: fd=%d offset=%llu - %s",
+                file->fd, (Llu)(offset + nread), strerror(errno));
+    event->payload_len = header_len + nread;
+    Serialization::encode_i32(&ptr, Error::OK);
+    Response::Parameters::Read(offset, nread).encode(&ptr);
+    handler->handle(event);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+size_t LocalFilesystem::read(int32_t fd, void *dst, size_t amount) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    lock_guard<mutex> lock(file->mutex);
+    off_t offset = lseek(file->fd, 0, SEEK_CUR);
+    if (offset == (off_t)-1)
+      HT_THROWF(errno_to_error(errno), "lseek failed: fd=%d offset=0 SEEK_CUR"
+                " - %s", file->fd, strerror(errno));
+    if (file->end_offset) {
+      if ((uint64_t)offset >= file->end_offset)
+        return 0;
+      amount = std::min(amount, (size_t)(file->end_offset - offset));
+    }
+    size_t nread = read_file(file.get(), dst, amount, offset);
+    if (lseek(file->fd, offset + nread, SEEK_SET) == (off_t)-1)
+      HT_THROWF(errno_to_error(errno), "lseek failed: fd=%d offset=%llu - %s",
+                file->fd, (Llu)(offset + nread), strerror(errno));
+    return nread;
+  }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error reading %u bytes from FS fd %d",
+               (unsigned)amount, (int)fd);
+  }
+}
+
+
+void LocalFilesystem::decode_response_read(EventPtr &event, const void **buffer,
+                                           uint64_t *offset, uint32_t *length) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Read params;
+  params.decode(&ptr, &remain);
+  *offset = params.get_offset();
+  *length = params.get_amount();
+
+  if (*length == (uint32_t)-1) {
+    *length = 0;
+    return;
+  }
+
+  if (remain < (size_t)*length)
+    HT_THROWF(Error::RESPONSE_TRUNCATED, "%lu < %lu", (Lu)remain, (Lu)*length);
+
+  *buffer = ptr;
+}
+
+
+void LocalFilesystem::append(int32_t fd, StaticBuffer &buffer, Flags flags,
+                             DispatchHandler *handler) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    lock_guard<mutex> lock(file->mutex);
+    off_t offset = lseek(file->fd, 0, SEEK_CUR);
+    if (offset == (off_t)-1)
+      HT_THROWF(errno_to_error(errno), "lseek failed: fd=%d offset=0 SEEK_CUR"
+                " - %s", file->fd, strerror(errno));
+    ssize_t nwritten = FileUtils::write(file->fd, buffer.base, buffer.size);
+    if (nwritten == -1)
+      HT_THROWF(errno_to_error(errno), "write failed: fd=%d offset=%llu "
+                "amount=%u - %s", file->fd, (Llu)offset, (unsigned)buffer.size,
+                strerror(errno));
+    if ((flags == Flags::FLUSH || flags == Flags::SYNC) && fsync(file->fd) != 0)
+      HT_THROWF(errno_to_error(errno), "flush failed: fd=%d - %s", file->fd,
+                strerror(errno));
+    respond(handler, Response::Parameters::Append(offset, nwritten));
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+size_t LocalFilesystem::append(int32_t fd, StaticBuffer &buffer, Flags flags) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    lock_guard<mutex> lock(file->mutex);
+    ssize_t nwritten = FileUtils::write(file->fd, buffer.base, buffer.size);
+    if (nwritten == -1)
+      HT_THROWF(errno_to_error(errno), "write failed: fd=%d amount=%u - %s",
+                file->fd, (unsigned)buffer.size, strerror(errno));
+    if ((flags == Flags::FLUSH || flags == Flags::SYNC) && fsync(file->fd) != 0)
+      HT_THROWF(errno_to_error(errno), "flush failed: fd=%d - %s", file->fd,
+                strerror(errno));
+    if (buffer.size != (size_t)nwritten)
+      HT_THROWF(Error::FSBROKER_IO_ERROR, "tried to append %u bytes but got "
+                "%u", (unsigned)buffer.size, (unsigned)nwritten);
+    return (size_t)nwritten;
+  }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error appending %u bytes to FS fd %d",
+               (unsigned)buffer.size, (int)fd);
+  }
+}
+
+
+void LocalFilesystem::decode_response_append(EventPtr &event, uint64_t *offset,
+                                             uint32_t *length) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Append params;
+  params.decode(&ptr, &remain);
+  *offset = params.get_offset();
+  *length = params.get_amount();
+}
+
+
+void LocalFilesystem::seek(int32_t fd, uint64_t offset,
+                           DispatchHandler *handler) {
+  try {
+    seek(fd, offset);
+    respond_ok(handler);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::seek(int32_t fd, uint64_t offset) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    lock_guard<mutex> lock(file->mutex);
+    if (lseek(file->fd, offset, SEEK_SET) == (off_t)-1)
+      HT_THROWF(errno_to_error(errno), "lseek failed: fd=%d offset=%llu - %s",
+                file->fd, (Llu)offset, strerror(errno));
+  }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error seeking to %llu on FS fd %d",
+               (Llu)offset, (int)fd);
+  }
+}
+
+
+void LocalFilesystem::remove(const String &name, DispatchHandler *handler) {
+  try {
+    remove(name, false);
+    respond_ok(handler);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::remove(const String &name, bool force) {
+  String path = abspath(name);
+
+  HT_INFOF("remove file='%s'", name.c_str());
+
+  if (m_no_removal) {
+    if (!FileUtils::rename(path, path + ".deleted"))
+      HT_THROWF(errno_to_error(errno), "Error removing FS file: %s",
+                name.c_str());
+  }
+  else if (unlink(path.c_str()) == -1) {
+    if (!force || errno != ENOENT)
+      HT_THROWF(errno_to_error(errno), "Error removing FS file: %s - %s",
+                name.c_str(), strerror(errno));
+  }
+}
+
+
+void LocalFilesystem::length(const String &name, bool accurate,
+                             DispatchHandler *handler) {
+  try {
+    respond(handler, Response::Parameters::Length(length(name, accurate)));
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+int64_t LocalFilesystem::length(const String &name, bool accurate) {
+  String path = abspath(name);
+  struct stat statbuf;
+
+  if (stat(path.c_str(), &statbuf) == -1)
+    HT_THROWF(errno_to_error(errno), "Error getting length of FS file: %s - %s",
+              name.c_str(), strerror(errno));
+  return (int64_t)statbuf.st_size;
+}
+
+
+int64_t LocalFilesystem::decode_response_length(EventPtr &event) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Length params;
+  params.decode(&ptr, &remain);
+  return params.get_length();
+}
+
+
+void LocalFilesystem::pread(int32_t fd, size_t len, uint64_t offset,
+                            bool verify_checksum, DispatchHandler *handler) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    Response::Parameters::Read params(offset, len);
+    size_t header_len = 4 + params.encoded_length();
+    EventPtr event = make_event(header_len + len);
+    uint8_t *ptr = (uint8_t *)event->payload;
+    {
+      lock_guard<mutex> lock(file->mutex);
+      if (read_file(file.get(), ptr + header_len, len, offset) != len)
+        HT_THROWF(Error::FSBROKER_IO_ERROR, "pread failed: fd=%d amount=%d "
+                  "offset=%llu - short read", file->fd, (int)len, (Llu)offset);
+    }
+    Serialization::encode_i32(&ptr, Error::OK);
+    params.encode(&ptr);
+    handler->handle(event);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+size_t LocalFilesystem::pread(int32_t fd, void *dst, size_t len,
+                              uint64_t offset, bool verify_checksum) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    lock_guard<mutex> lock(file->mutex);
+    return read_file(file.get(), dst, len, offset);
+  }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Error preading at byte %llu on FS fd %d",
+               (Llu)offset, (int)fd);
+  }
+}
+
+
+void LocalFilesystem::decode_response_pread(EventPtr &event,
+                                            const void **buffer,
+                                            uint64_t *offset,
+                                            uint32_t *length) {
+  decode_response_read(event, buffer, offset, length);
+}
+
+
+void LocalFilesystem::preadv(int32_t fd, const std::vector<Extent> &extents,
+                             bool verify_checksum, DispatchHandler *handler) {
+  try {
+    OpenFilePtr file = get_file(fd);
+    Response::Parameters::Preadv params(extents);
+    std::vector<Extent> &result = params.get_extents();
+    size_t total = 0;
+    for (const Extent &extent : extents)
+      total += extent.length;
+    size_t header_len = 4 + params.encoded_length();
+    EventPtr event = make_event(header_len + total);
+    uint8_t *ptr = (uint8_t *)event->payload;
+    uint8_t *dst = ptr + header_len;
+    {
+      lock_guard<mutex> lock(file->mutex);
+      // Adjacent extents are read with a single pread
+      for (size_t i=0, j; i<result.size(); i=j) {
+        size_t run = result[i].length;
+        for (j=i+1; j<result.size() &&
+               result[j].offset == result[j-1].offset + result[j-1].length; j++)
+          run += result[j].length;
+        size_t nread = read_file(file.get(), dst, run, result[i].offset);
+        dst += nread;
+        for (; i<j; i++) {
+          result[i].length = (uint32_t)std::min((size_t)result[i].length, nread);
+          nread -= result[i].length;
+        }
+      }
+    }
+    event->payload_len = dst - event->payload;
+    Serialization::encode_i32(&ptr, Error::OK);
+    params.encode(&ptr);
+    handler->handle(event);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::decode_response_preadv(EventPtr &event,
+                                             std::vector<Extent> &extents) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Preadv params;
+  params.decode(&ptr, &remain);
+  extents.swap(params.get_extents());
+
+  for (Extent &extent : extents) {
+    if (remain < (size_t)extent.length)
+      HT_THROWF(Error::RESPONSE_TRUNCATED, "%lu < %lu", (Lu)remain,
+                (Lu)extent.length);
+    extent.data = ptr;
+    ptr += extent.length;
+    remain -= extent.length;
+  }
+}
+
+
+void LocalFilesystem::mkdirs(const String &name, DispatchHandler *handler) {
+  try {
+    mkdirs(name);
+    respond_ok(handler);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::mkdirs(const String &name) {
+  HT_DEBUGF("mkdirs dir='%s'", name.c_str());
+  if (!FileUtils::mkdirs(abspath(name)))
+    HT_THROWF(errno_to_error(errno), "Error mkdirs FS directory %s - %s",
+              name.c_str(), strerror(errno));
+}
+
+
+void LocalFilesystem::flush(int32_t fd, DispatchHandler *handler) {
+  try {
+    flush(fd);
+    respond_ok(handler);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::flush(int32_t fd) {
+  sync(fd);
+}
+
+
+void LocalFilesystem::sync(int32_t fd) {
+  HT_DEBUGF("sync fd=%d", (int)fd);
+  OpenFilePtr file = get_file(fd);
+  lock_guard<mutex> lock(file->mutex);
+  if (fsync(file->fd) != 0)
+    HT_THROWF(errno_to_error(errno), "Error syncing FS fd %d - %s", (int)fd,
+              strerror(errno));
+}
+
+
+void LocalFilesystem::rmdir(const String &name, DispatchHandler *handler) {
+  try {
+    rmdir(name, false);
+    respond_ok(handler);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::rmdir(const String &name, bool force) {
+  String path = abspath(name);
+
+  HT_DEBUGF("rmdir dir='%s'", name.c_str());
+
+  if (!FileUtils::exists(path))
+    return;
+
+  if (m_no_removal) {
+    if (!FileUtils::rename(path, path + ".deleted"))
+      HT_THROWF(errno_to_error(errno), "Error removing FS directory: %s",
+                name.c_str());
+    return;
+  }
+
+  boost::system::error_code ec;
+  boost::filesystem::remove_all(path, ec);
+  if (ec)
+    HT_THROWF(Error::FSBROKER_IO_ERROR, "Error removing FS directory: %s - %s",
+              name.c_str(), ec.message().c_str());
+}
+
+
+void LocalFilesystem::readdir(const String &name, DispatchHandler *handler) {
+  try {
+    std::vector<Dirent> listing;
+    readdir(name, listing);
+    respond(handler, Response::Parameters::Readdir(listing));
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::readdir(const String &name,
+                              std::vector<Dirent> &listing) {
+  String absdir = abspath(name);
+  String full_entry_path;
+  struct stat statbuf;
+  struct dirent *dp;
+  Dirent entry;
+
+  HT_DEBUGF("Readdir dir='%s'", name.c_str());
+
+  DIR *dirp = opendir(absdir.c_str());
+  if (dirp == 0)
+    HT_THROWF(errno_to_error(errno), "opendir('%s') failed - %s",
+              absdir.c_str(), strerror(errno));
+
+  listing.clear();
+  errno = 0;
+  while ((dp = ::readdir(dirp)) != 0) {
+    if (dp->d_name[0] != '.' && dp->d_name[0] != 0) {
+      if (m_no_removal) {
+        size_t len = strlen(dp->d_name);
+        if (len > 8 && !strcmp(&dp->d_name[len-8], ".deleted"))
+          continue;
+      }
+      entry.name = dp->d_name;
+      entry.is_dir = dp->d_type == DT_DIR;
+      full_entry_path = absdir + "/" + entry.name;
+      if (stat(full_entry_path.c_str(), &statbuf) == -1) {
+        // Entry may have been removed since it was read
+        if (m_no_removal && errno == ENOENT)
+          continue;
+        int saved_errno = errno;
+        (void)closedir(dirp);
+        HT_THROWF(errno_to_error(saved_errno), "readdir('%s') failed - %s",
+                  absdir.c_str(), strerror(saved_errno));
+      }
+      entry.length = (uint64_t)statbuf.st_size;
+      entry.last_modification_time = statbuf.st_mtime;
+      listing.push_back(entry);
+    }
+    errno = 0;
+  }
+  int saved_errno = errno;
+  (void)closedir(dirp);
+  if (saved_errno)
+    HT_THROWF(errno_to_error(saved_errno), "readdir('%s') failed - %s",
+              absdir.c_str(), strerror(saved_errno));
+}
+
+
+void LocalFilesystem::decode_response_readdir(EventPtr &event,
+                                              std::vector<Dirent> &listing) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Readdir params;
+  params.decode(&ptr, &remain);
+  params.get_listing(listing);
+}
+
+
+void LocalFilesystem::exists(const String &name, DispatchHandler *handler) {
+  try {
+    respond(handler, Response::Parameters::Exists(exists(name)));
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+bool LocalFilesystem::exists(const String &name) {
+  return FileUtils::exists(abspath(name));
+}
+
+
+bool LocalFilesystem::decode_response_exists(EventPtr &event) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Exists params;
+  params.decode(&ptr, &remain);
+  return params.get_exists();
+}
+
+
+void LocalFilesystem::rename(const String &src, const String &dst,
+                             DispatchHandler *handler) {
+  try {
+    rename(src, dst);
+    respond_ok(handler);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+void LocalFilesystem::rename(const String &src, const String &dst) {
+  HT_INFOF("rename %s -> %s", src.c_str(), dst.c_str());
+  if (std::rename(abspath(src).c_str(), abspath(dst).c_str()) != 0)
+    HT_THROWF(errno_to_error(errno), "Error renaming of FS path: %s -> %s - "
+              "%s", src.c_str(), dst.c_str(), strerror(errno));
+}
+
+
+void LocalFilesystem::status(Status &status, Timer *timer) {
+  status.set(Status::Code::OK, "");
+}
+
+
+void LocalFilesystem::decode_response_status(EventPtr &event, Status &status) {
+  check_response(event);
+
+  const uint8_t *ptr = event->payload + 4;
+  size_t remain = event->payload_len - 4;
+
+  Response::Parameters::Status params;
+  params.decode(&ptr, &remain);
+  status = params.status();
+}
+
+
+void LocalFilesystem::debug(int32_t command,
+                            StaticBuffer &serialized_parameters) {
+  HT_THROWF(Error::NOT_IMPLEMENTED, "Unsupported debug command - %d", command);
+}
+
+
+void LocalFilesystem::debug(int32_t command,
+                            StaticBuffer &serialized_parameters,
+                            DispatchHandler *handler) {
+  try {
+    debug(command, serialized_parameters);
+  }
+  catch (Exception &e) {
+    respond_error(handler, e);
+  }
+}
+
+
+String LocalFilesystem::abspath(const String &name) {
+  if (!name.empty() && name[0] == '/')
+    return m_rootdir + name;
+  return m_rootdir + "/" + name;
+}
+
+
+int32_t LocalFilesystem::open_file(const String &name, int oflags,
+                                   uint32_t flags) {
+  String path = abspath(name);
+  bool directio = m_directio && (flags & Filesystem::OPEN_FLAG_DIRECTIO);
+  int local_fd;
+
+  if ((local_fd = local_open(path, oflags, directio)) == -1)
+    HT_THROWF(errno_to_error(errno), "open failed: file='%s' - %s",
+              path.c_str(), strerror(errno));
+
+  int32_t fd = ++m_next_fd;
+
+  HT_DEBUGF("open( %s ) = %d (local=%d)", name.c_str(), (int)fd, local_fd);
+
+  lock_guard<mutex> lock(m_mutex);
+  m_files[fd] = make_shared<OpenFile>(local_fd, directio);
+  return fd;
+}
+
+
+LocalFilesystem::OpenFilePtr LocalFilesystem::get_file(int32_t fd) {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_files.find(fd);
+  if (iter == m_files.end())
+    HT_THROWF(Error::FSBROKER_BAD_FILE_HANDLE, "%d", (int)fd);
+  return iter->second;
+}
+
+
+size_t LocalFilesystem::read_file(OpenFile *file, void *dst, size_t len,
+                                  uint64_t offset) {
+  ssize_t nread = local_pread(file->fd, dst, len, offset, file->directio);
+  if (nread == -1)
+    HT_THROWF(errno_to_error(errno), "pread failed: fd=%d amount=%d "
+              "offset=%llu - %s", file->fd, (int)len, (Llu)offset,
+              strerror(errno));
+  return (size_t)nread;
+}
@@ -0,0 +1,254 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for LocalFilesystem.
+/// This file contains declarations for LocalFilesystem, an in-process
+/// implementation of the local broker's filesystem.
+
+#ifndef FsBroker_Lib_LocalFilesystem_h
+#define FsBroker_Lib_LocalFilesystem_h
+
+#include <Common/Filesystem.h>
+#include <Common/Properties.h>
+#include <Common/Status.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Hypertable {
+namespace FsBroker {
+namespace Lib {
+
+  /// @addtogroup FsBrokerLib
+  /// @{
+
+  /** In-process local filesystem.  Carries out Filesystem commands directly
+   * against the local broker's root directory with <code>pread()</code>,
+   * <code>write()</code>, and <code>fsync()</code> from within the calling
+   * process, instead of sending them over AsyncComm to a separate local
+   * broker process.  File semantics are the same as those of the local
+   * broker (see LocalBroker): root directory and direct i/o properties,
+   * <code>O_APPEND</code>/<code>O_TRUNC</code> creation, <code>fsync()</code>
+   * on FLUSH and SYNC appends, and error codes.
+   *
+   * Asynchronous commands are carried out in the calling thread and their
+   * response is delivered to the dispatch handler before the method returns.
+   * The response event has the same payload format as a broker response, so
+   * it is decoded with the decode_response_* methods.  For <i>pread</i> and
+   * <i>read</i>, file data is read directly into the event payload, which
+   * may be handed off to the block cache without copying.
+   *
+   * Buffered opens (open_buffered()) do not allocate readahead buffers, the
+   * file is read sequentially between the start and end offsets and the
+   * kernel's readahead is relied upon instead.
+   */
+  class LocalFilesystem : public Filesystem {
+  public:
+
+    /** Constructor.  The following properties are read:
+     * <pre>
+     * FsBroker.Local.Root
+     * FsBroker.Local.DirectIO
+     * FsBroker.DisableFileRemoval
+     * Hypertable.DataDirectory
+     * </pre>
+     * If <code>FsBroker.Local.Root</code> is relative (or not set, in which
+     * case <code>fs/local</code> is used) it is taken relative to the
+     * Hypertable data directory.
+     * @param cfg Configuration properties
+     */
+    LocalFilesystem(PropertiesPtr &cfg);
+
+    /// Destructor.  Closes all open files.
+    virtual ~LocalFilesystem();
+
+    void open(const String &name, uint32_t flags, DispatchHandler *handler) override;
+    int open(const String &name, uint32_t flags) override;
+    int open_buffered(const String &name, uint32_t flags, uint32_t buf_size,
+                      uint32_t outstanding, uint64_t start_offset=0,
+                      uint64_t end_offset=0) override;
+    void decode_response_open(EventPtr &event, int32_t *fd) override;
+
+    void create(const String &name, uint32_t flags,
+                int32_t bufsz, int32_t replication,
+                int64_t blksz, DispatchHandler *handler) override;
+    int create(const String &name, uint32_t flags, int32_t bufsz,
+               int32_t replication, int64_t blksz) override;
+    void decode_response_create(EventPtr &event, int32_t *fd) override;
+
+    void close(int32_t fd, DispatchHandler *handler) override;
+    void close(int32_t fd) override;
+
+    void read(int32_t fd, size_t amount, DispatchHandler *handler) override;
+    size_t read(int32_t fd, void *dst, size_t amount) override;
+    void decode_response_read(EventPtr &event, const void **buffer,
+                              uint64_t *offset, uint32_t *length) override;
+
+    void append(int32_t fd, StaticBuffer &buffer, Flags flags,
+                DispatchHandler *handler) override;
+    size_t append(int32_t fd, StaticBuffer &buffer,
+                  Flags flags = Flags::NONE) override;
+    void decode_response_append(EventPtr &event, uint64_t *offset,
+                                uint32_t *length) override;
+
+    void seek(int32_t fd, uint64_t offset, DispatchHandler *handler) override;
+    void seek(int32_t fd, uint64_t offset) override;
+
+    void remove(const String &name, DispatchHandler *handler) override;
+    void remove(const String &name, bool force = true) override;
+
+    void length(const String &name, bool accurate,
+                DispatchHandler *handler) override;
+    int64_t length(const String &name, bool accurate = true) override;
+    int64_t decode_response_length(EventPtr &event) override;
+
+    void pread(int32_t fd, size_t len, uint64_t offset,
+               bool verify_checksum, DispatchHandler *handler) override;
+    size_t pread(int32_t fd, void *dst, size_t len, uint64_t offset,
+                 bool verify_checksum) override;
+    void decode_response_pread(EventPtr &event, const void **buffer,
+                               uint64_t *offset, uint32_t *length) override;
+
+    void preadv(int32_t fd, const std::vector<Extent> &extents,
+                bool verify_checksum, DispatchHandler *handler) override;
+    void decode_response_preadv(EventPtr &event,
+                                std::vector<Extent> &extents) override;
+
+    void mkdirs(const String &name, DispatchHandler *handler) override;
+    void mkdirs(const String &name) override;
+
+    void flush(int32_t fd, DispatchHandler *handler) override;
+    void flush(int32_t fd) override;
+
+    void sync(int32_t fd) override;
+
+    void rmdir(const String &name, DispatchHandler *handler) override;
+    void rmdir(const String &name, bool force = true) override;
+
+    void readdir(const String &name, DispatchHandler *handler) override;
+    void readdir(const String &name, std::vector<Dirent> &listing) override;
+    void decode_response_readdir(EventPtr &event,
+                                 std::vector<Dirent> &listing) override;
+
+    void exists(const String &name, DispatchHandler *handler) override;
+    bool exists(const String &name) override;
+    bool decode_response_exists(EventPtr &event) override;
+
+    void rename(const String &src, const String &dst,
+                DispatchHandler *handler) override;
+    void rename(const String &src, const String &dst) override;
+
+    void status(Status &status, Timer *timer=0) override;
+    void decode_response_status(EventPtr &event, Status &status) override;
+
+    void debug(int32_t command, StaticBuffer &serialized_parameters) override;
+    void debug(int32_t command, StaticBuffer &serialized_parameters,
+               DispatchHandler *handler) override;
+
+  private:
+
+    /// Open file state
+    class OpenFile {
+    public:
+      /// Constructor.
+      /// @param fd_ File descriptor
+      /// @param directio_ File was opened with <code>O_DIRECT</code>
+      OpenFile(int fd_, bool directio_) : fd(fd_), directio(directio_) { }
+      /// Destructor.  Closes #fd.
+      ~OpenFile();
+      /// File descriptor
+      int fd;
+      /// File was opened with <code>O_DIRECT</code>
+      bool directio;
+      /// Offset at which reads of a buffered open stop (0 for no limit)
+      uint64_t end_offset {};
+      /// Serializes commands on the file (read and seek use the file offset)
+      std::mutex mutex;
+    };
+
+    /// Smart pointer to OpenFile
+    typedef std::shared_ptr<OpenFile> OpenFilePtr;
+
+    /** Converts filesystem name to absolute local path.
+     * @param name File or directory name relative to root directory
+     * @return Absolute path
+     */
+    String abspath(const String &name);
+
+    /** Opens local file and adds it to #m_files.
+     * @param name File name
+     * @param oflags Flags passed to <code>open()</code>
+     * @param flags Filesystem open flags
+     * @return Filesystem file descriptor
+     */
+    int32_t open_file(const String &name, int oflags, uint32_t flags);
+
+    /** Looks up open file.  Throws Exception with code
+     * Error::FSBROKER_BAD_FILE_HANDLE if <code>fd</code> is not open.
+     * @param fd Filesystem file descriptor
+     * @return Open file state
+     */
+    OpenFilePtr get_file(int32_t fd);
+
+    /** Reads from open file.  Data is read directly into <code>dst</code>
+     * unless the file was opened with <code>O_DIRECT</code> and the buffer,
+     * length, or offset are not aligned, in which case it is read through
+     * an aligned bounce buffer.
+     * @param file Open file
+     * @param dst Destination buffer
+     * @param len Number of bytes to read
+     * @param offset File offset to read from
+     * @return Number of bytes read
+     */
+    size_t read_file(OpenFile *file, void *dst, size_t len, uint64_t offset);
+
+    /// Root directory
+    String m_rootdir;
+
+    /// Use direct i/o for files opened with OPEN_FLAG_DIRECTIO
+    bool m_directio {};
+
+    /// Rename removed files and directories with .deleted extension
+    bool m_no_removal {};
+
+    /// %Mutex protecting #m_files
+    std::mutex m_mutex;
+
+    /// Map of open files
+    std::unordered_map<int32_t, OpenFilePtr> m_files;
+
+    /// Next file descriptor
+    std::atomic<int32_t> m_next_fd {0};
+  };
+
+  /// Smart pointer to LocalFilesystem
+  typedef std::shared_ptr<LocalFilesystem> LocalFilesystemPtr;
+
+  /// @}
+
+}}}
+
+#endif // FsBroker_Lib_LocalFilesystem_h
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions of local file i/o helpers.
+/// This file contains definitions for helper functions shared by the local
+/// broker and the in-process local filesystem.
+
+#include <Common/Compat.h>
+
+#include "LocalIo.h"
+
+#include <Common/Error.h>
+#include <Common/FileUtils.h>
+#include <Common/Filesystem.h>
+#include <Common/Path.h>
+#include <Common/StaticBuffer.h>
+#include <Common/SystemInfo.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+#include <fcntl.h>
+#if defined(__sun__)
+#include <sys/fcntl.h>
+#endif
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace std;
+
+int FsBroker::Lib::errno_to_error(int errnum) {
+  if (errnum == ENOTDIR || errnum == ENAMETOOLONG || errnum == ENOENT)
+    return Error::FSBROKER_BAD_FILENAME;
+  else if (errnum == EACCES || errnum == EPERM)
+    return Error::FSBROKER_PERMISSION_DENIED;
+  else if (errnum == EBADF)
+    return Error::FSBROKER_BAD_FILE_HANDLE;
+  else if (errnum == EINVAL)
+    return Error::FSBROKER_INVALID_ARGUMENT;
+  return Error::FSBROKER_IO_ERROR;
+}
+
+
+bool FsBroker::Lib::local_directio_enabled(PropertiesPtr &cfg) {
+  bool directio;
+
+  if (cfg->has("DfsBroker.Local.DirectIO"))
+    directio = cfg->get_bool("DfsBroker.Local.DirectIO");
+  else
+    directio = cfg->get_bool("FsBroker.Local.DirectIO");
+
+#if defined(__linux__)
+  // disable direct i/o for kernels < 2.6
+  if (directio) {
+    if (System::os_info().version_major == 2 &&
+        System::os_info().version_minor < 6)
+      directio = false;
+  }
+#endif
+
+  return directio;
+}
+
+
+String FsBroker::Lib::local_root_directory(PropertiesPtr &cfg,
+                                           const String &root) {
+  Path root_path;
+
+  if (cfg->has("DfsBroker.Local.Root"))
+    root_path = Path(cfg->get_str("DfsBroker.Local.Root"));
+  else
+    root_path = Path(root);
+
+  if (!root_path.is_complete()) {
+    Path data_dir = cfg->get_str("Hypertable.DataDirectory");
+    root_path = data_dir / root_path;
+  }
+
+  return root_path.string();
+}
+
+
+int FsBroker::Lib::local_open(const String &path, int oflags, bool directio) {
+  int fd;
+
+#ifdef O_DIRECT
+  if (directio)
+    oflags |= O_DIRECT;
+#endif
+
+  if ((fd = ::open(path.c_str(), oflags, 0644)) == -1)
+    return -1;
+
+#if defined(__sun__)
+  if (directio)
+    ::directio(fd, DIRECTIO_ON);
+#endif
+
+  return fd;
+}
+
+
+ssize_t FsBroker::Lib::local_pread(int fd, void *dst, size_t len,
+                                   uint64_t offset, bool directio) {
+
+  if (directio &&
+      ((uintptr_t)dst % HT_DIRECT_IO_ALIGNMENT || !HT_IO_ALIGNED(len) ||
+       !HT_IO_ALIGNED(offset))) {
+    uint64_t aligned_offset = offset - (offset % HT_DIRECT_IO_ALIGNMENT);
+    size_t skip = (size_t)(offset - aligned_offset);
+    StaticBuffer buf(skip + len, (size_t)HT_DIRECT_IO_ALIGNMENT);
+    ssize_t nread = FileUtils::pread(fd, buf.base, buf.aligned_size(),
+                                     (off_t)aligned_offset);
+    if (nread == -1)
+      return -1;
+    nread = ((size_t)nread > skip) ? std::min((size_t)nread - skip, len) : 0;
+    memcpy(dst, buf.base + skip, nread);
+    return nread;
+  }
+
+  return FileUtils::pread(fd, dst, len, (off_t)offset);
+}
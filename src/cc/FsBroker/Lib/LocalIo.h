@@ -0,0 +1,101 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations of local file i/o helpers.
+/// This file contains declarations for helper functions shared by the local
+/// broker and the in-process local filesystem.
+
+#ifndef FsBroker_Lib_LocalIo_h
+#define FsBroker_Lib_LocalIo_h
+
+#include <Common/Properties.h>
+#include <Common/String.h>
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include <sys/types.h>
+}
+
+namespace Hypertable {
+namespace FsBroker {
+namespace Lib {
+
+  /// @addtogroup FsBrokerLib
+  /// @{
+
+  /** Converts <code>errno</code> value to error code.
+   * @param errnum <code>errno</code> value
+   * @return Error code (Error::FSBROKER_BAD_FILENAME,
+   * Error::FSBROKER_PERMISSION_DENIED, Error::FSBROKER_BAD_FILE_HANDLE,
+   * Error::FSBROKER_INVALID_ARGUMENT, or Error::FSBROKER_IO_ERROR)
+   */
+  extern int errno_to_error(int errnum);
+
+  /** Checks if direct i/o is enabled.  Reads
+   * <code>FsBroker.Local.DirectIO</code> (or the deprecated
+   * <code>DfsBroker.Local.DirectIO</code>) and turns it off on Linux kernels
+   * older than 2.6.
+   * @param cfg Configuration properties
+   * @return <i>true</i> if direct i/o is enabled
+   */
+  extern bool local_directio_enabled(PropertiesPtr &cfg);
+
+  /** Determines local root directory.  The deprecated
+   * <code>DfsBroker.Local.Root</code> property takes precedence over
+   * <code>root</code>.  A relative root is taken relative to
+   * <code>Hypertable.DataDirectory</code>.
+   * @param cfg Configuration properties
+   * @param root Configured root directory
+   * @return Absolute root directory
+   */
+  extern String local_root_directory(PropertiesPtr &cfg, const String &root);
+
+  /** Opens local file.  If <code>directio</code> is <i>true</i>, the file is
+   * opened for direct i/o (<code>O_DIRECT</code>, or
+   * <code>directio()</code> on Solaris).
+   * @param path Absolute path of file
+   * @param oflags Flags passed to <code>open()</code>
+   * @param directio Open file for direct i/o
+   * @return File descriptor, or -1 with <code>errno</code> set on error
+   */
+  extern int local_open(const String &path, int oflags, bool directio);
+
+  /** Reads from local file at offset.  If <code>directio</code> is
+   * <i>true</i> and the buffer, length, or offset do not meet the direct i/o
+   * alignment, the data is read through an aligned bounce buffer.
+   * @param fd File descriptor
+   * @param dst Destination buffer
+   * @param len Number of bytes to read
+   * @param offset File offset to read from
+   * @param directio File was opened for direct i/o
+   * @return Number of bytes read, or -1 with <code>errno</code> set on error
+   */
+  extern ssize_t local_pread(int fd, void *dst, size_t len, uint64_t offset,
+                             bool directio);
+
+  /// @}
+
+}}}
+
+#endif // FsBroker_Lib_LocalIo_h
@@ -0,0 +1,103 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Declarations for Preadv request parameters.
+/// This file contains declarations for Preadv, a class for encoding and
+/// decoding paramters to the <i>preadv</i> file system broker function.
+
+#ifndef FsBroker_Lib_Request_Parameters_Preadv_h
+#define FsBroker_Lib_Request_Parameters_Preadv_h
+
+#include <Common/Filesystem.h>
+#include <Common/Serializable.h>
+
+#include <vector>
+
+using namespace std;
+
+namespace Hypertable {
+namespace FsBroker {
+namespace Lib {
+namespace Request {
+namespace Parameters {
+
+  /// @addtogroup FsBrokerLibRequestParameters
+  /// @{
+
+  /// %Request parameters for <i>preadv</i> requests.
+  class Preadv : public Serializable {
+  public:
+
+    /// Constructor.
+    /// Empty initialization for decoding.
+    Preadv() {}
+
+    /// Constructor.
+    /// Initializes with parameters for encoding.  Sets #m_fd to
+    /// <code>fd</code>, #m_extents to <code>extents</code>, and
+    /// #m_verify_checksum to <code>verify_checksum</code>.
+    /// @param fd File descriptor
+    /// @param extents Extents to read
+    /// @param verify_checksum Verify checksum flag
+    Preadv(int32_t fd, const vector<Filesystem::Extent> &extents,
+           bool verify_checksum)
+      : m_fd(fd), m_extents(extents), m_verify_checksum(verify_checksum) {}
+
+    /// Gets file descriptor
+    /// @return File descriptor
+    int32_t get_fd() { return m_fd; }
+
+    /// Gets extents to read
+    /// @return Extents to read
+    const vector<Filesystem::Extent> &get_extents() { return m_extents; }
+
+    /// Gets verify checksum flag
+    /// @return Verify checksum flag
+    bool get_verify_checksum() { return m_verify_checksum; }
+
+  private:
+
+    uint8_t encoding_version() const override;
+
+    size_t encoded_length_internal() const override;
+
+    void encode_internal(uint8_t **bufp) const override;
+
+    void decode_internal(uint8_t version, const uint8_t **bufp,
+			 size_t *remainp) override;
+
+    /// File descriptor to which preadv applies
+    int32_t m_fd {};
+
+    /// Extents to read
+    vector<Filesystem::Extent> m_extents;
+
+    /// Verify checksum flag
+    bool m_verify_checksum {};
+  };
+
+  /// @}
+
+}}}}}
+
+#endif // FsBroker_Lib_Request_Parameters_Preadv_h
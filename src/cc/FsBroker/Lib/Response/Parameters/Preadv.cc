@@ -0,0 +1,67 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for Preadv response parameters.
+/// This file contains definitions for Preadv, a class for encoding and
+/// decoding paramters to the <i>preadv</i> file system broker function.
+
+#include <Common/Compat.h>
+
+#include "Preadv.h"
+
+#include <Common/Error.h>
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+using namespace Hypertable;
+using namespace Hypertable::FsBroker::Lib::Response::Parameters;
+
+uint8_t Preadv::encoding_version() const {
+  return 1;
+}
+
+size_t Preadv::encoded_length_internal() const {
+  return 4 + (12 * m_extents.size());
+}
+
+void Preadv::encode_internal(uint8_t **bufp) const {
+  Serialization::encode_i32(bufp, m_extents.size());
+  for (const Filesystem::Extent &extent : m_extents) {
+    Serialization::encode_i64(bufp, extent.offset);
+    Serialization::encode_i32(bufp, extent.length);
+  }
+}
+
+void Preadv::decode_internal(uint8_t version, const uint8_t **bufp,
+			     size_t *remainp) {
+  (void)version;
+  uint32_t count = Serialization::decode_i32(bufp, remainp);
+  if (count > *remainp / 12)
+    HT_THROWF(Error::SERIALIZATION_INPUT_OVERRUN, "%u extents", (unsigned)count);
+  m_extents.clear();
+  m_extents.reserve(count);
+  for (uint32_t i=0; i<count; i++) {
+    uint64_t offset = Serialization::decode_i64(bufp, remainp);
+    uint32_t length = Serialization::decode_i32(bufp, remainp);
+    m_extents.push_back(Filesystem::Extent(offset, length));
+  }
+}
@@ -0,0 +1,87 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Declarations for Preadv response parameters.
+/// This file contains declarations for Preadv, a class for encoding and
+/// decoding paramters to the <i>preadv</i> file system broker function.
+
+#ifndef FsBroker_Lib_Response_Parameters_Preadv_h
+#define FsBroker_Lib_Response_Parameters_Preadv_h
+
+#include <Common/Filesystem.h>
+#include <Common/Serializable.h>
+
+#include <vector>
+
+using namespace std;
+
+namespace Hypertable {
+namespace FsBroker {
+namespace Lib {
+namespace Response {
+namespace Parameters {
+
+  /// @addtogroup FsBrokerLibResponseParameters
+  /// @{
+
+  /// %Response parameters for <i>preadv</i> requests.
+  /// The data of the extents follows the encoded parameters in the response
+  /// message, concatenated in extent order.
+  class Preadv : public Serializable {
+  public:
+
+    /// Constructor.
+    /// Empty initialization for decoding.
+    Preadv() {}
+
+    /// Constructor.
+    /// Initializes with parameters for encoding.  Sets #m_extents to
+    /// <code>extents</code>.
+    /// @param extents Extents read, with lengths set to the amount of data
+    /// read for each
+    Preadv(const vector<Filesystem::Extent> &extents) : m_extents(extents) {}
+
+    /// Gets extents read
+    /// @return Extents read
+    vector<Filesystem::Extent> &get_extents() { return m_extents; }
+
+  private:
+
+    uint8_t encoding_version() const override;
+
+    size_t encoded_length_internal() const override;
+
+    void encode_internal(uint8_t **bufp) const override;
+
+    void decode_internal(uint8_t version, const uint8_t **bufp,
+			 size_t *remainp) override;
+
+    /// Extents read
+    vector<Filesystem::Extent> m_extents;
+  };
+
+  /// @}
+
+}}}}}
+
+#endif // FsBroker_Lib_Response_Parameters_Preadv_h
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for AsyncIoEngine.
+/// This file contains definitions for AsyncIoEngine, an io_uring based
+/// engine used by the local broker to carry out file reads and writes
+/// asynchronously.
+
+#include <Common/Compat.h>
+
+#include "AsyncIoEngine.h"
+
+#if defined(HT_WITH_IO_URING)
+
+#include <Common/Error.h>
+#include <Common/Logger.h>
+
+#include <cerrno>
+#include <cstring>
+
+using namespace Hypertable;
+using namespace Hypertable::FsBroker;
+using namespace std;
+
+namespace {
+
+  /// Largest length submitted in one entry
+  const size_t MAX_ENTRY_LENGTH = 1 << 30;
+
+  /// Tag bit set in the user data of linked fsync entries
+  const uint64_t FSYNC_TAG = 1;
+
+}
+
+
+AsyncIoEngine::AsyncIoEngine(unsigned entries)
+  : m_ring(new IoUring(entries, 0, 0)), m_max_outstanding(entries) {
+  m_thread = std::thread([this](){ reap(); });
+}
+
+
+AsyncIoEngine::~AsyncIoEngine() {
+  {
+    unique_lock<mutex> lock(m_mutex);
+    m_cond.wait(lock, [this](){ return m_outstanding == 0; });
+    m_shutdown = true;
+    // Wake up the completion thread
+    io_uring_sqe *sqe = m_ring->get_sqe();
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = IoUring::INTERNAL_USER_DATA;
+    m_ring->submit_and_wait(0, false);
+  }
+  m_thread.join();
+}
+
+
+void AsyncIoEngine::read(int fd, void *buf, size_t len, uint64_t offset,
+                         Callback cb) {
+  Request *req = new Request();
+  req->opcode = IORING_OP_READ;
+  req->fd = fd;
+  req->buf = (uint8_t *)buf;
+  req->len = len;
+  req->offset = offset;
+  req->cb = cb;
+  start(req);
+}
+
+
+void AsyncIoEngine::write(int fd, const void *buf, size_t len, bool sync,
+                          Callback cb) {
+  Request *req = new Request();
+  req->opcode = IORING_OP_WRITE;
+  req->fd = fd;
+  req->buf = (uint8_t *)buf;
+  req->len = len;
+  req->offset = 0;
+  req->sync = sync;
+  req->cb = cb;
+  start(req);
+}
+
+
+void AsyncIoEngine::start(Request *req) {
+  unique_lock<mutex> lock(m_mutex);
+  // Requests submitted from completion callbacks replace the one that just
+  // completed, so they are not held back
+  if (this_thread::get_id() != m_thread.get_id())
+    m_cond.wait(lock, [this](){ return m_outstanding < m_max_outstanding; });
+  m_outstanding++;
+  submit(req);
+}
+
+
+void AsyncIoEngine::submit(Request *req) {
+  io_uring_sqe *sqe = m_ring->get_sqe();
+  sqe->opcode = req->opcode;
+  sqe->fd = req->fd;
+  sqe->addr = (uint64_t)(uintptr_t)(req->buf + req->done);
+  sqe->len = (uint32_t)std::min(req->len - req->done, MAX_ENTRY_LENGTH);
+  // Writes go to the current file position, which O_APPEND files keep at
+  // end of file
+  if (req->opcode == IORING_OP_READ)
+    sqe->off = req->offset + req->done;
+  else
+    sqe->off = (uint64_t)-1;
+  sqe->user_data = (uint64_t)(uintptr_t)req;
+  req->pending = 1;
+
+  if (req->sync) {
+    sqe->flags |= IOSQE_IO_LINK;
+    sqe = m_ring->get_sqe();
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = req->fd;
+    sqe->user_data = (uint64_t)(uintptr_t)req | FSYNC_TAG;
+    req->pending++;
+  }
+
+  int ret;
+  while ((ret = m_ring->submit_and_wait(0, false)) == -EAGAIN ||
+         ret == -EBUSY)
+    this_thread::yield();
+  if (ret < 0)
+    HT_FATALF("io_uring_enter() failure: %s", strerror(-ret));
+}
+
+
+void AsyncIoEngine::handle_completion(Request *req, bool is_fsync, int res) {
+
+  req->pending--;
+
+  if (res < 0) {
+    // A linked fsync is canceled when its write comes up short; the rest of
+    // the write is submitted again below, together with a new fsync
+    if (!(is_fsync && res == -ECANCELED) && req->error == 0)
+      req->error = res;
+  }
+  else if (!is_fsync) {
+    if (res == 0) {
+      if (req->opcode == IORING_OP_READ)
+        req->len = req->done;  // end of file
+      else if (req->error == 0)
+        req->error = -EIO;
+    }
+    req->done += res;
+  }
+
+  if (req->pending)
+    return;
+
+  if (req->error == 0 && req->done < req->len) {
+    lock_guard<mutex> lock(m_mutex);
+    submit(req);
+    return;
+  }
+
+  Callback cb = std::move(req->cb);
+  int result = req->error ? req->error : (int)req->done;
+  delete req;
+
+  cb(result);
+
+  lock_guard<mutex> lock(m_mutex);
+  m_outstanding--;
+  m_cond.notify_all();
+}
+
+
+void AsyncIoEngine::reap() {
+  io_uring_cqe *cqe;
+
+  while (true) {
+    int ret = m_ring->wait(0);
+    if (ret < 0)
+      HT_FATALF("io_uring_enter() failure: %s", strerror(-ret));
+
+    while ((cqe = m_ring->peek_cqe()) != nullptr) {
+      uint64_t user_data = cqe->user_data;
+      int res = cqe->res;
+      m_ring->cqe_seen();
+      if (user_data == IoUring::INTERNAL_USER_DATA)
+        continue;
+      handle_completion((Request *)(uintptr_t)(user_data & ~FSYNC_TAG),
+                        (user_data & FSYNC_TAG) != 0, res);
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    if (m_shutdown && m_outstanding == 0)
+      break;
+  }
+}
+
+#endif // HT_WITH_IO_URING
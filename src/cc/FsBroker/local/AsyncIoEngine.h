@@ -0,0 +1,165 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for AsyncIoEngine.
+/// This file contains declarations for AsyncIoEngine, an io_uring based
+/// engine used by the local broker to carry out file reads and writes
+/// asynchronously.
+
+#ifndef FsBroker_local_AsyncIoEngine_h
+#define FsBroker_local_AsyncIoEngine_h
+
+#if defined(HT_WITH_IO_URING)
+
+#include <AsyncComm/IoUring.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Hypertable {
+namespace FsBroker {
+
+  /// Asynchronous file i/o engine.
+  /// Reads and writes are submitted to an io_uring from the calling thread
+  /// and completed by a dedicated completion thread, which invokes the
+  /// callback supplied with each request.  Many requests can be in flight at
+  /// once, so broker worker threads are not tied up for the duration of the
+  /// i/o.  Requests on the same file are not ordered with respect to one
+  /// another; callers that need ordering (e.g. appends) must wait for the
+  /// completion of one request before submitting the next.
+  class AsyncIoEngine {
+  public:
+
+    /// Completion callback.  It is passed the number of bytes transferred or
+    /// a negative <code>errno</code> value, and is invoked from the
+    /// completion thread.
+    typedef std::function<void(int result)> Callback;
+
+    /// Constructor.
+    /// Sets up the ring and starts the completion thread.  Throws Exception
+    /// with code Error::COMM_POLL_ERROR if io_uring is not available.
+    /// @param entries Number of submission queue entries; also bounds the
+    /// number of requests in flight
+    AsyncIoEngine(unsigned entries);
+
+    /// Destructor.
+    /// Waits for outstanding requests to complete and then stops the
+    /// completion thread.
+    ~AsyncIoEngine();
+
+    /// Submits read.
+    /// Short reads are continued until <code>len</code> bytes have been read
+    /// or end of file is reached.
+    /// @param fd File descriptor
+    /// @param buf Destination buffer
+    /// @param len Number of bytes to read
+    /// @param offset File offset to read from
+    /// @param cb Completion callback
+    void read(int fd, void *buf, size_t len, uint64_t offset, Callback cb);
+
+    /// Submits write at the current file position.
+    /// If <code>sync</code> is <i>true</i>, an <code>fsync()</code> linked
+    /// to the write is submitted with it and the callback is invoked once
+    /// both have completed.  Short writes are continued.
+    /// @param fd File descriptor
+    /// @param buf Source buffer
+    /// @param len Number of bytes to write
+    /// @param sync Sync the file after the write
+    /// @param cb Completion callback
+    void write(int fd, const void *buf, size_t len, bool sync, Callback cb);
+
+  private:
+
+    /// In-flight request
+    struct Request {
+      /// Ring opcode (<code>IORING_OP_READ</code> or
+      /// <code>IORING_OP_WRITE</code>)
+      uint8_t opcode;
+      /// File descriptor
+      int fd;
+      /// Buffer
+      uint8_t *buf;
+      /// Request length
+      size_t len;
+      /// Bytes transferred so far
+      size_t done {};
+      /// Read offset
+      uint64_t offset;
+      /// Write is followed by a linked fsync
+      bool sync {};
+      /// Completions still expected for the current submission
+      int pending {};
+      /// Negative errno of first failure
+      int error {};
+      /// Completion callback
+      Callback cb;
+    };
+
+    /// Queues submission queue entries for remaining part of request and
+    /// submits them.  Must be called with #m_mutex locked.
+    /// @param req Request
+    void submit(Request *req);
+
+    /// Admits new request, waiting if the in-flight limit has been reached
+    /// (except on the completion thread)
+    /// @param req Request
+    void start(Request *req);
+
+    /// Handles completion of a submission queue entry of <code>req</code>
+    /// @param req Request
+    /// @param is_fsync Completion is for the linked fsync
+    /// @param res Completion result
+    void handle_completion(Request *req, bool is_fsync, int res);
+
+    /// Completion thread loop
+    void reap();
+
+    /// io_uring instance
+    std::unique_ptr<IoUring> m_ring;
+
+    /// %Mutex serializing submissions and protecting #m_outstanding
+    std::mutex m_mutex;
+
+    /// Signaled when a request completes
+    std::condition_variable m_cond;
+
+    /// Number of requests in flight
+    unsigned m_outstanding {};
+
+    /// Maximum number of requests in flight
+    unsigned m_max_outstanding;
+
+    /// Set when completion thread is to exit
+    bool m_shutdown {};
+
+    /// Completion thread
+    std::thread m_thread;
+  };
+
+}}
+
+#endif // HT_WITH_IO_URING
+
+#endif // FsBroker_local_AsyncIoEngine_h
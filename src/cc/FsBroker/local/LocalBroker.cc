@@ -23,12 +23,11 @@
 
 #include "LocalBroker.h"
 
+#include <FsBroker/Lib/LocalIo.h>
+
 #include <Common/FileUtils.h>
 #include <Common/Filesystem.h>
-#include <Common/Path.h>
 #include <Common/String.h>
-#include <Common/System.h>
-#include <Common/SystemInfo.h>
 
 #include <AsyncComm/ReactorFactory.h>
 
@@ -57,47 +56,138 @@ using namespace Hypertable;
 using namespace Hypertable::FsBroker;
 using namespace std;
 
+namespace {
+
+  /// State of a preadv request.
+  /// Adjacent extents are grouped into runs that are each read with a single
+  /// pread into an aligned position of #buf.  Once all runs have been read,
+  /// finish() moves their data together so that #buf holds the data of the
+  /// extents concatenated, as expected by the response.
+  class PreadvRequest {
+  public:
+
+    /// Run of adjacent extents
+    struct Run {
+      /// File offset
+      uint64_t offset;
+      /// Length in bytes
+      size_t length;
+      /// Position in #buf
+      size_t position;
+      /// Index of first extent in run
+      size_t first;
+      /// Index one past the last extent in run
+      size_t last;
+      /// Bytes read or, for failed reads, -1 with #error set
+      ssize_t result {};
+      /// <code>errno</code> of failed read
+      int error {};
+    };
+
+    /// Constructor.
+    /// Groups <code>extents_</code> into runs and allocates #buf.
+    /// @param extents_ Extents to read
+    PreadvRequest(const vector<Filesystem::Extent> &extents_)
+      : extents(extents_), buf(layout(), (size_t)HT_DIRECT_IO_ALIGNMENT),
+        outstanding(runs.size()) { }
+
+    /// Returns length to read for <code>run</code>.
+    /// @param run Run
+    /// @return Length of run rounded up to the direct i/o alignment
+    static size_t read_length(const Run &run) {
+      return run.length + HT_IO_ALIGNMENT_PADDING(run.length);
+    }
+
+    /// Finishes request after all runs have been read.
+    /// Sets the length of each extent to the amount of its data read (EOF
+    /// shortens them) and moves the data together.
+    /// @return Total number of bytes read
+    size_t finish() {
+      size_t size = 0;
+      for (const Run &run : runs) {
+        size_t avail = std::min((size_t)run.result, run.length);
+        if (run.position != size)
+          memmove(buf.base + size, buf.base + run.position, avail);
+        size += avail;
+        for (size_t i=run.first; i<run.last; i++) {
+          extents[i].length = (uint32_t)std::min((size_t)extents[i].length,
+                                                 avail);
+          avail -= extents[i].length;
+        }
+      }
+      buf.size = size;
+      return size;
+    }
+
+    /// Extents to read
+    vector<Filesystem::Extent> extents;
+
+    /// Runs of adjacent extents
+    vector<Run> runs;
+
+    /// Read buffer
+    StaticBuffer buf;
+
+    /// Number of runs still being read asynchronously
+    atomic<size_t> outstanding;
+
+  private:
+
+    /// Groups #extents into #runs.
+    /// @return Size of read buffer
+    size_t layout() {
+      size_t size = 0;
+      for (size_t i=0, j; i<extents.size(); i=j) {
+        Run run;
+        run.offset = extents[i].offset;
+        run.length = extents[i].length;
+        run.position = size;
+        run.first = i;
+        for (j=i+1; j<extents.size() &&
+               extents[j].offset == extents[j-1].offset + extents[j-1].length;
+             j++)
+          run.length += extents[j].length;
+        run.last = j;
+        size += read_length(run);
+        runs.push_back(run);
+      }
+      return size;
+    }
+  };
+
+}
+
 atomic<int> LocalBroker::ms_next_fd {0};
 
 LocalBroker::LocalBroker(PropertiesPtr &cfg) {
   m_verbose = cfg->get_bool("verbose");
   m_no_removal = cfg->get_bool("FsBroker.DisableFileRemoval");
-  if (cfg->has("DfsBroker.Local.DirectIO"))
-    m_directio = cfg->get_bool("DfsBroker.Local.DirectIO");
-  else
-    m_directio = cfg->get_bool("FsBroker.Local.DirectIO");
+  m_directio = Lib::local_directio_enabled(cfg);
 
   m_metrics_handler = std::make_shared<MetricsHandler>(cfg, "local");
   m_metrics_handler->start_collecting();
 
-#if defined(__linux__)
-  // disable direct i/o for kernels < 2.6
-  if (m_directio) {
-    if (System::os_info().version_major == 2 &&
-        System::os_info().version_minor < 6)
-      m_directio = false;
-  }
-#endif
-
   /**
    * Determine root directory
    */
-  Path root;
-  if (cfg->has("DfsBroker.Local.Root"))
-    root = Path(cfg->get_str("DfsBroker.Local.Root"));
-  else
-    root = Path(cfg->get_str("root", ""));
-
-  if (!root.is_complete()) {
-    Path data_dir = cfg->get_str("Hypertable.DataDirectory");
-    root = data_dir / root;
-  }
-
-  m_rootdir = root.string();
+  m_rootdir = Lib::local_root_directory(cfg, cfg->get_str("root", ""));
 
   // ensure that root directory exists
   if (!FileUtils::mkdirs(m_rootdir))
     exit(EXIT_FAILURE);
+
+#if defined(HT_WITH_IO_URING)
+  if (cfg->get_bool("FsBroker.Local.UseIoUring")) {
+    try {
+      int entries = cfg->get_i32("FsBroker.Local.IoUringEntries");
+      m_io_engine.reset(new AsyncIoEngine(entries));
+      HT_INFO("Using io_uring for appends and preads");
+    }
+    catch (Exception &e) {
+      HT_WARNF("io_uring not available, using synchronous i/o - %s", e.what());
+    }
+  }
+#endif
 }
 
 
@@ -122,32 +212,16 @@ LocalBroker::open(Response::Callback::Open *cb, const char *fname,
 
   fd = ++ms_next_fd;
 
-  int oflags = O_RDONLY;
-
-  if (m_directio && flags & Filesystem::OPEN_FLAG_DIRECTIO) {
-#ifdef O_DIRECT
-    oflags |= O_DIRECT;
-#endif
-  }
-
   /**
    * Open the file
    */
-  if ((local_fd = ::open(abspath.c_str(), oflags)) == -1) {
+  if ((local_fd = Lib::local_open(abspath, O_RDONLY, m_directio &&
+                                  (flags & Filesystem::OPEN_FLAG_DIRECTIO))) == -1) {
     report_error(cb);
     HT_ERRORF("open failed: file='%s' - %s", abspath.c_str(), strerror(errno));
     return;
   }
 
-#if defined(__APPLE__)
-#ifdef F_NOCACHE
-  //fcntl(local_fd, F_NOCACHE, 1);
-#endif  
-#elif defined(__sun__)
-  if (m_directio)
-    directio(local_fd, DIRECTIO_ON);
-#endif
-
   HT_INFOF("open( %s ) = %d (local=%d)", fname, (int)fd, local_fd);
 
   {
@@ -185,16 +259,11 @@ LocalBroker::create(Response::Callback::Open *cb, const char *fname, uint32_t fl
   else
     oflags |= O_APPEND;
 
-  if (m_directio && flags & Filesystem::OPEN_FLAG_DIRECTIO) {
-#ifdef O_DIRECT
-    oflags |= O_DIRECT;
-#endif
-  }
-
   /**
    * Open the file
    */
-  if ((local_fd = ::open(abspath.c_str(), oflags, 0644)) == -1) {
+  if ((local_fd = Lib::local_open(abspath, oflags, m_directio &&
+                                  (flags & Filesystem::OPEN_FLAG_DIRECTIO))) == -1) {
     report_error(cb);
     HT_ERRORF("open failed: file='%s' - %s", abspath.c_str(), strerror(errno));
     return;
@@ -204,9 +273,6 @@ LocalBroker::create(Response::Callback::Open *cb, const char *fname, uint32_t fl
 #ifdef F_NOCACHE
     fcntl(local_fd, F_NOCACHE, 1);
 #endif  
-#elif defined(__sun__)
-    if (m_directio)
-      directio(local_fd, DIRECTIO_ON);
 #endif
 
   //HT_DEBUGF("created file='%s' fd=%d local_fd=%d", fname, fd, local_fd);
@@ -227,8 +293,11 @@ LocalBroker::create(Response::Callback::Open *cb, const char *fname, uint32_t fl
 
 
 void LocalBroker::close(ResponseCallback *cb, uint32_t fd) {
+  OpenFileDataLocalPtr fdata;
   int error;
   HT_DEBUGF("close fd=%d", fd);
+  if (m_open_file_map.get(fd, fdata))
+    fdata->wait_for_appends();
   m_open_file_map.remove(fd);
   if ((error = cb->response_ok()) != Error::OK)
     HT_ERRORF("Problem sending response for close(%u) - %s", (unsigned)fd, Error::get_text(error));
@@ -304,6 +373,13 @@ void LocalBroker::append(Response::Callback::Append *cb, uint32_t fd,
     return;
   }
 
+#if defined(HT_WITH_IO_URING)
+  if (m_io_engine) {
+    append_async(cb, fd, fdata, amount, data, flags);
+    return;
+  }
+#endif
+
   if ((offset = (uint64_t)lseek(fdata->fd, 0, SEEK_CUR)) == (uint64_t)-1) {
     int error = errno;
     report_error(cb);
@@ -359,6 +435,8 @@ void LocalBroker::seek(ResponseCallback *cb, uint32_t fd, uint64_t offset) {
     return;
   }
 
+  fdata->wait_for_appends();
+
   if ((offset = (uint64_t)lseek(fdata->fd, offset, SEEK_SET)) == (uint64_t)-1) {
     report_error(cb);
     HT_ERRORF("lseek failed: fd=%d offset=%llu - %s", fdata->fd, (Llu)offset,
@@ -442,8 +520,6 @@ LocalBroker::pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
 
   HT_DEBUGF("pread fd=%d offset=%llu amount=%d", fd, (Llu)offset, amount);
 
-  StaticBuffer buf((size_t)amount, (size_t)HT_DIRECT_IO_ALIGNMENT);
-
   if (!m_open_file_map.get(fd, fdata)) {
     char errbuf[32];
     sprintf(errbuf, "%d", fd);
@@ -452,6 +528,15 @@ LocalBroker::pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
     return;
   }
 
+#if defined(HT_WITH_IO_URING)
+  if (m_io_engine) {
+    pread_async(cb, fd, fdata, offset, amount);
+    return;
+  }
+#endif
+
+  StaticBuffer buf((size_t)amount, (size_t)HT_DIRECT_IO_ALIGNMENT);
+
   nread = FileUtils::pread(fdata->fd, buf.base, buf.aligned_size(), (off_t)offset);
   if (nread != (ssize_t)buf.aligned_size()) {
     int error = errno;
@@ -472,6 +557,54 @@ LocalBroker::pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
 }
 
 
+void
+LocalBroker::preadv(Response::Callback::Preadv *cb, uint32_t fd,
+                    const vector<Filesystem::Extent> &extents, bool) {
+  OpenFileDataLocalPtr fdata;
+  int error;
+
+  HT_DEBUGF("preadv fd=%d extents=%d", fd, (int)extents.size());
+
+  if (!m_open_file_map.get(fd, fdata)) {
+    char errbuf[32];
+    sprintf(errbuf, "%d", fd);
+    cb->error(Error::FSBROKER_BAD_FILE_HANDLE, errbuf);
+    m_metrics_handler->increment_error_count();
+    return;
+  }
+
+#if defined(HT_WITH_IO_URING)
+  if (m_io_engine && !extents.empty()) {
+    preadv_async(cb, fd, fdata, extents);
+    return;
+  }
+#endif
+
+  PreadvRequest req(extents);
+
+  for (PreadvRequest::Run &run : req.runs) {
+    run.result = FileUtils::pread(fdata->fd, req.buf.base + run.position,
+                                  PreadvRequest::read_length(run),
+                                  (off_t)run.offset);
+    if (run.result < 0) {
+      error = errno;
+      report_error(cb);
+      m_status_manager.set_read_error(error);
+      HT_ERRORF("preadv failed: fd=%d amount=%d offset=%llu - %s",
+                fdata->fd, (int)run.length, (Llu)run.offset, strerror(error));
+      return;
+    }
+  }
+
+  m_metrics_handler->add_bytes_read(req.finish());
+  m_status_manager.clear_status();
+
+  if ((error = cb->response(req.extents, req.buf)) != Error::OK)
+    HT_ERRORF("Problem sending response for preadv(%u, %d extents) - %s",
+              (unsigned)fd, (int)extents.size(), Error::get_text(error));
+}
+
+
 void LocalBroker::mkdirs(ResponseCallback *cb, const char *dname) {
   String absdir;
   int error;
@@ -655,6 +788,8 @@ void LocalBroker::sync(ResponseCallback *cb, uint32_t fd) {
     return;
   }
 
+  fdata->wait_for_appends();
+
   int64_t start_time = get_ts64();
   if (fsync(fdata->fd) != 0) {
     int error = errno;
@@ -724,21 +859,149 @@ LocalBroker::debug(ResponseCallback *cb, int32_t command,
 
 
 void LocalBroker::report_error(ResponseCallback *cb) {
+  report_error(cb, errno);
+}
+
+
+void LocalBroker::report_error(ResponseCallback *cb, int error) {
   char errbuf[128];
   errbuf[0] = 0;
 
   m_metrics_handler->increment_error_count();
 
-  strerror_r(errno, errbuf, 128);
+  strerror_r(error, errbuf, 128);
 
-  if (errno == ENOTDIR || errno == ENAMETOOLONG || errno == ENOENT)
-    cb->error(Error::FSBROKER_BAD_FILENAME, errbuf);
-  else if (errno == EACCES || errno == EPERM)
-    cb->error(Error::FSBROKER_PERMISSION_DENIED, errbuf);
-  else if (errno == EBADF)
-    cb->error(Error::FSBROKER_BAD_FILE_HANDLE, errbuf);
-  else if (errno == EINVAL)
-    cb->error(Error::FSBROKER_INVALID_ARGUMENT, errbuf);
-  else
-    cb->error(Error::FSBROKER_IO_ERROR, errbuf);
+  cb->error(Lib::errno_to_error(error), errbuf);
 }
+
+#if defined(HT_WITH_IO_URING)
+
+void
+LocalBroker::append_async(Response::Callback::Append *cb, uint32_t fd,
+                          OpenFileDataLocalPtr &fdata, uint32_t amount,
+                          const void *data, Filesystem::Flags flags) {
+  // The callback copy holds on to the request event, which owns the data
+  auto acb = make_shared<Response::Callback::Append>(*cb);
+  bool sync = flags == Filesystem::Flags::FLUSH ||
+    flags == Filesystem::Flags::SYNC;
+
+  fdata->enqueue_append([this, acb, fd, fdata, amount, data, sync]() {
+      uint64_t offset;
+
+      if ((offset = (uint64_t)lseek(fdata->fd, 0, SEEK_CUR)) == (uint64_t)-1) {
+        int error = errno;
+        report_error(acb.get(), error);
+        if (error != EINVAL)
+          m_status_manager.set_write_error(error);
+        HT_ERRORF("lseek failed: fd=%d offset=0 SEEK_CUR - %s", fdata->fd,
+                  strerror(error));
+        fdata->append_complete();
+        return;
+      }
+
+      int64_t start_time = get_ts64();
+      m_io_engine->write(fdata->fd, data, amount, sync,
+                         [this, acb, fd, fdata, offset, amount, sync,
+                          start_time](int result) {
+          int error;
+          if (result < 0) {
+            report_error(acb.get(), -result);
+            m_status_manager.set_write_error(-result);
+            HT_ERRORF("write failed: fd=%d offset=%llu amount=%d - %s",
+                      fdata->fd, (Llu)offset, amount, strerror(-result));
+          }
+          else {
+            if (sync)
+              m_metrics_handler->add_sync(get_ts64() - start_time);
+            m_metrics_handler->add_bytes_written(result);
+            m_status_manager.clear_status();
+            if ((error = acb->response(offset, result)) != Error::OK)
+              HT_ERRORF("Problem sending response for append(%u, localfd=%u, "
+                        "%u) - %s", (unsigned)fd, (unsigned)fdata->fd,
+                        (unsigned)amount, Error::get_text(error));
+          }
+          fdata->append_complete();
+        });
+    });
+}
+
+
+void
+LocalBroker::pread_async(Response::Callback::Read *cb, uint32_t fd,
+                         OpenFileDataLocalPtr &fdata, uint64_t offset,
+                         uint32_t amount) {
+  auto rcb = make_shared<Response::Callback::Read>(*cb);
+  auto buf = make_shared<StaticBuffer>((size_t)amount,
+                                       (size_t)HT_DIRECT_IO_ALIGNMENT);
+
+  m_io_engine->read(fdata->fd, buf->base, buf->aligned_size(), offset,
+                    [this, rcb, buf, fd, fdata, offset, amount](int result) {
+      int error;
+      if (result != (int)buf->aligned_size()) {
+        error = result < 0 ? -result : EIO;
+        report_error(rcb.get(), error);
+        m_status_manager.set_read_error(error);
+        HT_ERRORF("pread failed: fd=%d amount=%d aligned_size=%d offset=%llu "
+                  "- %s", fdata->fd, (int)amount, (int)buf->aligned_size(),
+                  (Llu)offset, strerror(error));
+        return;
+      }
+
+      m_metrics_handler->add_bytes_read(result);
+      m_status_manager.clear_status();
+
+      if ((error = rcb->response(offset, *buf)) != Error::OK)
+        HT_ERRORF("Problem sending response for pread(%u, %llu, %u) - %s",
+                  (unsigned)fd, (Llu)offset, (unsigned)amount,
+                  Error::get_text(error));
+    });
+}
+
+
+void
+LocalBroker::preadv_async(Response::Callback::Preadv *cb, uint32_t fd,
+                          OpenFileDataLocalPtr &fdata,
+                          const vector<Filesystem::Extent> &extents) {
+  auto rcb = make_shared<Response::Callback::Preadv>(*cb);
+  auto req = make_shared<PreadvRequest>(extents);
+
+  for (PreadvRequest::Run &run : req->runs) {
+    PreadvRequest::Run *runp = &run;
+    m_io_engine->read(fdata->fd, req->buf.base + run.position,
+                      PreadvRequest::read_length(run), run.offset,
+                      [this, rcb, req, runp, fd, fdata](int result) {
+        if (result < 0) {
+          runp->result = -1;
+          runp->error = -result;
+        }
+        else
+          runp->result = result;
+
+        // The last run to complete sends the response
+        if (--req->outstanding > 0)
+          return;
+
+        int error;
+        for (const PreadvRequest::Run &run : req->runs) {
+          if (run.result < 0) {
+            report_error(rcb.get(), run.error);
+            m_status_manager.set_read_error(run.error);
+            HT_ERRORF("preadv failed: fd=%d amount=%d offset=%llu - %s",
+                      fdata->fd, (int)run.length, (Llu)run.offset,
+                      strerror(run.error));
+            return;
+          }
+        }
+
+        m_metrics_handler->add_bytes_read(req->finish());
+        m_status_manager.clear_status();
+
+        if ((error = rcb->response(req->extents, req->buf)) != Error::OK)
+          HT_ERRORF("Problem sending response for preadv(%u, %d extents) - %s",
+                    (unsigned)fd, (int)req->extents.size(),
+                    Error::get_text(error));
+      });
+  }
+}
+
+#endif
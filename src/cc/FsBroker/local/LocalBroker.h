@@ -22,6 +22,8 @@
 #ifndef FsBroker_local_LocalBroker_h
 #define FsBroker_local_LocalBroker_h
 
+#include "AsyncIoEngine.h"
+
 #include <FsBroker/Lib/Broker.h>
 #include <FsBroker/Lib/MetricsHandler.h>
 #include <FsBroker/Lib/StatusManager.h>
@@ -30,7 +32,13 @@
 #include <Common/String.h>
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 extern "C" {
 #include <unistd.h>
@@ -47,9 +55,47 @@ namespace FsBroker {
     virtual ~OpenFileDataLocal() {
       close(fd);
     }
+
+    /// Queues asynchronous append.  <code>submit</code> is called right away
+    /// if no other append is in progress, otherwise once the appends ahead
+    /// of it have completed.
+    void enqueue_append(std::function<void()> submit) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        appends.push_back(submit);
+        if (appends.size() > 1)
+          return;
+      }
+      submit();
+    }
+
+    /// Signals completion of the append in progress and submits the next one
+    void append_complete() {
+      std::function<void()> next;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        appends.pop_front();
+        if (appends.empty())
+          cond.notify_all();
+        else
+          next = appends.front();
+      }
+      if (next)
+        next();
+    }
+
+    /// Waits for queued appends to complete
+    void wait_for_appends() {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this](){ return appends.empty(); });
+    }
+
     int  fd;
     int  flags;
     String filename;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::function<void()>> appends;
   };
 
   class OpenFileDataLocalPtr : public OpenFileDataPtr {
@@ -81,6 +127,9 @@ namespace FsBroker {
                     bool accurate = true);
     virtual void pread(Response::Callback::Read *cb, uint32_t fd, uint64_t offset,
                        uint32_t amount, bool verify_checksum);
+    virtual void preadv(Response::Callback::Preadv *cb, uint32_t fd,
+                        const std::vector<Filesystem::Extent> &extents,
+                        bool verify_checksum);
     virtual void mkdirs(ResponseCallback *cb, const char *dname);
     virtual void rmdir(ResponseCallback *cb, const char *dname);
     virtual void readdir(Response::Callback::Readdir *cb, const char *dname);
@@ -99,6 +148,25 @@ namespace FsBroker {
 
     virtual void report_error(ResponseCallback *cb);
 
+    void report_error(ResponseCallback *cb, int error);
+
+#if defined(HT_WITH_IO_URING)
+    void append_async(Response::Callback::Append *cb, uint32_t fd,
+                      OpenFileDataLocalPtr &fdata, uint32_t amount,
+                      const void *data, Filesystem::Flags flags);
+
+    void pread_async(Response::Callback::Read *cb, uint32_t fd,
+                     OpenFileDataLocalPtr &fdata, uint64_t offset,
+                     uint32_t amount);
+
+    void preadv_async(Response::Callback::Preadv *cb, uint32_t fd,
+                      OpenFileDataLocalPtr &fdata,
+                      const std::vector<Filesystem::Extent> &extents);
+
+    /// Asynchronous i/o engine for appends and preads (if enabled)
+    std::unique_ptr<AsyncIoEngine> m_io_engine;
+#endif
+
     /// Metrics collection handler
     MetricsHandlerPtr m_metrics_handler;
 
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Definitions for BatchOperation.
+/// This file contains definitions for the serialization functions of
+/// BatchOperation and BatchResult.
+
+#include <Common/Compat.h>
+
+#include "BatchOperation.h"
+
+#include <Common/Logger.h>
+#include <Common/Serialization.h>
+
+using namespace Hypertable;
+using namespace Serialization;
+
+namespace Hyperspace {
+
+  size_t encoded_length_batch_operation(const BatchOperation &op) {
+    size_t length = 1 + encoded_length_vstr(op.name) + 4 +
+      encoded_length_vstr(op.attr) + 4;
+    for (const auto &attr : op.attrs)
+      length += encoded_length_vstr(attr.name) +
+        encoded_length_vstr(attr.value_len);
+    return length;
+  }
+
+  void encode_batch_operation(uint8_t **bufp, const BatchOperation &op) {
+    encode_i8(bufp, (uint8_t)op.type);
+    encode_vstr(bufp, op.name);
+    encode_i32(bufp, op.oflags);
+    encode_vstr(bufp, op.attr);
+    encode_i32(bufp, op.attrs.size());
+    for (const auto &attr : op.attrs) {
+      encode_vstr(bufp, attr.name);
+      encode_vstr(bufp, attr.value, attr.value_len);
+    }
+  }
+
+  void decode_batch_operation(const uint8_t **bufp, size_t *remainp,
+                              BatchOperation &op) {
+    HT_TRY("decoding batch operation",
+      op.type = (BatchOperation::Type)decode_i8(bufp, remainp);
+      op.name = decode_vstr(bufp, remainp);
+      op.oflags = decode_i32(bufp, remainp);
+      op.attr = decode_vstr(bufp, remainp);
+      Attribute attr;
+      uint32_t count = decode_i32(bufp, remainp);
+      op.attrs.clear();
+      op.attrs.reserve(count);
+      while (count--) {
+        attr.name = decode_vstr(bufp, remainp);
+        attr.value = decode_vstr(bufp, remainp, &attr.value_len);
+        op.attrs.push_back(attr);
+      });
+  }
+
+  size_t encoded_length_batch_result(const BatchResult &result) {
+    return 4 + encoded_length_vstr(result.error_msg) + 8;
+  }
+
+  void encode_batch_result(uint8_t **bufp, const BatchResult &result) {
+    encode_i32(bufp, result.error);
+    encode_vstr(bufp, result.error_msg);
+    encode_i64(bufp, result.value);
+  }
+
+  void decode_batch_result(const uint8_t **bufp, size_t *remainp,
+                           BatchResult &result) {
+    HT_TRY("decoding batch result",
+      result.error = decode_i32(bufp, remainp);
+      result.error_msg = decode_vstr(bufp, remainp);
+      result.value = decode_i64(bufp, remainp));
+  }
+}
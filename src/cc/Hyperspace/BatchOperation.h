@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+/// @file
+/// Declarations for BatchOperation.
+/// This file contains declarations for BatchOperation and BatchResult, which
+/// describe the operations of a Hyperspace batch request and their results.
+
+#ifndef Hyperspace_BatchOperation_h
+#define Hyperspace_BatchOperation_h
+
+#include <Hyperspace/Protocol.h>
+
+#include <Common/Error.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Hyperspace {
+
+  /// @addtogroup Hyperspace
+  /// @{
+
+  /// %Operation of a batch request.
+  /// The operations of a batch are executed by the master in order within a
+  /// single BerkeleyDB transaction (see Session::batch()).
+  struct BatchOperation {
+
+    /// %Operation type
+    enum Type {
+      /// Create directory #name with attributes #attrs
+      MKDIR = 1,
+      /// Create directory #name and its missing parents, setting #attrs on
+      /// #name if it was created
+      MKDIRS,
+      /// Open #name with #oflags and set attributes #attrs
+      ATTR_SET,
+      /// Increment attribute #attr of #name
+      ATTR_INCR,
+      /// Remove #name
+      UNLINK
+    };
+
+    BatchOperation() { }
+
+    /// Constructor.
+    /// @param t %Operation type
+    /// @param n Absolute path name of node
+    /// @param a Attributes for MKDIR, MKDIRS and ATTR_SET
+    /// @param f Open flags for ATTR_SET (see \ref OpenFlags)
+    BatchOperation(Type t, const std::string &n,
+                   const std::vector<Attribute> &a = std::vector<Attribute>(),
+                   uint32_t f = 0)
+      : type(t), name(n), oflags(f), attrs(a) { }
+
+    /// Constructor for ATTR_INCR operations.
+    /// @param t %Operation type
+    /// @param n Absolute path name of node
+    /// @param at Name of attribute to increment
+    BatchOperation(Type t, const std::string &n, const std::string &at)
+      : type(t), name(n), attr(at) { }
+
+    /// %Operation type
+    Type type {MKDIR};
+
+    /// Absolute path name of node
+    std::string name;
+
+    /// Open flags (ATTR_SET)
+    uint32_t oflags {};
+
+    /// Attribute name (ATTR_INCR)
+    std::string attr;
+
+    /// Attributes (MKDIR, MKDIRS and ATTR_SET)
+    std::vector<Attribute> attrs;
+  };
+
+  /// Result of a BatchOperation.
+  struct BatchResult {
+    /// %Error code of operation
+    int error {Hypertable::Error::OK};
+
+    /// %Error message
+    std::string error_msg;
+
+    /// Pre-incremented attribute value (ATTR_INCR)
+    uint64_t value {};
+  };
+
+  /// Returns encoded length of a batch operation.
+  /// @param op Batch operation
+  /// @return Number of bytes required to encode <code>op</code>
+  size_t encoded_length_batch_operation(const BatchOperation &op);
+
+  /// Encodes a batch operation.
+  /// @param bufp Address of destination buffer pointer (advanced by call)
+  /// @param op Batch operation
+  void encode_batch_operation(uint8_t **bufp, const BatchOperation &op);
+
+  /// Decodes a batch operation.
+  /// Attribute names and values in <code>op.attrs</code> point into the
+  /// source buffer.
+  /// @param bufp Address of source buffer pointer (advanced by call)
+  /// @param remainp Address of remaining byte count (decremented by call)
+  /// @param op Batch operation to receive decoded data
+  void decode_batch_operation(const uint8_t **bufp, size_t *remainp,
+                              BatchOperation &op);
+
+  /// Returns encoded length of a batch result.
+  /// @param result Batch result
+  /// @return Number of bytes required to encode <code>result</code>
+  size_t encoded_length_batch_result(const BatchResult &result);
+
+  /// Encodes a batch result.
+  /// @param bufp Address of destination buffer pointer (advanced by call)
+  /// @param result Batch result
+  void encode_batch_result(uint8_t **bufp, const BatchResult &result);
+
+  /// Decodes a batch result.
+  /// @param bufp Address of source buffer pointer (advanced by call)
+  /// @param remainp Address of remaining byte count (decremented by call)
+  /// @param result Batch result to receive decoded data
+  void decode_batch_result(const uint8_t **bufp, size_t *remainp,
+                           BatchResult &result);
+
+  /// @}
+}
+
+#endif // Hyperspace_BatchOperation_h
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for ClientCache.
+/// This file contains definitions for ClientCache, a class that caches
+/// node attributes and directory listings on the client side of a Hyperspace
+/// session.
+
+#include <Common/Compat.h>
+
+#include "ClientCache.h"
+
+using namespace Hypertable;
+using namespace Hyperspace;
+using namespace std;
+
+const uint32_t ClientCache::ATTR_EVENT_MASK;
+const uint32_t ClientCache::CHILD_EVENT_MASK;
+
+void ClientCache::watch(const string &node, uint32_t event_mask) {
+  lock_guard<mutex> lock(m_mutex);
+  Node &entry = m_nodes[node];
+  entry.handles++;
+  if ((event_mask & ATTR_EVENT_MASK) == ATTR_EVENT_MASK)
+    entry.attr_handles++;
+  if ((event_mask & CHILD_EVENT_MASK) == CHILD_EVENT_MASK)
+    entry.child_handles++;
+  // Responses to requests sent before the master registered the handle may
+  // carry data that has since changed without notification
+  m_generation++;
+}
+
+void ClientCache::unwatch(const string &node, uint32_t event_mask) {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_nodes.find(node);
+  if (iter == m_nodes.end())
+    return;
+  Node &entry = iter->second;
+  if ((event_mask & ATTR_EVENT_MASK) == ATTR_EVENT_MASK &&
+      --entry.attr_handles == 0)
+    entry.attrs.clear();
+  if ((event_mask & CHILD_EVENT_MASK) == CHILD_EVENT_MASK &&
+      --entry.child_handles == 0) {
+    entry.has_listing = false;
+    entry.listing.clear();
+  }
+  if (--entry.handles == 0)
+    m_nodes.erase(iter);
+}
+
+uint64_t ClientCache::generation() {
+  lock_guard<mutex> lock(m_mutex);
+  return m_generation;
+}
+
+bool ClientCache::get_attr(const string &node, const string &attr,
+                           DynamicBuffer *value, bool *exists) {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_nodes.find(node);
+  if (iter != m_nodes.end()) {
+    auto attr_iter = iter->second.attrs.find(attr);
+    if (attr_iter != iter->second.attrs.end()) {
+      const Attribute &cached = attr_iter->second;
+      if (!cached.exists || !value || cached.has_value) {
+        *exists = cached.exists;
+        if (cached.exists && value) {
+          value->clear();
+          value->ensure(cached.value.length()+1);
+          value->add_unchecked(cached.value.data(), cached.value.length());
+          *value->ptr = 0;
+        }
+        m_hits++;
+        return true;
+      }
+    }
+  }
+  m_misses++;
+  return false;
+}
+
+void ClientCache::put_attr(const string &node, const string &attr,
+                           const void *value, size_t len, bool exists,
+                           uint64_t generation) {
+  lock_guard<mutex> lock(m_mutex);
+  if (generation != m_generation)
+    return;
+  auto iter = m_nodes.find(node);
+  if (iter == m_nodes.end() || iter->second.attr_handles == 0)
+    return;
+  Attribute &cached = iter->second.attrs[attr];
+  cached.exists = exists;
+  cached.has_value = exists && value;
+  if (cached.has_value)
+    cached.value.assign((const char *)value, len);
+  else
+    cached.value.clear();
+}
+
+bool ClientCache::get_listing(const string &node, vector<DirEntry> &listing) {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_nodes.find(node);
+  if (iter != m_nodes.end() && iter->second.has_listing) {
+    listing = iter->second.listing;
+    m_hits++;
+    return true;
+  }
+  m_misses++;
+  return false;
+}
+
+void ClientCache::put_listing(const string &node,
+                              const vector<DirEntry> &listing,
+                              uint64_t generation) {
+  lock_guard<mutex> lock(m_mutex);
+  if (generation != m_generation)
+    return;
+  auto iter = m_nodes.find(node);
+  if (iter == m_nodes.end() || iter->second.child_handles == 0)
+    return;
+  iter->second.listing = listing;
+  iter->second.has_listing = true;
+}
+
+bool ClientCache::get_exists(const string &node, bool *exists) {
+  string parent, child;
+  lock_guard<mutex> lock(m_mutex);
+  if (m_nodes.count(node)) {
+    *exists = true;
+    m_hits++;
+    return true;
+  }
+  if (split(node, parent, child)) {
+    auto iter = m_nodes.find(parent);
+    if (iter != m_nodes.end() && iter->second.has_listing) {
+      *exists = false;
+      for (const auto &entry : iter->second.listing) {
+        if (entry.name == child) {
+          *exists = true;
+          break;
+        }
+      }
+      m_hits++;
+      return true;
+    }
+  }
+  m_misses++;
+  return false;
+}
+
+void ClientCache::invalidate_attr(const string &node, const string &attr) {
+  lock_guard<mutex> lock(m_mutex);
+  m_generation++;
+  auto iter = m_nodes.find(node);
+  if (iter != m_nodes.end())
+    iter->second.attrs.erase(attr);
+}
+
+void ClientCache::invalidate_listing(const string &node) {
+  lock_guard<mutex> lock(m_mutex);
+  m_generation++;
+  auto iter = m_nodes.find(node);
+  if (iter != m_nodes.end()) {
+    iter->second.has_listing = false;
+    iter->second.listing.clear();
+  }
+}
+
+void ClientCache::invalidate_node(const string &node) {
+  string parent, child;
+  lock_guard<mutex> lock(m_mutex);
+  m_generation++;
+  auto iter = m_nodes.find(node);
+  if (iter != m_nodes.end()) {
+    iter->second.attrs.clear();
+    iter->second.has_listing = false;
+    iter->second.listing.clear();
+  }
+  if (split(node, parent, child) &&
+      (iter = m_nodes.find(parent)) != m_nodes.end()) {
+    iter->second.has_listing = false;
+    iter->second.listing.clear();
+  }
+}
+
+bool ClientCache::reserve_watch(const string &node) {
+  lock_guard<mutex> lock(m_mutex);
+  if (m_watches.size() >= m_max_watches || m_watches.count(node))
+    return false;
+  auto iter = m_nodes.find(node);
+  if (iter != m_nodes.end() && iter->second.attr_handles > 0)
+    return false;
+  m_watches[node] = 0;
+  return true;
+}
+
+void ClientCache::set_watch(const string &node, uint64_t handle) {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_watches.find(node);
+  if (iter == m_watches.end())
+    return;
+  if (handle)
+    iter->second = handle;
+  else
+    m_watches.erase(iter);
+}
+
+void ClientCache::drop_watch(const string &node, uint64_t handle) {
+  lock_guard<mutex> lock(m_mutex);
+  auto iter = m_watches.find(node);
+  if (iter != m_watches.end() && (iter->second == handle || iter->second == 0))
+    m_watches.erase(iter);
+}
+
+size_t ClientCache::watches() {
+  lock_guard<mutex> lock(m_mutex);
+  return m_watches.size();
+}
+
+void ClientCache::clear() {
+  lock_guard<mutex> lock(m_mutex);
+  m_generation++;
+  for (auto &entry : m_nodes) {
+    entry.second.attrs.clear();
+    entry.second.has_listing = false;
+    entry.second.listing.clear();
+  }
+}
+
+void ClientCache::reset() {
+  lock_guard<mutex> lock(m_mutex);
+  m_generation++;
+  m_nodes.clear();
+  m_watches.clear();
+}
+
+void ClientCache::get_stats(uint64_t *hits, uint64_t *misses) {
+  lock_guard<mutex> lock(m_mutex);
+  *hits = m_hits;
+  *misses = m_misses;
+}
+
+bool ClientCache::split(const string &node, string &parent, string &child) {
+  size_t slash = node.rfind('/');
+  if (slash == string::npos || node.length() == 1)
+    return false;
+  parent = (slash == 0) ? string("/") : node.substr(0, slash);
+  child = node.substr(slash+1);
+  return true;
+}
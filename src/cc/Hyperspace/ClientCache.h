@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for ClientCache.
+/// This file contains declarations for ClientCache, a class that caches
+/// node attributes and directory listings on the client side of a Hyperspace
+/// session.
+
+#ifndef Hyperspace_ClientCache_h
+#define Hyperspace_ClientCache_h
+
+#include <Hyperspace/DirEntry.h>
+#include <Hyperspace/HandleCallback.h>
+
+#include <Common/DynamicBuffer.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Hyperspace {
+
+  /// @addtogroup Hyperspace
+  /// @{
+
+  /// Client-side cache of node attributes and directory listings.
+  /// A node is cached only while the session has it open with a handle whose
+  /// event mask makes the master notify the session of changes to the cached
+  /// data: attribute values require #ATTR_EVENT_MASK and directory listings
+  /// require #CHILD_EVENT_MASK.  The master does not complete a modification
+  /// until all notified sessions have acknowledged the notification, and
+  /// ClientKeepaliveHandler invalidates the cache before acknowledging it, so
+  /// the cache is coherent for as long as the session lease is valid.  The
+  /// session clears the cache whenever it leaves the safe state.
+  ///
+  /// Attributes read by pathname are cached behind watch handles
+  /// (#OPEN_FLAG_WATCH) that the session opens on a cache miss, up to a
+  /// configured limit.  Watch handles do not keep the node from being removed;
+  /// the master closes them instead and notifies the session with an ATTR_DEL
+  /// event with an empty attribute name.
+  ///
+  /// Every invalidation advances a generation number.  Readers that miss the
+  /// cache obtain the generation before sending their request and pass it to
+  /// put_attr() or put_listing(), which discard the result if the cache was
+  /// invalidated while the request was outstanding.
+  class ClientCache {
+  public:
+
+    /// Event mask a handle needs for attribute values to be cached
+    static const uint32_t ATTR_EVENT_MASK =
+      EVENT_MASK_ATTR_SET | EVENT_MASK_ATTR_DEL;
+
+    /// Event mask a handle needs for directory listings to be cached
+    static const uint32_t CHILD_EVENT_MASK =
+      EVENT_MASK_CHILD_NODE_ADDED | EVENT_MASK_CHILD_NODE_REMOVED;
+
+    /// Constructor.
+    /// @param max_watches Maximum number of watch handles
+    ClientCache(size_t max_watches=0) : m_max_watches(max_watches) { }
+
+    /// Registers an open handle.
+    /// @param node Normalized name of node
+    /// @param event_mask Event mask of handle
+    void watch(const std::string &node, uint32_t event_mask);
+
+    /// Unregisters a closed handle.
+    /// Drops the cached data of <code>node</code> once no handle that allows
+    /// it to be cached remains open.
+    /// @param node Normalized name of node
+    /// @param event_mask Event mask of handle
+    void unwatch(const std::string &node, uint32_t event_mask);
+
+    /// Returns current generation.
+    /// @return Generation number
+    uint64_t generation();
+
+    /// Looks up an attribute.
+    /// If the attribute exists and <code>value</code> is not null, the value
+    /// is copied into <code>value</code> and nul-terminated, as done by
+    /// Session::attr_get().
+    /// @param node Normalized name of node
+    /// @param attr Attribute name
+    /// @param value Buffer to receive value, or null if only existence is
+    /// needed
+    /// @param exists Set to <i>true</i> if attribute exists
+    /// @return <i>true</i> on cache hit, <i>false</i> otherwise
+    bool get_attr(const std::string &node, const std::string &attr,
+                  Hypertable::DynamicBuffer *value, bool *exists);
+
+    /// Caches an attribute read from the master.
+    /// @param node Normalized name of node
+    /// @param attr Attribute name
+    /// @param value Attribute value, or null if it was not read
+    /// @param len Length of <code>value</code>
+    /// @param exists <i>true</i> if attribute exists
+    /// @param generation Generation obtained before the request was sent
+    void put_attr(const std::string &node, const std::string &attr,
+                  const void *value, size_t len, bool exists,
+                  uint64_t generation);
+
+    /// Looks up a directory listing.
+    /// @param node Normalized name of directory node
+    /// @param listing Vector to receive listing
+    /// @return <i>true</i> on cache hit, <i>false</i> otherwise
+    bool get_listing(const std::string &node, std::vector<DirEntry> &listing);
+
+    /// Caches a directory listing read from the master.
+    /// @param node Normalized name of directory node
+    /// @param listing Directory listing
+    /// @param generation Generation obtained before the request was sent
+    void put_listing(const std::string &node,
+                     const std::vector<DirEntry> &listing,
+                     uint64_t generation);
+
+    /// Determines whether a node exists.
+    /// A node exists if the session has it open, since the master only
+    /// removes nodes open with watch handles and notifies the session before
+    /// it does, or if it appears in a cached listing of its parent
+    /// directory.
+    /// @param node Normalized name of node
+    /// @param exists Set to <i>true</i> if node exists
+    /// @return <i>true</i> if answered from the cache, <i>false</i> otherwise
+    bool get_exists(const std::string &node, bool *exists);
+
+    /// Invalidates a cached attribute.
+    /// @param node Normalized name of node
+    /// @param attr Attribute name
+    void invalidate_attr(const std::string &node, const std::string &attr);
+
+    /// Invalidates the cached listing of a directory.
+    /// @param node Normalized name of directory node
+    void invalidate_listing(const std::string &node);
+
+    /// Invalidates all cached data of a node and the listing of its parent.
+    /// Called when a node is created or removed.
+    /// @param node Normalized name of node
+    void invalidate_node(const std::string &node);
+
+    /// Reserves a watch handle for a node.
+    /// Called after a read by pathname missed the cache.  If this returns
+    /// <i>true</i>, the caller opens a watch handle and passes it to
+    /// set_watch().
+    /// @param node Normalized name of node
+    /// @return <i>true</i> if the node is neither watched nor open with a
+    /// handle that allows its attributes to be cached, and the maximum number
+    /// of watch handles has not been reached
+    bool reserve_watch(const std::string &node);
+
+    /// Records the watch handle opened for a reserved node.
+    /// @param node Normalized name of node
+    /// @param handle Watch handle, or 0 if it could not be opened
+    void set_watch(const std::string &node, uint64_t handle);
+
+    /// Forgets the watch handle of a removed node.
+    /// @param node Normalized name of node
+    /// @param handle Watch handle closed by the master
+    void drop_watch(const std::string &node, uint64_t handle);
+
+    /// Returns number of watch handles.
+    /// @return Number of watch handles, including reserved ones
+    size_t watches();
+
+    /// Drops all cached data.
+    void clear();
+
+    /// Drops all cached data, all registered handles and all watch handles.
+    /// Called when the session's handles are discarded.
+    void reset();
+
+    /// Gets cache statistics.
+    /// @param hits Set to number of lookups answered from the cache
+    /// @param misses Set to number of lookups not answered from the cache
+    void get_stats(uint64_t *hits, uint64_t *misses);
+
+  private:
+
+    /// Cached attribute
+    struct Attribute {
+      /// <i>true</i> if attribute exists
+      bool exists {};
+      /// <i>true</i> if #value holds the attribute value
+      bool has_value {};
+      /// Attribute value
+      std::string value;
+    };
+
+    /// Cached node
+    struct Node {
+      /// Number of open handles
+      uint32_t handles {};
+      /// Number of open handles with #ATTR_EVENT_MASK
+      uint32_t attr_handles {};
+      /// Number of open handles with #CHILD_EVENT_MASK
+      uint32_t child_handles {};
+      /// Cached attributes
+      std::unordered_map<std::string, Attribute> attrs;
+      /// <i>true</i> if #listing is valid
+      bool has_listing {};
+      /// Cached directory listing
+      std::vector<DirEntry> listing;
+    };
+
+    /// Splits <code>node</code> into parent and child name.
+    /// @param node Normalized name of node
+    /// @param parent Set to normalized name of parent directory
+    /// @param child Set to name of node within parent directory
+    /// @return <i>false</i> if <code>node</code> is the root directory
+    static bool split(const std::string &node, std::string &parent,
+                      std::string &child);
+
+    /// %Mutex serializing access to members
+    std::mutex m_mutex;
+
+    /// Cached nodes, keyed by normalized name
+    std::unordered_map<std::string, Node> m_nodes;
+
+    /// Watch handles, keyed by normalized node name (0 while being opened)
+    std::unordered_map<std::string, uint64_t> m_watches;
+
+    /// Maximum number of watch handles
+    size_t m_max_watches {};
+
+    /// Generation, advanced by every invalidation
+    uint64_t m_generation {};
+
+    /// Number of lookups answered from the cache
+    uint64_t m_hits {};
+
+    /// Number of lookups not answered from the cache
+    uint64_t m_misses {};
+  };
+
+  /// Smart pointer to ClientCache
+  typedef std::shared_ptr<ClientCache> ClientCachePtr;
+
+  /// @}
+
+}
+
+#endif // Hyperspace_ClientCache_h
@@ -43,6 +43,8 @@ namespace Hyperspace {
     int lock_status;
     uint32_t lock_mode;
     uint64_t lock_generation;
+    /// <i>true</i> if registered with the session's ClientCache
+    bool cached {};
     std::mutex mutex;
     std::condition_variable cond;
   };
@@ -195,12 +195,14 @@ void ClientKeepaliveHandler::handle(Hypertable::EventPtr &event) {
           post_notification_size = decode_remain;
 
           std::set<uint64_t> delivered_events;
+          std::set<uint64_t> received_events;
 
           for (uint32_t i=0; i<notifications; i++) {
             handle = decode_i64(&decode_ptr, &decode_remain);
             event_id = decode_i64(&decode_ptr, &decode_remain);
             event_mask = decode_i32(&decode_ptr, &decode_remain);
 
+            received_events.insert(event_id);
             if (m_delivered_events.count(event_id) > 0)
               delivered_events.insert(event_id);
 
@@ -289,6 +291,33 @@ void ClientKeepaliveHandler::handle(Hypertable::EventPtr &event) {
                 event_mask == EVENT_MASK_CHILD_NODE_REMOVED) {
               name = decode_vstr(&decode_ptr, &decode_remain);
 
+              if (event_mask == EVENT_MASK_ATTR_DEL && *name == 0 &&
+                  (handle_state->open_flags & OPEN_FLAG_WATCH)) {
+                // The master removed the node and closed this watch handle
+                if (ClientCache *cache = m_session->get_cache()) {
+                  cache->invalidate_node(handle_state->normal_name);
+                  cache->drop_watch(handle_state->normal_name, handle);
+                  lock_guard<mutex> lock(handle_state->mutex);
+                  if (handle_state->cached) {
+                    cache->unwatch(handle_state->normal_name,
+                                   handle_state->event_mask);
+                    handle_state->cached = false;
+                  }
+                }
+                m_delivered_events.insert(event_id);
+                m_dropped_handles[handle] = event_id;
+                continue;
+              }
+
+              // Invalidate before the notification is acknowledged
+              if (ClientCache *cache = m_session->get_cache()) {
+                if (event_mask == EVENT_MASK_ATTR_SET ||
+                    event_mask == EVENT_MASK_ATTR_DEL)
+                  cache->invalidate_attr(handle_state->normal_name, name);
+                else
+                  cache->invalidate_listing(handle_state->normal_name);
+              }
+
               if (!m_delivered_events.insert(event_id).second)
                 continue;
 
@@ -336,6 +365,18 @@ void ClientKeepaliveHandler::handle(Hypertable::EventPtr &event) {
           }
           **/
 
+          // Forget watch handles closed by the master once it stopped
+          // resending the notification that closed them
+          for (auto iter = m_dropped_handles.begin();
+               iter != m_dropped_handles.end(); ) {
+            if (received_events.count(iter->second) == 0) {
+              m_handle_map.erase(iter->first);
+              iter = m_dropped_handles.erase(iter);
+            }
+            else
+              ++iter;
+          }
+
           if (m_conn_handler->disconnected())
             m_conn_handler->initiate_connection(m_master_addr);
 
@@ -410,6 +451,9 @@ void ClientKeepaliveHandler::expire_session() {
   this_thread::sleep_for(chrono::milliseconds(2000));
   m_conn_handler = 0;
   m_handle_map.clear();
+  m_dropped_handles.clear();
+  if (ClientCache *cache = m_session->get_cache())
+    cache->reset();
   m_bad_handle_map.clear();
   m_session_id = 0;
 
@@ -482,6 +526,9 @@ void ClientKeepaliveHandler::destroy() {
     m_conn_handler->close();
   m_conn_handler = 0;
   m_handle_map.clear();
+  m_dropped_handles.clear();
+  if (ClientCache *cache = m_session->get_cache())
+    cache->reset();
   m_bad_handle_map.clear();
   m_session_id = 0;
   m_comm->close_socket(m_local_addr);
@@ -107,6 +107,9 @@ namespace Hyperspace {
     std::set<uint64_t> m_delivered_events;
     typedef std::unordered_map<uint64_t, ClientHandleStatePtr> HandleMap;
     HandleMap  m_handle_map;
+    /// Watch handles closed by the master, mapped to the id of the event
+    /// that notified their removal
+    std::unordered_map<uint64_t, uint64_t> m_dropped_handles;
     typedef std::unordered_map<uint64_t, std::chrono::steady_clock::time_point> BadNotificationHandleMap;
     BadNotificationHandleMap m_bad_handle_map;
     static const uint64_t ms_bad_notification_grace_period = 120000;
@@ -522,38 +522,13 @@ Hyperspace::Master::mkdir(ResponseCallback *cb, uint64_t session_id, const char
 
 void
 Hyperspace::Master::mkdirs(ResponseCallback *cb, uint64_t session_id, const char *name, const std::vector<Attribute>& init_attrs) {
-  std::vector<EventContext> evts;
   bool commited = false;
   m_metrics_handler->request_increment();
   CommandContext ctx("mkdirs", session_id);
   HT_BDBTXN_BEGIN() {
     commited = false;
     ctx.reset(&txn);
-    bool file_exists;
-    exists(ctx, name, file_exists);
-    if (!ctx.aborted && !file_exists) {
-      typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
-      boost::char_separator<char> sep("/");
-      std::vector<String> name_components;
-      String path(name);
-      tokenizer tokens(path, sep);
-      for (tokenizer::iterator tok_iter = tokens.begin();
-            tok_iter != tokens.end(); ++tok_iter)
-        name_components.push_back(*tok_iter);
-
-      path.clear();
-      for (size_t i=0; i<name_components.size(); i++) {
-        path += String("/") + name_components[i];
-        mkdir(ctx, path.c_str());
-        if (ctx.aborted && ctx.error != Error::HYPERSPACE_FILE_EXISTS)
-          break;
-        if (init_attrs.size() && !ctx.aborted &&
-            i == name_components.size() - 1)
-          attr_set(ctx, 0, name, init_attrs);
-        ctx.reset_error();
-      }
-    }
-
+    mkdirs(ctx, name, init_attrs);
     if (ctx.aborted)
       txn.abort();
     else {
@@ -630,6 +605,104 @@ Hyperspace::Master::unlink(ResponseCallback *cb, uint64_t session_id, const char
 }
 
 
+/*
+ * Batch
+ *
+ * Does the following:
+ *
+ * > Start BDB txn
+ *   > Execute the operations in order, as done by the corresponding
+ *     commands, stopping at the first operation that fails
+ * > Commit BDB txn if all operations succeeded, otherwise abort it
+ * > Deliver notifications
+ * > Destroy handles opened by ATTR_SET operations
+ * > Send per-operation results
+ */
+void
+Hyperspace::Master::batch(ResponseCallbackBatch *cb, uint64_t session_id,
+                          const std::vector<BatchOperation> &ops) {
+  std::vector<BatchResult> results;
+  std::vector<uint64_t> opened_handles;
+  bool commited = false;
+  m_metrics_handler->request_increment();
+  CommandContext ctx("batch", session_id);
+  HT_BDBTXN_BEGIN() {
+    commited = false;
+    results.clear();
+    opened_handles.clear();
+    ctx.reset(&txn);
+    for (const auto &op : ops) {
+      results.emplace_back();
+      const char *name = op.name.c_str();
+      switch (op.type) {
+      case BatchOperation::MKDIR:
+        mkdir(ctx, name);
+        if (op.attrs.size() && !ctx.aborted)
+          attr_set(ctx, 0, name, op.attrs);
+        break;
+      case BatchOperation::MKDIRS:
+        mkdirs(ctx, name, op.attrs);
+        break;
+      case BatchOperation::ATTR_SET:
+        {
+          bool created;
+          uint64_t handle, lock_generation;
+          std::vector<Attribute> none;
+          open(ctx, name, op.oflags, 0, none, handle, created, lock_generation);
+          if (!ctx.aborted) {
+            opened_handles.push_back(handle);
+            attr_set(ctx, handle, 0, op.attrs);
+            close(ctx, handle);
+          }
+        }
+        break;
+      case BatchOperation::ATTR_INCR:
+        attr_incr(ctx, 0, name, op.attr.c_str(), results.back().value);
+        break;
+      case BatchOperation::UNLINK:
+        unlink(ctx, name);
+        break;
+      default:
+        ctx.set_error(Error::PROTOCOL_ERROR,
+                      format("Unknown batch operation type %d", (int)op.type));
+      }
+      if (ctx.aborted) {
+        results.back().error = ctx.error;
+        results.back().error_msg = ctx.error_msg;
+        break;
+      }
+    }
+    if (ctx.aborted)
+      txn.abort();
+    else {
+      txn.commit();
+      commited = true;
+    }
+  }
+  HT_BDBTXN_END_CB(cb);
+
+  // failed operations are reported in the results
+  if (ctx.aborted)
+    HT_INFOF("batch operation %d failed - %s - %s", (int)results.size()-1,
+             Error::get_text(ctx.error), ctx.error_msg.c_str());
+
+  if (commited) {
+    // Deliver notifications
+    deliver_event_notifications(ctx);
+
+    // Destroy handles opened by ATTR_SET operations
+    for (auto handle : opened_handles) {
+      if (!destroy_handle(handle, ctx.error, ctx.error_msg)) {
+        cb->error(ctx.error, ctx.error_msg);
+        return;
+      }
+    }
+  }
+
+  if ((ctx.error = cb->response(results)) != Error::OK)
+    HT_ERRORF("Problem sending back response - %s", Error::get_text(ctx.error));
+}
+
 /*
  * Open
  *
@@ -1711,6 +1784,46 @@ Hyperspace::Master::find_parent_node(const String &normal_name,String &parent_na
   return false;
 }
 
+/*
+ * Assumes it is in the middle of a BDB txn
+ *
+ * > Returns false if some handle not opened with OPEN_FLAG_WATCH is open
+ *   on the node, otherwise returns the node's (watch) handles
+ */
+bool
+Hyperspace::Master::get_watch_handles(BDbTxn &txn, const String &node,
+                                      std::vector<uint64_t> &watch_handles) {
+  std::vector<uint64_t> handles;
+  m_bdb_fs->get_node_handles(txn, node, handles);
+  for (auto handle : handles) {
+    if ((m_bdb_fs->get_handle_open_flags(txn, handle) & OPEN_FLAG_WATCH) == 0)
+      return false;
+  }
+  watch_handles.swap(handles);
+  return true;
+}
+
+/*
+ * Assumes it is in the middle of a BDB txn
+ *
+ * > Deletes watch handles of a node that is being removed.  Their sessions
+ *   learn about it from the node removed notification, so no close request
+ *   will be sent for them.
+ */
+void
+Hyperspace::Master::drop_watch_handles(BDbTxn &txn, const String &node,
+                                       const std::vector<uint64_t> &watch_handles) {
+  for (auto handle : watch_handles) {
+    uint64_t session_id = m_bdb_fs->get_handle_session(txn, handle);
+    if (m_bdb_fs->session_exists(txn, session_id))
+      m_bdb_fs->delete_session_handle(txn, session_id, handle);
+    m_bdb_fs->delete_node_handle(txn, node, handle);
+    m_bdb_fs->delete_handle(txn, handle);
+    HT_INFOF("watch handle %llu of '%s' closed (session=%llu)", (Llu)handle,
+             node.c_str(), (Llu)session_id);
+  }
+}
+
 /*
  * destroy_handle does the following:
  * > Start BDB txn
@@ -1722,10 +1835,11 @@ Hyperspace::Master::find_parent_node(const String &normal_name,String &parent_na
  * > End BDB txn
  * > Deliver notifications
  *
- * > If no one else has this node open
+ * > If no one else but watch handles has this node open
  *   > if this is an ephemeral node
  *     > Start BDB txn
  *       > persist CHILD_NODE_REMOVED event notification
+ *       > persist node removed notifications and close watch handles
  *       > delete node from BDB
  *     > End BDB txn
  *
@@ -1735,9 +1849,10 @@ Hyperspace::Master::destroy_handle(uint64_t handle, int &error, String &errmsg,
                        bool wait_for_notify) {
   bool has_refs = false;
   NotificationMap lock_release_notifications, lock_granted_notifications,
-                  lock_acquired_notifications, node_removed_notifications;
+                  lock_acquired_notifications, node_removed_notifications,
+                  node_watch_notifications;
   HyperspaceEventPtr lock_release_event, lock_granted_event, lock_acquired_event,
-                     node_removed_event ;
+                     node_removed_event, node_watch_event;
   bool node_removed = false;
   String node;
   bool aborted = false;
@@ -1784,13 +1899,26 @@ Hyperspace::Master::destroy_handle(uint64_t handle, int &error, String &errmsg,
   deliver_event_notifications(lock_acquired_event, lock_acquired_notifications,
                               wait_for_notify);
 
-  // txn 3: delete node if ephemeral and no one has it open
+  // txn 3: delete node if ephemeral and no one but watchers has it open
   HT_BDBTXN_BEGIN() {
-    has_refs = m_bdb_fs->node_has_open_handles(txn, node);
+    std::vector<uint64_t> watch_handles;
+    has_refs = !get_watch_handles(txn, node, watch_handles);
     if (!has_refs && m_bdb_fs->node_is_ephemeral(txn, node)) {
       String parent_node, child_node;
 
       if (find_parent_node(node, parent_node, child_node)) {
+        // persist node removed notifications to watchers and close them
+        if (!watch_handles.empty()) {
+          uint64_t event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
+          m_bdb_fs->create_event(txn, EVENT_TYPE_NAMED, event_id,
+                                 EVENT_MASK_ATTR_DEL, "");
+          node_watch_event = make_shared<EventNamed>(event_id, EVENT_MASK_ATTR_DEL, "");
+          if (m_bdb_fs->get_node_event_notification_map(txn, node,
+              EVENT_MASK_ATTR_DEL, node_watch_notifications)) {
+            persist_event_notifications(txn, event_id, node_watch_notifications);
+          }
+          drop_watch_handles(txn, node, watch_handles);
+        }
         // persist child node removed notifications
         uint64_t event_id = m_bdb_fs->get_next_id_i64(txn, EVENT, true);
         m_bdb_fs->create_event(txn, EVENT_TYPE_NAMED, event_id,
@@ -1814,6 +1942,9 @@ Hyperspace::Master::destroy_handle(uint64_t handle, int &error, String &errmsg,
   if (node_removed) {
     deliver_event_notifications(node_removed_event, node_removed_notifications,
                                 wait_for_notify);
+    if (node_watch_event)
+      deliver_event_notifications(node_watch_event, node_watch_notifications,
+                                  wait_for_notify);
   }
 
   // txn 4: delete handle data from BDB
@@ -1921,6 +2052,35 @@ void Hyperspace::Master::mkdir(CommandContext &ctx, const char *name) {
 
 
 
+void Hyperspace::Master::mkdirs(CommandContext &ctx, const char *name,
+                                const std::vector<Attribute> &init_attrs) {
+  bool file_exists;
+  exists(ctx, name, file_exists);
+  if (ctx.aborted || file_exists)
+    return;
+
+  typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+  boost::char_separator<char> sep("/");
+  std::vector<String> name_components;
+  String path(name);
+  tokenizer tokens(path, sep);
+  for (tokenizer::iterator tok_iter = tokens.begin();
+        tok_iter != tokens.end(); ++tok_iter)
+    name_components.push_back(*tok_iter);
+
+  path.clear();
+  for (size_t i=0; i<name_components.size(); i++) {
+    path += String("/") + name_components[i];
+    mkdir(ctx, path.c_str());
+    if (ctx.aborted && ctx.error != Error::HYPERSPACE_FILE_EXISTS)
+      break;
+    if (init_attrs.size() && !ctx.aborted &&
+        i == name_components.size() - 1)
+      attr_set(ctx, 0, name, init_attrs);
+    ctx.reset_error();
+  }
+}
+
 void Hyperspace::Master::open(CommandContext &ctx, const char *name,
           uint32_t flags, uint32_t event_mask,
           std::vector<Attribute> &init_attrs, uint64_t& handle,
@@ -1958,6 +2118,11 @@ void Hyperspace::Master::open(CommandContext &ctx, const char *name,
     return;
   }
 
+  if ((flags & OPEN_FLAG_WATCH) && (flags & ~(OPEN_FLAG_READ|OPEN_FLAG_WATCH))) {
+    ctx.set_error(Error::HYPERSPACE_MODE_RESTRICTION, "WATCH can only be combined with READ");
+    return;
+  }
+
   HT_ASSERT(ctx.txn);
   BDbTxn &txn = *ctx.txn;
 
@@ -2036,8 +2201,10 @@ void Hyperspace::Master::open(CommandContext &ctx, const char *name,
                           HANDLE_NOT_DEL);
   m_bdb_fs->add_session_handle(txn, ctx.session_id, handle);
 
-  // create node added event and persist notifications
-  create_event(ctx, parent_node, EVENT_MASK_CHILD_NODE_ADDED, child_name);
+  // create node added event and persist notifications (watch handles are
+  // opened behind the application's back, so don't report them)
+  if (!(flags & OPEN_FLAG_WATCH))
+    create_event(ctx, parent_node, EVENT_MASK_CHILD_NODE_ADDED, child_name);
 
   /*
     * If open flags LOCK_SHARED or LOCK_EXCLUSIVE, then obtain lock
@@ -2117,8 +2284,8 @@ void Hyperspace::Master::unlink(CommandContext &ctx, const char *name) {
     return;
   }
 
-  bool has_refs = m_bdb_fs->node_has_open_handles(txn, node);
-  if (has_refs) {
+  std::vector<uint64_t> watch_handles;
+  if (!get_watch_handles(txn, node, watch_handles)) {
     ctx.set_error(Error::HYPERSPACE_FILE_OPEN, "File is still open and referred to by some handle");
     return;
   }
@@ -2126,6 +2293,12 @@ void Hyperspace::Master::unlink(CommandContext &ctx, const char *name) {
   // Sanity check
   HT_ASSERT(name[0] == '/' && name[strlen(name)-1] != '/');
 
+  // Notify and close handles that only watch the node
+  if (!watch_handles.empty()) {
+    create_event(ctx, node, EVENT_MASK_ATTR_DEL, "");
+    drop_watch_handles(txn, node, watch_handles);
+  }
+
   // Create event and persist notifications
   create_event(ctx, parent_node, EVENT_MASK_CHILD_NODE_REMOVED, child_name);
 
@@ -30,6 +30,7 @@
 #include <Hyperspace/response/ResponseCallbackAttrGet.h>
 #include <Hyperspace/response/ResponseCallbackAttrIncr.h>
 #include <Hyperspace/response/ResponseCallbackAttrList.h>
+#include <Hyperspace/response/ResponseCallbackBatch.h>
 #include <Hyperspace/response/ResponseCallbackExists.h>
 #include <Hyperspace/response/ResponseCallbackLock.h>
 #include <Hyperspace/response/ResponseCallbackOpen.h>
@@ -117,6 +118,8 @@ namespace Hyperspace {
     void readpath_attr(ResponseCallbackReadpathAttr *cb, uint64_t session_id,
                        uint64_t handle, const char *name, const char *attr);
     void shutdown(ResponseCallback *cb, uint64_t session_id);
+    void batch(ResponseCallbackBatch *cb, uint64_t session_id,
+               const std::vector<BatchOperation> &ops);
     void status(ResponseCallbackStatus *cb);
     void lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t handle,
               uint32_t mode, bool try_lock);
@@ -250,6 +253,8 @@ namespace Hyperspace {
     };
 
     void mkdir(CommandContext &ctx, const char *name);
+    void mkdirs(CommandContext &ctx, const char *name,
+                const std::vector<Attribute> &init_attrs);
     void unlink(CommandContext &ctx, const char *name);
     void open(CommandContext &ctx, const char *name,
               uint32_t flags, uint32_t event_mask,
@@ -311,6 +316,10 @@ namespace Hyperspace {
                           std::string &parent_name, std::string &child_name);
     bool destroy_handle(uint64_t handle, int &error, String &errmsg,
                         bool wait_for_notify=true);
+    bool get_watch_handles(BDbTxn &txn, const String &node,
+                           std::vector<uint64_t> &watch_handles);
+    void drop_watch_handles(BDbTxn &txn, const String &node,
+                            const std::vector<uint64_t> &watch_handles);
     void release_lock(BDbTxn &txn, uint64_t handle, const String &node,
         HyperspaceEventPtr &release_event, NotificationMap &release_notifications);
     void lock_handle(BDbTxn &txn, uint64_t handle, uint32_t mode, String &node);
@@ -28,6 +28,7 @@
 #include <Common/Compat.h>
 
 #include "Protocol.h"
+#include "BatchOperation.h"
 
 #include <AsyncComm/CommHeader.h>
 
@@ -69,7 +70,8 @@ const char *Hyperspace::Protocol::command_strs[COMMAND_MAX] = {
   "readdirattr",
   "attrincr",
   "readpathattr",
-  "shutdown"
+  "shutdown",
+  "batch"
 };
 
 
@@ -520,3 +522,19 @@ CommBuf *Hyperspace::Protocol::create_shutdown_request() {
   CommBuf *cbuf = new CommBuf(header, 0);
   return cbuf;
 }
+
+
+CommBuf *
+Hyperspace::Protocol::create_batch_request(const std::vector<BatchOperation> &ops) {
+  size_t len = 4;
+  for (const auto &op : ops)
+    len += encoded_length_batch_operation(op);
+  CommHeader header(COMMAND_BATCH);
+  if (!ops.empty())
+    header.gid = filename_to_group(ops.front().name);
+  CommBuf *cbuf = new CommBuf(header, len);
+  cbuf->append_i32(ops.size());
+  for (const auto &op : ops)
+    encode_batch_operation(cbuf->get_data_ptr_address(), op);
+  return cbuf;
+}
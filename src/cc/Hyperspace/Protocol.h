@@ -65,6 +65,8 @@ namespace Hyperspace {
     uint32_t value_len;
   };
 
+  struct BatchOperation;
+
   /** %Protocol driver for encoding request messages. */
   class Protocol : public Hypertable::Protocol {
 
@@ -177,6 +179,12 @@ namespace Hyperspace {
     static CommBuf *create_status_request();
     static CommBuf *create_shutdown_request();
 
+    /** Creates a batch request.
+     * @param ops Operations to execute in a single transaction
+     * @return Request message
+     */
+    static CommBuf *create_batch_request(const std::vector<BatchOperation> &ops);
+
     static const uint64_t COMMAND_KEEPALIVE      = 0;
     static const uint64_t COMMAND_HANDSHAKE      = 1;
     static const uint64_t COMMAND_OPEN           = 2;
@@ -202,7 +210,8 @@ namespace Hyperspace {
     static const uint64_t COMMAND_ATTRINCR       = 22;
     static const uint64_t COMMAND_READPATHATTR   = 23;
     static const uint64_t COMMAND_SHUTDOWN       = 24;
-    static const uint64_t COMMAND_MAX            = 25;
+    static const uint64_t COMMAND_BATCH          = 25;
+    static const uint64_t COMMAND_MAX            = 26;
 
     static const char * command_strs[COMMAND_MAX];
 
@@ -50,10 +50,24 @@ using namespace Hypertable;
 using namespace Hyperspace;
 using namespace Serialization;
 
+namespace {
+
+  /// Callback of watch handles.
+  /// Watch handles are only opened to receive the notifications that keep
+  /// the client-side cache coherent, so there is nothing to report.
+  class WatchCallback : public HandleCallback {
+  public:
+    WatchCallback() : HandleCallback(ClientCache::ATTR_EVENT_MASK) { }
+  };
+
+}
+
 
 Session::Session(Comm *comm, PropertiesPtr &cfg)
   : m_comm(comm), m_cfg(cfg), m_verbose(false), m_silent(false),
     m_state(STATE_JEOPARDY), m_last_callback_id(0) {
+  bool cache_enabled {};
+  int32_t max_watches {};
 
   HT_TRY("getting config values",
     m_verbose = cfg->get_bool("Hypertable.Verbose");
@@ -61,11 +75,16 @@ Session::Session(Comm *comm, PropertiesPtr &cfg)
     m_grace_period = cfg->get_i32("Hyperspace.GracePeriod");
     m_lease_interval = cfg->get_i32("Hyperspace.Lease.Interval");
     m_hyperspace_port = cfg->get_i16("Hyperspace.Replica.Port");
-    m_reconnect = cfg->get_bool("Hyperspace.Session.Reconnect"));
+    m_reconnect = cfg->get_bool("Hyperspace.Session.Reconnect");
+    cache_enabled = cfg->get_bool("Hyperspace.Client.Cache.Enable");
+    max_watches = cfg->get_i32("Hyperspace.Client.Cache.MaxWatches"));
 
   if (m_reconnect)
     HT_INFO("Hyperspace session setup to reconnect");
 
+  if (cache_enabled)
+    m_cache = make_shared<ClientCache>(max_watches > 0 ? max_watches : 0);
+
   for (const auto &replica : cfg->get_strs("Hyperspace.Replica.Host")) {
     m_hyperspace_replicas.push_back(replica);
   }
@@ -190,6 +209,12 @@ Session::open(ClientHandleStatePtr &handle_state, CommBufPtr &cbuf_ptr,
       handle_state->lock_generation = decode_i64(&decode_ptr, &decode_remain);
       /** if (createdp) *createdp = cbyte ? true : false; **/
       m_keepalive_handler_ptr->register_handle(handle_state);
+      if (m_cache) {
+        if (open_flags & OPEN_FLAG_CREATE)
+          m_cache->invalidate_node(handle_state->normal_name);
+        m_cache->watch(handle_state->normal_name, handle_state->event_mask);
+        handle_state->cached = true;
+      }
       HT_DEBUG_OUT << "Open succeeded session="
                   << m_keepalive_handler_ptr->get_session_id()
                   << ", name=" << handle_state->normal_name
@@ -266,6 +291,7 @@ void Session::close(uint64_t handle, Timer *timer) {
     if (!sync_handler.wait_for_reply(event_ptr))
       HT_THROW((int)Protocol::response_code(event_ptr.get()),
                "Hyperspace 'close' error");
+    uncache_handle(handle);
     m_keepalive_handler_ptr->unregister_handle(handle);
   }
   else {
@@ -280,6 +306,7 @@ void Session::close_nowait(uint64_t handle) {
     if (m_state != STATE_SAFE)
       return;
   }
+  uncache_handle(handle);
   CommBufPtr cbuf_ptr(Protocol::create_close_request(handle));
   send_message(cbuf_ptr, 0, 0);
 }
@@ -320,7 +347,10 @@ void Session::unlink(const std::string &name, Timer *timer) {
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr))
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    if (m_cache)
+      m_cache->invalidate_node(normal_name);
+    if (!ok)
       HT_THROWF((int)Protocol::response_code(event_ptr.get()),
                 "Hyperspace 'unlink' error, name=%s", normal_name.c_str());
   }
@@ -332,13 +362,67 @@ void Session::unlink(const std::string &name, Timer *timer) {
 }
 
 
+void Session::batch(const std::vector<BatchOperation> &ops,
+                    std::vector<BatchResult> &results, Timer *timer) {
+  DispatchHandlerSynchronizer sync_handler;
+  Hypertable::EventPtr event_ptr;
+  std::vector<BatchOperation> normal_ops(ops);
+
+  for (auto &op : normal_ops) {
+    String normal_name;
+    normalize_name(op.name, normal_name);
+    op.name = normal_name;
+  }
+
+  CommBufPtr cbuf_ptr(Protocol::create_batch_request(normal_ops));
+
+ try_again:
+  if (!wait_for_safe())
+    HT_THROW(Error::HYPERSPACE_EXPIRED_SESSION, "");
+
+  int error = send_message(cbuf_ptr, &sync_handler, timer);
+  if (error == Error::OK) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    if (m_cache) {
+      for (const auto &op : normal_ops)
+        m_cache->invalidate_node(op.name);
+    }
+    if (!ok)
+      HT_THROW((int)Protocol::response_code(event_ptr.get()),
+               "Hyperspace 'batch' error");
+    else {
+      const uint8_t *decode_ptr = event_ptr->payload + 4;
+      size_t decode_remain = event_ptr->payload_len - 4;
+      results.clear();
+      results.resize(decode_i32(&decode_ptr, &decode_remain));
+      for (auto &result : results)
+        decode_batch_result(&decode_ptr, &decode_remain, result);
+      if (!results.empty() && results.back().error != Error::OK)
+        HT_THROWF(results.back().error,
+                  "Hyperspace 'batch' error, operation %d, name=%s - %s",
+                  (int)results.size()-1,
+                  normal_ops[results.size()-1].name.c_str(),
+                  results.back().error_msg.c_str());
+    }
+  }
+  else {
+    state_transition(Session::STATE_JEOPARDY);
+    goto try_again;
+  }
+}
+
+
 bool Session::exists(const std::string &name, Timer *timer) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
   String normal_name;
+  bool bval;
 
   normalize_name(name, normal_name);
 
+  if (cache_usable() && m_cache->get_exists(normal_name, &bval))
+    return bval;
+
   CommBufPtr cbuf_ptr(Protocol::create_exists_request(normal_name));
 
  try_again:
@@ -354,8 +438,7 @@ bool Session::exists(const std::string &name, Timer *timer) {
     else {
       const uint8_t *decode_ptr = event_ptr->payload + 4;
       size_t decode_remain = event_ptr->payload_len - 4;
-      uint8_t bval = decode_byte(&decode_ptr, &decode_remain);
-      return (bval == 0) ? false : true;
+      return decode_byte(&decode_ptr, &decode_remain) != 0;
     }
   }
 
@@ -379,7 +462,9 @@ void Session::attr_set(uint64_t handle, const std::string &attr,
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr)) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    invalidate_cached_attr(handle, attr);
+    if (!ok) {
       ClientHandleStatePtr handle_state;
       String fname = "UNKNOWN";
       if (m_keepalive_handler_ptr->get_handle_state(handle, handle_state))
@@ -409,7 +494,10 @@ void Session::attr_set(uint64_t handle, const std::vector<Attribute> &attrs,
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr)) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    for (const auto &attr : attrs)
+      invalidate_cached_attr(handle, attr.name);
+    if (!ok) {
       ClientHandleStatePtr handle_state;
       String fname = "UNKNOWN";
       if (m_keepalive_handler_ptr->get_handle_state(handle, handle_state))
@@ -444,7 +532,16 @@ void Session::attr_set(const std::string &name, uint32_t oflags, const std::stri
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr)) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    if (m_cache) {
+      String normal_name;
+      normalize_name(name, normal_name);
+      if (oflags & OPEN_FLAG_CREATE)
+        m_cache->invalidate_node(normal_name);
+      else
+        m_cache->invalidate_attr(normal_name, attr);
+    }
+    if (!ok) {
       HT_THROWF((int)Protocol::response_code(event_ptr.get()),
                 "Problem setting attribute '%s' of hyperspace file '%s'",
                 attr.c_str(), name.c_str());
@@ -469,7 +566,17 @@ void Session::attr_set(const std::string &name, uint32_t oflags,
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr)) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    if (m_cache) {
+      String normal_name;
+      normalize_name(name, normal_name);
+      if (oflags & OPEN_FLAG_CREATE)
+        m_cache->invalidate_node(normal_name);
+      else
+        for (const auto &attr : attrs)
+          m_cache->invalidate_attr(normal_name, attr.name);
+    }
+    if (!ok) {
       HT_THROWF((int)Protocol::response_code(event_ptr.get()),
                 "Problem setting attributes of hyperspace file '%s'", name.c_str());
     }
@@ -493,7 +600,9 @@ uint64_t Session::attr_incr(uint64_t handle, const std::string &attr, Timer *tim
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr)) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    invalidate_cached_attr(handle, attr);
+    if (!ok) {
       ClientHandleStatePtr handle_state;
       String fname = "UNKNOWN";
       if (m_keepalive_handler_ptr->get_handle_state(handle, handle_state))
@@ -530,7 +639,13 @@ uint64_t Session::attr_incr(const std::string &name, const std::string &attr, Ti
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr)) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    if (m_cache) {
+      String normal_name;
+      normalize_name(name, normal_name);
+      m_cache->invalidate_attr(normal_name, attr);
+    }
+    if (!ok) {
       HT_THROWF((int)Protocol::response_code(event_ptr.get()),
                 "Problem incrementing attribute '%s' of hyperspace file '%s'",
                 attr.c_str(), name.c_str());
@@ -555,6 +670,21 @@ Session::attr_get(uint64_t handle, const std::string &attr,
                   DynamicBuffer &value, Timer *timer) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
+  String node;
+  uint64_t generation {};
+  bool exists;
+
+  if (cached_node(handle, ClientCache::ATTR_EVENT_MASK, node)) {
+    if (m_cache->get_attr(node, attr, &value, &exists)) {
+      if (!exists)
+        HT_THROWF(Error::HYPERSPACE_ATTR_NOT_FOUND,
+                  "Problem getting attribute '%s' of hyperspace file '%s'",
+                  attr.c_str(), node.c_str());
+      return;
+    }
+    generation = m_cache->generation();
+  }
+
   CommBufPtr cbuf_ptr(Protocol::create_attr_get_request(handle, 0, attr));
 
  try_again:
@@ -568,12 +698,19 @@ Session::attr_get(uint64_t handle, const std::string &attr,
       String fname = "UNKNOWN";
       if (m_keepalive_handler_ptr->get_handle_state(handle, handle_state))
         fname = handle_state->normal_name.c_str();
-      HT_THROWF((int)Protocol::response_code(event_ptr.get()),
+      error = (int)Protocol::response_code(event_ptr.get());
+      if (!node.empty() && error == Error::HYPERSPACE_ATTR_NOT_FOUND)
+        m_cache->put_attr(node, attr, 0, 0, false, generation);
+      HT_THROWF(error,
                 "Problem getting attribute '%s' of hyperspace file '%s'",
                 attr.c_str(), fname.c_str());
     }
-    else
+    else {
       decode_value(event_ptr, value);
+      if (!node.empty())
+        m_cache->put_attr(node, attr, value.base, value.fill(), true,
+                          generation);
+    }
   }
   else {
     state_transition(Session::STATE_JEOPARDY);
@@ -586,6 +723,26 @@ Session::attr_get(const std::string &name, const std::string &attr,
                   DynamicBuffer &value, Timer *timer) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
+  String node;
+  uint64_t generation {};
+  bool exists;
+
+  if (cache_usable()) {
+    normalize_name(name, node);
+    if (m_cache->get_attr(node, attr, &value, &exists)) {
+      if (!exists)
+        HT_THROWF(Error::HYPERSPACE_ATTR_NOT_FOUND,
+                  "Problem getting attribute '%s' of hyperspace file '%s'",
+                  attr.c_str(), name.c_str());
+      return;
+    }
+    if (watch_node(node, timer) == Error::HYPERSPACE_FILE_NOT_FOUND)
+      HT_THROWF(Error::HYPERSPACE_FILE_NOT_FOUND,
+                "Problem getting attribute '%s' of hyperspace file '%s'",
+                attr.c_str(), name.c_str());
+    generation = m_cache->generation();
+  }
+
   CommBufPtr cbuf_ptr(Protocol::create_attr_get_request(0, &name, attr));
 
  try_again:
@@ -595,12 +752,19 @@ Session::attr_get(const std::string &name, const std::string &attr,
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
     if (!sync_handler.wait_for_reply(event_ptr)) {
-      HT_THROWF((int)Protocol::response_code(event_ptr.get()),
+      error = (int)Protocol::response_code(event_ptr.get());
+      if (!node.empty() && error == Error::HYPERSPACE_ATTR_NOT_FOUND)
+        m_cache->put_attr(node, attr, 0, 0, false, generation);
+      HT_THROWF(error,
                 "Problem getting attribute '%s' of hyperspace file '%s'",
                 attr.c_str(), name.c_str());
     }
-    else
+    else {
       decode_value(event_ptr, value);
+      if (!node.empty())
+        m_cache->put_attr(node, attr, value.base, value.fill(), true,
+                          generation);
+    }
   }
   else {
     state_transition(Session::STATE_JEOPARDY);
@@ -686,6 +850,15 @@ Session::attr_exists(uint64_t handle, const std::string& attr, Timer *timer)
 {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
+  String node;
+  uint64_t generation {};
+  bool exists;
+
+  if (cached_node(handle, ClientCache::ATTR_EVENT_MASK, node)) {
+    if (m_cache->get_attr(node, attr, 0, &exists))
+      return exists;
+    generation = m_cache->generation();
+  }
 
   CommBufPtr cbuf_ptr(Protocol::create_attr_exists_request(handle, attr));
 
@@ -702,8 +875,10 @@ Session::attr_exists(uint64_t handle, const std::string& attr, Timer *timer)
     else {
       const uint8_t *decode_ptr = event_ptr->payload + 4;
       size_t decode_remain = event_ptr->payload_len - 4;
-      uint8_t bval = decode_byte(&decode_ptr, &decode_remain);
-      return (bval == 0) ? false : true;
+      exists = decode_byte(&decode_ptr, &decode_remain) != 0;
+      if (!node.empty())
+        m_cache->put_attr(node, attr, 0, 0, exists, generation);
+      return exists;
     }
   }
 
@@ -716,6 +891,19 @@ Session::attr_exists(const std::string& name, const std::string& attr, Timer *ti
 {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
+  String node;
+  uint64_t generation {};
+  bool exists;
+
+  if (cache_usable()) {
+    normalize_name(name, node);
+    if (m_cache->get_attr(node, attr, 0, &exists))
+      return exists;
+    if (watch_node(node, timer) == Error::HYPERSPACE_FILE_NOT_FOUND)
+      HT_THROWF(Error::HYPERSPACE_FILE_NOT_FOUND,
+                "Hyperspace 'attr_exists' error, name=%s", attr.c_str());
+    generation = m_cache->generation();
+  }
 
   CommBufPtr cbuf_ptr(Protocol::create_attr_exists_request(name, attr));
 
@@ -732,8 +920,10 @@ Session::attr_exists(const std::string& name, const std::string& attr, Timer *ti
     else {
       const uint8_t *decode_ptr = event_ptr->payload + 4;
       size_t decode_remain = event_ptr->payload_len - 4;
-      uint8_t bval = decode_byte(&decode_ptr, &decode_remain);
-      return (bval == 0) ? false : true;
+      exists = decode_byte(&decode_ptr, &decode_remain) != 0;
+      if (!node.empty())
+        m_cache->put_attr(node, attr, 0, 0, exists, generation);
+      return exists;
     }
   }
 
@@ -755,7 +945,9 @@ void Session::attr_del(uint64_t handle, const std::string &name, Timer *timer) {
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr)) {
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    invalidate_cached_attr(handle, name);
+    if (!ok) {
       ClientHandleStatePtr handle_state;
       String fname = "UNKNOWN";
       if (m_keepalive_handler_ptr->get_handle_state(handle, handle_state))
@@ -818,6 +1010,15 @@ Session::readdir(uint64_t handle, std::vector<DirEntry> &listing,
                  Timer *timer) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
+  String node;
+  uint64_t generation {};
+
+  if (cached_node(handle, ClientCache::CHILD_EVENT_MASK, node)) {
+    if (m_cache->get_listing(node, listing))
+      return;
+    generation = m_cache->generation();
+  }
+
   CommBufPtr cbuf_ptr(Protocol::create_readdir_request(handle));
 
  try_again:
@@ -852,6 +1053,8 @@ Session::readdir(uint64_t handle, std::vector<DirEntry> &listing,
         }
         listing.push_back(dentry);
       }
+      if (!node.empty())
+        m_cache->put_listing(node, listing, generation);
     }
   }
   else {
@@ -1182,6 +1385,9 @@ int Session::state_transition(int state) {
   lock_guard<mutex> lock(m_mutex);
   int old_state = m_state;
   m_state = state;
+  // Notifications may be missed while the lease is not known to be valid
+  if (m_cache && m_state != STATE_SAFE)
+    m_cache->clear();
   if (m_state == STATE_SAFE) {
     m_cond.notify_all();
     if (old_state == STATE_JEOPARDY) {
@@ -1263,7 +1469,10 @@ void Session::mkdir(const std::string &name, bool create_intermediate, const std
 
   int error = send_message(cbuf_ptr, &sync_handler, timer);
   if (error == Error::OK) {
-    if (!sync_handler.wait_for_reply(event_ptr))
+    bool ok = sync_handler.wait_for_reply(event_ptr);
+    if (m_cache)
+      m_cache->invalidate_node(normal_name);
+    if (!ok)
       HT_THROWF((int)Protocol::response_code(event_ptr.get()),
                 "Hyperspace 'mkdir' error, name=%s", normal_name.c_str());
   }
@@ -1359,6 +1568,7 @@ Session::send_message(CommBufPtr &cbuf_ptr, DispatchHandler *handler,
   int error;
   uint32_t timeout_ms = timer ? (time_t)timer->remaining() : m_timeout_ms;
 
+  m_request_count++;
   if ((error = m_comm->send_request(m_master_addr, timeout_ms, cbuf_ptr,
       handler)) != Error::OK) {
     std::string str;
@@ -1370,6 +1580,89 @@ Session::send_message(CommBufPtr &cbuf_ptr, DispatchHandler *handler,
 }
 
 
+void Session::get_request_stats(uint64_t *requests, uint64_t *cache_hits) {
+  uint64_t misses;
+  *requests = m_request_count;
+  *cache_hits = 0;
+  if (m_cache)
+    m_cache->get_stats(cache_hits, &misses);
+}
+
+
+bool Session::cache_usable() {
+  return m_cache && get_state() == STATE_SAFE;
+}
+
+
+/**
+ * Looks up the node name of an open handle for a cached read.  The read is
+ * only served from and stored in the cache if the handle's event mask
+ * includes all of the events in <code>event_mask</code>.
+ */
+bool Session::cached_node(uint64_t handle, uint32_t event_mask,
+                          std::string &node) {
+  ClientHandleStatePtr handle_state;
+  if (!cache_usable() ||
+      !m_keepalive_handler_ptr->get_handle_state(handle, handle_state) ||
+      (handle_state->event_mask & event_mask) != event_mask)
+    return false;
+  node = handle_state->normal_name;
+  return true;
+}
+
+
+/**
+ * Opens a watch handle on <code>node</code> after a read by pathname missed
+ * the cache, so that the attributes read next can be cached.  Returns the
+ * error of the open request, or Error::OK if no handle had to be opened.
+ */
+int Session::watch_node(const std::string &node, Timer *timer) {
+  if (!m_cache->reserve_watch(node))
+    return Error::OK;
+
+  ClientHandleStatePtr handle_state = make_shared<ClientHandleState>();
+  HandleCallbackPtr callback = make_shared<WatchCallback>();
+  std::vector<Attribute> empty_attrs;
+
+  handle_state->open_flags = OPEN_FLAG_READ | OPEN_FLAG_WATCH;
+  handle_state->event_mask = callback->get_event_mask();
+  handle_state->callback = callback;
+  handle_state->normal_name = node;
+
+  CommBufPtr cbuf_ptr(Protocol::create_open_request(node,
+                      handle_state->open_flags, callback, empty_attrs));
+  try {
+    open(handle_state, cbuf_ptr, timer);
+  }
+  catch (Exception &e) {
+    m_cache->set_watch(node, 0);
+    return e.code();
+  }
+  m_cache->set_watch(node, handle_state->handle);
+  return Error::OK;
+}
+
+
+void Session::invalidate_cached_attr(uint64_t handle, const std::string &attr) {
+  ClientHandleStatePtr handle_state;
+  if (m_cache && m_keepalive_handler_ptr->get_handle_state(handle, handle_state))
+    m_cache->invalidate_attr(handle_state->normal_name, attr);
+}
+
+
+void Session::uncache_handle(uint64_t handle) {
+  ClientHandleStatePtr handle_state;
+  if (m_cache &&
+      m_keepalive_handler_ptr->get_handle_state(handle, handle_state)) {
+    lock_guard<mutex> lock(handle_state->mutex);
+    if (handle_state->cached) {
+      m_cache->unwatch(handle_state->normal_name, handle_state->event_mask);
+      handle_state->cached = false;
+    }
+  }
+}
+
+
 void Session::normalize_name(const String &name, String &normal) {
 
   if (name == "/") {
@@ -22,6 +22,8 @@
 #ifndef Hyperspace_Session_h
 #define Hyperspace_Session_h
 
+#include <Hyperspace/BatchOperation.h>
+#include <Hyperspace/ClientCache.h>
 #include <Hyperspace/ClientKeepaliveHandler.h>
 #include <Hyperspace/DirEntry.h>
 #include <Hyperspace/DirEntryAttr.h>
@@ -41,6 +43,7 @@
 #include <Common/String.h>
 #include <Common/Timer.h>
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <memory>
@@ -82,7 +85,12 @@ namespace Hyperspace {
     /** Atomically open and lock file shared, fail if can't */
     OPEN_FLAG_LOCK_SHARED    = 0x00044,
     /** atomically open and lock file exclusive, fail if can't */
-    OPEN_FLAG_LOCK_EXCLUSIVE = 0x00084
+    OPEN_FLAG_LOCK_EXCLUSIVE = 0x00084,
+    /** Open file only to be notified of changes; the handle does not
+     * prevent the file from being removed, instead it is closed and
+     * an ATTR_DEL event with an empty name is delivered.  Can only be
+     * combined with OPEN_FLAG_READ */
+    OPEN_FLAG_WATCH          = 0x00100
   };
 
   /**
@@ -473,6 +481,20 @@ namespace Hyperspace {
      */
     void unlink(const std::string &name, Timer *timer=0);
 
+    /** Executes a batch of operations atomically.  The operations are
+     * executed in order by the master within a single transaction, so
+     * either all of them take effect or, if one fails, none of them do.
+     * Results are returned for each executed operation; if an operation
+     * fails, <code>results</code> ends with the result of the failed
+     * operation and an exception carrying its error code is thrown.
+     *
+     * @param ops operations to execute
+     * @param results vector to receive per-operation results
+     * @param timer maximum wait timer
+     */
+    void batch(const std::vector<BatchOperation> &ops,
+               std::vector<BatchResult> &results, Timer *timer=0);
+
     /** Gets a directory listing.  The listing comes back as a vector of
      * DireEntry which contains a name and boolean flag indicating if the
      * entry is an element or not.
@@ -693,6 +715,16 @@ namespace Hyperspace {
      */
     void shutdown(Timer *timer=0);
 
+    /// Returns client-side attribute and listing cache (internal method).
+    /// @return Pointer to cache, or null if the cache is disabled
+    ClientCache *get_cache() { return m_cache.get(); }
+
+    /// Gets request statistics.
+    /// @param requests Set to number of requests sent to the master
+    /// @param cache_hits Set to number of reads answered from the
+    /// client-side cache
+    void get_request_stats(uint64_t *requests, uint64_t *cache_hits);
+
   private:
 
     typedef std::unordered_map<uint64_t, SessionCallback *> CallbackMap;
@@ -705,6 +737,11 @@ namespace Hyperspace {
     int send_message(CommBufPtr &, DispatchHandler *, Timer *timer);
     void normalize_name(const std::string &name, std::string &normal);
     uint64_t open(ClientHandleStatePtr &, CommBufPtr &, Timer *timer);
+    bool cache_usable();
+    bool cached_node(uint64_t handle, uint32_t event_mask, std::string &node);
+    int watch_node(const std::string &node, Timer *timer);
+    void invalidate_cached_attr(uint64_t handle, const std::string &attr);
+    void uncache_handle(uint64_t handle);
 
     std::mutex m_mutex;
     std::condition_variable m_cond;
@@ -727,6 +764,11 @@ namespace Hyperspace {
     vector<String>            m_hyperspace_replicas;
     String                    m_hyperspace_master;
 
+    /// Client-side attribute and listing cache (null if disabled)
+    ClientCachePtr            m_cache;
+    /// Number of requests sent to the master
+    std::atomic<uint64_t>     m_request_count {0};
+
     /// Delivers suspend/resume notifications (e.g. laptop close/open).
     SleepWakeNotifier *m_sleep_wake_notifier;
   };
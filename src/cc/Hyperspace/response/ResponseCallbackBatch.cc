@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+
+#include "AsyncComm/CommBuf.h"
+
+#include "ResponseCallbackBatch.h"
+
+using namespace Hyperspace;
+using namespace Hypertable;
+
+/*
+ *
+ */
+int ResponseCallbackBatch::response(const std::vector<BatchResult> &results) {
+  CommHeader header;
+  uint32_t len = 8;
+
+  header.initialize_from_request_header(m_event->header);
+
+  for (const auto &result : results)
+    len += encoded_length_batch_result(result);
+
+  CommBufPtr cbp(new CommBuf(header, len));
+
+  cbp->append_i32(Error::OK);
+  cbp->append_i32(results.size());
+
+  for (const auto &result : results)
+    encode_batch_result(cbp->get_data_ptr_address(), result);
+
+  return m_comm->send_response(m_event->addr, cbp);
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hyperspace/BatchOperation.h>
+#include <Hyperspace/Session.h>
+
+#include <Common/Logger.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  void check_operation(const BatchOperation &op) {
+    size_t length = encoded_length_batch_operation(op);
+    std::vector<uint8_t> buf(length);
+    uint8_t *ptr = buf.data();
+    encode_batch_operation(&ptr, op);
+    HT_ASSERT((size_t)(ptr - buf.data()) == length);
+
+    BatchOperation decoded;
+    const uint8_t *decode_ptr = buf.data();
+    size_t remain = length;
+    decode_batch_operation(&decode_ptr, &remain, decoded);
+    HT_ASSERT(remain == 0);
+
+    HT_ASSERT(decoded.type == op.type);
+    HT_ASSERT(decoded.name == op.name);
+    HT_ASSERT(decoded.oflags == op.oflags);
+    HT_ASSERT(decoded.attr == op.attr);
+    HT_ASSERT(decoded.attrs.size() == op.attrs.size());
+    for (size_t i=0; i<op.attrs.size(); i++) {
+      HT_ASSERT(!strcmp(decoded.attrs[i].name, op.attrs[i].name));
+      HT_ASSERT(decoded.attrs[i].value_len == op.attrs[i].value_len);
+      HT_ASSERT(!memcmp(decoded.attrs[i].value, op.attrs[i].value,
+                        op.attrs[i].value_len));
+    }
+  }
+
+  void test_operations() {
+    std::vector<Attribute> attrs;
+    attrs.push_back(Attribute("id", "2/1", 3));
+    attrs.push_back(Attribute("empty", "", 0));
+    attrs.push_back(Attribute("binary", "a\0b", 3));
+
+    check_operation(BatchOperation(BatchOperation::MKDIR, "/hypertable/a",
+                                   attrs));
+    check_operation(BatchOperation(BatchOperation::MKDIRS, "/a/b/c"));
+    check_operation(BatchOperation(BatchOperation::ATTR_SET, "/a/file", attrs,
+                                   OPEN_FLAG_READ|OPEN_FLAG_WRITE|
+                                   OPEN_FLAG_CREATE|OPEN_FLAG_EXCL));
+    check_operation(BatchOperation(BatchOperation::ATTR_INCR, "/a", "nid"));
+    check_operation(BatchOperation(BatchOperation::UNLINK, "/a/file"));
+  }
+
+  void check_result(const BatchResult &result) {
+    size_t length = encoded_length_batch_result(result);
+    std::vector<uint8_t> buf(length);
+    uint8_t *ptr = buf.data();
+    encode_batch_result(&ptr, result);
+    HT_ASSERT((size_t)(ptr - buf.data()) == length);
+
+    BatchResult decoded;
+    const uint8_t *decode_ptr = buf.data();
+    size_t remain = length;
+    decode_batch_result(&decode_ptr, &remain, decoded);
+    HT_ASSERT(remain == 0);
+
+    HT_ASSERT(decoded.error == result.error);
+    HT_ASSERT(decoded.error_msg == result.error_msg);
+    HT_ASSERT(decoded.value == result.value);
+  }
+
+  void test_results() {
+    BatchResult result;
+    check_result(result);
+
+    result.value = 0xFEDCBA9876543210LL;
+    check_result(result);
+
+    result.error = Error::HYPERSPACE_FILE_EXISTS;
+    result.error_msg = "mode=CREATE|EXCL";
+    result.value = 0;
+    check_result(result);
+  }
+
+  void test_truncated() {
+    BatchOperation op(BatchOperation::ATTR_INCR, "/a", "nid");
+    size_t length = encoded_length_batch_operation(op);
+    std::vector<uint8_t> buf(length);
+    uint8_t *ptr = buf.data();
+    encode_batch_operation(&ptr, op);
+
+    BatchOperation decoded;
+    const uint8_t *decode_ptr = buf.data();
+    size_t remain = length - 1;
+    try {
+      decode_batch_operation(&decode_ptr, &remain, decoded);
+      HT_ASSERT(!"truncated batch operation decoded");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::SERIALIZATION_INPUT_OVERRUN);
+    }
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  test_operations();
+  test_results();
+  test_truncated();
+
+  cout << "SUCCESS" << endl;
+
+  return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hyperspace/ClientCache.h>
+
+#include <Common/Logger.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const uint32_t ATTR_MASK = ClientCache::ATTR_EVENT_MASK;
+  const uint32_t DIR_MASK = ClientCache::CHILD_EVENT_MASK;
+
+  void test_attributes() {
+    ClientCache cache;
+    DynamicBuffer value;
+    bool exists;
+
+    // Nodes not open with a notifying handle are never cached
+    cache.watch("/a", EVENT_MASK_ATTR_SET);
+    cache.put_attr("/a", "x", "1", 1, true, cache.generation());
+    HT_ASSERT(!cache.get_attr("/a", "x", &value, &exists));
+
+    cache.watch("/b", ATTR_MASK);
+    cache.put_attr("/b", "x", "12", 2, true, cache.generation());
+    HT_ASSERT(cache.get_attr("/b", "x", &value, &exists));
+    HT_ASSERT(exists && value.fill() == 2 && !strcmp((char *)value.base, "12"));
+
+    // Negative entries
+    cache.put_attr("/b", "y", 0, 0, false, cache.generation());
+    HT_ASSERT(cache.get_attr("/b", "y", &value, &exists) && !exists);
+
+    // Existence-only entries do not answer value lookups
+    cache.put_attr("/b", "z", 0, 0, true, cache.generation());
+    HT_ASSERT(cache.get_attr("/b", "z", 0, &exists) && exists);
+    HT_ASSERT(!cache.get_attr("/b", "z", &value, &exists));
+
+    // Results of requests that raced with an invalidation are dropped
+    uint64_t generation = cache.generation();
+    cache.invalidate_attr("/b", "x");
+    HT_ASSERT(!cache.get_attr("/b", "x", &value, &exists));
+    cache.put_attr("/b", "x", "old", 3, true, generation);
+    HT_ASSERT(!cache.get_attr("/b", "x", &value, &exists));
+
+    cache.clear();
+    HT_ASSERT(!cache.get_attr("/b", "y", &value, &exists));
+
+    cache.put_attr("/b", "x", "2", 1, true, cache.generation());
+    cache.unwatch("/b", ATTR_MASK);
+    HT_ASSERT(!cache.get_attr("/b", "x", &value, &exists));
+
+    uint64_t hits, misses;
+    cache.get_stats(&hits, &misses);
+    HT_ASSERT(hits == 3);
+  }
+
+  void test_listings() {
+    ClientCache cache;
+    vector<DirEntry> listing, cached;
+    bool exists;
+
+    DirEntry entry;
+    entry.name = "child";
+    entry.is_dir = false;
+    listing.push_back(entry);
+
+    cache.watch("/dir", DIR_MASK);
+    HT_ASSERT(!cache.get_exists("/dir/child", &exists));
+    cache.put_listing("/dir", listing, cache.generation());
+    HT_ASSERT(cache.get_listing("/dir", cached) && cached.size() == 1);
+
+    HT_ASSERT(cache.get_exists("/dir", &exists) && exists);
+    HT_ASSERT(cache.get_exists("/dir/child", &exists) && exists);
+    HT_ASSERT(cache.get_exists("/dir/other", &exists) && !exists);
+
+    // Creating or removing a node invalidates the parent listing
+    cache.invalidate_node("/dir/other");
+    HT_ASSERT(!cache.get_listing("/dir", cached));
+    HT_ASSERT(!cache.get_exists("/dir/other", &exists));
+
+    cache.put_listing("/dir", listing, cache.generation());
+    cache.invalidate_listing("/dir");
+    HT_ASSERT(!cache.get_listing("/dir", cached));
+
+    // Reset forgets open handles
+    cache.reset();
+    HT_ASSERT(!cache.get_exists("/dir", &exists));
+    cache.put_listing("/dir", listing, cache.generation());
+    HT_ASSERT(!cache.get_listing("/dir", cached));
+  }
+
+  void test_watches() {
+    ClientCache cache(2);
+
+    // Nodes already open with a notifying handle need no watch handle
+    cache.watch("/open", ATTR_MASK);
+    HT_ASSERT(!cache.reserve_watch("/open"));
+
+    HT_ASSERT(cache.reserve_watch("/a"));
+    HT_ASSERT(!cache.reserve_watch("/a"));
+    cache.set_watch("/a", 0);
+    HT_ASSERT(cache.watches() == 0);
+
+    HT_ASSERT(cache.reserve_watch("/a"));
+    cache.set_watch("/a", 10);
+    HT_ASSERT(cache.reserve_watch("/b"));
+    cache.set_watch("/b", 11);
+
+    // Limit reached
+    HT_ASSERT(!cache.reserve_watch("/c"));
+
+    // Removal of a node frees its watch
+    cache.drop_watch("/a", 12);
+    HT_ASSERT(cache.watches() == 2);
+    cache.drop_watch("/a", 10);
+    HT_ASSERT(cache.watches() == 1);
+    HT_ASSERT(cache.reserve_watch("/c"));
+
+    // Removal while the watch handle is being opened
+    cache.drop_watch("/c", 13);
+    cache.set_watch("/c", 13);
+    HT_ASSERT(cache.watches() == 1);
+
+    cache.reset();
+    HT_ASSERT(cache.watches() == 0);
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  test_attributes();
+  test_listings();
+  test_watches();
+
+  cout << "SUCCESS" << endl;
+
+  return 0;
+}
@@ -46,7 +46,7 @@ namespace {
   bool desc_inited = false;
 
   PropertiesDesc
-  compressor_desc("  bmz|lzo|quicklz|zlib|snappy|none [compressor_options]\n\n"
+  compressor_desc("  bmz|lzo|quicklz|zlib|snappy|zstd|lz4|none [compressor_options]\n\n"
                   "compressor_options"),
     bloomfilter_desc("  rows|rows+cols|none [bloomfilter_options]\n\n"
                       "  Default bloom filter is defined by the config property:\n"
@@ -67,10 +67,14 @@ namespace {
       ("normal", "Normal setting for zlib")
       ("fp-len", i16()->default_value(19), "Minimum fingerprint length for bmz")
       ("offset", i16()->default_value(0), "Starting fingerprint offset for bmz")
+      ("level", i32(), "Compression level for zstd and lz4 (implies --hc)")
+      ("hc", "High compression mode for lz4")
+      ("dictionary-size", i32()->default_value(0),
+       "Size of dictionary trained per cell store for zstd (0 = disabled)")
       ;
     compressor_hidden_desc.add_options()
       ("compressor-type", str(), 
-       "Compressor type (bmz|lzo|quicklz|zlib|snappy|none)")
+       "Compressor type (bmz|lzo|quicklz|zlib|snappy|zstd|lz4|none)")
       ;
     compressor_pos_desc.add("compressor-type", 1);
 
@@ -83,9 +87,16 @@ namespace {
        "probability for the Bloom filter")
       ("max-approx-items", i32()->default_value(1000), "Number of cell store "
        "items used to guess the number of actual Bloom filter entries")
+      ("prefix-length", i32(), "Length of row key prefix to insert "
+       "into the Bloom filter in prefix mode")
+      ("prefix-delimiter", str(), "Character that ends the row key prefix "
+       "to insert into the Bloom filter in prefix mode")
+      ("blocked", "Place the bits of each item in one cache line "
+       "(faster probes, slightly higher false positive rate)")
       ;
     bloomfilter_hidden_desc.add_options()
-      ("bloom-filter-mode", str(), "Bloom filter mode (rows|rows+cols|none)")
+      ("bloom-filter-mode", str(),
+       "Bloom filter mode (rows|rows+cols|prefix|none)")
       ;
     bloomfilter_pos_desc.add("bloom-filter-mode", 1);
     desc_inited = true;
@@ -291,6 +302,24 @@ void AccessGroupOptions::parse_bloom_filter(const std::string &spec, PropertiesP
            || mode == "rows-cols" || mode == "row-col"
            || mode == "rows_cols" || mode == "row_col")
     props->set("bloom-filter-mode", BLOOM_FILTER_ROWS_COLS);
+  else if (mode == "prefix" || mode == "row-prefix" || mode == "rows-prefix") {
+    bool has_length = props->has("prefix-length");
+    bool has_delimiter = props->has("prefix-delimiter");
+    if (has_length == has_delimiter)
+      HT_THROWF(Error::BAD_SCHEMA, "bloom filter mode '%s' requires one of "
+                "--prefix-length or --prefix-delimiter", mode.c_str());
+    if (has_length) {
+      int32_t length = props->get_i32("prefix-length");
+      if (length < 1 || length > 255)
+        HT_THROWF(Error::BAD_SCHEMA, "invalid bloom filter prefix length: %d "
+                  "(must be 1 - 255)", (int)length);
+    }
+    else if (props->get_str("prefix-delimiter").length() != 1)
+      HT_THROWF(Error::BAD_SCHEMA, "bloom filter prefix delimiter must be a "
+                "single character: '%s'",
+                props->get_str("prefix-delimiter").c_str());
+    props->set("bloom-filter-mode", BLOOM_FILTER_ROW_PREFIX);
+  }
   else
     HT_THROWF(Error::BAD_SCHEMA, "unknown bloom filter mode: '%s'",
                  mode.c_str());
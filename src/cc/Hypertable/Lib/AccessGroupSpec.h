@@ -47,7 +47,9 @@ namespace Hypertable {
     /// Rows only
     BLOOM_FILTER_ROWS,
     /// Rows plus columns
-    BLOOM_FILTER_ROWS_COLS
+    BLOOM_FILTER_ROWS_COLS,
+    /// Row key prefixes
+    BLOOM_FILTER_ROW_PREFIX
   };
 
   /// Specification for access group options.
@@ -139,6 +141,7 @@ namespace Hypertable {
     /// mode:
     ///   rows [options]
     ///   rows+cols [options]
+    ///   prefix (--prefix-length &lt;int&gt; | --prefix-delimiter &lt;char&gt;) [options]
     ///   none
     ///
     /// options:
@@ -146,6 +149,7 @@ namespace Hypertable {
     ///   --num-hashes &lt;int&gt;
     ///   --false-positive &lt;float&gt;
     ///   --max-approx-items &lt;int&gt;
+    ///   --blocked
     /// </pre>
     /// @param bloomfilter Bloom filter specification
     /// @throws Exception with code set to Error::SCHEMA_PARSE_ERROR
@@ -256,7 +260,7 @@ namespace Hypertable {
     /// <td>bloom-filter-mode</td>
     /// <td>string</td>
     /// <td><i>none</i></td>
-    /// <td>Mode (rows|rows+cols|none)</td>
+    /// <td>Mode (rows|rows+cols|prefix|none)</td>
     /// </tr>
     /// <tr>
     /// <td>bits-per-item</td>
@@ -283,7 +287,29 @@ namespace Hypertable {
     /// <td>Number of cell store items used to estimate the number of actual
     /// entries</td>
     /// </tr>
+    /// <tr>
+    /// <td>prefix-length</td>
+    /// <td>int</td>
+    /// <td><i>none</i></td>
+    /// <td>Length of row key prefix inserted in <i>prefix</i> mode (1 - 255)</td>
+    /// </tr>
+    /// <tr>
+    /// <td>prefix-delimiter</td>
+    /// <td>string</td>
+    /// <td><i>none</i></td>
+    /// <td>Character ending row key prefix inserted in <i>prefix</i> mode (the
+    /// prefix includes the delimiter)</td>
+    /// </tr>
+    /// <tr>
+    /// <td>blocked</td>
+    /// <td>flag</td>
+    /// <td><i>false</i></td>
+    /// <td>Use blocked encoding, which places the bits of each item in one
+    /// cache line</td>
+    /// </tr>
     /// </table>
+    /// Exactly one of <i>prefix-length</i> or <i>prefix-delimiter</i> must be
+    /// given in <i>prefix</i> mode.
     /// @param spec Bloom filter specification
     /// @param props Properties object to populate
     static void parse_bloom_filter(const std::string &spec, PropertiesPtr &props);
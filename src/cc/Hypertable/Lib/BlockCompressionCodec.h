@@ -56,7 +56,9 @@ namespace Hypertable {
       LZO=3,      ///< LZO compression
       QUICKLZ=4,  ///< QuickLZ 1.5 compession
       SNAPPY=5,   ///< Snappy compression
-      COMPRESSION_TYPE_LIMIT=6  ///< Limit of compression types
+      ZSTD=6,     ///< Zstandard compression
+      LZ4=7,      ///< LZ4 compression
+      COMPRESSION_TYPE_LIMIT=8  ///< Limit of compression types
     };
 
     /// Compression codec argument vector.
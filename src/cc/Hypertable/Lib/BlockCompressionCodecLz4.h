@@ -0,0 +1,106 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for BlockCompressionCodecLz4.
+/// This file contains declarations for BlockCompressionCodecLz4, a class
+/// for compressing blocks using the LZ4 compression algorithm.
+
+#ifndef Hypertable_Lib_BlockCompressionCodecLz4_h
+#define Hypertable_Lib_BlockCompressionCodecLz4_h
+
+#include <Hypertable/Lib/BlockCompressionCodec.h>
+
+namespace Hypertable {
+
+  /// @addtogroup libHypertable
+  /// @{
+
+  /// Block compressor that uses the LZ4 algorithm.
+  /// This class provides a way to compress and decompress blocks of data using
+  /// the <i>lz4</i> algorithm, which has very fast decompression.  The
+  /// high-compression variant (LZ4HC) trades compression speed for a better
+  /// compression ratio while keeping the same decompression speed.
+  /// The following arguments are supported:
+  /// <table>
+  /// <tr><td>--hc</td><td>Use high-compression (LZ4HC) mode</td></tr>
+  /// <tr><td>--level &lt;n&gt;</td><td>LZ4HC compression level
+  /// (default = 9)</td></tr>
+  /// </table>
+  class BlockCompressionCodecLz4 : public BlockCompressionCodec {
+
+  public:
+
+    /// Constructor.
+    /// @param args Arguments to control compression behavior
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INVALID_ARG
+    BlockCompressionCodecLz4(const Args &args) { set_args(args); }
+
+    /// Destructor.
+    virtual ~BlockCompressionCodecLz4() { }
+
+    /// Sets arguments to control compression behavior.
+    /// @param args Compressor specific arguments
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INVALID_ARG
+    virtual void set_args(const Args &args);
+
+    /// Compresses a buffer using the LZ4 algorithm.
+    /// This method reserves enough space in <code>output</code> to hold the
+    /// serialized <code>header</code> followed by the compressed input followed
+    /// by <code>reserve</code> bytes.  If the resulting compressed buffer is
+    /// larger than the input buffer, then the input buffer is copied directly
+    /// to the output buffer and the compression type is set to
+    /// BlockCompressionCodec::NONE.
+    /// @param input Input buffer
+    /// @param output Output buffer
+    /// @param header Block header populated by function
+    /// @param reserve Additional space to reserve at end of <code>output</code>
+    ///   buffer
+    virtual void deflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockHeader &header, size_t reserve=0);
+
+    /// Decompresses a buffer compressed with the LZ4 algorithm.
+    /// @see deflate() for description of input buffer %format
+    /// @param input Input buffer
+    /// @param output Output buffer
+    /// @param header Block header
+    virtual void inflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockHeader &header);
+
+    /// Returns enum value representing compression type LZ4.
+    /// @see BlockCompressionCodec::LZ4
+    /// @return Compression type (LZ4)
+    virtual int get_type() { return LZ4; }
+
+  private:
+
+    /// Use high-compression mode
+    bool m_hc {};
+
+    /// LZ4HC compression level
+    int m_level {9};
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_Lib_BlockCompressionCodecLz4_h
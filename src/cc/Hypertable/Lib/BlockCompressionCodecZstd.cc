@@ -0,0 +1,226 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for BlockCompressionCodecZstd.
+/// This file contains definitions for BlockCompressionCodecZstd, a class
+/// for compressing blocks using the Zstandard compression algorithm.
+
+#include <Common/Compat.h>
+
+#include "BlockCompressionCodecZstd.h"
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/Checksum.h>
+
+#include <zdict.h>
+
+#include <cstdlib>
+
+using namespace Hypertable;
+using namespace std;
+
+BlockCompressionCodecZstd::BlockCompressionCodecZstd(const Args &args) {
+  set_args(args);
+}
+
+
+BlockCompressionCodecZstd::~BlockCompressionCodecZstd() {
+  ZSTD_freeCDict(m_cdict);
+  ZSTD_freeDDict(m_ddict);
+  ZSTD_freeCCtx(m_cctx);
+  ZSTD_freeDCtx(m_dctx);
+}
+
+#define _NEXT_ARG(_code_) do { \
+  ++it; \
+  HT_EXPECT(it != arg_end, Error::BLOCK_COMPRESSOR_INVALID_ARG); \
+  _code_; \
+} while (0)
+
+void BlockCompressionCodecZstd::set_args(const Args &args) {
+  Args::const_iterator it = args.begin(), arg_end = args.end();
+
+  for (; it != arg_end; ++it) {
+    if (*it == "--level") {
+      _NEXT_ARG(m_level = atoi((*it).c_str()));
+      if (m_level < 1 || m_level > ZSTD_maxCLevel())
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Invalid zstd "
+                  "compression level: %d (must be 1 - %d)", m_level,
+                  ZSTD_maxCLevel());
+      // Digested dictionary embeds the level
+      ZSTD_freeCDict(m_cdict);
+      m_cdict = 0;
+    }
+    else if (*it == "--dictionary-size")
+      _NEXT_ARG(m_dictionary_size = (size_t)strtoul((*it).c_str(), 0, 0));
+    else
+      HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Unrecognized argument "
+                "to zstd codec: '%s'", (*it).c_str());
+  }
+}
+
+
+void BlockCompressionCodecZstd::set_dictionary(const string &dictionary) {
+  ZSTD_freeCDict(m_cdict);
+  ZSTD_freeDDict(m_ddict);
+  m_cdict = 0;
+  m_ddict = 0;
+  m_dictionary = dictionary;
+}
+
+
+string
+BlockCompressionCodecZstd::train_dictionary(const DynamicBuffer &samples,
+                                            const vector<size_t> &sample_sizes,
+                                            size_t dictionary_size) {
+  string dictionary(dictionary_size, '\0');
+  size_t len = ZDICT_trainFromBuffer(&dictionary[0], dictionary_size,
+                                     samples.base, sample_sizes.data(),
+                                     (unsigned)sample_sizes.size());
+  if (ZDICT_isError(len)) {
+    HT_INFOF("Unable to train zstd dictionary from %u samples - %s",
+             (unsigned)sample_sizes.size(), ZDICT_getErrorName(len));
+    return string();
+  }
+  dictionary.resize(len);
+  return dictionary;
+}
+
+
+void
+BlockCompressionCodecZstd::deflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockHeader &header, size_t reserve) {
+  size_t avail_out = ZSTD_compressBound(input.fill());
+
+  output.clear();
+  output.reserve(header.encoded_length() + avail_out + reserve);
+
+  if (m_cctx == 0)
+    m_cctx = ZSTD_createCCtx();
+
+  uint8_t *dst = output.base + header.encoded_length();
+  size_t zlen;
+  if (!m_dictionary.empty()) {
+    if (m_cdict == 0)
+      m_cdict = ZSTD_createCDict(m_dictionary.data(), m_dictionary.size(),
+                                 m_level);
+    zlen = ZSTD_compress_usingCDict(m_cctx, dst, avail_out, input.base,
+                                    input.fill(), m_cdict);
+  }
+  else
+    zlen = ZSTD_compressCCtx(m_cctx, dst, avail_out, input.base, input.fill(),
+                             m_level);
+
+  if (ZSTD_isError(zlen))
+    HT_THROWF(Error::BLOCK_COMPRESSOR_DEFLATE_ERROR, "zstd compression "
+              "error - %s", ZSTD_getErrorName(zlen));
+
+  /* check for an incompressible block */
+  if (zlen >= input.fill()) {
+    header.set_compression_type(NONE);
+    memcpy(dst, input.base, input.fill());
+    header.set_data_length(input.fill());
+    header.set_data_zlength(input.fill());
+  }
+  else {
+    header.set_compression_type(ZSTD);
+    header.set_data_length(input.fill());
+    header.set_data_zlength(zlen);
+  }
+
+  header.set_data_checksum(
+    header.compute_data_checksum(dst, header.get_data_zlength()));
+
+  output.ptr = output.base;
+  header.encode(&output.ptr);
+  output.ptr += header.get_data_zlength();
+}
+
+
+void
+BlockCompressionCodecZstd::inflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockHeader &header) {
+  const uint8_t *msg_ptr = input.base;
+  size_t remaining = input.fill();
+
+  header.decode(&msg_ptr, &remaining);
+
+  if (header.get_data_zlength() > remaining)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Block decompression error, "
+              "header zlength = %lu, actual = %lu",
+              (Lu)header.get_data_zlength(), (Lu)remaining);
+
+  uint32_t checksum =
+    header.compute_data_checksum(msg_ptr, header.get_data_zlength());
+
+  if (checksum != header.get_data_checksum())
+    HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Compressed block "
+              "checksum mismatch header=%lx, computed=%lx",
+              (Lu)header.get_data_checksum(), (Lu)checksum);
+
+  try {
+    output.reserve(header.get_data_length());
+
+    // check compress bit
+    if (header.get_compression_type() == NONE)
+      memcpy(output.base, msg_ptr, header.get_data_length());
+    else {
+      if (m_dctx == 0)
+        m_dctx = ZSTD_createDCtx();
+
+      size_t len;
+      // Every frame compressed with a dictionary, index blocks included,
+      // carries its dictionary ID (CellStoreV7::load_block_index() loads the
+      // dictionary before inflating the index).  Frames compressed without
+      // one, e.g. when dictionary training failed, carry an ID of 0.
+      if (ZSTD_getDictID_fromFrame(msg_ptr, header.get_data_zlength()) != 0) {
+        if (m_dictionary.empty())
+          HT_THROW(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                   "requires a zstd dictionary but none was supplied");
+        if (m_ddict == 0)
+          m_ddict = ZSTD_createDDict(m_dictionary.data(), m_dictionary.size());
+        len = ZSTD_decompress_usingDDict(m_dctx, output.base,
+                                         header.get_data_length(), msg_ptr,
+                                         header.get_data_zlength(), m_ddict);
+      }
+      else
+        len = ZSTD_decompressDCtx(m_dctx, output.base, header.get_data_length(),
+                                  msg_ptr, header.get_data_zlength());
+
+      if (ZSTD_isError(len))
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "inflate error - %s", ZSTD_getErrorName(len));
+
+      if (len != header.get_data_length())
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "inflate error, expected %lu but only inflated to %lu bytes",
+                  (Lu)header.get_data_length(), (Lu)len);
+    }
+
+    output.ptr = output.base + header.get_data_length();
+  }
+  catch (Exception &e) {
+    output.free();
+    throw;
+  }
+}
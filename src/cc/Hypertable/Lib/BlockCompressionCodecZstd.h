@@ -0,0 +1,151 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for BlockCompressionCodecZstd.
+/// This file contains declarations for BlockCompressionCodecZstd, a class
+/// for compressing blocks using the Zstandard compression algorithm.
+
+#ifndef Hypertable_Lib_BlockCompressionCodecZstd_h
+#define Hypertable_Lib_BlockCompressionCodecZstd_h
+
+#include <Hypertable/Lib/BlockCompressionCodec.h>
+
+#include <string>
+#include <vector>
+
+#include <zstd.h>
+
+namespace Hypertable {
+
+  /// @addtogroup libHypertable
+  /// @{
+
+  /// Block compressor that uses the Zstandard algorithm.
+  /// This class provides a way to compress and decompress blocks of data using
+  /// the <i>zstd</i> algorithm, which offers compression ratios close to zlib
+  /// at speeds closer to snappy, with a tunable compression level.  The codec
+  /// can also be given a dictionary (see train_dictionary()), which greatly
+  /// improves the compression ratio of small blocks that share structure.
+  /// The following arguments are supported:
+  /// <table>
+  /// <tr><td>--level &lt;n&gt;</td><td>Compression level, 1 (fastest)
+  /// through ZSTD_maxCLevel() (default = 3)</td></tr>
+  /// <tr><td>--dictionary-size &lt;n&gt;</td><td>Size in bytes of dictionary
+  /// to train per CellStore, 0 disables (default = 0)</td></tr>
+  /// </table>
+  class BlockCompressionCodecZstd : public BlockCompressionCodec {
+
+  public:
+
+    /// Constructor.
+    /// @param args Arguments to control compression behavior
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INVALID_ARG
+    BlockCompressionCodecZstd(const Args &args);
+
+    /// Destructor.
+    /// Frees compression contexts and dictionaries.
+    virtual ~BlockCompressionCodecZstd();
+
+    /// Sets arguments to control compression behavior.
+    /// @param args Compressor specific arguments
+    /// @throws Exception Code set to Error::BLOCK_COMPRESSOR_INVALID_ARG
+    virtual void set_args(const Args &args);
+
+    /// Compresses a buffer using the Zstandard algorithm.
+    /// This method reserves enough space in <code>output</code> to hold the
+    /// serialized <code>header</code> followed by the compressed input followed
+    /// by <code>reserve</code> bytes.  If a dictionary has been set, it is used
+    /// to compress the block.  If the resulting compressed buffer is larger
+    /// than the input buffer, then the input buffer is copied directly to the
+    /// output buffer and the compression type is set to
+    /// BlockCompressionCodec::NONE.
+    /// @param input Input buffer
+    /// @param output Output buffer
+    /// @param header Block header populated by function
+    /// @param reserve Additional space to reserve at end of <code>output</code>
+    ///   buffer
+    virtual void deflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockHeader &header, size_t reserve=0);
+
+    /// Decompresses a buffer compressed with the Zstandard algorithm.
+    /// Blocks compressed with a dictionary can only be decompressed after the
+    /// same dictionary has been supplied with set_dictionary().
+    /// @see deflate() for description of input buffer %format
+    /// @param input Input buffer
+    /// @param output Output buffer
+    /// @param header Block header
+    virtual void inflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockHeader &header);
+
+    /// Sets dictionary used to compress and decompress blocks.
+    /// @param dictionary Dictionary content (e.g. from train_dictionary())
+    void set_dictionary(const std::string &dictionary);
+
+    /// Returns dictionary size requested with <code>--dictionary-size</code>.
+    /// @return Requested dictionary size, 0 if dictionary is disabled
+    size_t get_dictionary_size() const { return m_dictionary_size; }
+
+    /// Trains dictionary from sample blocks.
+    /// @param samples Sample blocks, concatenated
+    /// @param sample_sizes Length of each sample block within
+    /// <code>samples</code>
+    /// @param dictionary_size Maximum size of dictionary
+    /// @return Dictionary content, or empty string if there is not enough
+    /// sample data to train a dictionary
+    static std::string train_dictionary(const DynamicBuffer &samples,
+                                        const std::vector<size_t> &sample_sizes,
+                                        size_t dictionary_size);
+
+    /// Returns enum value representing compression type ZSTD.
+    /// @see BlockCompressionCodec::ZSTD
+    /// @return Compression type (ZSTD)
+    virtual int get_type() { return ZSTD; }
+
+  private:
+
+    /// Compression context
+    ZSTD_CCtx *m_cctx {};
+
+    /// Decompression context
+    ZSTD_DCtx *m_dctx {};
+
+    /// Digested dictionary for compression (created on first use)
+    ZSTD_CDict *m_cdict {};
+
+    /// Digested dictionary for decompression (created on first use)
+    ZSTD_DDict *m_ddict {};
+
+    /// Dictionary content
+    std::string m_dictionary;
+
+    /// Compression level
+    int m_level {3};
+
+    /// Requested dictionary size
+    size_t m_dictionary_size {};
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_Lib_BlockCompressionCodecZstd_h
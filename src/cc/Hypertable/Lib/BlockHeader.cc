@@ -42,14 +42,15 @@ using namespace Hypertable;
 using namespace Serialization;
 
 namespace {
-  const size_t VersionLengths[BlockHeader::LatestVersion+1] = { 26, 28 };
+  const size_t VersionLengths[BlockHeader::LatestVersion+1] = { 26, 28, 29 };
 }
 
 const uint16_t BlockHeader::LatestVersion;
 
 BlockHeader::BlockHeader(uint16_t version, const char *magic) :
   m_flags(0), m_data_length(0), m_data_zlength(0), m_data_checksum(0),
-  m_compression_type((uint16_t)-1), m_version(version) {
+  m_compression_type((uint16_t)-1),
+  m_checksum_type(version >= 2 ? CRC32C : FLETCHER32), m_version(version) {
   HT_ASSERT(version <= LatestVersion);
   if (magic)
     memcpy(m_magic, magic, 10);
@@ -73,6 +74,13 @@ BlockHeader::write_header_checksum(uint8_t *base) {
 }
 
 
+uint32_t BlockHeader::compute_data_checksum(const void *data, size_t len) {
+  if (m_checksum_type == CRC32C)
+    return crc32c(data, len);
+  return fletcher32(data, len);
+}
+
+
 size_t BlockHeader::encoded_length() {
   return VersionLengths[m_version];
 }
@@ -93,6 +101,8 @@ void BlockHeader::encode(uint8_t **bufp) {
 
   *(*bufp)++ = (uint8_t)encoded_length();
   *(*bufp)++ = (uint8_t)m_compression_type;
+  if (m_version >= 2)
+    *(*bufp)++ = m_checksum_type;
   encode_i32(bufp, m_data_checksum);
   encode_i32(bufp, m_data_length);
   encode_i32(bufp, m_data_zlength);
@@ -133,6 +143,13 @@ void BlockHeader::decode(const uint8_t **bufp, size_t *remainp) {
     HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER,
               "Unsupported compression type (%d)", (int)m_compression_type);
 
+  if (m_version >= 2) {
+    m_checksum_type = decode_byte(bufp, remainp);
+    if (m_checksum_type >= CHECKSUM_TYPE_LIMIT)
+      HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER,
+                "Unsupported checksum type (%d)", (int)m_checksum_type);
+  }
+
   m_data_checksum = decode_i32(bufp, remainp);
   m_data_length = decode_i32(bufp, remainp);
   m_data_zlength = decode_i32(bufp, remainp);
@@ -146,6 +163,9 @@ bool BlockHeader::equals(const BlockHeader &other) const {
       m_data_length == other.m_data_length &&
       m_data_zlength == other.m_data_zlength &&
       m_data_checksum == other.m_data_checksum) {
+    if (m_version >= 2)
+      return m_flags == other.m_flags &&
+        m_checksum_type == other.m_checksum_type;
     if (m_version > 0)
       return m_flags == other.m_flags;
     return true;
@@ -28,6 +28,8 @@
 #ifndef HYPERTABLE_BLOCKHEADER_H
 #define HYPERTABLE_BLOCKHEADER_H
 
+#include <Common/Logger.h>
+
 #include <utility>
 
 namespace Hypertable {
@@ -49,12 +51,24 @@ namespace Hypertable {
 
   public:
 
-    static const uint16_t LatestVersion = 1;    
+    static const uint16_t LatestVersion = 2;
+
+    /// Data checksum algorithms.
+    enum ChecksumType {
+      /// fletcher32 (all blocks written with header versions 0 and 1)
+      FLETCHER32 = 0,
+      /// CRC32C (Castagnoli)
+      CRC32C = 1,
+      /// Number of checksum types (must be last)
+      CHECKSUM_TYPE_LIMIT
+    };
 
     /** Constructor.
      * Initializes #m_version to <code>version</code>, #m_magic with the first
      * ten bytes of <code>magic</code>, and initializes all other members to
-     * their default values.
+     * their default values.  The checksum type defaults to CRC32C for
+     * version 2 and later and FLETCHER32 for earlier versions, which have no
+     * checksum type field.
      * @param version Version of block header to initialize
      * @param magic Pointer to magic character sequence
      */
@@ -106,7 +120,8 @@ namespace Hypertable {
     uint32_t get_data_zlength() { return m_data_zlength; }
 
     /** Sets the checksum field.
-     * The checksum field stores the fletcher32 checksum of the compressed data
+     * The checksum field stores the checksum of the compressed data, computed
+     * with compute_data_checksum()
      * @param checksum Checksum of compressed data
      */
     void
@@ -117,6 +132,32 @@ namespace Hypertable {
      */
     uint32_t get_data_checksum() { return m_data_checksum; }
 
+    /** Sets the checksum type field.
+     * Only version 2 and later headers record the checksum type, earlier
+     * versions always use FLETCHER32.
+     * @param type Checksum type (see ChecksumType)
+     */
+    void set_checksum_type(uint8_t type) {
+      HT_ASSERT(type < CHECKSUM_TYPE_LIMIT);
+      HT_ASSERT(m_version >= 2 || type == FLETCHER32);
+      m_checksum_type = type;
+    }
+
+    /** Gets the checksum type field.
+     * @return Checksum type (see ChecksumType)
+     */
+    uint8_t get_checksum_type() { return m_checksum_type; }
+
+    /** Computes checksum of block data.
+     * Computes checksum of <code>data</code> with the algorithm given by the
+     * checksum type field.  This is used to compute the value stored with
+     * set_data_checksum() and to verify data against get_data_checksum().
+     * @param data Pointer to (compressed) block data
+     * @param len Length of data
+     * @return Checksum of data
+     */
+    uint32_t compute_data_checksum(const void *data, size_t len);
+
     /** Sets the compression type field.
      * @param type Compression type (see BlockCompressionCodec::Type)
      */
@@ -178,6 +219,9 @@ namespace Hypertable {
      *   <td>int8</td><td>Compression type</td>
      *   </tr>
      *   <tr>
+     *   <td>int8</td><td>Checksum type (version 2 and later)</td>
+     *   </tr>
+     *   <tr>
      *   <td>int32</td><td>Data checksum</td>
      *   </tr>
      *   <tr>
@@ -228,6 +272,9 @@ namespace Hypertable {
     /// Type of data compression used (see BlockCompressionCodec::Type)
     uint16_t m_compression_type;
 
+    /// Algorithm used to compute #m_data_checksum (see ChecksumType)
+    uint8_t m_checksum_type;
+
   private:
     /// %Serialization format version number
     uint16_t m_version;
@@ -37,8 +37,8 @@ using namespace Hypertable;
 using namespace Serialization;
 
 namespace {
-  const size_t EncodedLengths[BlockHeaderCellStore::LatestVersion+1] = { 0, 0 };
-  const uint16_t BaseVersions[BlockHeaderCellStore::LatestVersion+1] = { 0, 1 };
+  const size_t EncodedLengths[BlockHeaderCellStore::LatestVersion+1] = { 0, 0, 0 };
+  const uint16_t BaseVersions[BlockHeaderCellStore::LatestVersion+1] = { 0, 1, 2 };
 }
 
 const uint16_t BlockHeaderCellStore::LatestVersion;
@@ -45,6 +45,8 @@
 #include <Common/Time.h>
 #include <Common/md5.h>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include <cassert>
 #include <chrono>
 
@@ -68,11 +70,16 @@ CommitLog::~CommitLog() {
 
 void
 CommitLog::initialize(const string &log_dir, PropertiesPtr &props,
-                      CommitLogBase *init_log, bool is_meta) {
+                      CommitLogBase *init_log, bool is_meta, uint32_t lane,
+                      uint32_t lanes) {
   string compressor;
 
+  HT_ASSERT(lanes > 0 && lane < lanes);
+
   m_log_dir = log_dir;
   m_cur_fragment_num = 0;
+  m_lane = lane;
+  m_lanes = lanes;
   m_needs_roll = false;
   m_replication = -1;
 
@@ -85,12 +92,20 @@ CommitLog::initialize(const string &log_dir, PropertiesPtr &props,
 
   HT_TRY("getting commit log properites",
     m_max_fragment_size = cfg.get_i64("RollLimit");
-    compressor = cfg.get_str("Compressor"));
+    compressor = cfg.get_str("Compressor");
+    m_max_outstanding_appends = cfg.get_i32("MaxOutstandingAppends", 8));
+
+  if (m_max_outstanding_appends == 0)
+    m_max_outstanding_appends = 1;
 
   m_compressor.reset(CompressorFactory::create_block_codec(compressor));
 
   boost::trim_right_if(m_log_dir, boost::is_any_of("/"));
 
+  string base_dir = m_log_dir;
+  if (m_lane)
+    m_log_dir = format("%s/%u.lane", base_dir.c_str(), (unsigned)m_lane);
+
   m_range_reference_required = props->get_bool("Hypertable.RangeServer.CommitLog.FragmentRemoval.RangeReferenceRequired");
 
   if (init_log) {
@@ -102,16 +117,14 @@ CommitLog::initialize(const string &log_dir, PropertiesPtr &props,
         m_cur_fragment_num = frag->num + 1;
     }
   }
-  else {  // chose one past the max one found in the directory
-    uint32_t num;
-    std::vector<Filesystem::Dirent> listing;
-    m_fs->readdir(m_log_dir, listing);
-    for (size_t i=0; i<listing.size(); i++) {
-      num = atoi(listing[i].name.c_str());
-      if (num >= m_cur_fragment_num)
-        m_cur_fragment_num = num + 1;
-    }
-  }
+
+  // chose one past the max one found in the directory, including other
+  // lanes since fragment numbers are unique across lanes
+  if (!init_log || m_lanes > 1)
+    skip_existing_fragments(base_dir, true);
+
+  while (m_cur_fragment_num % m_lanes != m_lane)
+    m_cur_fragment_num++;
 
   if (m_range_reference_required)
     HT_INFOF("Range reference for '%s' is required", m_log_dir.c_str());
@@ -136,6 +149,23 @@ CommitLog::initialize(const string &log_dir, PropertiesPtr &props,
 }
 
 
+void CommitLog::skip_existing_fragments(const string &log_dir, bool lanes) {
+  uint32_t num;
+  std::vector<Filesystem::Dirent> listing;
+  m_fs->readdir(log_dir, listing);
+  for (size_t i=0; i<listing.size(); i++) {
+    if (boost::ends_with(listing[i].name, ".lane")) {
+      if (lanes)
+        skip_existing_fragments(log_dir + "/" + listing[i].name, false);
+      continue;
+    }
+    num = atoi(listing[i].name.c_str());
+    if (num >= m_cur_fragment_num)
+      m_cur_fragment_num = num + 1;
+  }
+}
+
+
 int64_t CommitLog::get_timestamp() {
   return get_ts64();
 }
@@ -147,6 +177,12 @@ int CommitLog::flush() {
   try {
     if (m_fd == -1)
       return Error::CLOSED;
+    wait_for_appends(0);
+    if (m_append_error != Error::OK) {
+      error = m_append_error;
+      m_append_error = Error::OK;
+      return error;
+    }
     m_fs->flush(m_fd);
   }
   catch (Exception &e) {
@@ -165,6 +201,12 @@ int CommitLog::sync() {
   try {
     if (m_fd == -1)
       return Error::CLOSED;
+    wait_for_appends(0);
+    if (m_append_error != Error::OK) {
+      error = m_append_error;
+      m_append_error = Error::OK;
+      return error;
+    }
     m_fs->sync(m_fd);
   }
   catch (Exception &e) {
@@ -208,6 +250,101 @@ CommitLog::write(uint64_t cluster_id, DynamicBuffer &buffer, int64_t revision,
 }
 
 
+int
+CommitLog::compress_block(uint64_t cluster_id, DynamicBuffer &buffer,
+                          int64_t revision, DynamicBuffer &zblock) {
+  lock_guard<mutex> lock(m_compressor_mutex);
+  BlockHeaderCommitLog header(MAGIC_DATA, revision, cluster_id);
+
+  try {
+    m_compressor->deflate(buffer, zblock, header);
+  }
+  catch (Exception &e) {
+    HT_ERRORF("Problem compressing commit log block: %s: %s",
+              m_log_dir.c_str(), e.what());
+    return e.code();
+  }
+
+  return Error::OK;
+}
+
+
+int CommitLog::append_block(DynamicBuffer &zblock, int64_t revision) {
+  lock_guard<mutex> lock(m_mutex);
+  int error;
+
+  if (m_needs_roll) {
+    if ((error = roll()) != Error::OK)
+      return error;
+  }
+
+  if (m_fd == -1)
+    return Error::CLOSED;
+
+  // Bound number of appends in flight
+  wait_for_appends(m_max_outstanding_appends - 1);
+
+  try {
+    size_t amount = zblock.fill();
+    StaticBuffer send_buf(zblock);
+
+    m_fs->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_append_handler);
+    m_outstanding_appends++;
+    assert(revision != 0);
+    if (revision > m_latest_revision)
+      m_latest_revision = revision;
+    m_cur_fragment_length += amount;
+  }
+  catch (Exception &e) {
+    HT_ERRORF("Problem writing commit log: %s: %s",
+              m_cur_fragment_fname.c_str(), e.what());
+    return e.code();
+  }
+
+  if (m_cur_fragment_length > m_max_fragment_size) {
+    if ((error = roll()) != Error::OK)
+      return error;
+  }
+
+  return Error::OK;
+}
+
+
+int CommitLog::wait_for_appends() {
+  lock_guard<mutex> lock(m_mutex);
+  wait_for_appends(0);
+  int error = m_append_error;
+  m_append_error = Error::OK;
+  return error;
+}
+
+
+void CommitLog::wait_for_appends(size_t limit) {
+  EventPtr event;
+  uint64_t offset;
+  uint32_t amount;
+
+  while (m_outstanding_appends > limit) {
+    m_outstanding_appends--;
+    try {
+      if (!m_append_handler.wait_for_reply(event)) {
+        if (event->type == Event::ERROR)
+          HT_THROW(event->error, event->to_str());
+        HT_THROW(Protocol::response_code(event),
+                 Protocol::string_format_message(event));
+      }
+      m_fs->decode_response_append(event, &offset, &amount);
+    }
+    catch (Exception &e) {
+      HT_ERRORF("Problem appending to commit log: %s: %s",
+                m_cur_fragment_fname.c_str(), e.what());
+      if (m_append_error == Error::OK)
+        m_append_error = e.code();
+    }
+  }
+}
+
+
 int CommitLog::link_log(uint64_t cluster_id, CommitLogBase *log_base) {
   lock_guard<mutex> lock(m_mutex);
   int error;
@@ -241,7 +378,8 @@ int CommitLog::link_log(uint64_t cluster_id, CommitLogBase *log_base) {
   header.set_compression_type(BlockCompressionCodec::NONE);
   header.set_data_length(log_dir.length() + 1);
   header.set_data_zlength(log_dir.length() + 1);
-  header.set_data_checksum(fletcher32(log_dir.c_str(), log_dir.length()+1));
+  header.set_data_checksum(
+    header.compute_data_checksum(log_dir.c_str(), log_dir.length()+1));
 
   header.encode(&input.ptr);
   input.add(log_dir.c_str(), log_dir.length() + 1);
@@ -292,6 +430,7 @@ int CommitLog::close() {
 
   try {
     if (m_fd >= 0) {
+      wait_for_appends(0);
       m_fs->close(m_fd);
       m_fd = -1;
     }
@@ -418,6 +557,8 @@ int CommitLog::roll(CommitLogFileInfo **clfip) {
     *clfip = 0;
 
   if (m_fd >= 0) {
+    // Outstanding appends must land in this fragment before it is closed
+    wait_for_appends(0);
     try {
       m_fs->close(m_fd);
     }
@@ -450,7 +591,7 @@ int CommitLog::roll(CommitLogFileInfo **clfip) {
 
     m_latest_revision = TIMESTAMP_MIN;
 
-    m_cur_fragment_num++;
+    m_cur_fragment_num += m_lanes;
     m_cur_fragment_fname = m_log_dir + "/" + m_cur_fragment_num;
 
   }
@@ -486,7 +627,10 @@ CommitLog::compress_and_write(DynamicBuffer &input, BlockHeader *header,
     if (m_fd == -1)
       return Error::CLOSED;
 
-    m_compressor->deflate(input, zblock, *header);
+    {
+      lock_guard<mutex> compressor_lock(m_compressor_mutex);
+      m_compressor->deflate(input, zblock, *header);
+    }
 
     size_t amount = zblock.fill();
     StaticBuffer send_buf(zblock);
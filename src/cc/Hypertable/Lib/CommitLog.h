@@ -31,6 +31,8 @@
 #include <Hypertable/Lib/CommitLogBase.h>
 #include <Hypertable/Lib/CommitLogBlockStream.h>
 
+#include <AsyncComm/DispatchHandlerSynchronizer.h>
+
 #include <Common/DynamicBuffer.h>
 #include <Common/String.h>
 #include <Common/Properties.h>
@@ -58,6 +60,22 @@ namespace Hypertable {
    *<pre>
    * Hypertable.RangeServer.CommitLog.RollLimit
    *</pre>
+   * Besides the synchronous write(), blocks can be written in two steps so
+   * that compression overlaps filesystem round trips: compress_block()
+   * compresses a block without touching the log file and append_block()
+   * issues an asynchronous append of the compressed block.  Up to
+   * <code>Hypertable.CommitLog.MaxOutstandingAppends</code> appends may be
+   * in flight at once; flush() and sync() wait for all of them to complete
+   * before flushing or syncing the fragment, so their durability guarantees
+   * cover every block appended before the call.
+   *
+   * A log may be split into several <i>lanes</i> that are written
+   * independently.  Lane 0 lives in the log directory itself and lane
+   * <i>n</i> lives in the subdirectory <code>n.lane</code>.  Lanes share one
+   * fragment number space (lane <i>n</i> of <i>N</i> only uses numbers
+   * congruent to <i>n</i> modulo <i>N</i>), so CommitLogReader can read all
+   * lanes of a log as if they were a single log and a fragment number still
+   * identifies a unique fragment during recovery.
    */
 
   class CommitLog : public CommitLogBase {
@@ -81,12 +99,14 @@ namespace Hypertable {
      * @param props reference to properties map
      * @param init_log base log to pull fragments from
      * @param is_meta true for root, system and metadata logs
+     * @param lane Lane of log written by this object
+     * @param lanes Total number of lanes of log
      */
     CommitLog(FilesystemPtr &fs, const std::string &log_dir,
               PropertiesPtr &props, CommitLogBase *init_log = 0,
-              bool is_meta=true)
+              bool is_meta=true, uint32_t lane=0, uint32_t lanes=1)
       : CommitLogBase(log_dir), m_fs(fs) {
-      initialize(log_dir, props, init_log, is_meta);
+      initialize(log_dir, props, init_log, is_meta, lane, lanes);
     }
 
     /**
@@ -117,13 +137,49 @@ namespace Hypertable {
      */
     int write(uint64_t cluster_id, DynamicBuffer &buffer, int64_t revision, Filesystem::Flags flags);
 
+    /** Compresses a block of updates for a subsequent append_block().
+     * This method does not access the log file and may be called
+     * concurrently with append_block(), flush(), and sync().
+     *
+     * @param cluster_id Originating cluster ID
+     * @param buffer block of updates to compress
+     * @param revision most recent revision in buffer
+     * @param zblock Output buffer to hold compressed block, including header
+     * @return Error::OK on success or error code on failure
+     */
+    int compress_block(uint64_t cluster_id, DynamicBuffer &buffer,
+                       int64_t revision, DynamicBuffer &zblock);
+
+    /** Appends a compressed block to the commit log without waiting.
+     * Issues an asynchronous append of <code>zblock</code>, which must have
+     * been produced by compress_block(), and takes ownership of its memory.
+     * If the maximum number of appends are already outstanding, waits for
+     * the oldest one to complete first.  Errors from appends that complete
+     * in the background are returned by the next flush(), sync(), or
+     * wait_for_appends().
+     *
+     * @param zblock Compressed block
+     * @param revision most recent revision in block
+     * @return Error::OK on success or error code on failure
+     */
+    int append_block(DynamicBuffer &zblock, int64_t revision);
+
+    /** Waits for all outstanding appends to complete.
+     *
+     * @return Error::OK if all appends issued since the last call succeeded,
+     * otherwise error code of first failed append
+     */
+    int wait_for_appends();
+
     /** Flushes previous updates written to commit log.
+     * Waits for outstanding appends before issuing the flush.
      *
      * @return Error::OK on success or error code on failure
      */
     int flush();
 
     /** Sync previous updates written to commit log.
+     * Waits for outstanding appends before issuing the sync.
      *
      * @return Error::OK on success or error code on failure
      */
@@ -201,19 +257,44 @@ namespace Hypertable {
 
   private:
     void initialize(const std::string &log_dir,
-                    PropertiesPtr &, CommitLogBase *init_log, bool is_meta);
+                    PropertiesPtr &, CommitLogBase *init_log, bool is_meta,
+                    uint32_t lane=0, uint32_t lanes=1);
+
+    /** Advances #m_cur_fragment_num past fragments found in a directory.
+     * Lane subdirectories are scanned as well if <code>lanes</code> is
+     * <i>true</i>.
+     *
+     * @param log_dir Directory to scan
+     * @param lanes Also scan lane subdirectories
+     */
+    void skip_existing_fragments(const std::string &log_dir, bool lanes);
     int roll(CommitLogFileInfo **clfip=0);
     int compress_and_write(DynamicBuffer &input, BlockHeader *header,
                            int64_t revision, Filesystem::Flags flags);
     void remove_file_info(CommitLogFileInfo *fi, StringSet &removed_logs);
 
+    /** Waits for outstanding appends to complete.
+     * Must be called with #m_mutex locked.  The error code of the first
+     * failed append is saved in #m_append_error.
+     *
+     * @param limit Wait until no more than this many appends are outstanding
+     */
+    void wait_for_appends(size_t limit);
+
     FilesystemPtr           m_fs;
     std::set<CommitLogFileInfo *> m_reap_set;
     std::unique_ptr<BlockCompressionCodec> m_compressor;
+    std::mutex              m_compressor_mutex;
+    DispatchHandlerSynchronizer m_append_handler;
+    size_t                  m_outstanding_appends {};
+    size_t                  m_max_outstanding_appends;
+    int                     m_append_error {};
     std::string                  m_cur_fragment_fname;
     int64_t                 m_cur_fragment_length;
     int64_t                 m_max_fragment_size;
     uint32_t                m_cur_fragment_num;
+    uint32_t                m_lane {};
+    uint32_t                m_lanes {1};
     int32_t                 m_fd;
     int32_t                 m_replication;
     bool                    m_needs_roll;
@@ -28,8 +28,6 @@
 
 #include "CommitLogBlockStream.h"
 
-#include <FsBroker/Lib/Utility.h>
-
 #include <Common/Checksum.h>
 #include <Common/Config.h>
 #include <Common/Error.h>
@@ -46,8 +44,9 @@ using namespace std;
 
 namespace {
   const uint32_t READAHEAD_BUFFER_SIZE = 131072;
-  const uint32_t LatestVersion = 1;
-  const uint32_t BlockHeaderVersions[LatestVersion+1] = { 0, 1 };
+  const uint32_t ARCHIVE_BUFFER_SIZE = 32768;
+  const uint32_t LatestVersion = 2;
+  const uint32_t BlockHeaderVersions[LatestVersion+1] = { 0, 1, 2 };
 }
 
 bool CommitLogBlockStream::ms_assert_on_error = true;
@@ -299,17 +298,36 @@ bool CommitLogBlockStream::archive_bad_fragment(const string &fname,
     return false;
   }
 
-  FsBroker::Lib::ClientPtr client = dynamic_pointer_cast<FsBroker::Lib::Client>(m_fs);
-  HT_ASSERT(client);
-
-  // Archive file
+  // Archive file.  Copied through the Filesystem interface so that it
+  // works with any filesystem, including the in-process local one.
+  int from_fd = -1;
+  int to_fd = -1;
   try {
-    FsBroker::Lib::copy(client, fname, archive_fname);
+    from_fd = m_fs->open(fname, 0);
+    to_fd = m_fs->create(archive_fname, Filesystem::OPEN_FLAG_OVERWRITE,
+                         -1, -1, -1);
+    StaticBuffer buf(ARCHIVE_BUFFER_SIZE);
+    size_t nread;
+    while ((nread = m_fs->read(from_fd, buf.base, ARCHIVE_BUFFER_SIZE)) > 0) {
+      StaticBuffer send_buf(buf.base, nread, false);
+      m_fs->append(to_fd, send_buf);
+    }
+    m_fs->close(from_fd);
+    from_fd = -1;
+    m_fs->close(to_fd);
   }
   catch (Exception &e) {
     HT_ERRORF("Problem copying file %s to %s - %s (%s)",
               fname.c_str(), archive_fname.c_str(),
               Error::get_text(e.code()), e.what());
+    try {
+      if (from_fd != -1)
+        m_fs->close(from_fd);
+      if (to_fd != -1)
+        m_fs->close(to_fd);
+    }
+    catch (Exception &) {
+    }
     return false;
   }
   
@@ -68,6 +68,11 @@ namespace {
       return num_x < num_y;
     }
   };
+  struct LtFragmentNumber {
+    bool operator()(CommitLogFileInfo *x, CommitLogFileInfo *y) const {
+      return x->num < y->num;
+    }
+  };
 }
 
 CommitLogReader::CommitLogReader(FilesystemPtr &fs, const string &log_dir)
@@ -209,6 +214,43 @@ CommitLogReader::next(const uint8_t **blockp, size_t *lenp,
 }
 
 
+bool
+CommitLogReader::next_compressed(DynamicBuffer &zblock,
+                                 BlockHeaderCommitLog *header) {
+  CommitLogBlockInfo binfo;
+
+  while (next_raw_block(&binfo, header)) {
+
+    if (binfo.error == Error::OK) {
+      // Block stream buffer is reused by the next read, so copy it out
+      zblock.clear();
+      zblock.ensure(binfo.block_len);
+      zblock.add_unchecked(binfo.block_ptr, binfo.block_len);
+
+      if (header->get_revision() > m_latest_revision)
+        m_latest_revision = header->get_revision();
+
+      if (header->get_revision() > m_revision)
+        m_revision = header->get_revision();
+
+      return true;
+    }
+
+    LogFragmentQueue::iterator iter = m_fragment_queue.begin() + m_fragment_queue_offset;
+    HT_WARNF("Corruption detected in CommitLog fragment %s starting at "
+             "postion %lld for %lld bytes - %s",
+             (*iter)->block_stream->get_fname().c_str(),
+             (Lld)binfo.start_offset, (Lld)(binfo.end_offset
+             - binfo.start_offset), Error::get_text(binfo.error));
+  }
+
+  struct LtClfip swo;
+  sort(m_fragment_queue.begin(), m_fragment_queue.end(), swo);
+
+  return false;
+}
+
+
 void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent) {
   vector<Filesystem::Dirent> listing;
   CommitLogFileInfo *fi;
@@ -238,10 +280,18 @@ void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent)
 
   sort(listing.begin(), listing.end(), ByFragmentNumber());
 
+  vector<String> lane_dirs;
+
   for (size_t i = 0; i < listing.size(); i++) {
     if (boost::ends_with(listing[i].name, ".tmp"))
       continue;
 
+    if (boost::ends_with(listing[i].name, ".lane")) {
+      if (parent == 0 && log_dir == m_log_dir)
+        lane_dirs.push_back(log_dir + "/" + listing[i].name);
+      continue;
+    }
+
     if (boost::ends_with(listing[i].name, ".mark")) {
       mark = atoi(listing[i].name.c_str());
       continue;
@@ -249,7 +299,7 @@ void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent)
 
     char *endptr;
     int32_t num = (int32_t)strtol(listing[i].name.c_str(), &endptr, 10);
-    if (m_fragment_filter.size() && log_dir == m_log_dir &&
+    if (m_fragment_filter.size() && parent == 0 &&
       m_fragment_filter.find(num) == m_fragment_filter.end()) {
       if (m_verbose)
         HT_INFOF("Dropping log fragment %s/%d because it is filtered",
@@ -301,6 +351,15 @@ void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent)
       m_range_reference_required = false;
   }
 
+  // Lanes share the fragment number space of the log, so read them as part
+  // of it, in fragment number order
+  if (!lane_dirs.empty()) {
+    for (const auto &lane_dir : lane_dirs)
+      load_fragments(lane_dir, 0);
+    stable_sort(m_fragment_queue.begin(), m_fragment_queue.end(),
+                LtFragmentNumber());
+  }
+
   // Add this log dir to the parent's purge_dirs set or
   // initialize m_init_fragments vector if no parent
   if (parent)
@@ -66,6 +66,16 @@ namespace Hypertable {
     bool next(const uint8_t **blockp, size_t *lenp,
               BlockHeaderCommitLog *);
 
+    /// Reads next block without decompressing it.
+    /// Behaves like next() but copies the still compressed block, header
+    /// included, into <code>zblock</code> so that the caller can decompress
+    /// blocks concurrently (e.g. during parallel log replay).  Revision
+    /// tracking is updated as the block is read.
+    /// @param zblock Buffer to hold compressed block
+    /// @param header Set to header of block
+    /// @return <i>true</i> if a block was read, <i>false</i> at end of log
+    bool next_compressed(DynamicBuffer &zblock, BlockHeaderCommitLog *header);
+
     void reset() {
       m_fragment_queue_offset = 0;
       m_block_buffer.clear();
@@ -370,6 +370,8 @@ namespace {
     "      | quicklz",
     "      | snappy",
     "      | zlib [ zlib_options ]",
+    "      | zstd [ zstd_options ]",
+    "      | lz4 [ lz4_options ]",
     "      | none",
     "",
     "    bmz_options:",
@@ -381,16 +383,30 @@ namespace {
     "      | --best",
     "      | --normal",
     "",
+    "    zstd_options:",
+    "      --level int",
+    "      | --dictionary-size int",
+    "",
+    "    lz4_options:",
+    "      --hc",
+    "      | --level int",
+    "",
     "    bloom_filter_spec:",
     "      rows [ bloom_filter_options ]",
     "      | rows+cols [ bloom_filter_options ]",
+    "      | prefix prefix_option [ bloom_filter_options ]",
     "      | none ",
     "",
+    "    prefix_option:",
+    "      --prefix-length int",
+    "      | --prefix-delimiter char",
+    "",
     "    bloom_filter_options:",
     "      --false-positive float",
     "      --bits-per-item float",
     "      --num-hashes int",
     "      --max-approx-items int",
+    "      --blocked",
     "",
     "Description",
     "-----------",
@@ -540,6 +556,8 @@ namespace {
     "      | quicklz",
     "      | snappy",
     "      | zlib [ zlib_options ]",
+    "      | zstd [ zstd_options ]",
+    "      | lz4 [ lz4_options ]",
     "      | none",
     "",
     "    bmz_options:",
@@ -551,16 +569,30 @@ namespace {
     "      | --best",
     "      | --normal",
     "",
+    "    zstd_options:",
+    "      --level int",
+    "      | --dictionary-size int",
+    "",
+    "    lz4_options:",
+    "      --hc",
+    "      | --level int",
+    "",
     "    bloom_filter_spec:",
     "      rows [ bloom_filter_options ]",
     "      | rows+cols [ bloom_filter_options ]",
+    "      | prefix prefix_option [ bloom_filter_options ]",
     "      | none ",
     "",
+    "    prefix_option:",
+    "      --prefix-length int",
+    "      | --prefix-delimiter char",
+    "",
     "    bloom_filter_options:",
     "      --false-positive float",
     "      --bits-per-item float",
     "      --num-hashes int",
     "      --max-approx-items int",
+    "      --blocked",
     "",
     "    table_option:",
     "      access_group_option",
@@ -811,11 +843,18 @@ namespace {
     "The bloom filter specification can take one of the following forms.  The rows",
     "form, which is the default, causes only row keys to be inserted into the bloom",
     "filter.  The rows+cols form causes the row key concatenated with the column",
-    "family to be inserted into the bloom filter.  none disables the bloom",
-    "filter.",
+    "family to be inserted into the bloom filter.  The prefix form causes a",
+    "prefix of each row key to be inserted into the bloom filter, either the",
+    "first --prefix-length bytes of the row key or the row key up to and",
+    "including the first occurrence of the --prefix-delimiter character.  Scans",
+    "confined to rows that share one prefix (e.g. ROW =^ 'tenant|') can then",
+    "skip cell stores that contain no rows with that prefix.  none disables the",
+    "bloom filter.",
     "",
     "  * rows [ bloom_filter_options ]",
     "  * rows+cols [ bloom_filter_options ]",
+    "  * prefix (--prefix-length int | --prefix-delimiter char)",
+    "    [ bloom_filter_options ]",
     "  * none",
     "",
     "The following describes the bloom filter options:",
@@ -835,8 +874,16 @@ namespace {
     "  --num-hashes arg        Number of hash functions to use.  Must be used in",
     "                          conjunction with --bits-per-item.",
     "",
-    "  --max-approx-items arg  Number of cell store items used to guess the number",
-    "                          of actual bloom filter entries (default = 1000)",
+    "  --max-approx-items arg  Minimum number of cell store items used to guess the",
+    "                          number of actual bloom filter entries, when there",
+    "                          are too many entries to size the filter exactly",
+    "                          (default = 1000)",
+    "",
+    "  --blocked               Place all of the bits for an item in a single",
+    "                          64-byte block, so a lookup costs one cache miss",
+    "                          instead of one per hash function.  The false",
+    "                          positive rate is slightly higher for the same",
+    "                          filter size.",
     "",
     "Compressors",
     "-----------",
@@ -850,6 +897,8 @@ namespace {
     "  * quicklz",
     "  * zlib",
     "  * snappy",
+    "  * zstd",
+    "  * lz4",
     "  * none",
     "",
     "The default code is snappy for cell store blocks.  The following list ",
@@ -859,6 +908,13 @@ namespace {
     "  bmz --offset arg    Starting fingerprint offset (default = 0)",
     "  zlib -9 [ --best ]  Highest compression ratio (at the cost of speed)",
     "  zlib --normal       Normal compression ratio",
+    "  zstd --level arg    Compression level, 1 (fastest) to 22 (default = 3)",
+    "  zstd --dictionary-size arg",
+    "                      Train a dictionary of this many bytes from the first",
+    "                      blocks of each cell store and compress all blocks",
+    "                      with it (default = 0, disabled)",
+    "  lz4 --hc            High compression mode (same decompression speed)",
+    "  lz4 --level arg     High compression level, 1 to 12 (default = 9)",
     "",
     "Table Options",
     "-------------",
@@ -29,10 +29,89 @@
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
 using namespace Hypertable;
 using namespace std;
 
+namespace {
+
+  /// Checks if node key (table name, end row) sorts before the search key.
+  /// A null <code>rowkey</code> denotes the end of the table.
+  template <typename NodeT>
+  inline bool key_less(const NodeT *node, const char *table_name,
+                       const char *rowkey) {
+    int cmp = strcmp(node->table_name, table_name);
+    if (cmp)
+      return cmp < 0;
+    if (node->unbounded)
+      return false;
+    if (rowkey == 0)
+      return true;
+    return strcmp(node->end_row.c_str(), rowkey) < 0;
+  }
+
+}
+
+/** Registers a lookup with the current epoch so that nodes it may reach are
+ * not freed until it finishes.
+ */
+class LocationCache::ReadGuard {
+public:
+  ReadGuard(LocationCache *cache) {
+    Stripe &stripe =
+      cache->m_stripes[hash<thread::id>()(this_thread::get_id()) % STRIPES];
+    while (true) {
+      uint64_t epoch = cache->m_epoch.load();
+      m_readers = &stripe.readers[epoch & 1];
+      m_readers->fetch_add(1);
+      // Pairs with the fence in reclaim(): either reclaim() sees this
+      // reader or this reader sees every unlink made before the epoch advanced
+      atomic_thread_fence(memory_order_seq_cst);
+      if (cache->m_epoch.load() == epoch)
+        break;
+      m_readers->fetch_sub(1, memory_order_release);
+    }
+  }
+  ~ReadGuard() {
+    m_readers->fetch_sub(1, memory_order_release);
+  }
+private:
+  atomic<int64_t> *m_readers;
+};
+
+
+LocationCache::LocationCache(uint32_t max_entries)
+  : m_max_entries(max_entries) {
+  m_head = create_node(MAX_HEIGHT);
+  m_head->table_name = "";
+  for (size_t i=0; i<STRIPES; i++) {
+    m_stripes[i].readers[0] = 0;
+    m_stripes[i].readers[1] = 0;
+  }
+}
+
+
+/**
+ * Destructor
+ */
+LocationCache::~LocationCache() {
+  for (AddressSet::iterator iter = m_addresses.begin();
+       iter != m_addresses.end(); ++iter)
+    delete *iter;
+  Node *node = m_head->next[0].load();
+  while (node) {
+    Node *next = node->next[0].load();
+    free_node(node);
+    node = next;
+  }
+  free_node(m_head);
+  for (auto &retired : m_retired)
+    for (auto node : retired)
+      free_node(node);
+}
+
+
 /**
  * Insert
  */
@@ -40,9 +119,8 @@ void
 LocationCache::insert(const char *table_name, RangeLocationInfo &range_loc_info,
                       bool pegged) {
   lock_guard<mutex> lock(m_mutex);
-  Value *newval = new Value;
-  LocationMap::iterator iter;
-  LocationCacheKey key;
+  Node *preds[MAX_HEIGHT];
+  Node *node;
 
   assert(table_name);
 
@@ -51,78 +129,59 @@ LocationCache::insert(const char *table_name, RangeLocationInfo &range_loc_info,
       << " location=" << location << HT_END;
   */
 
-  newval->start_row = range_loc_info.start_row;
-  newval->end_row = range_loc_info.end_row;
-  newval->addrp = get_constant_address(range_loc_info.addr);
-  newval->pegged = pegged;
-
-  key.table_name = m_strings.get(table_name);
-  key.end_row = (range_loc_info.end_row == "") ? 0 : newval->end_row.c_str();
+  const char *end_row = range_loc_info.end_row.empty() ? 0
+    : range_loc_info.end_row.c_str();
 
   // remove old entry
-  if ((iter = m_location_map.find(key)) != m_location_map.end())
-    remove((*iter).second);
+  node = lower_bound(table_name, end_row);
+  if (node && !strcmp(node->table_name, table_name) &&
+      (end_row ? (!node->unbounded && node->end_row == end_row)
+               : node->unbounded))
+    remove(node);
 
   // make room for the new entry
-  while (m_location_map.size() >= m_max_entries) {
-    if (m_tail->pegged)
-      move_to_head(m_tail);
-    else
-      remove(m_tail);
-  }
-
-  // add to head
-  if (m_head == 0) {
-    assert(m_tail == 0);
-    newval->next = newval->prev = 0;
-    m_head = m_tail = newval;
-  }
-  else {
-    m_head->next = newval;
-    newval->prev = m_head;
-    newval->next = 0;
-    m_head = newval;
-  }
-
-  // Insert the new entry into the map, recording an iterator to the entry
-  {
-    std::pair<LocationMap::iterator, bool> old_entry;
-    LocationMap::value_type map_value(key, newval);
-    old_entry = m_location_map.insert(map_value);
-    assert(old_entry.second);
-    newval->map_iter = old_entry.first;
+  while (m_size >= m_max_entries) {
+    if (!evict())
+      break;
   }
 
+  node = create_node(random_height());
+  node->table_name = m_strings.get(table_name);
+  node->end_row = range_loc_info.end_row;
+  node->start_row = range_loc_info.start_row;
+  node->addrp = get_constant_address(range_loc_info.addr);
+  node->unbounded = (end_row == 0);
+  node->pegged = pegged;
+  node->accessed.store(true, memory_order_relaxed);
+
+  lower_bound(table_name, end_row, preds);
+
+  // Fully initialize the node before publishing it, bottom level first
+  for (int i=0; i<node->height; i++)
+    node->next[i].store(preds[i]->next[i].load(memory_order_relaxed),
+                        memory_order_relaxed);
+  for (int i=0; i<node->height; i++)
+    preds[i]->next[i].store(node, memory_order_release);
+
+  m_size++;
+  reclaim();
 }
 
-/**
- *
- */
-LocationCache::~LocationCache() {
-  for (AddressSet::iterator iter = m_addresses.begin();
-       iter != m_addresses.end(); ++iter)
-    delete *iter;
-  for (LocationMap::iterator lm_it = m_location_map.begin();
-       lm_it != m_location_map.end(); ++lm_it)
-    delete (*lm_it).second;
-}
-
-
 /**
  * Lookup
  */
 bool
 LocationCache::lookup(const char * table_name, const char *rowkey,
                       RangeLocationInfo *range_loc_infop, bool inclusive) {
-  lock_guard<mutex> lock(m_mutex);
+  ReadGuard guard(this);
 
-  Value* cacheval;
-  if (!lookup(table_name, rowkey, cacheval, inclusive))
+  Node *node = lookup(table_name, rowkey, inclusive);
+  if (node == 0)
     return false;
 
-  range_loc_infop->start_row = cacheval->start_row;
-  range_loc_infop->end_row   = cacheval->end_row;
-  range_loc_infop->addr      = *cacheval->addrp;
+  range_loc_infop->start_row = node->start_row;
+  range_loc_infop->end_row   = node->end_row;
+  range_loc_infop->addr      = *node->addrp;
 
   return true;
 }
@@ -130,44 +189,37 @@ LocationCache::lookup(const char * table_name, const char *rowkey,
 bool
 LocationCache::lookup(const char * table_name, const char *rowkey,
                       RangeAddrInfo *range_addr_infop, bool inclusive) {
-  lock_guard<mutex> lock(m_mutex);
+  ReadGuard guard(this);
 
-  Value* cacheval;
-  if (!lookup(table_name, rowkey, cacheval, inclusive))
+  Node *node = lookup(table_name, rowkey, inclusive);
+  if (node == 0)
     return false;
 
-  range_addr_infop->addr = *cacheval->addrp;
+  range_addr_infop->addr = *node->addrp;
 
   return true;
 }
 
 bool LocationCache::invalidate(const char *table_name, const char *rowkey) {
   lock_guard<mutex> lock(m_mutex);
-  LocationMap::iterator iter;
-  LocationCacheKey key;
 
   assert(table_name);
 
   //cout << table_name << " row=" << rowkey << endl << flush;
 
-  key.table_name = table_name;
-  key.end_row = rowkey;
-
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
+  Node *node = lower_bound(table_name, rowkey);
+  if (node == 0)
     return false;
 
-  if (strcmp((*iter).first.table_name, table_name))
+  if (strcmp(node->table_name, table_name))
     return false;
 
-#if 0
-  if (rowkey && strcmp(rowkey, (*iter).second->start_row.c_str()) < 0)
-    return false;
-#endif
-  if ((rowkey == 0 && !(*iter).second->start_row.empty()) ||
-      (rowkey && strcmp(rowkey, (*iter).second->start_row.c_str()) < 0))
+  if ((rowkey == 0 && !node->start_row.empty()) ||
+      (rowkey && strcmp(rowkey, node->start_row.c_str()) < 0))
     return false;
 
-  remove((*iter).second);
+  remove(node);
+  reclaim();
   return true;
 }
 
@@ -178,103 +230,185 @@ void LocationCache::invalidate_host(const string &hostname) {
   addr.set_proxy(hostname);
   const CommAddress *addrp = get_constant_address(addr);
 
-  LocationMap::iterator iter = m_location_map.begin();
-  Value *val = 0;
-  while (iter != m_location_map.end()) {
-    val = 0;
-    if (iter->second->addrp == addrp)
-      val = iter->second;
-    ++iter;
-    if (val)
-      remove(val);
-  }
+  vector<Node *> nodes;
+  for (Node *node = m_head->next[0].load(); node; node = node->next[0].load())
+    if (node->addrp == addrp)
+      nodes.push_back(node);
+  for (auto node : nodes)
+    remove(node);
+  reclaim();
 }
 
 
 void LocationCache::display(std::ostream &out) {
-  for (Value *value = m_head; value; value = value->prev)
-    out << "DUMP: end=" << value->end_row << " start=" << value->start_row
+  lock_guard<mutex> lock(m_mutex);
+  for (Node *node = m_head->next[0].load(); node; node = node->next[0].load())
+    out << "DUMP: end=" << node->end_row << " start=" << node->start_row
         << endl;
 }
 
-bool LocationCache::lookup(const char * table_name, const char *rowkey,
-                           Value*& cacheval, bool inclusive) {
-  LocationMap::iterator iter;
-  LocationCacheKey key;
 
-  assert(table_name);
+LocationCache::Node *LocationCache::create_node(int height) {
+  void *mem = operator new(sizeof(Node) + (height-1)*sizeof(atomic<Node *>));
+  Node *node = new (mem) Node();
+  node->height = height;
+  node->accessed.store(false, memory_order_relaxed);
+  node->next[0].store(0, memory_order_relaxed);
+  for (int i=1; i<height; i++)
+    new (&node->next[i]) atomic<Node *>(0);
+  return node;
+}
 
-  key.table_name = table_name;
-  key.end_row = rowkey;
 
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
-    return false;
+void LocationCache::free_node(Node *node) {
+  node->~Node();
+  operator delete(node);
+}
 
-  if (strcmp((*iter).first.table_name, table_name))
-    return false;
+
+int LocationCache::random_height() {
+  int height = 1;
+  // xorshift, only called with the mutex held
+  while (height < MAX_HEIGHT) {
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    if (m_random == 0)
+      m_random = 2463534242U;
+    if (m_random & 3)
+      break;
+    height++;
+  }
+  return height;
+}
+
+
+LocationCache::Node *
+LocationCache::lower_bound(const char *table_name, const char *rowkey,
+                           Node **preds) {
+  Node *node = m_head;
+  for (int i=MAX_HEIGHT-1; i>=0; i--) {
+    Node *next = node->next[i].load(memory_order_acquire);
+    while (next && key_less(next, table_name, rowkey)) {
+      node = next;
+      next = node->next[i].load(memory_order_acquire);
+    }
+    if (preds)
+      preds[i] = node;
+  }
+  return node->next[0].load(memory_order_acquire);
+}
+
+
+LocationCache::Node *
+LocationCache::lookup(const char * table_name, const char *rowkey,
+                      bool inclusive) {
+  assert(table_name);
+
+  Node *node = lower_bound(table_name, rowkey);
+  if (node == 0)
+    return 0;
+
+  if (strcmp(node->table_name, table_name))
+    return 0;
 
   if (inclusive) {
-    if (strcmp(rowkey, (*iter).second->start_row.c_str()) < 0)
-      return false;
+    if (strcmp(rowkey, node->start_row.c_str()) < 0)
+      return 0;
   }
   else {
-    if (strcmp(rowkey, (*iter).second->start_row.c_str()) <= 0)
-      return false;
+    if (strcmp(rowkey, node->start_row.c_str()) <= 0)
+      return 0;
   }
 
-  cacheval = (*iter).second;
-  move_to_head(cacheval);
+  // Avoid dirtying the cache line if the bit is already set
+  if (!node->accessed.load(memory_order_relaxed))
+    node->accessed.store(true, memory_order_relaxed);
 
-  return true;
+  return node;
 }
 
 
 /**
- * MoveToHead
+ * Unlinks node from the skiplist and retires it.  Must be called with the
+ * mutex held.
  */
-void LocationCache::move_to_head(Value *cacheval) {
-
-  if (m_head == cacheval)
-    return;
+void LocationCache::remove(Node *node) {
+  Node *preds[MAX_HEIGHT];
+
+  assert(node);
+  lower_bound(node->table_name, node->unbounded ? 0 : node->end_row.c_str(),
+              preds);
+
+  if (m_hand == node)
+    m_hand = node->next[0].load(memory_order_relaxed);
+
+  // The node keeps its forward pointers so readers positioned on it can
+  // continue their traversal
+  for (int i=node->height-1; i>=0; i--) {
+    assert(preds[i]->next[i].load(memory_order_relaxed) == node);
+    preds[i]->next[i].store(node->next[i].load(memory_order_relaxed),
+                            memory_order_release);
+  }
 
-  // unstich entry from cache
-  cacheval->next->prev = cacheval->prev;
-  if (cacheval->prev == 0)
-    m_tail = cacheval->next;
-  else
-    cacheval->prev->next = cacheval->next;
-
-  cacheval->next = 0;
-  cacheval->prev = m_head;
-  m_head->next = cacheval;
-  m_head = cacheval;
+  m_size--;
+  m_retired[m_epoch.load(memory_order_relaxed) & 1].push_back(node);
+  m_generation.fetch_add(1, memory_order_release);
 }
 
 
 /**
- * remove
+ * Evicts one entry using the CLOCK algorithm.  Entries accessed since the
+ * hand last passed them get a second chance.  Must be called with the
+ * mutex held.
+ * @return <i>true</i> if an entry was evicted, <i>false</i> if all entries
+ * are pegged
  */
-void LocationCache::remove(Value *cacheval) {
-  assert(cacheval);
-  if (m_tail == cacheval) {
-    m_tail = cacheval->next;
-    if (m_tail)
-      m_tail->prev = 0;
-    else {
-      assert (m_head == cacheval);
-      m_head = 0;
+bool LocationCache::evict() {
+  // Two full sweeps clear every access bit, so give up after that
+  for (size_t scanned = 0; scanned <= 2*m_size; scanned++) {
+    if (m_hand == 0)
+      m_hand = m_head->next[0].load(memory_order_relaxed);
+    if (m_hand == 0)
+      return false;
+    Node *node = m_hand;
+    m_hand = node->next[0].load(memory_order_relaxed);
+    if (node->pegged)
+      continue;
+    if (node->accessed.load(memory_order_relaxed)) {
+      node->accessed.store(false, memory_order_relaxed);
+      continue;
     }
+    remove(node);
+    return true;
   }
-  else if (m_head == cacheval) {
-    m_head = m_head->prev;
-    m_head->next = 0;
-  }
-  else {
-    cacheval->next->prev = cacheval->prev;
-    cacheval->prev->next = cacheval->next;
-  }
-  m_location_map.erase(cacheval->map_iter);
-  delete cacheval;
+  return false;
+}
+
+
+/**
+ * Advances the epoch if no reader of the previous epoch remains, freeing
+ * the nodes retired during the previous epoch.  Must be called with the
+ * mutex held.
+ */
+void LocationCache::reclaim() {
+  uint64_t epoch = m_epoch.load(memory_order_relaxed);
+
+  atomic_thread_fence(memory_order_seq_cst);
+
+  int64_t readers = 0;
+  for (size_t i=0; i<STRIPES; i++)
+    readers += m_stripes[i].readers[(epoch + 1) & 1].load(memory_order_acquire);
+  if (readers)
+    return;
+
+  // Readers of the previous epoch are gone and readers of the current epoch
+  // started after those nodes were unlinked
+  for (auto node : m_retired[(epoch + 1) & 1])
+    free_node(node);
+  m_retired[(epoch + 1) & 1].clear();
+
+  m_epoch.store(epoch + 1);
 }
 
 
@@ -288,4 +422,3 @@ const CommAddress *LocationCache::get_constant_address(const CommAddress &addr)
   m_addresses.insert(new_addr);
   return new_addr;
 }
-
@@ -28,75 +28,33 @@
 #include <Common/InetAddr.h>
 #include <Common/StringExt.h>
 
+#include <atomic>
 #include <cstring>
 #include <ostream>
-#include <map>
 #include <mutex>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace Hypertable {
 
   /**
-   * Key type for Range location cache
-   */
-  struct LocationCacheKey {
-    const char *table_name;
-    const char *end_row;
-  };
-
-  /**
-   * Less than operator for LocationCacheKey
-   */
-  inline bool operator<(const LocationCacheKey &x, const LocationCacheKey &y) {
-    int cmp = strcmp(x.table_name, y.table_name);
-    if (cmp)
-      return cmp < 0;
-    if (y.end_row == 0)
-      return (x.end_row == 0) ? false : true;
-    else if (x.end_row == 0)
-      return false;
-    return strcmp(x.end_row, y.end_row) < 0;
-  }
-
-  /**
-   * Equality operator for LocationCacheKey
-   */
-  inline bool operator==(const LocationCacheKey &x, const LocationCacheKey &y) {
-    if (strcmp(x.table_name, y.table_name))
-      return false;
-    if (x.end_row == 0)
-      return (y.end_row == 0) ? true : false;
-    else if (y.end_row == 0)
-      return false;
-    return !strcmp(x.end_row, y.end_row);
-  }
-
-  /**
-   * Equality operator for LocationCacheKey
-   */
-  inline bool operator!=(const LocationCacheKey &x, const LocationCacheKey &y) {
-    return !(x == y);
-  }
-
-
-  /**
-   *  This class acts as a cache of Range location information.  It
+   * Cache of Range location information.  Entries are kept in a skiplist
+   * sorted by table name and end row.  Lookups do not take a lock: inserts
+   * and removals are serialized by a mutex and publish nodes with release
+   * stores, while readers traverse the skiplist with acquire loads.  Removed
+   * nodes are reclaimed with epoch based reclamation; a reader announces
+   * itself in one of a set of striped counters for the current epoch and a
+   * node is freed only after the epoch has advanced twice, which requires
+   * every reader of the epoch it was removed in to have finished.  Instead
+   * of maintaining an LRU list, which would make every lookup write shared
+   * state, lookups set an access bit on the entry and eviction uses the
+   * CLOCK (second chance) algorithm over the entries in key order.
    */
   class LocationCache {
   public:
-    /**
-     */
-    struct Value {
-      struct Value *prev, *next;
-      std::map<LocationCacheKey, Value *>::iterator map_iter;
-      std::string start_row;
-      std::string end_row;
-      const CommAddress *addrp;
-      bool pegged;
-    };
 
-    LocationCache(uint32_t max_entries) : m_mutex(), m_location_map(),
-        m_head(0), m_tail(0), m_max_entries(max_entries) { return; }
+    LocationCache(uint32_t max_entries);
     ~LocationCache();
 
     void insert(const char * table_name, RangeLocationInfo &range_loc_info,
@@ -111,11 +69,60 @@ namespace Hypertable {
 
     void display(std::ostream &);
 
+    /** Returns cache generation.  The generation is incremented whenever an
+     * entry is invalidated, evicted or replaced, so callers that keep copies
+     * of entries can detect that the copies may be stale without taking the
+     * cache mutex.  Inserting a new entry leaves existing copies valid and
+     * does not change the generation.
+     * @return Cache generation
+     */
+    uint64_t generation() const {
+      return m_generation.load(std::memory_order_acquire);
+    }
+
   private:
-    bool lookup(const char *table_name, const char *rowkey,
-                Value*& cacheval, bool inclusive);
-    void move_to_head(Value *cacheval);
-    void remove(Value *cacheval);
+
+    /// Maximum skiplist node height
+    static const int MAX_HEIGHT = 16;
+
+    /// Number of reader counter stripes
+    static const size_t STRIPES = 16;
+
+    /** Skiplist node holding one cache entry.  All members except the
+     * forward pointers and the access bit are immutable once the node is
+     * published.
+     */
+    struct Node {
+      const char *table_name;
+      std::string end_row;
+      std::string start_row;
+      const CommAddress *addrp;
+      bool unbounded;   //!< Empty end row, sorts after every row
+      bool pegged;
+      std::atomic<bool> accessed;
+      int height;
+      std::atomic<Node *> next[1];
+    };
+
+    /** Per-stripe reader counts for even and odd epochs, padded to a cache
+     * line.
+     */
+    struct Stripe {
+      std::atomic<int64_t> readers[2];
+      char pad[64 - 2*sizeof(std::atomic<int64_t>)];
+    };
+
+    class ReadGuard;
+
+    Node *create_node(int height);
+    void free_node(Node *node);
+    int random_height();
+    Node *lower_bound(const char *table_name, const char *rowkey,
+                      Node **preds=0);
+    Node *lookup(const char *table_name, const char *rowkey, bool inclusive);
+    void remove(Node *node);
+    bool evict();
+    void reclaim();
 
     const CommAddress *get_constant_address(const CommAddress &addr);
 
@@ -126,16 +133,20 @@ namespace Hypertable {
       }
     };
 
-    typedef std::map<LocationCacheKey, Value *> LocationMap;
     typedef std::set<const CommAddress *, CommAddressPointerLt> AddressSet;
 
     std::mutex m_mutex;
-    LocationMap    m_location_map;
+    Node          *m_head;
+    size_t         m_size {};
+    Node          *m_hand {};
     AddressSet     m_addresses;
-    Value         *m_head;
-    Value         *m_tail;
     uint32_t       m_max_entries;
     FlyweightString m_strings;
+    uint32_t       m_random {};
+    std::atomic<uint64_t> m_generation {};
+    std::atomic<uint64_t> m_epoch {};
+    Stripe         m_stripes[STRIPES];
+    std::vector<Node *> m_retired[2];
   };
 
   /// Smart pointer to LocationCache
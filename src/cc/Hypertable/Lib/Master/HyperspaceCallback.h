@@ -41,7 +41,7 @@ namespace Master {
   public:
     HyperspaceCallback(Client *client,
                                  ApplicationQueueInterfacePtr &app_queue)
-      : HandleCallback(EVENT_MASK_ATTR_SET), m_client(client),
+      : HandleCallback(EVENT_MASK_ATTR_SET|EVENT_MASK_ATTR_DEL), m_client(client),
         m_app_queue(app_queue) { }
 
     virtual void attr_set(const std::string &name);
@@ -101,45 +101,41 @@ void NameIdMapper::add_entry(const string &names_parent, const string &names_ent
   string ids_file = parent_ids_file + String("/") + id;
   std::vector<Attribute> attrs;
   attrs.push_back(Attribute("name", names_entry.c_str(), names_entry.length()));
-  attrs.push_back(Attribute("nid", "0", 1));
+  if (is_namespace)
+    attrs.push_back(Attribute("nid", "0", 1));
+  std::vector<BatchOperation> ops;
+  std::vector<BatchResult> results;
+  int oflags = OPEN_FLAG_READ|OPEN_FLAG_WRITE|OPEN_FLAG_CREATE|OPEN_FLAG_EXCL;
 
   if (m_hyperspace->exists(ids_file)) {
     if (is_namespace) {
-      if (!m_hyperspace->attr_exists(ids_file, "nid")) {
-        m_hyperspace->attr_set(ids_file, 0, attrs);
-      }
+      if (!m_hyperspace->attr_exists(ids_file, "nid"))
+        ops.push_back(BatchOperation(BatchOperation::ATTR_SET, ids_file, attrs));
     }
   }
   else {
-    if (is_namespace) {
-      try {
-        m_hyperspace->mkdir(ids_file, attrs);
-      }
-      catch (Exception &e) {
-        HT_ERROR_OUT << e << HT_END;
-        throw;
-      }
-    }
+    if (is_namespace)
+      ops.push_back(BatchOperation(BatchOperation::MKDIR, ids_file, attrs));
     else
-      m_hyperspace->attr_set(ids_file, OPEN_FLAG_READ|OPEN_FLAG_WRITE|OPEN_FLAG_CREATE|OPEN_FLAG_EXCL,
-                             "name", names_entry.c_str(), names_entry.length());
+      ops.push_back(BatchOperation(BatchOperation::ATTR_SET, ids_file, attrs,
+                                   oflags));
   }
 
-  // At this point the ID file exists, we now need to
-  // create the names file/dir and update the "id" attribute
+  // Create the names file/dir with its "id" attribute in the same
+  // transaction as the ID file
 
   UInt64Formatter buf(id);
+  std::vector<Attribute> init_attr;
+  init_attr.push_back(Attribute("id", buf.c_str(), buf.size()));
+
+  if (is_namespace)
+    ops.push_back(BatchOperation(BatchOperation::MKDIR, names_file, init_attr));
+  else
+    ops.push_back(BatchOperation(BatchOperation::ATTR_SET, names_file,
+                                 init_attr, oflags));
+
+  m_hyperspace->batch(ops, results);
 
-  if (is_namespace) {
-    std::vector<Attribute> init_attr;
-    init_attr.push_back(Attribute("id", buf.c_str(), buf.size()));
-    m_hyperspace->mkdir(names_file, init_attr);
-  }
-  else {
-    // Set the "id" attribute of the names file
-    m_hyperspace->attr_set(names_file, OPEN_FLAG_READ|OPEN_FLAG_WRITE|OPEN_FLAG_CREATE|OPEN_FLAG_EXCL,
-                           "id", buf.c_str(), buf.size());
-  }
   ids.push_back(id);
 }
 
@@ -37,7 +37,7 @@ namespace Hypertable {
   class RootFileHandler : public HandleCallback {
   public:
     RootFileHandler(RangeLocator *rangelocator)
-        : HandleCallback(EVENT_MASK_ATTR_SET),
+        : HandleCallback(EVENT_MASK_ATTR_SET|EVENT_MASK_ATTR_DEL),
           m_range_locator(rangelocator) { return; }
 
     virtual void attr_set(const std::string &name);
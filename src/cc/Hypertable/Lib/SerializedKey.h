@@ -24,6 +24,7 @@
 
 #include "Common/ByteString.h"
 #include "Common/Logger.h"
+#include "Common/MemoryCompare.h"
 
 namespace Hypertable {
 
@@ -46,7 +47,7 @@ namespace Hypertable {
           len2 -= 8;
       }
       int len = (len1 < len2) ? len1 : len2;
-      int cmp = memcmp(ptr1+1, ptr2+1, len-1);
+      int cmp = MemoryCompare::compare(ptr1+1, ptr2+1, len-1);
       return (cmp==0) ? len1 - len2 : cmp;
     }
 
@@ -55,6 +56,24 @@ namespace Hypertable {
       Serialization::decode_vi32(&rptr);
       return (const char *)rptr+1;
     }
+
+    /** Returns fixed-width prefix of a row.
+     * The prefix consists of the first eight bytes of <code>row</code>, zero
+     * padded and packed in big-endian order, so comparing the prefixes of two
+     * keys as integers gives the same result as compare() whenever they
+     * differ.  Rows are NUL terminated and the terminator sorts below every
+     * row byte, which is why zero padding is safe.  Keys with equal prefixes
+     * must be compared in full.
+     * @param row Pointer to (remainder of) NUL terminated row
+     * @return Big-endian row prefix
+     */
+    static uint64_t row_prefix(const uint8_t *row) {
+      uint64_t prefix = 0;
+      int i = 0;
+      for (; i<8 && row[i]; ++i)
+        prefix = (prefix << 8) | row[i];
+      return i ? prefix << (8 * (8-i)) : 0;
+    }
   };
 
   inline bool operator==(const SerializedKey sk1, const SerializedKey sk2) {
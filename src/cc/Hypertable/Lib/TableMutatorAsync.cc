@@ -90,10 +90,12 @@ void TableMutatorAsync::initialize(PropertiesPtr &props) {
 
   m_max_memory = props->get_i64("Hypertable.Mutator.ScatterBuffer.FlushLimit.Aggregate");
 
+  m_range_cache.reset(new TableMutatorAsyncRangeCache(m_range_locator->location_cache()));
+
   uint32_t buffer_id = ++m_next_buffer_id;
   m_current_buffer = make_shared<TableMutatorAsyncScatterBuffer>(m_comm, m_app_queue, 
           this, &m_table_identifier, m_schema, m_range_locator, 
-          m_table->auto_refresh(), m_timeout_ms, buffer_id);
+          m_table->auto_refresh(), m_timeout_ms, buffer_id, m_range_cache.get());
 
   // if there are indices then initialize the index mutators
   initialize_indices(props);
@@ -290,12 +292,24 @@ TableMutatorAsync::update_without_index(const Key &full_key, const ColumnFamilyS
   }
 }
 
+void
+TableMutatorAsync::set_batch(std::vector<TableMutatorAsyncScatterBuffer::BatchCell> &batch) {
+  if (batch.empty())
+    return;
+  m_current_buffer->set_cells(batch);
+  for (const auto &bc : batch)
+    m_memory_used += bc.incr_mem;
+  batch.clear();
+}
+
 void
 TableMutatorAsync::set_cells(Cells::const_iterator it, 
         Cells::const_iterator end) {
   {
     lock_guard<mutex> lock(m_member_mutex);
     ColumnFamilySpec *cf = 0;
+    std::vector<TableMutatorAsyncScatterBuffer::BatchCell> batch;
+    bool flushing_batch = false;
 
     try {
       for (; it != end; ++it) {
@@ -323,14 +337,36 @@ TableMutatorAsync::set_cells(Cells::const_iterator it,
         // if there's an index: buffer the key and update the index
         if (cell.flag == FLAG_INSERT && m_use_index 
             && cf && (cf->get_value_index() || cf->get_qualifier_index())) {
+          // buffer pending cells first to keep the order of cells in a row
+          flushing_batch = true;
+          set_batch(batch);
+          flushing_batch = false;
           update_with_index(full_key, cf, cell.value, cell.value_len);
         }
         else {
-          update_without_index(full_key, cf, cell);
+          batch.emplace_back();
+          TableMutatorAsyncScatterBuffer::BatchCell &bc = batch.back();
+          bc.key = full_key;
+          bc.incr_mem = 20 + full_key.row_len + full_key.column_qualifier_len;
+          if (cell.flag == FLAG_INSERT) {
+            bc.cf = cf;
+            bc.value = cell.value;
+            bc.value_len = cell.value_len;
+            bc.incr_mem += cell.value_len;
+          }
         }
       }
+      flushing_batch = true;
+      set_batch(batch);
     }
     catch (...) {
+      if (flushing_batch) {
+        handle_send_exceptions(format("%d batched cells, first row=%s (%s:%d)",
+                                      (int)batch.size(),
+                                      (const char *)batch.front().key.row,
+                                      __FILE__, __LINE__));
+        throw;
+      }
       handle_send_exceptions(
         format("row=%s, cf=%s, cq=%s, value_len=%d (%s:%d)",
         it->row_key,
@@ -521,7 +557,7 @@ void TableMutatorAsync::flush_with_tablequeue(TableMutator *mutator, bool sync)
         m_current_buffer = make_shared<TableMutatorAsyncScatterBuffer>(m_comm, 
                 m_app_queue, this, &m_table_identifier, m_schema, 
                 m_range_locator, m_table->auto_refresh(), m_timeout_ms, 
-                buffer_id);
+                buffer_id, m_range_cache.get());
         m_memory_used = 0;
       }
     }
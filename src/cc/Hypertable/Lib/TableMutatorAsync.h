@@ -258,6 +258,10 @@ namespace Hypertable {
 
     bool key_uses_index(Key &key);
 
+    /// Adds batched cells to current scatter buffer and clears batch.
+    /// @param batch Batched cells
+    void set_batch(std::vector<TableMutatorAsyncScatterBuffer::BatchCell> &batch);
+
     void update_with_index(Key &key, const ColumnFamilySpec *cf, const void *value,
                            uint32_t value_len);
 
@@ -276,6 +280,7 @@ namespace Hypertable {
     uint64_t m_max_memory {};
     ScatterBufferAsyncMap  m_outstanding_buffers;  // protected by buffer mutex
     TableMutatorAsyncScatterBufferPtr m_current_buffer; // needs mutex
+    TableMutatorAsyncRangeCachePtr m_range_cache; // needs mutex
     uint64_t m_resends {};  // needs mutex
     uint32_t m_timeout_ms {};
     ResultCallback *m_cb {};
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for TableMutatorAsyncRangeCache.
+/// This file contains definitions for TableMutatorAsyncRangeCache, a class
+/// that holds a mutator-private snapshot of recently used range locations.
+
+#include <Common/Compat.h>
+
+#include "TableMutatorAsyncRangeCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Checks if range lies entirely before row (empty end row is the end of
+  /// the table)
+  inline bool ends_before(const string &end_row, const char *row) {
+    return !end_row.empty() && strcmp(end_row.c_str(), row) < 0;
+  }
+
+  /// Checks if range contains row
+  inline bool contains(const RangeLocationInfo &info, const char *row) {
+    return !ends_before(info.end_row, row) &&
+      strcmp(row, info.start_row.c_str()) > 0;
+  }
+
+}
+
+
+const RangeLocationInfo *
+TableMutatorAsyncRangeCache::lookup(const char *row) {
+  uint64_t generation = m_location_cache->generation();
+
+  if (generation != m_generation) {
+    clear();
+    m_generation = generation;
+    return nullptr;
+  }
+
+  if (m_entries.empty())
+    return nullptr;
+
+  // Consecutive cells usually fall into the same range
+  if (m_last < m_entries.size() && contains(m_entries[m_last].info, row)) {
+    m_entries[m_last].last_used = ++m_tick;
+    return &m_entries[m_last].info;
+  }
+
+  auto iter = lower_bound(m_entries.begin(), m_entries.end(), row,
+                          [](const Entry &entry, const char *r) {
+                            return ends_before(entry.info.end_row, r); });
+  if (iter == m_entries.end() || !contains(iter->info, row))
+    return nullptr;
+
+  iter->last_used = ++m_tick;
+  m_last = iter - m_entries.begin();
+  return &iter->info;
+}
+
+
+const RangeLocationInfo *
+TableMutatorAsyncRangeCache::insert(const RangeLocationInfo &info) {
+  auto before = [](const Entry &entry, const string &end_row) {
+    if (entry.info.end_row.empty())
+      return false;
+    return end_row.empty() || entry.info.end_row < end_row;
+  };
+  auto iter = lower_bound(m_entries.begin(), m_entries.end(), info.end_row,
+                          before);
+
+  if (iter != m_entries.end() && iter->info.end_row == info.end_row) {
+    iter->info = info;
+    iter->last_used = ++m_tick;
+    m_last = iter - m_entries.begin();
+    return &iter->info;
+  }
+
+  if (m_entries.size() >= m_max_entries) {
+    auto lru = min_element(m_entries.begin(), m_entries.end(),
+                           [](const Entry &e1, const Entry &e2) {
+                             return e1.last_used < e2.last_used; });
+    m_entries.erase(lru);
+    iter = lower_bound(m_entries.begin(), m_entries.end(), info.end_row,
+                       before);
+  }
+
+  iter = m_entries.insert(iter, Entry { info, ++m_tick });
+  m_last = iter - m_entries.begin();
+  return &iter->info;
+}
@@ -0,0 +1,119 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for TableMutatorAsyncRangeCache.
+/// This file contains declarations for TableMutatorAsyncRangeCache, a class
+/// that holds a mutator-private snapshot of recently used range locations.
+
+#ifndef Hypertable_Lib_TableMutatorAsyncRangeCache_h
+#define Hypertable_Lib_TableMutatorAsyncRangeCache_h
+
+#include <Hypertable/Lib/LocationCache.h>
+#include <Hypertable/Lib/RangeLocationInfo.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup libHypertable
+  /// @{
+
+  /// Snapshot of recently used range locations of one table.
+  /// A mutator resolves the range of every cell it buffers.  Going to the
+  /// shared LocationCache for each cell means a search of its full skiplist
+  /// and writes to counters shared with other threads, which shows up in
+  /// the cost of TableMutator::set() for bulk loads.  This class keeps a
+  /// small, sorted copy of the range boundaries
+  /// the mutator used most recently.  It is private to one mutator and only
+  /// accessed while the mutator's member mutex is held, so lookups take no
+  /// lock.  Staleness is detected by comparing the generation of the
+  /// LocationCache against the generation the snapshot was taken at; any
+  /// removal from the LocationCache discards the snapshot.
+  class TableMutatorAsyncRangeCache {
+  public:
+
+    /// Constructor.
+    /// @param location_cache Shared location cache backing the snapshot
+    /// @param max_entries Maximum number of ranges held
+    TableMutatorAsyncRangeCache(LocationCachePtr location_cache,
+                                size_t max_entries=64)
+      : m_location_cache(location_cache), m_max_entries(max_entries) { }
+
+    /// Looks up range containing row.
+    /// @param row Row key
+    /// @return Pointer to range location, valid until the next call to
+    /// insert() or clear(), or <i>nullptr</i> if not found
+    const RangeLocationInfo *lookup(const char *row);
+
+    /// Adds range location to snapshot.
+    /// Must be called after a lookup() miss for the same row, with a
+    /// location obtained after that lookup.  Evicts the least recently used
+    /// range if the snapshot is full.
+    /// @param info Range location
+    /// @return Pointer to added range location, valid until the next call to
+    /// insert() or clear()
+    const RangeLocationInfo *insert(const RangeLocationInfo &info);
+
+    /// Discards all ranges.
+    void clear() {
+      m_entries.clear();
+      m_last = 0;
+    }
+
+  private:
+
+    /// Snapshot entry
+    struct Entry {
+      /// Range location
+      RangeLocationInfo info;
+      /// Lookup tick of last use
+      uint64_t last_used;
+    };
+
+    /// Shared location cache
+    LocationCachePtr m_location_cache;
+
+    /// Ranges sorted by end row
+    std::vector<Entry> m_entries;
+
+    /// Maximum number of ranges
+    size_t m_max_entries;
+
+    /// Index of range returned by previous lookup
+    size_t m_last {};
+
+    /// Location cache generation the snapshot was taken at
+    uint64_t m_generation {};
+
+    /// Lookup counter used to track recency
+    uint64_t m_tick {};
+  };
+
+  /// Smart pointer to TableMutatorAsyncRangeCache
+  typedef std::unique_ptr<TableMutatorAsyncRangeCache> TableMutatorAsyncRangeCachePtr;
+
+  /// @}
+}
+
+#endif // Hypertable_Lib_TableMutatorAsyncRangeCache_h
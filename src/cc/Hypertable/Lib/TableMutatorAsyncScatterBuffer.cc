@@ -49,10 +49,12 @@ using namespace std;
 TableMutatorAsyncScatterBuffer::TableMutatorAsyncScatterBuffer(Comm *comm,
     ApplicationQueueInterfacePtr &app_queue, TableMutatorAsync *mutator,
     const TableIdentifier *table_identifier, SchemaPtr &schema,
-    RangeLocatorPtr &range_locator, bool auto_refresh, uint32_t timeout_ms, uint32_t id)
+    RangeLocatorPtr &range_locator, bool auto_refresh, uint32_t timeout_ms, uint32_t id,
+    TableMutatorAsyncRangeCache *range_cache)
   : m_comm(comm), m_app_queue(app_queue), m_mutator(mutator), m_schema(schema),
     m_range_locator(range_locator),
     m_location_cache(range_locator->location_cache()),
+    m_range_cache(range_cache),
     m_range_server(comm, timeout_ms), m_table_identifier(*table_identifier),
     m_auto_refresh(auto_refresh), m_timeout_ms(timeout_ms),
     m_counter_value(9), m_timer(timeout_ms), m_id(id),
@@ -72,17 +74,11 @@ TableMutatorAsyncScatterBuffer::~TableMutatorAsyncScatterBuffer() {
 void
 TableMutatorAsyncScatterBuffer::set(const Key &key, const ColumnFamilySpec *cf, const void *value,
     uint32_t value_len, size_t incr_mem) {
-  RangeAddrInfo range_info;
   TableMutatorAsyncSendBufferMap::const_iterator iter;
   bool counter_reset = false;
+  int64_t counter = 0;
 
-  if (!m_location_cache->lookup(m_table_identifier.id, key.row, &range_info)) {
-    Timer timer(m_timeout_ms, true);
-    RangeLocationInfo range_loc_info;
-    m_range_locator->find_loop(&m_table_identifier, key.row, &range_loc_info,
-                               timer, false);
-    range_info = range_loc_info;
-  }
+  const CommAddress &addr = locate(key.row).addr;
 
   {
     lock_guard<mutex> lock(m_mutex);
@@ -96,46 +92,23 @@ TableMutatorAsyncScatterBuffer::set(const Key &key, const ColumnFamilySpec *cf,
 
     // counter? make sure that a valid integer was specified and re-encode
     // it as a 64bit value
-    if (is_counter) {
-      const char *ascii_value = (const char *)value;
-      char *endptr;
-      m_counter_value.clear();
-      m_counter_value.ensure(value_len+1);
-      if (value_len > 0 && (*ascii_value == '=' || *ascii_value == '+')) {
-        counter_reset = (*ascii_value == '=');
-        m_counter_value.add_unchecked(ascii_value+1, value_len-1);
-      }
-      else
-        m_counter_value.add_unchecked(value, value_len);
-      m_counter_value.add_unchecked((const void *)"\0",1);
-      int64_t val = strtoll((const char *)m_counter_value.base, &endptr, 0);
-      if (*endptr)
-        HT_THROWF(Error::BAD_KEY, "Expected integer value, got %s, row=%s",
-      (char*)m_counter_value.base, key.row);
-      m_counter_value.clear();
-      Serialization::encode_i64(&m_counter_value.ptr, val);
-    }
+    if (is_counter)
+      counter_reset = parse_counter(key, value, value_len, &counter);
 
-    iter = m_buffer_map.find(range_info.addr);
+    iter = m_buffer_map.find(addr);
 
     if (iter == m_buffer_map.end()) {
-      iter = m_buffer_map.insert(std::make_pair(range_info.addr, make_shared<TableMutatorAsyncSendBuffer>(&m_table_identifier,
+      iter = m_buffer_map.insert(std::make_pair(addr, make_shared<TableMutatorAsyncSendBuffer>(&m_table_identifier,
                                  &m_completion_counter, m_range_locator.get()))).first;
-      (*iter).second->addr = range_info.addr;
+      (*iter).second->addr = addr;
     }
 
     (*iter).second->key_offsets.push_back((*iter).second->accum.fill());
     create_key_and_append((*iter).second->accum, key);
 
     // now append the counter
-    if (is_counter) {
-      if (counter_reset) {
-        *m_counter_value.ptr++ = '=';
-        append_as_byte_string((*iter).second->accum, m_counter_value.base, 9);
-      }
-      else
-        append_as_byte_string((*iter).second->accum, m_counter_value.base, 8);
-    }
+    if (is_counter)
+      append_counter((*iter).second->accum, counter, counter_reset);
     else
       append_as_byte_string((*iter).second->accum, value, value_len);
 
@@ -149,39 +122,21 @@ TableMutatorAsyncScatterBuffer::set(const Key &key, const ColumnFamilySpec *cf,
 void TableMutatorAsyncScatterBuffer::set_delete(const Key &key, size_t incr_mem) {
   lock_guard<mutex> lock(m_mutex);
 
-  RangeAddrInfo range_info;
   TableMutatorAsyncSendBufferMap::const_iterator iter;
 
-  if (key.flag == FLAG_INSERT)
-    HT_THROW(Error::BAD_KEY, "Key flag is FLAG_INSERT, expected delete");
+  check_delete_key(key);
 
-  if (!m_location_cache->lookup(m_table_identifier.id, key.row, &range_info)) {
-    Timer timer(m_timeout_ms, true);
-    RangeLocationInfo range_loc_info;
-    m_range_locator->find_loop(&m_table_identifier, key.row, &range_loc_info,
-                               timer, false);
-    range_info = range_loc_info;
-  }
-  iter = m_buffer_map.find(range_info.addr);
+  const CommAddress &addr = locate(key.row).addr;
+
+  iter = m_buffer_map.find(addr);
 
   if (iter == m_buffer_map.end()) {
-    iter = m_buffer_map.insert(std::make_pair(range_info.addr, make_shared<TableMutatorAsyncSendBuffer>(&m_table_identifier,
+    iter = m_buffer_map.insert(std::make_pair(addr, make_shared<TableMutatorAsyncSendBuffer>(&m_table_identifier,
                                  &m_completion_counter, m_range_locator.get()))).first;
-    (*iter).second->addr = range_info.addr;
+    (*iter).second->addr = addr;
   }
 
   (*iter).second->key_offsets.push_back((*iter).second->accum.fill());
-  if (key.flag == FLAG_DELETE_COLUMN_FAMILY ||
-      key.flag == FLAG_DELETE_CELL || key.flag == FLAG_DELETE_CELL_VERSION) {
-    if (key.column_family_code == 0)
-      HT_THROWF(Error::BAD_KEY, "key.flag set to %d but column family=0", key.flag);
-    if (key.flag == FLAG_DELETE_CELL || key.flag == FLAG_DELETE_CELL_VERSION) {
-      if (key.flag == FLAG_DELETE_CELL_VERSION && key.timestamp == AUTO_ASSIGN) {
-        HT_THROWF(Error::BAD_KEY, "key.flag set to %d but timestamp == AUTO_ASSIGN", key.flag);
-      }
-    }
-  }
-
   create_key_and_append((*iter).second->accum, key);
   append_as_byte_string((*iter).second->accum, 0, 0);
   if ((*iter).second->accum.fill() > m_server_flush_limit)
@@ -226,6 +181,141 @@ TableMutatorAsyncScatterBuffer::set(SerializedKey key, ByteString value, size_t
 }
 
 
+void TableMutatorAsyncScatterBuffer::set_cells(vector<BatchCell> &cells) {
+  lock_guard<mutex> lock(m_mutex);
+  vector<BatchCell *> order;
+
+  // Validate every cell first so that a bad cell rejects the whole batch
+  order.reserve(cells.size());
+  for (auto &cell : cells) {
+    if (cell.key.flag == FLAG_INSERT) {
+      if (cell.key.column_family_code) {
+        if (!cell.cf)
+          cell.cf = m_schema->get_column_family(cell.key.column_family_code);
+        cell.is_counter = cell.cf->get_option_counter();
+      }
+      if (cell.is_counter)
+        cell.counter_reset = parse_counter(cell.key, cell.value,
+                                           cell.value_len, &cell.counter);
+    }
+    else
+      check_delete_key(cell.key);
+    order.push_back(&cell);
+  }
+
+  // Sort by row so that the range is resolved once per run of cells that
+  // fall into it.  send() sorts by row as well, so the order in which cells
+  // are buffered does not matter as long as cells with equal rows keep
+  // their relative order.
+  stable_sort(order.begin(), order.end(),
+              [](const BatchCell *c1, const BatchCell *c2) {
+                return strcmp(c1->key.row, c2->key.row) < 0; });
+
+  TableMutatorAsyncSendBuffer *send_buffer = 0;
+  String end_row;
+
+  for (auto cell : order) {
+    if (send_buffer == 0 ||
+        (!end_row.empty() && strcmp(cell->key.row, end_row.c_str()) > 0)) {
+      const RangeLocationInfo &range_info = locate(cell->key.row);
+      end_row = range_info.end_row;
+      auto iter = m_buffer_map.find(range_info.addr);
+      if (iter == m_buffer_map.end()) {
+        iter = m_buffer_map.insert(std::make_pair(range_info.addr, make_shared<TableMutatorAsyncSendBuffer>(&m_table_identifier,
+                                   &m_completion_counter, m_range_locator.get()))).first;
+        (*iter).second->addr = range_info.addr;
+      }
+      send_buffer = (*iter).second.get();
+    }
+
+    send_buffer->key_offsets.push_back(send_buffer->accum.fill());
+    create_key_and_append(send_buffer->accum, cell->key);
+    if (cell->key.flag != FLAG_INSERT)
+      append_as_byte_string(send_buffer->accum, 0, 0);
+    else if (cell->is_counter)
+      append_counter(send_buffer->accum, cell->counter, cell->counter_reset);
+    else
+      append_as_byte_string(send_buffer->accum, cell->value, cell->value_len);
+
+    if (send_buffer->accum.fill() > m_server_flush_limit)
+      m_full = true;
+    m_memory_used += cell->incr_mem;
+  }
+}
+
+
+const RangeLocationInfo &
+TableMutatorAsyncScatterBuffer::locate(const char *row) {
+  const RangeLocationInfo *info;
+
+  if (m_range_cache && (info = m_range_cache->lookup(row)))
+    return *info;
+
+  if (!m_location_cache->lookup(m_table_identifier.id, row, &m_location)) {
+    Timer timer(m_timeout_ms, true);
+    m_range_locator->find_loop(&m_table_identifier, row, &m_location,
+                               timer, false);
+  }
+
+  if (m_range_cache)
+    return *m_range_cache->insert(m_location);
+  return m_location;
+}
+
+
+void TableMutatorAsyncScatterBuffer::check_delete_key(const Key &key) {
+  if (key.flag == FLAG_INSERT)
+    HT_THROW(Error::BAD_KEY, "Key flag is FLAG_INSERT, expected delete");
+
+  if (key.flag == FLAG_DELETE_COLUMN_FAMILY ||
+      key.flag == FLAG_DELETE_CELL || key.flag == FLAG_DELETE_CELL_VERSION) {
+    if (key.column_family_code == 0)
+      HT_THROWF(Error::BAD_KEY, "key.flag set to %d but column family=0", key.flag);
+    if (key.flag == FLAG_DELETE_CELL || key.flag == FLAG_DELETE_CELL_VERSION) {
+      if (key.flag == FLAG_DELETE_CELL_VERSION && key.timestamp == AUTO_ASSIGN) {
+        HT_THROWF(Error::BAD_KEY, "key.flag set to %d but timestamp == AUTO_ASSIGN", key.flag);
+      }
+    }
+  }
+}
+
+
+bool TableMutatorAsyncScatterBuffer::parse_counter(const Key &key,
+    const void *value, uint32_t value_len, int64_t *valp) {
+  const char *ascii_value = (const char *)value;
+  char *endptr;
+  bool reset = false;
+
+  m_counter_value.clear();
+  m_counter_value.ensure(value_len+1);
+  if (value_len > 0 && (*ascii_value == '=' || *ascii_value == '+')) {
+    reset = (*ascii_value == '=');
+    m_counter_value.add_unchecked(ascii_value+1, value_len-1);
+  }
+  else
+    m_counter_value.add_unchecked(value, value_len);
+  m_counter_value.add_unchecked((const void *)"\0",1);
+  *valp = strtoll((const char *)m_counter_value.base, &endptr, 0);
+  if (*endptr)
+    HT_THROWF(Error::BAD_KEY, "Expected integer value, got %s, row=%s",
+              (char*)m_counter_value.base, key.row);
+  return reset;
+}
+
+
+void TableMutatorAsyncScatterBuffer::append_counter(DynamicBuffer &accum,
+    int64_t value, bool reset) {
+  m_counter_value.clear();
+  Serialization::encode_i64(&m_counter_value.ptr, value);
+  if (reset) {
+    *m_counter_value.ptr++ = '=';
+    append_as_byte_string(accum, m_counter_value.base, 9);
+  }
+  else
+    append_as_byte_string(accum, m_counter_value.base, 8);
+}
+
+
 namespace {
 
   struct SendRec {
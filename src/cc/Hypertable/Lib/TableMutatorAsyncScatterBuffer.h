@@ -35,6 +35,7 @@
 #include <Hypertable/Lib/Schema.h>
 #include <Hypertable/Lib/TableMutatorAsyncSendBuffer.h>
 #include <Hypertable/Lib/TableMutatorAsyncCompletionCounter.h>
+#include <Hypertable/Lib/TableMutatorAsyncRangeCache.h>
 
 #include <AsyncComm/CommAddress.h>
 #include <AsyncComm/ApplicationQueueInterface.h>
@@ -69,12 +70,42 @@ namespace Hypertable {
                                    const TableIdentifier *,
                                    SchemaPtr &, RangeLocatorPtr &, bool auto_refresh,
                                    uint32_t timeout_ms,
-                                   uint32_t id);
+                                   uint32_t id,
+                                   TableMutatorAsyncRangeCache *range_cache=0);
     virtual ~TableMutatorAsyncScatterBuffer();
+
+    /// %Cell passed to set_cells().
+    struct BatchCell {
+      /// %Cell key
+      Key key;
+      /// Column family of cell, looked up if null
+      const ColumnFamilySpec *cf {};
+      /// %Cell value
+      const void *value {};
+      /// Length of value
+      uint32_t value_len {};
+      /// Memory accounted for the cell
+      size_t incr_mem {};
+      /// Decoded counter value, set by set_cells()
+      int64_t counter {};
+      /// Counter reset flag, set by set_cells()
+      bool counter_reset {};
+      /// Counter column flag, set by set_cells()
+      bool is_counter {};
+    };
+
     void set(const Key &, const ColumnFamilySpec *cf, const void *value,
              uint32_t value_len, size_t incr_mem);
     void set_delete(const Key &key, size_t incr_mem);
     void set(SerializedKey key, ByteString value, size_t incr_mem);
+
+    /// Adds a batch of inserts and deletes.
+    /// All cells are validated before any is added, so a bad cell causes
+    /// the entire batch to be rejected.  The cells are then sorted by row and
+    /// the destination range is resolved once per run of cells that falls
+    /// into the same range.  <code>cells</code> may be modified.
+    /// @param cells Cells to add
+    void set_cells(std::vector<BatchCell> &cells);
     bool full() { std::lock_guard<std::mutex> lock(m_mutex); return m_full; }
     void send(uint32_t flags);
     void wait_for_completion();
@@ -88,6 +119,8 @@ namespace Hypertable {
     void refresh_schema(const TableIdentifier &table_id, SchemaPtr &schema) {
       m_schema = schema;
       m_table_identifier = table_id;
+      if (m_range_cache)
+        m_range_cache->clear();
     }
 
     uint32_t get_id() const { return m_id; }
@@ -105,6 +138,35 @@ namespace Hypertable {
 
   private:
     int set_failed_mutations();
+
+    /// Locates range containing row.
+    /// Consults the mutator's range cache, if any, then the location cache
+    /// and finally the range locator.
+    /// @param row Row key
+    /// @return Range location, valid until the next call
+    const RangeLocationInfo &locate(const char *row);
+
+    /// Checks delete key for validity.
+    /// @param key Delete key
+    /// @throws Exception with code Error::BAD_KEY if key is invalid
+    void check_delete_key(const Key &key);
+
+    /// Parses ASCII counter value.
+    /// @param key %Cell key
+    /// @param value ASCII counter value, optionally prefixed by '=' or '+'
+    /// @param value_len Length of value
+    /// @param valp Set to parsed counter value
+    /// @return <i>true</i> if value resets the counter
+    /// @throws Exception with code Error::BAD_KEY if value is not an integer
+    bool parse_counter(const Key &key, const void *value, uint32_t value_len,
+                       int64_t *valp);
+
+    /// Appends binary encoded counter value.
+    /// @param accum Buffer to append to
+    /// @param value Counter value
+    /// @param reset <i>true</i> if value resets the counter
+    void append_counter(DynamicBuffer &accum, int64_t value, bool reset);
+
     typedef CommAddressMap<TableMutatorAsyncSendBufferPtr> TableMutatorAsyncSendBufferMap;
 
     Comm                *m_comm;
@@ -113,6 +175,8 @@ namespace Hypertable {
     SchemaPtr            m_schema;
     RangeLocatorPtr      m_range_locator;
     LocationCachePtr     m_location_cache;
+    TableMutatorAsyncRangeCache *m_range_cache;
+    RangeLocationInfo    m_location;
     Lib::RangeServer::Client  m_range_server;
     TableIdentifierManaged m_table_identifier;
     TableMutatorAsyncSendBufferMap m_buffer_map;
@@ -20,6 +20,8 @@
  */
 
 #include <Common/Compat.h>
+#include <Common/Checksum.h>
+#include <Common/Error.h>
 #include <Common/Logger.h>
 
 #include <Hypertable/Lib/BlockCompressionCodec.h>
@@ -39,7 +41,7 @@ int main(int argc, char **argv) {
   //
 
   {
-    HT_ASSERT(BlockHeaderCommitLog::LatestVersion == 1);
+    HT_ASSERT(BlockHeaderCommitLog::LatestVersion == 2);
 
     BlockHeaderCommitLog before;
     BlockHeaderCommitLog after;
@@ -66,7 +68,10 @@ int main(int argc, char **argv) {
     // Version 1
 
     encode_ptr = buffer;
-    before = BlockHeaderCommitLog("COMMITDATA", 123456789LL, 9876543210LLU);
+    before = BlockHeaderCommitLog(1);
+    before.set_magic("COMMITDATA");
+    before.set_revision(123456789LL);
+    before.set_cluster_id(9876543210LLU);
     before.set_compression_type(BlockCompressionCodec::BMZ);
     before.set_data_length(1000);
     before.set_data_zlength(100);
@@ -82,6 +87,29 @@ int main(int argc, char **argv) {
     HT_ASSERT(after.get_revision() == 123456789LL);
     HT_ASSERT(after.get_cluster_id() == 9876543210LLU);
     HT_ASSERT(after.check_magic("COMMITDATA"));
+    HT_ASSERT(after.get_checksum_type() == BlockHeader::FLETCHER32);
+
+    HT_ASSERT(before == after);
+
+    // Version 2
+
+    encode_ptr = buffer;
+    before = BlockHeaderCommitLog("COMMITDATA", 123456789LL, 9876543210LLU);
+    before.set_compression_type(BlockCompressionCodec::ZSTD);
+    before.set_data_length(1000);
+    before.set_data_zlength(100);
+    before.set_data_checksum(42);
+    before.encode(&encode_ptr);
+
+    remain = encode_ptr-buffer;
+    HT_ASSERT(remain == 45);
+    decode_ptr = buffer;
+    after = BlockHeaderCommitLog(2);
+    after.decode(&decode_ptr, &remain);
+
+    HT_ASSERT(after.get_revision() == 123456789LL);
+    HT_ASSERT(after.get_cluster_id() == 9876543210LLU);
+    HT_ASSERT(after.get_checksum_type() == BlockHeader::CRC32C);
 
     HT_ASSERT(before == after);
   }
@@ -91,7 +119,7 @@ int main(int argc, char **argv) {
   //
 
   {
-    HT_ASSERT(BlockHeaderCellStore::LatestVersion == 1);
+    HT_ASSERT(BlockHeaderCellStore::LatestVersion == 2);
 
     BlockHeaderCellStore before;
     BlockHeaderCellStore after;
@@ -135,6 +163,46 @@ int main(int argc, char **argv) {
     after.decode(&decode_ptr, &remain);
 
     HT_ASSERT(before == after);
+
+    // Version 2
+
+    encode_ptr = buffer;
+    before = BlockHeaderCellStore(2, "CELLSTORE-");
+    before.set_compression_type(BlockCompressionCodec::SNAPPY);
+    before.set_checksum_type(BlockHeader::FLETCHER32);
+    before.set_data_length(1000);
+    before.set_data_zlength(100);
+    before.set_data_checksum(28);
+    before.encode(&encode_ptr);
+
+    remain = encode_ptr-buffer;
+    HT_ASSERT(remain == 29);
+    decode_ptr = buffer;
+    after = BlockHeaderCellStore(2);
+    after.decode(&decode_ptr, &remain);
+
+    HT_ASSERT(after.get_checksum_type() == BlockHeader::FLETCHER32);
+    HT_ASSERT(before == after);
+
+    // Corrupt checksum type
+    buffer[16] = BlockHeader::CHECKSUM_TYPE_LIMIT;
+    before.write_header_checksum(buffer);
+    remain = 29;
+    decode_ptr = buffer;
+    try {
+      after.decode(&decode_ptr, &remain);
+      HT_ASSERT(!"Invalid checksum type not detected");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::BLOCK_COMPRESSOR_BAD_HEADER);
+    }
+
+    // Data checksums
+    const char *data = "123456789";
+    before.set_checksum_type(BlockHeader::CRC32C);
+    HT_ASSERT(before.compute_data_checksum(data, 9) == 0xe3069283);
+    before.set_checksum_type(BlockHeader::FLETCHER32);
+    HT_ASSERT(before.compute_data_checksum(data, 9) == fletcher32(data, 9));
   }
 
   return 0;
@@ -36,6 +36,16 @@
 #include "Hypertable/Lib/CommitLogReader.h"
 
 #include "FsBroker/Lib/Client.h"
+#include "FsBroker/Lib/LocalFilesystem.h"
+
+#include <boost/filesystem.hpp>
+
+#include <set>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
 
 using namespace Hypertable;
 using namespace Config;
@@ -59,6 +69,8 @@ namespace {
   void write_entries(CommitLog *log, int num_entries, uint64_t *sump,
                      CommitLogBase *link_log);
   void read_entries(CommitLogReader *log_reader, uint64_t *sump);
+  void test_lanes(FsBroker::Lib::ClientPtr &client);
+  void test_archive_corrupt_fragment();
 }
 
 
@@ -66,6 +78,8 @@ int main(int argc, char **argv) {
   try {
     init_with_policies<Policies>(argc, argv);
 
+    test_archive_corrupt_fragment();
+
     Comm *comm = Comm::instance();
     ConnectionManagerPtr conn_mgr = make_shared<ConnectionManager>(comm);
     int timeout = has("fs-timeout") ? get_i32("fs-timeout") : 180000;
@@ -85,6 +99,7 @@ int main(int argc, char **argv) {
 
     //test1(fs);
     test_link(fs);
+    test_lanes(fs);
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -207,6 +222,82 @@ namespace {
     HT_ASSERT(sum_read == sum_written);
   }
 
+  void test_lanes(FsBroker::Lib::ClientPtr &client) {
+    String log_dir = "/hypertable/test_log/lanes";
+    uint64_t sum_written = 0;
+    uint64_t sum_read = 0;
+    FilesystemPtr fs = client;
+    const uint32_t lanes = 3;
+
+    client->mkdirs(log_dir);
+
+    // Write each lane twice, the second time picking up where the first
+    // left off, as after a restart
+    for (int pass=0; pass<2; pass++) {
+      vector<CommitLogPtr> logs;
+      for (uint32_t lane=0; lane<lanes; lane++)
+        logs.push_back(make_shared<CommitLog>(fs, log_dir, properties,
+                                              nullptr, true, lane, lanes));
+      for (auto &log : logs)
+        write_entries(log.get(), 20, &sum_written, 0);
+    }
+
+    // Reader sees all lanes as one log with unique fragment numbers
+    CommitLogReaderPtr log_reader_ptr =
+      make_shared<CommitLogReader>(fs, log_dir);
+    vector<uint32_t> ids;
+    log_reader_ptr->get_init_fragment_ids(ids);
+    HT_ASSERT(ids.size() >= 2*lanes);
+    HT_ASSERT(set<uint32_t>(ids.begin(), ids.end()).size() == ids.size());
+    read_entries(log_reader_ptr.get(), &sum_read);
+    HT_ASSERT(sum_read == sum_written);
+
+    // Fragment filter applies to lane fragments too
+    vector<int32_t> filter;
+    filter.push_back(ids.back());
+    log_reader_ptr = make_shared<CommitLogReader>(fs, log_dir, filter);
+    ids.clear();
+    log_reader_ptr->get_init_fragment_ids(ids);
+    HT_ASSERT(ids.size() == 1);
+  }
+
+  /// Replays a commit log with a truncated fragment from the in-process
+  /// local filesystem and checks that the fragment is archived
+  void test_archive_corrupt_fragment() {
+    String root = (boost::filesystem::current_path() / "fsroot").string();
+    String log_dir = "/hypertable/test_log/corrupt";
+    uint64_t sum_written = 0;
+    uint64_t sum_read = 0;
+
+    properties->set("FsBroker.Local.Root", root);
+    FilesystemPtr fs = make_shared<FsBroker::Lib::LocalFilesystem>(properties);
+
+    if (fs->exists(log_dir))
+      fs->rmdir(log_dir);
+    fs->mkdirs(log_dir);
+
+    CommitLog *log = new CommitLog(fs, log_dir, properties);
+    write_entries(log, 20, &sum_written, 0);
+    delete log;
+
+    // Cut the first fragment short in the middle of its last block
+    String fname = log_dir + "/0";
+    int64_t length = fs->length(fname) - 3;
+    HT_ASSERT(::truncate((root + fname).c_str(), length) == 0);
+
+    CommitLogReaderPtr log_reader_ptr =
+      make_shared<CommitLogReader>(fs, log_dir);
+    read_entries(log_reader_ptr.get(), &sum_read);
+    HT_ASSERT(sum_read < sum_written);
+
+    String archive_fname = String("/")
+      + properties->get_str("Hypertable.Directory") + "/backup" + fname;
+    HT_ASSERT(fs->exists(archive_fname));
+    HT_ASSERT(fs->length(archive_fname) == length);
+
+    fs->rmdir(log_dir);
+  }
+
   void
   write_entries(CommitLog *log, int num_entries, uint64_t *sump,
                 CommitLogBase *link_log) {
@@ -238,10 +329,20 @@ namespace {
         dbuf.ptr = dbuf.base + (4*limit);
         dbuf.own = false;
 
-        if ((error = log->write(0, dbuf, revision, Filesystem::Flags::FLUSH)) != Error::OK)
+        // Alternate between synchronous writes and pipelined appends
+        if (i % 2) {
+          DynamicBuffer zblock;
+          if ((error = log->compress_block(0, dbuf, revision, zblock)) != Error::OK ||
+              (error = log->append_block(zblock, revision)) != Error::OK)
+            HT_THROW(error, "Problem appending to log file");
+        }
+        else if ((error = log->write(0, dbuf, revision, Filesystem::Flags::FLUSH)) != Error::OK)
           HT_THROW(error, "Problem writing to log file");
       }
     }
+
+    if ((error = log->flush()) != Error::OK)
+      HT_THROW(error, "Problem flushing log file");
   }
 
   void read_entries(CommitLogReader *log_reader, uint64_t *sump) {
@@ -22,15 +22,21 @@
 #include <Common/Compat.h>
 
 #include <Hypertable/Lib/CompressorFactory.h>
+#include <Hypertable/Lib/BlockCompressionCodecZstd.h>
 #include <Hypertable/Lib/BlockHeaderCommitLog.h>
 
 #include <Common/DynamicBuffer.h>
 #include <Common/FileUtils.h>
 #include <Common/Logger.h>
+#include <Common/Stopwatch.h>
 #include <Common/System.h>
 #include <Common/Usage.h>
 
+#include <iostream>
+#include <vector>
+
 using namespace Hypertable;
+using namespace std;
 
 namespace {
   const char *usage[] = {
@@ -44,9 +50,82 @@ namespace {
     "lzo",
     "quicklz",
     "snappy",
+    "zstd",
+    "lz4",
+    "",
+    "The argument may include compressor options (e.g. \"zstd --level 9\").",
+    "After validation, the compression ratio and the deflate and inflate",
+    "throughput are reported.",
     "",
     0
   };
+
+  /// Number of times input is compressed when measuring throughput
+  const int ITERATIONS = 500;
+
+  /// Block size used when training and measuring dictionary compression
+  const size_t DICT_BLOCK_SIZE = 512;
+
+  bool round_trip(BlockCompressionCodec *compressor, const char *spec,
+                  DynamicBuffer &input, DynamicBuffer &output1,
+                  DynamicBuffer &output2, BlockHeaderCommitLog &header) {
+    try {
+      compressor->deflate(input, output1, header);
+      compressor->inflate(output1, output2, header);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      return false;
+    }
+
+    if (input.fill() != output2.fill()) {
+      HT_ERRORF("Input length (%lu) does not match output length (%lu) after "
+                "%s codec", (Lu)input.fill(), (Lu)output2.fill(), spec);
+      return false;
+    }
+
+    if (memcmp(input.base, output2.base, input.fill())) {
+      HT_ERRORF("Input does not match output after %s codec", spec);
+      return false;
+    }
+    return true;
+  }
+
+  /// Compresses <code>input</code> in blocks of <code>block_size</code>
+  /// bytes and reports compression ratio and throughput
+  void report(BlockCompressionCodec *compressor, const char *label,
+              DynamicBuffer &input, size_t block_size,
+              BlockHeaderCommitLog &header) {
+    DynamicBuffer block(0), output1(0), output2(0);
+    size_t zlen = 0;
+    double deflate_time = 0.0, inflate_time = 0.0;
+
+    for (size_t offset=0; offset<input.fill(); offset += block_size) {
+      size_t len = std::min(block_size, input.fill()-offset);
+      block.clear();
+      block.add(input.base + offset, len);
+
+      Stopwatch w;
+      for (int i=0; i<ITERATIONS; i++)
+        compressor->deflate(block, output1, header);
+      w.stop();
+      deflate_time += w.elapsed();
+      zlen += header.get_data_zlength();
+
+      w.reset();
+      w.start();
+      for (int i=0; i<ITERATIONS; i++)
+        compressor->inflate(output1, output2, header);
+      w.stop();
+      inflate_time += w.elapsed();
+    }
+
+    double mb = ((double)input.fill() * ITERATIONS) / (1024.0 * 1024.0);
+    cout << label << ": ratio=" << ((double)zlen / input.fill())
+         << " deflate=" << (mb / deflate_time) << " MB/s"
+         << " inflate=" << (mb / inflate_time) << " MB/s" << endl;
+  }
+
 }
 
 const char MAGIC[12] = { '-','-','-','-','-','-','-','-','-','-','-','-' };
@@ -65,7 +144,13 @@ int main(int argc, char **argv) {
 
   System::initialize(System::locate_install_dir(argv[0]));
 
-  compressor = CompressorFactory::create_block_codec(argv[1]);
+  try {
+    compressor = CompressorFactory::create_block_codec(argv[1]);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
 
   if (!compressor)
     return 1;
@@ -76,27 +161,46 @@ int main(int argc, char **argv) {
     return 1;
   }
   input.ptr = input.base + len;
+  input.size = len;
+
+  if (!round_trip(compressor, argv[1], input, output1, output2, header))
+    return 1;
 
   try {
-    compressor->deflate(input, output1, header);
-    compressor->inflate(output1, output2, header);
+    report(compressor, argv[1], input, input.fill(), header);
+
+    BlockCompressionCodecZstd *zstd =
+      dynamic_cast<BlockCompressionCodecZstd *>(compressor);
+
+    // Train dictionary on small blocks of the input and verify that blocks
+    // compressed with it round-trip
+    if (zstd && zstd->get_dictionary_size()) {
+      vector<size_t> sizes;
+      for (size_t offset=0; offset<input.fill(); offset += DICT_BLOCK_SIZE)
+        sizes.push_back(std::min(DICT_BLOCK_SIZE, input.fill()-offset));
+
+      report(compressor, "no dictionary", input, DICT_BLOCK_SIZE, header);
+
+      string dictionary =
+        BlockCompressionCodecZstd::train_dictionary(input, sizes,
+                                                    zstd->get_dictionary_size());
+      if (dictionary.empty())
+        cout << "dictionary: not enough sample data" << endl;
+      else {
+        zstd->set_dictionary(dictionary);
+        if (!round_trip(compressor, argv[1], input, output1, output2, header))
+          return 1;
+        report(compressor, format("dictionary (%u bytes)",
+                                  (unsigned)dictionary.size()).c_str(),
+               input, DICT_BLOCK_SIZE, header);
+      }
+    }
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
     return 1;
   }
 
-  if (input.fill() != output2.fill()) {
-    HT_ERRORF("Input length (%lu) does not match output length (%lu) after %s "
-              "codec", (Lu)input.fill(), (Lu)output2.fill(), argv[0]);
-    return 1;
-  }
-
-  if (memcmp(input.base, output2.base, input.fill())) {
-    HT_ERRORF("Input does not match output after %s codec", argv[0]);
-    return 1;
-  }
-
   // this should not compress ...
 
   memcpy(input.base, "foo", 3);
@@ -104,25 +208,10 @@ int main(int argc, char **argv) {
 
   output2.free();
 
-  try {
-    compressor->deflate(input, output1, header);
-    compressor->inflate(output1, output2, header);
-  }
-  catch (Exception &e) {
-    HT_ERROR_OUT << e << HT_END;
+  if (!round_trip(compressor, argv[1], input, output1, output2, header))
     return 1;
-  }
 
-  if (input.fill() != output2.fill()) {
-    HT_ERRORF("Input length (%lu) does not match output length (%lu) after %s "
-              "codec", (Lu)input.fill(), (Lu)output2.fill(), argv[0]);
-    return 1;
-  }
-
-  if (memcmp(input.base, output2.base, input.fill())) {
-    HT_ERRORF("Input does not match output after %s codec", argv[0]);
-    return 1;
-  }
+  delete compressor;
 
   return 0;
 }
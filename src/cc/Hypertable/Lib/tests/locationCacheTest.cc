@@ -23,12 +23,18 @@
 
 #include <Hypertable/Lib/LocationCache.h>
 
+#include <Common/Random.h>
+#include <Common/Stopwatch.h>
 #include <Common/StringExt.h>
 #include <Common/Usage.h>
 
+#include <atomic>
 #include <cstdio>
 #include <fstream>
+#include <iostream>
+#include <thread>
 #include <utility>
+#include <vector>
 
 extern "C" {
 #include <sys/types.h>
@@ -89,7 +95,9 @@ namespace {
     "",
     "Validates LocationCache class.  Generates output file "
     "'./locationCacheTest.output' and",
-    "diffs it against ./locationCacheTest.golden'.",
+    "diffs it against ./locationCacheTest.golden'.  Then measures lookup",
+    "throughput with an increasing number of reader threads while a writer",
+    "thread keeps inserting and invalidating entries.",
     0
   };
   typedef pair<const char *, const char *> RowRangeSpec;
@@ -255,6 +263,83 @@ namespace {
       outfile << "[NULL]" << endl;
   }
 
+  const int BENCH_RANGES = 10000;
+  const int BENCH_LOOKUPS = 1000000;
+
+  String bench_row(int i) {
+    return format("row%08d", i);
+  }
+
+  void bench_insert(LocationCache &cache, int i, const char *server) {
+    RangeLocationInfo range_loc_info;
+    range_loc_info.start_row = i ? bench_row(i*10) : String();
+    range_loc_info.end_row = bench_row((i+1)*10);
+    range_loc_info.addr.set_proxy(server);
+    cache.insert("1", range_loc_info);
+  }
+
+  /// Looks up rows and checks that each hit contains the row.  Rows are
+  /// generated up front so that readers only contend inside the cache.
+  void bench_reader(LocationCache *cache, const vector<String> *rows,
+                    atomic<int> *misses) {
+    RangeLocationInfo range_loc_info;
+    int local_misses = 0;
+    for (const String &row : *rows) {
+      if (!cache->lookup("1", row.c_str(), &range_loc_info)) {
+        local_misses++;
+        continue;
+      }
+      HT_ASSERT(row > range_loc_info.start_row &&
+                row <= range_loc_info.end_row);
+    }
+    *misses += local_misses;
+  }
+
+  /// Multi-threaded lookup benchmark
+  void bench(int threads) {
+    // Room for all but a few ranges so that inserts also evict
+    LocationCache cache(BENCH_RANGES - 100);
+    atomic<bool> done(false);
+    atomic<int> misses(0);
+
+    for (int i=0; i<BENCH_RANGES; i++)
+      bench_insert(cache, i, server_ids[i % MAX_SERVERIDS]);
+
+    vector<vector<String>> rows(threads);
+    for (auto &thread_rows : rows) {
+      thread_rows.reserve(BENCH_LOOKUPS / threads);
+      for (int i=0; i<BENCH_LOOKUPS / threads; i++)
+        thread_rows.push_back(bench_row(Random::number32(BENCH_RANGES*10)));
+    }
+
+    // Writer moves ranges around and invalidates them while readers run
+    thread writer([&cache, &done]() {
+        int n = 0;
+        while (!done) {
+          int i = Random::number32(BENCH_RANGES);
+          if (n++ % 4 == 0)
+            cache.invalidate("1", bench_row(i*10 + 5).c_str());
+          else
+            bench_insert(cache, i, server_ids[n % MAX_SERVERIDS]);
+          this_thread::yield();
+        }
+      });
+
+    Stopwatch w;
+    vector<thread> readers;
+    for (int i=0; i<threads; i++)
+      readers.push_back(thread(bench_reader, &cache, &rows[i], &misses));
+    for (auto &t : readers)
+      t.join();
+    w.stop();
+    done = true;
+    writer.join();
+
+    cout << "threads=" << threads << ": "
+         << (size_t)(BENCH_LOOKUPS / w.elapsed()) << " lookups/s, "
+         << misses << " misses" << endl;
+  }
+
 }
 
 
@@ -318,5 +403,8 @@ int main(int argc, char **argv) {
   if (system("diff ./locationCacheTest.output ./locationCacheTest.golden"))
     return 1;
 
+  for (int threads=1; threads<=8; threads *= 2)
+    bench(threads);
+
   return 0;
 }
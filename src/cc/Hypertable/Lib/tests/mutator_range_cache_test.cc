@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/LocationCache.h>
+#include <Hypertable/Lib/TableMutatorAsyncRangeCache.h>
+
+#include <Common/Logger.h>
+#include <Common/Stopwatch.h>
+#include <Common/StringExt.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *table_id = "3";
+  const int RANGES = 256;
+  const int ROWS = 100000;
+
+  String row_key(int i) {
+    return format("row%08d", i);
+  }
+
+  /// Resolves row the way the scatter buffer does
+  const RangeLocationInfo *locate(TableMutatorAsyncRangeCache &range_cache,
+                                  LocationCache &cache, const char *row,
+                                  bool *hit) {
+    const RangeLocationInfo *info = range_cache.lookup(row);
+    *hit = info != 0;
+    if (info)
+      return info;
+    RangeLocationInfo loc;
+    HT_ASSERT(cache.lookup(table_id, row, &loc));
+    return range_cache.insert(loc);
+  }
+
+  /// Checks that row resolves to the same range as in the location cache
+  void check(TableMutatorAsyncRangeCache &range_cache, LocationCache &cache,
+             const char *row, bool *hit) {
+    RangeLocationInfo expected;
+    HT_ASSERT(cache.lookup(table_id, row, &expected));
+    const RangeLocationInfo *info = locate(range_cache, cache, row, hit);
+    HT_ASSERT(info->start_row == expected.start_row);
+    HT_ASSERT(info->end_row == expected.end_row);
+    HT_ASSERT(info->addr == expected.addr);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  LocationCachePtr cache = make_shared<LocationCache>(RANGES * 2);
+  int span = ROWS / RANGES;
+  bool hit;
+
+  srandom(1);
+
+  for (int i=0; i<RANGES; i++) {
+    RangeLocationInfo loc;
+    loc.start_row = i ? row_key(i*span - 1) : String();
+    loc.end_row = (i+1 == RANGES) ? String(Key::END_ROW_MARKER)
+      : row_key((i+1)*span - 1);
+    loc.addr.set_proxy(format("rs%d", i % 7));
+    cache->insert(table_id, loc);
+  }
+
+  // Snapshot smaller than the working set exercises eviction
+  TableMutatorAsyncRangeCache range_cache(cache, 32);
+
+  for (int i=0; i<100000; i++)
+    check(range_cache, *cache, row_key(random() % ROWS).c_str(), &hit);
+
+  // Rows within a few ranges are served from the snapshot
+  size_t hits = 0;
+  for (int i=0; i<10000; i++) {
+    check(range_cache, *cache, row_key(random() % (span*8)).c_str(), &hit);
+    if (hit)
+      hits++;
+  }
+  HT_ASSERT(hits >= 10000 - 8);
+
+  // Inserting ranges of another table leaves the snapshot in place
+  String row = row_key(span / 2);
+  check(range_cache, *cache, row.c_str(), &hit);
+  for (int i=0; i<RANGES / 2; i++) {
+    RangeLocationInfo loc;
+    loc.end_row = row_key(i);
+    loc.addr.set_proxy("rs-other");
+    cache->insert("4", loc);
+  }
+  check(range_cache, *cache, row.c_str(), &hit);
+  HT_ASSERT(hit);
+
+  // Invalidating a range discards the snapshot
+  HT_ASSERT(cache->invalidate(table_id, row.c_str()));
+  HT_ASSERT(range_cache.lookup(row.c_str()) == 0);
+  RangeLocationInfo loc;
+  loc.start_row = String();
+  loc.end_row = row_key(span - 1);
+  loc.addr.set_proxy("rs-moved");
+  cache->insert(table_id, loc);
+  check(range_cache, *cache, row.c_str(), &hit);
+  HT_ASSERT(!hit);
+  HT_ASSERT(range_cache.lookup(row.c_str())->addr == loc.addr);
+
+  // Compare with going to the location cache for every row of a sorted run
+  Stopwatch w1;
+  RangeAddrInfo addr_info;
+  for (int i=0; i<ROWS; i++)
+    HT_ASSERT(cache->lookup(table_id, row_key(i).c_str(), &addr_info));
+  w1.stop();
+  Stopwatch w2;
+  for (int i=0; i<ROWS; i++)
+    locate(range_cache, *cache, row_key(i).c_str(), &hit);
+  w2.stop();
+  cout << "location cache: " << (size_t)(ROWS / w1.elapsed())
+       << " lookups/s, range cache: " << (size_t)(ROWS / w2.elapsed())
+       << " lookups/s" << endl;
+
+  return 0;
+}
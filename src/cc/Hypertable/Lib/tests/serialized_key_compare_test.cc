@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/SerializedKey.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Logger.h>
+#include <Common/MemoryCompare.h>
+#include <Common/Stopwatch.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Original (memcmp based) SerializedKey::compare()
+  int reference_compare(const SerializedKey sk1, const SerializedKey sk2) {
+    const uint8_t *ptr1, *ptr2;
+    int len1 = sk1.decode_length(&ptr1);
+    int len2 = sk2.decode_length(&ptr2);
+
+    if (*ptr1 != *ptr2) {
+      if (*ptr1 >= 0x80 && *ptr1 != 0xD0)
+        len1 -= 8;
+      if (*ptr2 >= 0x80 && *ptr2 != 0xD0)
+        len2 -= 8;
+    }
+    int len = (len1 < len2) ? len1 : len2;
+    int cmp = memcmp(ptr1+1, ptr2+1, len-1);
+    return (cmp==0) ? len1 - len2 : cmp;
+  }
+
+  int sign(int64_t v) { return (v > 0) - (v < 0); }
+
+  /// Random string from a small alphabet so that keys share long prefixes
+  string random_string(size_t max_len) {
+    string str;
+    size_t len = random() % (max_len+1);
+    for (size_t i=0; i<len; i++)
+      str += "aab\x7f\xff"[random() % 5];
+    return str;
+  }
+
+  const uint8_t flags[] = { FLAG_DELETE_ROW, FLAG_DELETE_COLUMN_FAMILY,
+                            FLAG_DELETE_CELL, FLAG_DELETE_CELL_VERSION,
+                            FLAG_INSERT };
+
+  void generate_keys(DynamicBuffer &buf, vector<SerializedKey> &keys,
+                     size_t count) {
+    vector<size_t> offsets;
+    string row, qualifier;
+    for (size_t i=0; i<count; i++) {
+      row = random_string(40);
+      qualifier = random_string(20);
+      int64_t timestamp = AUTO_ASSIGN, revision = AUTO_ASSIGN;
+      switch (random() % 4) {
+      case 0: break;
+      case 1: timestamp = random() % 4; break;
+      case 2: revision = random() % 4; break;
+      case 3: timestamp = revision = random() % 4; break;
+      }
+      offsets.push_back(buf.fill());
+      create_key_and_append(buf, flags[random() % 5], row.c_str(),
+                            1 + random() % 2, qualifier.c_str(), timestamp,
+                            revision, (random() % 2) == 0);
+    }
+    for (auto offset : offsets)
+      keys.push_back(SerializedKey(buf.base + offset));
+  }
+
+  /// Checks mismatch implementation against byte-by-byte scan
+  void check_mismatch(const char *name, MemoryCompare::MismatchFunc mismatch,
+                      size_t iterations) {
+    uint8_t a[512], b[512];
+    for (size_t i=0; i<iterations; i++) {
+      size_t offset_a = random() % 32, offset_b = random() % 32;
+      size_t len = random() % (sizeof(a) - 32);
+      for (size_t j=0; j<len; j++)
+        a[offset_a+j] = b[offset_b+j] = (uint8_t)random();
+      size_t expected = len;
+      if (len && random() % 4) {
+        expected = random() % len;
+        while (b[offset_b+expected] == a[offset_a+expected])
+          b[offset_b+expected] = (uint8_t)random();
+      }
+      size_t found = mismatch(a+offset_a, b+offset_b, len);
+      if (found != expected) {
+        cout << name << " mismatch returned " << found << " expected "
+             << expected << " (len=" << len << ")" << endl;
+        exit(1);
+      }
+      HT_ASSERT(sign(MemoryCompare::compare(a+offset_a, b+offset_b, len)) ==
+                sign(memcmp(a+offset_a, b+offset_b, len)));
+    }
+  }
+
+}
+
+int main(int argc, char **argv) {
+  srandom(argc > 1 ? atoi(argv[1]) : 1234);
+
+  cout << "implementation: " << MemoryCompare::implementation() << endl;
+
+  check_mismatch("scalar", MemoryCompare::mismatch_scalar, 200000);
+#if defined(__x86_64__)
+  check_mismatch("sse2", MemoryCompare::mismatch_sse2, 200000);
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    check_mismatch("avx2", MemoryCompare::mismatch_avx2, 200000);
+#endif
+
+  DynamicBuffer buf(1024*1024);
+  vector<SerializedKey> keys;
+  generate_keys(buf, keys, 4000);
+
+  // Compare every pair against the original implementation
+  size_t prefix_decided = 0;
+  for (size_t i=0; i<keys.size(); i++) {
+    uint64_t prefix_i =
+      SerializedKey::row_prefix((const uint8_t *)keys[i].row());
+    for (size_t j=0; j<keys.size(); j++) {
+      int expected = sign(reference_compare(keys[i], keys[j]));
+      if (sign(keys[i].compare(keys[j])) != expected) {
+        cout << "compare mismatch: " << keys[i] << " vs " << keys[j] << endl;
+        return 1;
+      }
+      uint64_t prefix_j =
+        SerializedKey::row_prefix((const uint8_t *)keys[j].row());
+      if (prefix_i != prefix_j) {
+        prefix_decided++;
+        if ((prefix_i < prefix_j ? -1 : 1) != expected) {
+          cout << "row prefix mismatch: " << keys[i] << " vs " << keys[j]
+               << endl;
+          return 1;
+        }
+      }
+    }
+  }
+  cout << "row prefix decided " << prefix_decided << " of "
+       << keys.size()*keys.size() << " comparisons" << endl;
+
+  // Time both comparators
+  int64_t total = 0;
+  Stopwatch w;
+  for (size_t i=0; i<keys.size(); i++)
+    for (size_t j=0; j<keys.size(); j++)
+      total += sign(reference_compare(keys[i], keys[j]));
+  w.stop();
+  double ref_ns = (w.elapsed() * 1e9) / (keys.size()*keys.size());
+  w.reset();
+  w.start();
+  for (size_t i=0; i<keys.size(); i++)
+    for (size_t j=0; j<keys.size(); j++)
+      total -= sign(keys[i].compare(keys[j]));
+  w.stop();
+  double ns = (w.elapsed() * 1e9) / (keys.size()*keys.size());
+  HT_ASSERT(total == 0);
+  cout << "memcmp " << ref_ns << " ns/compare, "
+       << MemoryCompare::implementation() << " " << ns << " ns/compare"
+       << endl;
+
+  return 0;
+}
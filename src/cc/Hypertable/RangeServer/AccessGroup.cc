@@ -205,7 +205,7 @@ MergeScannerAccessGroup *AccessGroup::create_scanner(ScanContext *scan_ctx) {
     m_cell_cache_manager->add_scanners(scanner, scan_ctx);
 
     if (!m_in_memory) {
-      bool bloom_filter_disabled;
+      uint8_t bloom_filter_mode;
 
       for (size_t i=0; i<m_stores.size(); ++i) {
 
@@ -213,14 +213,16 @@ MergeScannerAccessGroup *AccessGroup::create_scanner(ScanContext *scan_ctx) {
             scan_ctx->time_interval.second < m_stores[i].timestamp_min)
           continue;
 
-        bloom_filter_disabled = boost::any_cast<uint8_t>(m_stores[i].cs->get_trailer()->get("bloom_filter_mode")) == BLOOM_FILTER_DISABLED;
+        bloom_filter_mode = boost::any_cast<uint8_t>(m_stores[i].cs->get_trailer()->get("bloom_filter_mode"));
 
         initial_bytes_read = m_stores[i].cs->bytes_read();
 
         // Query bloomfilter only if it is enabled and a start row has been specified
-        // (ie query is not something like select bar from foo;)
-        if (bloom_filter_disabled ||
-            !scan_ctx->single_row ||
+        // (ie query is not something like select bar from foo;).  Prefix
+        // bloom filters can also rule out scans over rows sharing a prefix
+        if (bloom_filter_mode == BLOOM_FILTER_DISABLED ||
+            (!scan_ctx->single_row &&
+             bloom_filter_mode != BLOOM_FILTER_ROW_PREFIX) ||
             scan_ctx->start_row == "") {
           if (m_stores[i].shadow_cache) {
             scanner->add_scanner(m_stores[i].shadow_cache->create_scanner(scan_ctx));
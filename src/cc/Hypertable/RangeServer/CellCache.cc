@@ -28,6 +28,7 @@
 
 #include <Hypertable/Lib/Key.h>
 
+#include <Common/DynamicBuffer.h>
 #include <Common/Logger.h>
 #include <Common/Serialization.h>
 
@@ -38,31 +39,8 @@
 using namespace Hypertable;
 using namespace std;
 
-namespace {
-
-  struct CounterKeyCompare {
-    bool operator()(const CellCache::Value lhs, const CellCache::Value rhs) {
-      const uint8_t *ptr1, *ptr2;
-      int len1 = lhs.first.decode_length(&ptr1);
-      int len2 = rhs.first.decode_length(&ptr2);
-
-      // Strip timestamp & revision from key length (see Key.h)
-      if (*ptr1 >= 0x80)
-        len1 -= (*ptr1 & Key::REV_IS_TS) ? 8 : 16;
-      if (*ptr2 >= 0x80)
-        len2 -= (*ptr2 & Key::REV_IS_TS) ? 8 : 16;
-
-      int len = (len1 < len2) ? len1 : len2;
-      int cmp = memcmp(ptr1+1, ptr2+1, len-1);
-      return (cmp==0) ? len1 - len2 : cmp;
-    }
-  };
-
-}
-
-
 CellCache::CellCache()
-  : m_cell_map(std::less<const SerializedKey>(), Alloc(m_arena)) {
+  : m_cell_map(m_arena) {
   assert(Config::properties); // requires Config::init* first
   m_arena.set_page_size((size_t)
       Config::get_i32("Hypertable.RangeServer.AccessGroup.CellCache.PageSize"));
@@ -89,8 +67,8 @@ void CellCache::add(const Key &key, const ByteString value) {
   CellMap::value_type v(new_key, key.length);
   std::pair<CellMap::iterator, bool> r = m_cell_map.insert(v);
   if (!r.second) {
-    m_cell_map.erase(r.first);
-    m_cell_map.insert(v);
+    // Equal keys have equal lengths, so the value offset is unchanged
+    m_cell_map.replace(r.first, new_key);
     m_collisions++;
     HT_WARNF("Collision detected key insert (row = %s)", new_key.row());
   }
@@ -120,18 +98,21 @@ void CellCache::add_counter(const Key &key, const ByteString value) {
 
   HT_ASSERT(*value.ptr == 8);
 
-  CounterKeyCompare comp;
-  Value lookup_value(key.serial, 0);
-  auto range = equal_range(m_cell_map.begin(), m_cell_map.end(), lookup_value, comp);
+  // Probe for the first cell with the same row, column and flag by zeroing
+  // the timestamp & revision bytes (see Key.h)
+  size_t prefix_len = (key.flag_ptr+1) - (const uint8_t *)key.serial.ptr;
+  DynamicBuffer probe(key.length);
+  probe.add_unchecked(key.serial.ptr, prefix_len);
+  memset(probe.ptr, 0, key.length-prefix_len);
+
+  auto iter = m_cell_map.lower_bound(SerializedKey(probe.base));
 
   // If no matching key, do a normal add
-  if (range.first == range.second) {
+  if (iter == m_cell_map.end()) {
     add(key, value);
     return;
   }
 
-  auto iter = range.first;
-
   size_t len = (*iter).first.decode_length(&ptr);
 
   // If the lengths differ, assume they're different keys and do a normal add
@@ -175,9 +156,6 @@ void CellCache::add_counter(const Key &key, const ByteString value) {
   }
 #endif
 
-  // Copy timestamp/revision info from insert key to the one in the map
-  memcpy(((uint8_t *)(*iter).first.ptr) + offset, key.flag_ptr+1, len);
-
   // read old value
   ptr = old_value.ptr+1;
   size_t remaining = 8;
@@ -188,19 +166,33 @@ void CellCache::add_counter(const Key &key, const ByteString value) {
   remaining = 8;
   int64_t new_count = (int64_t)Serialization::decode_i64(&ptr, &remaining);
 
-  uint8_t *write_ptr = (uint8_t *)old_value.ptr+1;
-
+  // Scanners read the map without locking, so build the accumulated cell in
+  // new memory and publish it with a single pointer swap
+  size_t key_len = (*iter).second;
+  SerializedKey new_key;
+  uint8_t *write_ptr;
+
+  new_key.ptr = write_ptr = m_arena.alloc(key_len + 9);
+  memcpy(write_ptr, (*iter).first.ptr, offset);
+  // Copy timestamp/revision info from insert key
+  memcpy(write_ptr + offset, key.flag_ptr+1, len);
+  write_ptr += key_len;
+  *write_ptr++ = 8;
   Serialization::encode_i64(&write_ptr, old_count+new_count);
+
+  m_key_bytes += key_len;
+  m_value_bytes += 9;
+
+  m_cell_map.replace(iter, new_key);
 }
 
 
 void CellCache::split_row_estimate_data(SplitRowDataMapT &split_row_data) {
-  lock_guard<mutex> lock(m_mutex);
   const char *row, *last_row = 0;
   int64_t last_count = 0;
   for (CellMap::iterator iter = m_cell_map.begin();
        iter != m_cell_map.end(); ++iter) {
-    row = iter->first.row();
+    row = (*iter).first.row();
     if (last_row == 0)
       last_row = row;
     if (strcmp(row, last_row) != 0) {
@@ -23,12 +23,12 @@
 #define Hypertable_RangeServer_CellCache_h
 
 #include <Hypertable/RangeServer/CellCacheAllocator.h>
+#include <Hypertable/RangeServer/CellCacheSkipList.h>
 #include <Hypertable/RangeServer/CellListScanner.h>
 #include <Hypertable/RangeServer/CellList.h>
 
 #include <Hypertable/Lib/SerializedKey.h>
 
-#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -47,7 +47,9 @@ namespace Hypertable {
   /**
    * Represents  a sorted list of key/value pairs in memory.
    * All updates get written to the CellCache and later get "compacted"
-   * into a CellStore on disk.
+   * into a CellStore on disk.  Cells are held in a CellCacheSkipList;
+   * writers are serialized with #lock and #unlock, but scanners read the
+   * cell map without taking the mutex.
    */
   class CellCache : public CellList, public std::enable_shared_from_this<CellCache> {
 
@@ -65,7 +67,7 @@ namespace Hypertable {
 
     CellCache();
     CellCache(CellCacheArena &arena);
-    virtual ~CellCache() { m_cell_map.clear(); }
+    virtual ~CellCache() { }
     /**
      * Adds a key/value pair to the CellCache.  This method assumes that
      * the CellCache has been locked by a call to #lock.  Copies of
@@ -88,9 +90,9 @@ namespace Hypertable {
     void lock()   { m_mutex.lock(); }
     void unlock() { m_mutex.unlock(); }
 
-    size_t size() { std::lock_guard<std::mutex> lock(m_mutex); return m_cell_map.size(); }
+    size_t size() { return m_cell_map.size(); }
 
-    bool empty() { std::lock_guard<std::mutex> lock(m_mutex); return m_cell_map.empty(); }
+    bool empty() { return m_cell_map.empty(); }
 
     /** Returns the amount of memory used by the CellCache.  This is the
      * summation of the lengths of all the keys and values in the map.
@@ -141,13 +143,12 @@ namespace Hypertable {
 
     friend class CellCacheScanner;
 
-    typedef std::pair<const SerializedKey, uint32_t> Value;
-    typedef CellCacheAllocator<Value> Alloc;
-    typedef std::map<const SerializedKey, uint32_t,
-                     std::less<const SerializedKey>, Alloc> CellMap;
+    typedef CellCacheSkipList::value_type Value;
+    typedef CellCacheSkipList CellMap;
 
   protected:
 
+    /// Serializes writers and protects statistics (not needed for scans)
     std::mutex m_mutex;
     CellCacheArena m_arena;
     CellMap m_cell_map;
@@ -36,9 +36,7 @@ using namespace std;
 
 CellCacheScanner::CellCacheScanner(CellCachePtr cellcache,
                                    ScanContext *scan_ctx)
-  : CellListScanner(scan_ctx), m_cell_cache_ptr(cellcache),
-    m_cell_cache_mutex(cellcache->m_mutex) {
-  lock_guard<mutex> lock(m_cell_cache_mutex);
+  : CellListScanner(scan_ctx), m_cell_cache_ptr(cellcache) {
   DynamicBuffer current_buf;
   Key current;
   String tmp_str;
@@ -73,11 +71,11 @@ CellCacheScanner::CellCacheScanner(CellCachePtr cellcache,
 
     for (iter = m_cell_cache_ptr->m_cell_map.lower_bound(current.serial);
          iter != m_cell_cache_ptr->m_cell_map.end(); ++iter) {
-      current.load(iter->first);
+      current.load((*iter).first);
       if (current.flag != FLAG_DELETE_ROW ||
           strcmp(current.row, scan_ctx->start_key.row))
         break;
-      m_deletes.insert(CellCache::CellMap::value_type(iter->first, iter->second));
+      m_deletes.insert(*iter);
     }
 
     if (scan_ctx->has_start_cf_qualifier) {
@@ -92,12 +90,12 @@ CellCacheScanner::CellCacheScanner(CellCachePtr cellcache,
 
       for (iter = m_cell_cache_ptr->m_cell_map.lower_bound(current.serial);
            iter != m_cell_cache_ptr->m_cell_map.end(); ++iter) {
-        current.load(iter->first);
+        current.load((*iter).first);
         if (current.flag != FLAG_DELETE_COLUMN_FAMILY ||
             current.column_family_code != scan_ctx->start_key.column_family_code ||
             strcmp(current.row, scan_ctx->start_key.row))
           break;
-        m_deletes.insert(CellCache::CellMap::value_type(iter->first, iter->second));
+        m_deletes.insert(*iter);
       }
     }
   }
@@ -202,8 +200,6 @@ void CellCacheScanner::internal_forward() {
  * size_t                         m_entry_cache_next;
  */
 void CellCacheScanner::load_entry_cache() {
-  lock_guard<mutex> lock(m_cell_cache_mutex);
-
   m_entry_cache_next = 0;
   m_entry_cache.clear();
 
@@ -29,7 +29,8 @@
 namespace Hypertable {
 
   /**
-   * Provides a scanning interface to a CellCache.
+   * Provides a scanning interface to a CellCache.  The cell map is read
+   * without taking the cache mutex, so scans do not block writers.
    */
   class CellCacheScanner : public CellListScanner {
   public:
@@ -38,6 +39,16 @@ namespace Hypertable {
     virtual void forward();
     virtual bool get(Key &key, ByteString &value);
 
+    /// Returns reference to cell cache.
+    /// Values live in the cell cache arena, which remains valid for as long
+    /// as the cell cache itself.
+    /// @return Reference to cell cache, or empty pointer if scan is keys only
+    virtual std::shared_ptr<void> pin_value() {
+      if (m_keys_only)
+        return std::shared_ptr<void>();
+      return m_cell_cache_ptr;
+    }
+
     virtual int64_t get_disk_read() { return 0; }
 
     typedef std::map<const SerializedKey, uint32_t> CellCacheMap;
@@ -60,7 +71,6 @@ namespace Hypertable {
     CellCache::CellMap::iterator   m_cur_iter;
     CellCacheMap::iterator         m_delete_iter;
     CellCachePtr                   m_cell_cache_ptr;
-    std::mutex                    &m_cell_cache_mutex;
     CellCacheEntry                 m_cur_entry;
     std::vector<CellCacheEntry>    m_entry_cache;
     size_t                         m_entry_cache_next {};
@@ -0,0 +1,128 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CellCacheSkipList.
+/// This file contains type definitions for CellCacheSkipList, an arena
+/// backed, single-writer/multi-reader skiplist that holds the cells of a
+/// CellCache.
+
+#include <Common/Compat.h>
+
+#include "CellCacheSkipList.h"
+
+#include <new>
+
+using namespace Hypertable;
+using namespace std;
+
+CellCacheSkipList::CellCacheSkipList(CellCacheArena &arena) : m_arena(arena) {
+  Node *head = new (m_head_storage) Node();
+  head->m_key.store(nullptr, memory_order_relaxed);
+  head->m_value_offset = 0;
+  for (int i=0; i<MAX_HEIGHT; i++)
+    head->m_next[i].store(nullptr, memory_order_relaxed);
+}
+
+
+pair<CellCacheSkipList::iterator, bool>
+CellCacheSkipList::insert(const value_type &v) {
+  Node *prev[MAX_HEIGHT];
+  Node *node = find_greater_or_equal(v.first, prev);
+
+  if (node && node->key().compare(v.first) == 0)
+    return make_pair(iterator(node), false);
+
+  int height = random_height();
+  int max_height = m_max_height.load(memory_order_relaxed);
+  if (height > max_height) {
+    for (int i=max_height; i<height; i++)
+      prev[i] = head();
+    // Readers that see the new height before the node is linked simply
+    // descend from the head's (still null) pointer at the new levels
+    m_max_height.store(height, memory_order_relaxed);
+  }
+
+  node = new_node(v, height);
+  for (int i=0; i<height; i++) {
+    node->m_next[i].store(prev[i]->m_next[i].load(memory_order_relaxed),
+                          memory_order_relaxed);
+    prev[i]->m_next[i].store(node, memory_order_release);
+  }
+  m_size.fetch_add(1, memory_order_release);
+  return make_pair(iterator(node), true);
+}
+
+
+CellCacheSkipList::iterator
+CellCacheSkipList::lower_bound(const SerializedKey key) const {
+  return iterator(find_greater_or_equal(key, nullptr));
+}
+
+
+CellCacheSkipList::Node *
+CellCacheSkipList::new_node(const value_type &v, int height) {
+  size_t size = sizeof(Node) + (height-1)*sizeof(atomic<Node *>);
+  // Arena allocations are not aligned (keys and values are packed), so pad
+  // the request and align the node manually
+  uintptr_t addr = (uintptr_t)m_arena.alloc(size + alignof(Node) - 1);
+  addr = (addr + alignof(Node) - 1) & ~(uintptr_t)(alignof(Node) - 1);
+  Node *node = new ((void *)addr) Node();
+  node->m_key.store(v.first.ptr, memory_order_relaxed);
+  node->m_value_offset = v.second;
+  return node;
+}
+
+
+int CellCacheSkipList::random_height() {
+  // Branching factor of 4
+  int height = 1;
+  while (height < MAX_HEIGHT) {
+    m_rnd ^= m_rnd << 13;
+    m_rnd ^= m_rnd >> 17;
+    m_rnd ^= m_rnd << 5;
+    if ((m_rnd & 3) != 0)
+      break;
+    height++;
+  }
+  return height;
+}
+
+
+CellCacheSkipList::Node *
+CellCacheSkipList::find_greater_or_equal(const SerializedKey key,
+                                         Node **prev) const {
+  Node *node = head();
+  int level = m_max_height.load(memory_order_relaxed) - 1;
+  Node *next;
+  while (true) {
+    next = node->next(level);
+    if (next && next->key().compare(key) < 0)
+      node = next;
+    else {
+      if (prev)
+        prev[level] = node;
+      if (level == 0)
+        return next;
+      level--;
+    }
+  }
+}
@@ -0,0 +1,188 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellCacheSkipList.
+/// This file contains type declarations for CellCacheSkipList, an arena
+/// backed, single-writer/multi-reader skiplist that holds the cells of a
+/// CellCache.
+
+#ifndef Hypertable_RangeServer_CellCacheSkipList_h
+#define Hypertable_RangeServer_CellCacheSkipList_h
+
+#include <Hypertable/RangeServer/CellCacheAllocator.h>
+
+#include <Hypertable/Lib/SerializedKey.h>
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Sorted map of serialized keys to value offsets used by CellCache.
+  /// Nodes are allocated from the cell cache arena and are never removed, so
+  /// a pointer to a node stays valid for the lifetime of the arena.  Inserts
+  /// must be serialized by the caller (CellCache holds its mutex while
+  /// adding), but any number of readers may run concurrently with the writer
+  /// without locking.  A node is fully initialized before it is published
+  /// with a release store into its predecessors' forward pointers, so a
+  /// reader that observes a node through an acquire load also observes its
+  /// key and value.
+  class CellCacheSkipList {
+
+  public:
+
+    /// Maximum node height
+    static const int MAX_HEIGHT = 16;
+
+    /// Key/value-offset pair returned when dereferencing an iterator
+    typedef std::pair<const SerializedKey, uint32_t> value_type;
+
+    /// Skiplist node.
+    class Node {
+    public:
+      /// Returns serialized key.
+      /// @return Serialized key (value bytes follow the key)
+      SerializedKey key() const {
+        return SerializedKey(m_key.load(std::memory_order_acquire));
+      }
+
+      /// Returns offset of value relative to start of key.
+      /// @return Value offset
+      uint32_t value_offset() const { return m_value_offset; }
+
+      /// Returns next node at level <code>level</code>.
+      /// @param level Level of forward pointer to return
+      /// @return Next node at level <code>level</code>
+      Node *next(int level) const {
+        return m_next[level].load(std::memory_order_acquire);
+      }
+
+    private:
+      friend class CellCacheSkipList;
+
+      /// Pointer to serialized key and value bytes
+      std::atomic<const uint8_t *> m_key;
+
+      /// Offset of value relative to #m_key
+      uint32_t m_value_offset;
+
+      /// Forward pointers (allocated with node height elements)
+      std::atomic<Node *> m_next[1];
+    };
+
+    /// Forward iterator.
+    class iterator {
+    public:
+      iterator(Node *node=nullptr) : m_node(node) { }
+      value_type operator*() const {
+        return value_type(m_node->key(), m_node->value_offset());
+      }
+      iterator &operator++() { m_node = m_node->next(0); return *this; }
+      bool operator==(const iterator &other) const {
+        return m_node == other.m_node;
+      }
+      bool operator!=(const iterator &other) const {
+        return m_node != other.m_node;
+      }
+      Node *node() const { return m_node; }
+    private:
+      Node *m_node;
+    };
+
+    typedef iterator const_iterator;
+
+    /// Constructor.
+    /// @param arena Arena from which nodes are allocated
+    CellCacheSkipList(CellCacheArena &arena);
+
+    /// Inserts a key.
+    /// If an equal key already exists, the skiplist is left unmodified and an
+    /// iterator to the existing node is returned.
+    /// @note Must not be called concurrently with another insert
+    /// @param v Serialized key and offset of value relative to key
+    /// @return Pair consisting of iterator to node holding <code>v</code> (or
+    /// the existing equal key) and <i>true</i> if inserted
+    std::pair<iterator, bool> insert(const value_type &v);
+
+    /// Replaces the key bytes of an existing node.
+    /// <code>key</code> must occupy the same position in the sort order as
+    /// the key in the node and its value must be located at the same offset.
+    /// Concurrent readers see either the old or the new bytes.
+    /// @param iter Iterator to node to modify
+    /// @param key New key/value bytes
+    void replace(iterator iter, const SerializedKey key) {
+      iter.node()->m_key.store(key.ptr, std::memory_order_release);
+    }
+
+    /// Returns iterator to first key not less than <code>key</code>.
+    /// @param key Key to search for
+    /// @return Iterator to first key not less than <code>key</code>
+    iterator lower_bound(const SerializedKey key) const;
+
+    /// Returns iterator to first key.
+    iterator begin() const { return iterator(head()->next(0)); }
+
+    /// Returns iterator one past the last key.
+    iterator end() const { return iterator(); }
+
+    /// Returns number of keys.
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+
+    /// Checks if empty.
+    bool empty() const { return size() == 0; }
+
+  private:
+
+    Node *head() const { return (Node *)m_head_storage; }
+
+    Node *new_node(const value_type &v, int height);
+
+    int random_height();
+
+    /// Finds node preceding <code>key</code> at each level
+    Node *find_greater_or_equal(const SerializedKey key, Node **prev) const;
+
+    /// Arena from which nodes are allocated
+    CellCacheArena &m_arena;
+
+    /// Storage for head node with #MAX_HEIGHT forward pointers
+    alignas(Node) uint8_t m_head_storage[sizeof(Node) +
+                                         (MAX_HEIGHT-1)*sizeof(std::atomic<Node *>)];
+
+    /// Current maximum height
+    std::atomic<int> m_max_height {1};
+
+    /// Number of keys
+    std::atomic<size_t> m_size {0};
+
+    /// Random state for choosing node heights
+    uint32_t m_rnd {0xdeadbeef};
+  };
+
+  /// @}
+}
+
+#endif // Hypertable_RangeServer_CellCacheSkipList_h
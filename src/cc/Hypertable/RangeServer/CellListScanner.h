@@ -40,6 +40,16 @@ namespace Hypertable {
     virtual void forward() = 0;
     virtual bool get(Key &key, ByteString &value) = 0;
 
+    /// Returns reference that keeps memory of current value valid.
+    /// The value returned by get() normally becomes invalid once the scanner
+    /// is forwarded.  Scanners that return values from shared memory (e.g.
+    /// the block cache or a cell cache) can return a reference that keeps
+    /// that memory valid until the reference is released, which allows the
+    /// value to be sent to the client without being copied.
+    /// @return Reference to memory holding current value, or empty pointer
+    /// if the value can't be pinned
+    virtual std::shared_ptr<void> pin_value() { return std::shared_ptr<void>(); }
+
     ScanContext *scan_context() { return m_scan_context_ptr; }
 
     virtual int64_t get_disk_read() = 0;
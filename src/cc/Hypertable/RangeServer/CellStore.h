@@ -325,6 +325,7 @@ namespace Hypertable {
     static const char DATA_BLOCK_MAGIC[10];
     static const char INDEX_FIXED_BLOCK_MAGIC[10];
     static const char INDEX_VARIABLE_BLOCK_MAGIC[10];
+    static const char DICTIONARY_BLOCK_MAGIC[10];
 
   protected:
 
@@ -0,0 +1,139 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CellStoreBlockCompressor.
+/// This file contains type definitions for CellStoreBlockCompressor, a class
+/// that compresses CellStore blocks on the shared compression pool and hands
+/// them back in submission order.
+
+#include <Common/Compat.h>
+
+#include "CellStoreBlockCompressor.h"
+
+#include <Hypertable/Lib/BlockCompressionCodecZstd.h>
+#include <Hypertable/Lib/CompressorFactory.h>
+
+#include <Common/Logger.h>
+
+using namespace Hypertable;
+using namespace std;
+
+CellStoreBlockCompressor::CellStoreBlockCompressor(CellStoreCompressionPool *pool,
+                                                   BlockCompressionCodec::Type type,
+                                                   const BlockCompressionCodec::Args &args,
+                                                   size_t reserve)
+  : m_pool(pool), m_reserve(reserve) {
+  HT_ASSERT(pool->workers() > 0);
+  for (size_t i=0; i<pool->workers(); i++) {
+    m_codecs.push_back(unique_ptr<BlockCompressionCodec>(CompressorFactory::create_block_codec(type, args)));
+    m_idle_codecs.push_back(m_codecs.back().get());
+  }
+}
+
+
+CellStoreBlockCompressor::~CellStoreBlockCompressor() {
+  unique_lock<mutex> lock(m_mutex);
+  m_shutdown = true;
+  m_done_cond.wait(lock, [this]() { return m_tasks == 0; });
+}
+
+
+void CellStoreBlockCompressor::add(BlockPtr block) {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    block->done = false;
+    m_queue.push_back(block.get());
+    m_blocks.push_back(move(block));
+    m_tasks++;
+  }
+  m_pool->add([this]() { compress(); });
+}
+
+
+void CellStoreBlockCompressor::set_dictionary(const string &dictionary) {
+  lock_guard<mutex> lock(m_mutex);
+  HT_ASSERT(m_blocks.empty());
+  for (auto &codec : m_codecs) {
+    BlockCompressionCodecZstd *zstd =
+      dynamic_cast<BlockCompressionCodecZstd *>(codec.get());
+    if (zstd)
+      zstd->set_dictionary(dictionary);
+  }
+}
+
+
+bool CellStoreBlockCompressor::next(BlockPtr &block, bool wait) {
+  unique_lock<mutex> lock(m_mutex);
+  if (wait)
+    m_done_cond.wait(lock, [this]() {
+        return m_error || m_blocks.empty() || m_blocks.front()->done; });
+  if (m_error)
+    HT_THROW2(m_error->code(), *m_error, "Compressing CellStore block");
+  if (m_blocks.empty() || !m_blocks.front()->done)
+    return false;
+  block = move(m_blocks.front());
+  m_blocks.pop_front();
+  return true;
+}
+
+
+void CellStoreBlockCompressor::compress() {
+  Block *block {};
+  BlockCompressionCodec *codec {};
+  unique_ptr<Exception> error;
+
+  {
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_shutdown) {
+      // At most one task per pool worker runs at a time, so a codec is free
+      HT_ASSERT(!m_queue.empty() && !m_idle_codecs.empty());
+      block = m_queue.front();
+      m_queue.pop_front();
+      codec = m_idle_codecs.back();
+      m_idle_codecs.pop_back();
+    }
+  }
+
+  if (block) {
+    try {
+      codec->deflate(block->input, block->output, block->header, m_reserve);
+      // Release uncompressed data before handing block back
+      block->input.free();
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      error.reset(new Exception(e));
+    }
+  }
+
+  lock_guard<mutex> lock(m_mutex);
+  if (codec)
+    m_idle_codecs.push_back(codec);
+  if (error) {
+    if (!m_error)
+      m_error = move(error);
+  }
+  else if (block)
+    block->done = true;
+  m_tasks--;
+  m_done_cond.notify_all();
+}
@@ -0,0 +1,176 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellStoreBlockCompressor.
+/// This file contains type declarations for CellStoreBlockCompressor, a class
+/// that compresses CellStore blocks on the shared compression pool and hands
+/// them back in submission order.
+
+#ifndef Hypertable_RangeServer_CellStoreBlockCompressor_h
+#define Hypertable_RangeServer_CellStoreBlockCompressor_h
+
+#include "CellStoreCompressionPool.h"
+
+#include <Hypertable/Lib/BlockCompressionCodec.h>
+#include <Hypertable/Lib/BlockHeaderCellStore.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Error.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Compresses CellStore blocks in parallel.
+  /// Blocks are submitted with add() and compressed by the worker threads of
+  /// a CellStoreCompressionPool shared with all other CellStores being
+  /// written.  The compressor holds one BlockCompressionCodec per pool worker
+  /// and lends one to each running task, since codec type, arguments and
+  /// dictionary differ from one CellStore to the next.  Compressed blocks
+  /// are returned by next() strictly in the order they were submitted, so the
+  /// caller can append them to the CellStore file and assign block index
+  /// offsets exactly as if they had been compressed inline.
+  class CellStoreBlockCompressor {
+  public:
+
+    /// Block to be compressed.
+    class Block {
+    public:
+      /// Constructor.
+      /// @param header_version Block header version
+      /// @param magic Block header magic string
+      Block(uint16_t header_version, const char *magic)
+        : header(header_version, magic) { }
+      /// Block header
+      BlockHeaderCellStore header;
+      /// Uncompressed block data
+      DynamicBuffer input;
+      /// Compressed block, including header
+      DynamicBuffer output;
+      /// Opaque caller data carried along with block (e.g. index key)
+      DynamicBuffer tag;
+      /// Set to <i>true</i> once compressed
+      bool done {};
+    };
+
+    /// Smart pointer to Block
+    typedef std::unique_ptr<Block> BlockPtr;
+
+    /// Constructor.
+    /// Creates one codec per worker of <code>pool</code>.
+    /// @param pool Pool whose workers compress the blocks
+    /// @param type Compression codec type
+    /// @param args Compression codec arguments
+    /// @param reserve Extra bytes to reserve at end of each compressed block
+    CellStoreBlockCompressor(CellStoreCompressionPool *pool,
+                             BlockCompressionCodec::Type type,
+                             const BlockCompressionCodec::Args &args,
+                             size_t reserve);
+
+    /// Destructor.
+    /// Discards any blocks not yet compressed or retrieved and waits for the
+    /// tasks already handed to the pool to finish.
+    ~CellStoreBlockCompressor();
+
+    /// Submits block for compression.
+    /// @param block Block to compress
+    void add(BlockPtr block);
+
+    /// Retrieves next compressed block in submission order.
+    /// If <code>wait</code> is <i>true</i>, blocks until the oldest
+    /// outstanding block has been compressed.  If a worker failed to
+    /// compress the block, the exception it raised is rethrown here.
+    /// @param block Set to next compressed block
+    /// @param wait Wait for the oldest outstanding block
+    /// @return <i>true</i> if <code>block</code> was set, <i>false</i> if no
+    /// blocks are outstanding or (when <code>wait</code> is <i>false</i>)
+    /// the oldest block is not yet compressed
+    bool next(BlockPtr &block, bool wait);
+
+    /// Sets compression dictionary on every worker codec.
+    /// Only applies to Zstandard codecs and must be called while no blocks
+    /// are outstanding.
+    /// @param dictionary Dictionary content
+    void set_dictionary(const std::string &dictionary);
+
+    /// Returns number of submitted blocks not yet retrieved.
+    /// @return Number of outstanding blocks
+    size_t outstanding() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_blocks.size();
+    }
+
+    /// Returns number of blocks that can be compressed at the same time.
+    /// @return Number of pool workers
+    size_t workers() const { return m_codecs.size(); }
+
+  private:
+
+    /// Pool task that compresses the oldest block waiting for a worker
+    void compress();
+
+    /// Pool whose workers compress the blocks
+    CellStoreCompressionPool *m_pool;
+
+    /// %Mutex protecting members
+    std::mutex m_mutex;
+
+    /// Signals that a block finished compressing or a task completed
+    std::condition_variable m_done_cond;
+
+    /// Outstanding blocks in submission order
+    std::deque<BlockPtr> m_blocks;
+
+    /// Blocks waiting for a worker
+    std::deque<Block *> m_queue;
+
+    /// One codec per pool worker
+    std::vector<std::unique_ptr<BlockCompressionCodec>> m_codecs;
+
+    /// Codecs not in use by a running task
+    std::vector<BlockCompressionCodec *> m_idle_codecs;
+
+    /// Number of tasks added to the pool that have not completed
+    size_t m_tasks {};
+
+    /// Extra bytes to reserve at end of compressed block
+    size_t m_reserve;
+
+    /// First error encountered by a worker
+    std::unique_ptr<Exception> m_error;
+
+    /// Set to <i>true</i> to make remaining tasks skip their block
+    bool m_shutdown {};
+  };
+
+  /// @}
+}
+
+#endif // Hypertable_RangeServer_CellStoreBlockCompressor_h
@@ -39,8 +39,10 @@
 #include <Common/StaticBuffer.h>
 
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <vector>
 
 namespace Hypertable {
 
@@ -94,8 +96,17 @@ namespace Hypertable {
     ArrayIteratorT m_iter;
   };
 
-  /**
-   *
+  /** Block index of a CellStore.
+   * Entries are held in a key-ordered array of SerializedKey/offset pairs.
+   * When the prefix layout is enabled (see set_prefix_layout()), a second
+   * copy of the index is built holding only the fixed-width key prefix of
+   * each entry (see SerializedKey::row_prefix()), laid out in Eytzinger (BFS)
+   * order.  Row bytes shared by every entry (e.g. a common table key
+   * prefix) are skipped before taking the prefix so that it stays
+   * selective.  lower_bound() and upper_bound() then walk that array, touching
+   * one cache line every three levels instead of dereferencing a key
+   * pointer at every step, and only fall back to a full key comparison when
+   * prefixes tie.
    */
   template <typename OffsetT>
   class CellStoreBlockIndexArray {
@@ -186,6 +197,8 @@ namespace Hypertable {
         m_middle_key = m_array[mid_point].key;
       }
 
+      build_prefix_tree();
+
       // Free variable buf here to maintain original semantics
       variable.free();
 
@@ -373,7 +386,9 @@ namespace Hypertable {
     }
 
     size_t memory_used() {
-      return m_keydata.size + (m_array.size() * (sizeof(ElementT)));
+      return m_keydata.size + (m_array.size() * (sizeof(ElementT))) +
+        (m_prefix_tree.size() * sizeof(uint64_t)) +
+        (m_prefix_slot.size() * sizeof(uint32_t));
     }
 
     int64_t disk_used() { return m_disk_used; }
@@ -396,16 +411,46 @@ namespace Hypertable {
     }
 
     iterator lower_bound(const SerializedKey& k) {
+      if (!m_prefix_tree.empty()) {
+        uint64_t prefix;
+        int scope = common_row_scope(k, &prefix);
+        if (scope)
+          return scope < 0 ? begin() : end();
+        return prefix_search([this, prefix, &k](size_t i) {
+            uint64_t p = m_prefix_tree[i];
+            return p < prefix ||
+              (p == prefix && m_array[m_prefix_slot[i]].key < k);
+          });
+      }
       ElementT ee(k);
       return iterator(std::lower_bound(m_array.begin(), m_array.end(), ee, LtT()));
     }
 
     iterator upper_bound(const SerializedKey& k) {
+      if (!m_prefix_tree.empty()) {
+        uint64_t prefix;
+        int scope = common_row_scope(k, &prefix);
+        if (scope)
+          return scope < 0 ? begin() : end();
+        return prefix_search([this, prefix, &k](size_t i) {
+            uint64_t p = m_prefix_tree[i];
+            return p < prefix ||
+              (p == prefix && !(k < m_array[m_prefix_slot[i]].key));
+          });
+      }
       ElementT ee(k);
       return iterator(std::upper_bound(m_array.begin(), m_array.end(), ee, LtT()));
     }
 
+    /** Enables or disables the Eytzinger-ordered prefix layout.
+     * Takes effect at the next load() or rescope().
+     * @param enable <i>true</i> to build the prefix layout
+     */
+    void set_prefix_layout(bool enable) { m_prefix_layout = enable; }
+
     void clear() {
+      m_prefix_tree.clear();
+      m_prefix_slot.clear();
       m_array.clear();
       m_keydata.free();
       m_middle_key.ptr = 0;
@@ -413,12 +458,104 @@ namespace Hypertable {
     }
 
   private:
+
+    /** Builds Eytzinger-ordered prefix array from #m_array.
+     * Position 0 of #m_prefix_tree is unused; the children of position
+     * <code>i</code> are at <code>2i</code> and <code>2i+1</code>.
+     */
+    void build_prefix_tree() {
+      m_prefix_tree.clear();
+      m_prefix_slot.clear();
+      if (!m_prefix_layout || m_array.empty())
+        return;
+      const char *first = m_array.front().key.row();
+      const char *last = m_array.back().key.row();
+      m_common_row = first;
+      for (m_common_row_length = 0;
+           first[m_common_row_length] &&
+             first[m_common_row_length] == last[m_common_row_length];
+           ++m_common_row_length)
+        ;
+      m_prefix_tree.resize(m_array.size() + 1);
+      m_prefix_slot.resize(m_array.size() + 1);
+      size_t next = 0;
+      build_prefix_tree(1, next);
+      HT_ASSERT(next == m_array.size());
+    }
+
+    void build_prefix_tree(size_t i, size_t &next) {
+      if (i >= m_prefix_tree.size())
+        return;
+      build_prefix_tree(2*i, next);
+      m_prefix_slot[i] = (uint32_t)next;
+      m_prefix_tree[i] = SerializedKey::row_prefix(
+        (const uint8_t *)m_array[next].key.row() + m_common_row_length);
+      next++;
+      build_prefix_tree(2*i+1, next);
+    }
+
+    /** Locates key relative to row bytes common to all entries.
+     * @param k Search key
+     * @param prefix Address of variable to hold search prefix of
+     * <code>k</code> (only set if return value is 0)
+     * @return Negative if <code>k</code> sorts before every entry, positive if
+     * it sorts after every entry, and 0 if its row starts with the common
+     * bytes
+     */
+    int common_row_scope(const SerializedKey &k, uint64_t *prefix) {
+      const uint8_t *row = (const uint8_t *)k.row();
+      const uint8_t *common = (const uint8_t *)m_common_row;
+      for (size_t i=0; i<m_common_row_length; ++i) {
+        if (row[i] != common[i])
+          return (row[i] < common[i]) ? -1 : 1;
+      }
+      *prefix = SerializedKey::row_prefix(row + m_common_row_length);
+      return 0;
+    }
+
+    /** Searches prefix array for first entry for which <code>less</code> is
+     * <i>false</i>.
+     * @param less Predicate returning <i>true</i> if entry at Eytzinger
+     * position is ordered before the search key
+     * @return Iterator to first entry not ordered before the search key
+     */
+    template <typename LessT>
+    iterator prefix_search(LessT less) {
+      size_t n = m_prefix_tree.size() - 1;
+      size_t i = 1;
+      while (i <= n) {
+        // Descendants three levels down share one cache line
+        __builtin_prefetch(m_prefix_tree.data() + 8*i);
+        i = 2*i + (less(i) ? 1 : 0);
+      }
+      // Strip the trailing right turns plus the final left turn
+      i >>= __builtin_ffsll(~(unsigned long long)i);
+      if (i == 0)
+        return iterator(m_array.end());
+      return iterator(m_array.begin() + m_prefix_slot[i]);
+    }
+
     ArrayT m_array;
     StaticBuffer m_keydata;
     SerializedKey m_middle_key;
     OffsetT m_end_of_last_block;
     OffsetT m_disk_used;
     OffsetT m_maximum_entries;
+
+    /// Build Eytzinger-ordered prefix layout on load
+    bool m_prefix_layout {};
+
+    /// Key prefixes in Eytzinger order (1-based)
+    std::vector<uint64_t> m_prefix_tree;
+
+    /// Maps Eytzinger position to index in #m_array
+    std::vector<uint32_t> m_prefix_slot;
+
+    /// Row bytes shared by all entries (points into #m_keydata)
+    const char *m_common_row {};
+
+    /// Length of #m_common_row
+    size_t m_common_row_length {};
   };
 
   /** @}*/
@@ -0,0 +1,74 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for CellStoreCompressionPool.
+/// This file contains type definitions for CellStoreCompressionPool, the
+/// set of worker threads shared by all CellStores being written.
+
+#include <Common/Compat.h>
+
+#include "CellStoreCompressionPool.h"
+
+#include <Common/Logger.h>
+
+using namespace Hypertable;
+using namespace std;
+
+CellStoreCompressionPool::CellStoreCompressionPool(size_t workers) {
+  HT_ASSERT(workers > 0);
+  for (size_t i=0; i<workers; i++)
+    m_threads.push_back(thread(&CellStoreCompressionPool::worker, this));
+}
+
+
+CellStoreCompressionPool::~CellStoreCompressionPool() {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_shutdown = true;
+    m_cond.notify_all();
+  }
+  for (auto &t : m_threads)
+    t.join();
+}
+
+
+void CellStoreCompressionPool::add(function<void()> task) {
+  lock_guard<mutex> lock(m_mutex);
+  m_queue.push_back(move(task));
+  m_cond.notify_one();
+}
+
+
+void CellStoreCompressionPool::worker() {
+  function<void()> task;
+  while (true) {
+    {
+      unique_lock<mutex> lock(m_mutex);
+      m_cond.wait(lock, [this]() { return m_shutdown || !m_queue.empty(); });
+      if (m_queue.empty())
+        return;
+      task = move(m_queue.front());
+      m_queue.pop_front();
+    }
+    task();
+  }
+}
@@ -0,0 +1,91 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for CellStoreCompressionPool.
+/// This file contains type declarations for CellStoreCompressionPool, the
+/// set of worker threads shared by all CellStores being written.
+
+#ifndef Hypertable_RangeServer_CellStoreCompressionPool_h
+#define Hypertable_RangeServer_CellStoreCompressionPool_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Worker threads that compress CellStore blocks.
+  /// One pool is shared by every CellStoreBlockCompressor in the RangeServer,
+  /// so the number of threads compressing blocks stays fixed no matter how
+  /// many compactions and splits are writing CellStores at the same time.
+  /// Tasks are run in the order they were added.
+  class CellStoreCompressionPool {
+  public:
+
+    /// Constructor.
+    /// Starts the worker threads.
+    /// @param workers Number of worker threads
+    CellStoreCompressionPool(size_t workers);
+
+    /// Destructor.
+    /// Runs the tasks still queued and then stops the workers.
+    ~CellStoreCompressionPool();
+
+    /// Adds task to be run by a worker thread.
+    /// @param task Task to run
+    void add(std::function<void()> task);
+
+    /// Returns number of worker threads.
+    /// @return Number of worker threads
+    size_t workers() const { return m_threads.size(); }
+
+  private:
+
+    /// Worker thread loop
+    void worker();
+
+    /// %Mutex protecting members
+    std::mutex m_mutex;
+
+    /// Signals workers that a task was added or shutdown was requested
+    std::condition_variable m_cond;
+
+    /// Tasks waiting for a worker
+    std::deque<std::function<void()>> m_queue;
+
+    /// Worker threads
+    std::vector<std::thread> m_threads;
+
+    /// Set to <i>true</i> to stop the workers
+    bool m_shutdown {};
+  };
+
+  /// @}
+}
+
+#endif // Hypertable_RangeServer_CellStoreCompressionPool_h
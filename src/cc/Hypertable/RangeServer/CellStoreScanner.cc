@@ -194,6 +194,14 @@ int64_t CellStoreScanner<IndexT>::get_disk_read() {
 
 
 
+template <typename IndexT>
+std::shared_ptr<void> CellStoreScanner<IndexT>::pin_value() {
+  if (m_eos || m_keys_only)
+    return std::shared_ptr<void>();
+  return m_interval_scanners[m_interval_index]->pin_value();
+}
+
+
 template <typename IndexT>
 void CellStoreScanner<IndexT>::forward() {
   if (m_eos)
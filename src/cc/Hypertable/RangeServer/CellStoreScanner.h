@@ -51,6 +51,7 @@ namespace Hypertable {
     virtual ~CellStoreScanner();
     void forward() override;
     bool get(Key &key, ByteString &value) override;
+    std::shared_ptr<void> pin_value() override;
     int64_t get_disk_read() override;
 
   private:
@@ -25,6 +25,8 @@
 #include "Common/ByteString.h"
 #include "Hypertable/Lib/Key.h"
 
+#include <memory>
+
 namespace Hypertable {
 
   class CellStoreScannerInterval {
@@ -32,6 +34,9 @@ namespace Hypertable {
     CellStoreScannerInterval() : m_disk_read(0) { }
     virtual void forward() = 0;
     virtual bool get(Key &key, ByteString &value) = 0;
+    /// Returns reference that keeps memory of current value valid.
+    /// @see CellListScanner::pin_value()
+    virtual std::shared_ptr<void> pin_value() { return std::shared_ptr<void>(); }
     virtual ~CellStoreScannerInterval() { }
     int64_t get_disk_read() { return m_disk_read; }
 
@@ -41,11 +41,21 @@
 #include <Common/Error.h>
 #include <Common/System.h>
 
+#include <atomic>
 #include <cassert>
+#include <cstring>
 #include <utility>
+#include <vector>
 
 using namespace Hypertable;
 
+namespace {
+
+  /// Set once the filesystem has reported that it does not support preadv
+  std::atomic<bool> preadv_unsupported {false};
+
+}
+
 template <typename IndexT>
 CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(CellStorePtr &cellstore,
   IndexT *index, SerializedKey start_key, SerializedKey end_key, ScanContext *scan_ctx) :
@@ -107,7 +117,7 @@ CellStoreScannerIntervalBlockIndex<IndexT>::~CellStoreScannerIntervalBlockIndex(
   if (m_block.base != 0) {
     if (m_cached)
       Global::block_cache->checkin(m_file_id, m_block.offset);
-    else
+    else if (!m_block_pin)
       delete [] m_block.base;
   }
   delete m_zcodec;
@@ -171,6 +181,37 @@ void CellStoreScannerIntervalBlockIndex<IndexT>::forward() {
 
 
 
+/**
+ * Pins the current block.  If the block came from the block cache, an extra
+ * reference to it is taken with FileBlockCache::pin(), which leaves its
+ * position in the cache unchanged, and the returned reference unpins it when
+ * the last copy is released.  Otherwise ownership of the block memory passes
+ * from this scanner to the reference.  The reference is created once per
+ * block and shared by all values pinned from that block.
+ */
+template <typename IndexT>
+std::shared_ptr<void> CellStoreScannerIntervalBlockIndex<IndexT>::pin_value() {
+  if (m_block.base == 0)
+    return std::shared_ptr<void>();
+  if (!m_block_pin) {
+    if (m_cached) {
+      uint8_t *block;
+      if (!Global::block_cache->pin(m_file_id, m_block.offset, &block))
+        return std::shared_ptr<void>();
+      HT_ASSERT(block == m_block.base);
+      int file_id = m_file_id;
+      int64_t offset = m_block.offset;
+      m_block_pin.reset(block, [file_id, offset](void *) {
+          Global::block_cache->unpin(file_id, offset);
+        });
+    }
+    else
+      m_block_pin.reset((void *)m_block.base,
+                        [](void *block) { delete [] (uint8_t *)block; });
+  }
+  return m_block_pin;
+}
+
 /**
  * This method fetches the 'next' compressed block of key/value pairs from the
  * underlying CellStore.
@@ -190,9 +231,10 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
   if (m_block.base != 0 && eob) {
     if (m_cached)
       Global::block_cache->checkin(m_file_id, m_block.offset);
-    else
+    else if (!m_block_pin)
       delete [] m_block.base;
     memset(&m_block, 0, sizeof(m_block));
+    m_block_pin.reset();
     ++m_iter;
 
     // find next block requested by scan and filter rows
@@ -225,8 +267,7 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
      * Cache lookup / block read
      */
     if (Global::block_cache == 0 || Global::block_cache->compressed() ||
-        !Global::block_cache->checkout(m_file_id, m_block.offset,
-				       (uint8_t **)&m_block.base, &len)) {
+        !checkout_block((uint8_t **)&m_block.base, &len)) {
       bool second_try {};
       bool checked_out {};
 
@@ -236,16 +277,15 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
         EventPtr event;
 
 	if (Global::block_cache == 0 || !Global::block_cache->compressed() ||
-            !Global::block_cache->checkout(m_file_id, m_block.offset,
-				           (uint8_t **)&buf.base, &len)) {
+            !checkout_block((uint8_t **)&buf.base, &len)) {
 
 	  /** Read compressed block **/
-          DispatchHandlerSynchronizer sync_handler;
-	  Global::dfs->pread(m_fd, m_block.zlength, m_block.offset, second_try, &sync_handler);
-          if (!sync_handler.wait_for_reply(event))
-            HT_THROW(Protocol::response_code(event.get()),
-                     Protocol::string_format_message(event).c_str());
-          {
+          if (second_try || !read_with_prefetch(event, buf)) {
+            DispatchHandlerSynchronizer sync_handler;
+            Global::dfs->pread(m_fd, m_block.zlength, m_block.offset, second_try, &sync_handler);
+            if (!sync_handler.wait_for_reply(event))
+              HT_THROW(Protocol::response_code(event.get()),
+                       Protocol::string_format_message(event).c_str());
             uint32_t length;
             uint64_t off;
             const void *data;
@@ -281,10 +321,10 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
         if (Global::block_cache && Global::block_cache->compressed()) {
           if (checked_out)
             Global::block_cache->checkin(m_file_id, m_block.offset);
-          else
-            Global::block_cache->insert(m_file_id, m_block.offset,
-                                        (uint8_t *)buf.base, m_block.zlength,
-                                        event, false);
+          else if (Global::block_cache->insert(m_file_id, m_block.offset,
+                                               (uint8_t *)buf.base,
+                                               m_block.zlength, event, false))
+            buf.own = false;
         }
       }
       catch (Exception &e) {
@@ -324,6 +364,183 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
   return false;
 }
 
+/**
+ * Reads the current block together with the blocks that follow it in a single
+ * vectored read.  Up to Global::cellstore_prefetch_blocks following blocks are
+ * read.  Prefetch stops at the end of the index, at the first block lying
+ * past the end row of the scan interval, and at the first block that is
+ * already in the block cache.  Prefetched blocks are inserted into the block
+ * cache, where subsequent calls to fetch_next_block() find them.  Scans that
+ * filter rows skip blocks and do not prefetch.  With a compressed block cache,
+ * the current block is copied out of the response into <code>buf</code>,
+ * which then owns it, so that the cache is not charged for a block while it
+ * holds on to the whole response.
+ *
+ * @param event Set to the response event holding the data read
+ * @param buf Set to point to the data of the current block in <code>event</code>
+ * @return true if the current block was read, false if prefetch does not apply
+ * and nothing was read
+ */
+template <typename IndexT>
+bool CellStoreScannerIntervalBlockIndex<IndexT>::read_with_prefetch(EventPtr &event,
+                                                                    DynamicBuffer &buf) {
+
+  if (Global::cellstore_prefetch_blocks <= 0 || Global::block_cache == 0 ||
+      !m_rowset.empty() || preadv_unsupported)
+    return false;
+
+  std::vector<Filesystem::Extent> extents;
+  extents.push_back(Filesystem::Extent(m_block.offset, m_block.zlength));
+
+  IndexIteratorT it_prev = m_iter;
+  IndexIteratorT it = m_iter;
+  ++it;
+  while (it != m_index->end() &&
+         extents.size() <= (size_t)Global::cellstore_prefetch_blocks) {
+    // Previous block ends past the end row, so this one is not needed
+    if (strcmp(it_prev.key().row(), m_end_row) > 0)
+      break;
+    uint64_t offset = it.value();
+    if (Global::block_cache->contains(m_file_id, offset))
+      break;
+    IndexIteratorT it_next = it;
+    ++it_next;
+    uint64_t end = (it_next == m_index->end()) ?
+      m_index->end_of_last_block() : it_next.value();
+    extents.push_back(Filesystem::Extent(offset, (uint32_t)(end - offset)));
+    it_prev = it;
+    it = it_next;
+  }
+
+  if (extents.size() == 1)
+    return false;
+
+  std::vector<Filesystem::Extent> requested = extents;
+
+  DispatchHandlerSynchronizer sync_handler;
+  Global::dfs->preadv(m_fd, extents, false, &sync_handler);
+  if (!sync_handler.wait_for_reply(event)) {
+    int error = Protocol::response_code(event.get());
+    // Brokers without preadv support answer with one of these
+    if (error == Error::NOT_IMPLEMENTED || error == Error::PROTOCOL_ERROR ||
+        error == Error::INVALID_METHOD_IDENTIFIER) {
+      if (!preadv_unsupported.exchange(true))
+        HT_INFOF("Filesystem does not support preadv (%s), disabling "
+                 "CellStore block prefetch", Error::get_text(error));
+      return false;
+    }
+    HT_THROW(error, Protocol::string_format_message(event).c_str());
+  }
+
+  Global::dfs->decode_response_preadv(event, extents);
+
+  if (extents.size() != requested.size() ||
+      extents[0].length != m_block.zlength)
+    HT_THROWF(Error::FSBROKER_EOF, "Short preadv of block at offset %llu",
+              (Llu)m_block.offset);
+
+  if (Global::block_cache->compressed()) {
+    buf.base = new uint8_t [m_block.zlength];
+    memcpy(buf.base, extents[0].data, m_block.zlength);
+    buf.own = true;
+  }
+  else {
+    buf.base = (uint8_t *)extents[0].data;
+    buf.own = false;
+  }
+
+  for (size_t i=1; i<extents.size(); i++) {
+    if (extents[i].length != requested[i].length)
+      break;
+    if (cache_prefetched_block(extents[i]))
+      m_prefetch_end = extents[i].offset + extents[i].length;
+  }
+
+  if (Global::block_cache->compressed())
+    event.reset();
+
+  return true;
+}
+
+/**
+ * Inserts a prefetched block into the block cache.  Blocks are inserted into
+ * the probationary segment of the cache; when the scan reaches them they are
+ * pinned rather than checked out (see checkout_block()), so read-ahead is
+ * only promoted if a later scan reads it again.  With a compressed cache the
+ * block is copied out of the response so that the memory charged to the
+ * cache is the memory it holds.  Blocks that fail to inflate are dropped;
+ * they are read again, with checksum verification, if the scan reaches them.
+ *
+ * @param extent Extent of the compressed block
+ * @return true if the block was inserted into the cache
+ */
+template <typename IndexT>
+bool CellStoreScannerIntervalBlockIndex<IndexT>::cache_prefetched_block(const Filesystem::Extent &extent) {
+
+  if (Global::block_cache->compressed()) {
+    uint8_t *block = new uint8_t [extent.length];
+    memcpy(block, extent.data, extent.length);
+    if (!Global::block_cache->insert(m_file_id, extent.offset, block,
+                                     extent.length, EventPtr(), false)) {
+      delete [] block;
+      return false;
+    }
+    return true;
+  }
+
+  DynamicBuffer buf;
+  DynamicBuffer expand_buf;
+  BlockHeaderCellStore header(m_cellstore->block_header_format());
+
+  buf.base = (uint8_t *)extent.data;
+  buf.ptr = buf.base + extent.length;
+  buf.own = false;
+
+  try {
+    m_zcodec->inflate(buf, expand_buf, header);
+  }
+  catch (Exception &e) {
+    HT_DEBUG_OUT << "Dropping prefetched block at offset " << extent.offset
+                 << " of " << m_cellstore->get_filename() << " - " << e
+                 << HT_END;
+    return false;
+  }
+
+  if (!header.check_magic(CellStore::DATA_BLOCK_MAGIC))
+    return false;
+
+  m_disk_read += expand_buf.fill();
+
+  size_t fill;
+  uint8_t *block = expand_buf.release(&fill);
+  if (!Global::block_cache->insert(m_file_id, extent.offset, block, fill,
+                                   EventPtr(), false)) {
+    delete [] block;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Gets the current block from the block cache.  Blocks that this scanner
+ * prefetched are pinned, leaving them in the probationary segment, since
+ * the scan reaching them is not a second access.  All other blocks are
+ * checked out.  Either way the block is released with
+ * FileBlockCache::checkin().
+ *
+ * @param blockp Address of variable to hold block pointer
+ * @param lengthp Address of variable to hold block length
+ * @return true if the block is cached, false otherwise
+ */
+template <typename IndexT>
+bool CellStoreScannerIntervalBlockIndex<IndexT>::checkout_block(uint8_t **blockp,
+                                                                uint32_t *lengthp) {
+  if (m_block.offset < m_prefetch_end)
+    return Global::block_cache->pin(m_file_id, m_block.offset, blockp, lengthp);
+  return Global::block_cache->checkout(m_file_id, m_block.offset, blockp,
+                                       lengthp);
+}
+
 namespace Hypertable {
   template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<uint32_t> >;
   template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<int64_t> >;
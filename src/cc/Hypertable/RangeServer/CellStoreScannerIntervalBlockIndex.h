@@ -32,7 +32,10 @@
 #include <Hypertable/RangeServer/CellStoreScannerInterval.h>
 #include <Hypertable/RangeServer/ScanContext.h>
 
+#include <AsyncComm/Event.h>
+
 #include <Common/DynamicBuffer.h>
+#include <Common/Filesystem.h>
 
 namespace Hypertable {
 
@@ -54,15 +57,23 @@ namespace Hypertable {
     virtual ~CellStoreScannerIntervalBlockIndex();
     virtual void forward();
     virtual bool get(Key &key, ByteString &value);
+    virtual std::shared_ptr<void> pin_value();
 
   private:
 
     bool fetch_next_block(bool eob=false);
 
+    bool read_with_prefetch(EventPtr &event, DynamicBuffer &buf);
+
+    bool cache_prefetched_block(const Filesystem::Extent &extent);
+
+    bool checkout_block(uint8_t **blockp, uint32_t *lengthp);
+
     CellStorePtr          m_cellstore;
     IndexT               *m_index {};
     IndexIteratorT        m_iter;
     BlockInfo             m_block;
+    std::shared_ptr<void> m_block_pin;
     Key                   m_key;
     SerializedKey         m_cur_key;
     ByteString            m_cur_value;
@@ -73,6 +84,7 @@ namespace Hypertable {
     BlockCompressionCodec *m_zcodec {};
     KeyDecompressor      *m_key_decompressor {};
     int32_t               m_fd {-1};
+    int64_t               m_prefetch_end {};
     bool                  m_cached {};
     bool                  m_check_for_range_end {};
     int                   m_file_id {};
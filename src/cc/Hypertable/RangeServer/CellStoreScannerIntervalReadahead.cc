@@ -149,7 +149,8 @@ CellStoreScannerIntervalReadahead<IndexT>::~CellStoreScannerIntervalReadahead()
   try {
     if (m_fd != -1)
       Global::dfs->close(m_fd);
-    delete [] m_block.base;
+    if (!m_block_pin)
+      delete [] m_block.base;
     delete m_zcodec;
     delete m_key_decompressor;
   }
@@ -219,6 +220,21 @@ void CellStoreScannerIntervalReadahead<IndexT>::forward() {
 
 
 
+/**
+ * Pins the current block.  Ownership of the block memory passes from this
+ * scanner to the returned reference, which is created once per block and
+ * shared by all values pinned from that block.
+ */
+template <typename IndexT>
+std::shared_ptr<void> CellStoreScannerIntervalReadahead<IndexT>::pin_value() {
+  if (m_block.base == 0)
+    return std::shared_ptr<void>();
+  if (!m_block_pin)
+    m_block_pin.reset((void *)m_block.base,
+                      [](void *block) { delete [] (uint8_t *)block; });
+  return m_block_pin;
+}
+
 /**
  * This method fetches the 'next' compressed block of key/value pairs from
  * the underlying CellStore.
@@ -238,8 +254,10 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
 
   // If we're at the end of the current block, deallocate and move to next
   if (m_block.base != 0 && eob) {
-    delete [] m_block.base;
+    if (!m_block_pin)
+      delete [] m_block.base;
     memset(&m_block, 0, sizeof(m_block));
+    m_block_pin.reset();
   }
 
   if (m_offset >= m_end_offset)
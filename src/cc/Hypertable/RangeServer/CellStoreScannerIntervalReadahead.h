@@ -54,6 +54,7 @@ namespace Hypertable {
     virtual ~CellStoreScannerIntervalReadahead();
     virtual void forward();
     virtual bool get(Key &key, ByteString &value);
+    virtual std::shared_ptr<void> pin_value();
 
   private:
 
@@ -61,6 +62,7 @@ namespace Hypertable {
 
     CellStorePtr           m_cellstore;
     BlockInfo              m_block;
+    std::shared_ptr<void>  m_block_pin;
     Key                    m_key;
     SerializedKey          m_end_key;
     ByteString             m_cur_value;
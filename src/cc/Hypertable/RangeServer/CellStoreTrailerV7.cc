@@ -221,6 +221,12 @@ void CellStoreTrailerV7::display(std::ostream &os) {
     os << " 64BIT_INDEX";
   if (flags & MAJOR_COMPACTION)
     os << " MAJOR_COMPACTION";
+  if (flags & COMPRESSION_DICTIONARY)
+    os << " COMPRESSION_DICTIONARY";
+  if (flags & BLOOM_FILTER_PREFIX_DELIMITER)
+    os << " BLOOM_FILTER_PREFIX_DELIMITER";
+  if (flags & BLOOM_FILTER_BLOCKED)
+    os << " BLOOM_FILTER_BLOCKED";
   os << " )";
   os << ", alignment=" << alignment;
   os << ", compression_ratio=" << compression_ratio;
@@ -233,6 +239,14 @@ void CellStoreTrailerV7::display(std::ostream &os) {
     os << ", bloom_filter_mode=ROWS";
   else if (bloom_filter_mode == BLOOM_FILTER_ROWS_COLS)
     os << ", bloom_filter_mode=ROWS_COLS";
+  else if (bloom_filter_mode == BLOOM_FILTER_ROW_PREFIX) {
+    if (flags & BLOOM_FILTER_PREFIX_DELIMITER)
+      os << ", bloom_filter_mode=ROW_PREFIX(delimiter='"
+         << (char)get_bloom_filter_prefix() << "')";
+    else
+      os << ", bloom_filter_mode=ROW_PREFIX(length="
+         << (int)get_bloom_filter_prefix() << ")";
+  }
   else
     os << ", bloom_filter_mode=?(" << bloom_filter_mode << ")";
   os << ", bloom_filter_hash_count=" << bloom_filter_hash_count;
@@ -282,6 +296,14 @@ void CellStoreTrailerV7::display_multiline(std::ostream &os) {
     os << "  bloom_filter_mode=ROWS\n";
   else if (bloom_filter_mode == BLOOM_FILTER_ROWS_COLS)
     os << "  bloom_filter_mode=ROWS_COLS\n";
+  else if (bloom_filter_mode == BLOOM_FILTER_ROW_PREFIX) {
+    if (flags & BLOOM_FILTER_PREFIX_DELIMITER)
+      os << "  bloom_filter_mode=ROW_PREFIX(delimiter='"
+         << (char)get_bloom_filter_prefix() << "')\n";
+    else
+      os << "  bloom_filter_mode=ROW_PREFIX(length="
+         << (int)get_bloom_filter_prefix() << ")\n";
+  }
   else
     os << "  bloom_filter_mode=?(" << bloom_filter_mode << ")\n";
   os << "  bloom_filter_hash_count=" << (int)bloom_filter_hash_count << "\n";
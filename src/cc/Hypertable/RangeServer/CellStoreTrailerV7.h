@@ -85,11 +85,33 @@ namespace Hypertable {
     uint8_t   bloom_filter_hash_count;
     uint16_t  version;
 
+    /// Trailer flags.  For the BLOOM_FILTER_ROW_PREFIX bloom filter mode, the
+    /// high byte of #flags holds the prefix length, or the prefix delimiter
+    /// if BLOOM_FILTER_PREFIX_DELIMITER is set (see
+    /// get_bloom_filter_prefix()).
     enum Flags { INDEX_64BIT = 1,
                  MAJOR_COMPACTION = 2,
-                 SPLIT = 4
+                 SPLIT = 4,
+                 COMPRESSION_DICTIONARY = 8,
+                 BLOOM_FILTER_PREFIX_DELIMITER = 16,
+                 BLOOM_FILTER_BLOCKED = 32
     };
 
+    /// Sets row key prefix parameter of prefix bloom filter.
+    /// @param value Prefix length or delimiter character
+    /// @param delimiter <i>true</i> if <code>value</code> is a delimiter
+    void set_bloom_filter_prefix(uint8_t value, bool delimiter) {
+      flags &= ~(0xFF000000 | BLOOM_FILTER_PREFIX_DELIMITER);
+      flags |= (uint32_t)value << 24;
+      if (delimiter)
+        flags |= BLOOM_FILTER_PREFIX_DELIMITER;
+    }
+
+    /// Gets row key prefix parameter of prefix bloom filter.
+    /// @return Prefix length, or delimiter character if
+    /// BLOOM_FILTER_PREFIX_DELIMITER is set in #flags
+    uint8_t get_bloom_filter_prefix() const { return (uint8_t)(flags >> 24); }
+
     boost::any get(const String& prop) {
       if     (prop == "version")                return version;
       else if (prop == "trailer_checksum")      return trailer_checksum;
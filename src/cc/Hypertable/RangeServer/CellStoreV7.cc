@@ -41,6 +41,7 @@
 
 #include "AsyncComm/Protocol.h"
 
+#include "Hypertable/Lib/BlockCompressionCodecZstd.h"
 #include "Hypertable/Lib/BlockHeaderCellStore.h"
 #include "Hypertable/Lib/CompressorFactory.h"
 #include "Hypertable/Lib/Key.h"
@@ -62,19 +63,35 @@ using namespace Hypertable;
 
 namespace {
   const uint32_t MAX_APPENDS_OUTSTANDING = 3;
-  const uint16_t BLOCK_HEADER_VERSION = 1;
+  /// Block header version for new CellStores (readers use the version
+  /// recorded in the trailer)
+  const uint16_t BLOCK_HEADER_VERSION = 2;
+  /// Amount of sample data, as a multiple of the dictionary size, buffered
+  /// before training a compression dictionary
+  const size_t DICTIONARY_SAMPLE_RATIO = 100;
+  /// Number of most recently submitted data blocks left out of the
+  /// compression ratio used to size new blocks.  Independent of the number
+  /// of compression workers so that block boundaries are too.
+  const size_t BLOCKSIZE_FEEDBACK_LAG = 16;
+  /// Memory that bloom filter items may occupy while they are held back to
+  /// size the filter exactly at finalize
+  const size_t BLOOM_FILTER_ITEMS_LIMIT = 16*1024*1024;
 }
 
 
 CellStoreV7::CellStoreV7(Filesystem *filesys)
   : m_filesys(filesys) {
   m_file_id = FileBlockCache::get_next_file_id();
+  m_index_map32.set_prefix_layout(Global::cellstore_block_index_prefix_layout);
+  m_index_map64.set_prefix_layout(Global::cellstore_block_index_prefix_layout);
   assert(sizeof(float) == 4);
 }
 
 CellStoreV7::CellStoreV7(Filesystem *filesys, SchemaPtr &schema)
   : m_filesys(filesys), m_schema(schema) {
   m_file_id = FileBlockCache::get_next_file_id();
+  m_index_map32.set_prefix_layout(Global::cellstore_block_index_prefix_layout);
+  m_index_map64.set_prefix_layout(Global::cellstore_block_index_prefix_layout);
   assert(sizeof(float) == 4);
 }
 
@@ -97,8 +114,15 @@ CellStoreV7::~CellStoreV7() {
 
 
 BlockCompressionCodec *CellStoreV7::create_block_compression_codec() {
-  return CompressorFactory::create_block_codec(
+  BlockCompressionCodec *codec = CompressorFactory::create_block_codec(
       (BlockCompressionCodec::Type)m_trailer.compression_type);
+  if (!m_compression_dictionary.empty()) {
+    BlockCompressionCodecZstd *zstd =
+      dynamic_cast<BlockCompressionCodecZstd *>(codec);
+    if (zstd)
+      zstd->set_dictionary(m_compression_dictionary);
+  }
+  return codec;
 }
 
 KeyDecompressor *CellStoreV7::create_key_decompressor() {
@@ -240,6 +264,19 @@ CellStoreV7::create(const char *fname, size_t max_entries,
       (BlockCompressionCodec::Type)m_trailer.compression_type,
       m_compressor_args);
 
+  if (Global::cellstore_compression_pool &&
+      m_trailer.compression_type != BlockCompressionCodec::NONE)
+    m_block_compressor = make_unique<CellStoreBlockCompressor>(
+        Global::cellstore_compression_pool,
+        (BlockCompressionCodec::Type)m_trailer.compression_type,
+        m_compressor_args, HT_DIRECT_IO_ALIGNMENT);
+
+  // Hold back the first blocks so a dictionary can be trained from them
+  BlockCompressionCodecZstd *zstd =
+    dynamic_cast<BlockCompressionCodecZstd *>(m_compressor);
+  if (zstd)
+    m_dictionary_size = zstd->get_dictionary_size();
+
   uint32_t oflags = Filesystem::OPEN_FLAG_DIRECTIO|Filesystem::OPEN_FLAG_OVERWRITE;
   m_fd = m_filesys->create(m_filename, oflags, -1, replication, -1);
 
@@ -264,6 +301,21 @@ CellStoreV7::create(const char *fname, size_t max_entries,
     else
       m_filter_false_positive_prob = props->get_f64("false-positive");
     m_bloom_filter_items = new BloomFilterItems(); // aproximator items
+    m_bloom_filter_items_bytes = 0;
+    m_last_bloom_item.clear();
+    m_last_bloom_family = -1;
+
+    if (props->has("blocked"))
+      m_trailer.flags |= CellStoreTrailerV7::BLOOM_FILTER_BLOCKED;
+
+    if (m_bloom_filter_mode == BLOOM_FILTER_ROW_PREFIX) {
+      if (props->has("prefix-delimiter"))
+        m_trailer.set_bloom_filter_prefix(props->get_str("prefix-delimiter")[0],
+                                          true);
+      else
+        m_trailer.set_bloom_filter_prefix(props->get_i32("prefix-length"),
+                                          false);
+    }
   }
   HT_DEBUG_OUT <<"bloom-filter-mode="<< m_bloom_filter_mode
       <<" max-approx-items="<< m_max_approx_items <<" false-positive="
@@ -280,11 +332,13 @@ void CellStoreV7::create_bloom_filter(bool is_approx) {
   try {
     if (m_filter_false_positive_prob != 0.0)
       m_bloom_filter = new BloomFilterWithChecksum(m_trailer.filter_items_estimate,
-                                                   m_filter_false_positive_prob);
+                                                   m_filter_false_positive_prob,
+                                                   bloom_filter_encoding());
     else
       m_bloom_filter = new BloomFilterWithChecksum(m_trailer.filter_items_estimate,
                                                    m_bloom_bits_per_item,
-                                                   m_trailer.bloom_filter_hash_count);
+                                                   m_trailer.bloom_filter_hash_count,
+                                                   bloom_filter_encoding());
   }
   catch(Exception &e) {
     HT_FATAL_OUT << "Error creating new BloomFilter for CellStore '"
@@ -302,6 +356,55 @@ void CellStoreV7::create_bloom_filter(bool is_approx) {
     << m_filename <<"'"<< HT_END;
 }
 
+void CellStoreV7::add_bloom_filter_item(const void *item, size_t len) {
+
+  if (m_bloom_filter) {
+    m_bloom_filter->insert(item, len);
+    return;
+  }
+
+  if (!m_bloom_filter_items->insert(item, len).second)
+    return;
+
+  m_bloom_filter_items_bytes += len + sizeof(BloomFilterItems::value_type);
+
+  // Too many items to hold until finalize, extrapolate the number of items
+  // from the cells seen so far
+  if (m_bloom_filter_items_bytes > BLOOM_FILTER_ITEMS_LIMIT &&
+      m_trailer.total_entries >= m_max_approx_items) {
+    int64_t items = (int64_t)m_bloom_filter_items->size();
+    m_trailer.filter_items_estimate = (int64_t)(((double)m_max_entries
+        / (double)(m_trailer.total_entries + 1)) * items);
+    if (m_trailer.filter_items_estimate < items)
+      m_trailer.filter_items_estimate = items;
+    create_bloom_filter(true);
+  }
+}
+
+
+size_t CellStoreV7::bloom_filter_prefix_length(const char *row,
+                                               size_t row_len, bool *complete) {
+  bool found;
+  size_t len;
+  if (m_trailer.flags & CellStoreTrailerV7::BLOOM_FILTER_PREFIX_DELIMITER) {
+    const char *ptr = (const char *)memchr(row,
+                                           m_trailer.get_bloom_filter_prefix(),
+                                           row_len);
+    found = ptr != 0;
+    len = found ? (ptr - row) + 1 : row_len;
+  }
+  else {
+    len = m_trailer.get_bloom_filter_prefix();
+    found = row_len >= len;
+    if (!found)
+      len = row_len;
+  }
+  if (complete)
+    *complete = found;
+  return len;
+}
+
+
 const std::vector<String> &CellStoreV7::get_replaced_files() {
   lock_guard<mutex> lock(m_mutex);
   if (!m_replaced_files_loaded)
@@ -368,7 +471,8 @@ void CellStoreV7::load_bloom_filter() {
     m_bloom_filter = new BloomFilterWithChecksum(m_trailer.filter_items_actual,
                                                  m_trailer.filter_items_actual,
                                                  m_trailer.filter_length,
-                                                 m_trailer.bloom_filter_hash_count);
+                                                 m_trailer.bloom_filter_hash_count,
+                                                 bloom_filter_encoding());
   }
   catch(Exception &e) {
     HT_FATAL_OUT << "Error loading BloomFilter for CellStore '"
@@ -444,8 +548,6 @@ uint64_t CellStoreV7::purge_indexes() {
 
 
 void CellStoreV7::add(const Key &key, const ByteString value) {
-  EventPtr event_ptr;
-  DynamicBuffer zbuf;
 
   if (key.revision > m_trailer.revision)
     m_trailer.revision = key.revision;
@@ -458,46 +560,7 @@ void CellStoreV7::add(const Key &key, const ByteString value) {
   }
 
   if (m_buffer.fill() > (size_t)m_uncompressed_blocksize) {
-    BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DATA_BLOCK_MAGIC);
-
-    m_index_builder.add_entry(m_key_compressor, m_offset);
-
-    m_uncompressed_data += (float)m_buffer.fill();
-    m_compressor->deflate(m_buffer, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
-    m_compressed_data += (float)zbuf.fill();
-    m_buffer.clear();
-
-    uint64_t llval = ((uint64_t)m_trailer.blocksize
-        * (uint64_t)m_uncompressed_data) / (uint64_t)m_compressed_data;
-    m_uncompressed_blocksize = (int64_t)llval;
-
-    if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
-      if (!m_sync_handler.wait_for_reply(event_ptr)) {
-        if (event_ptr->type == Event::MESSAGE)
-          HT_THROWF(Hypertable::Protocol::response_code(event_ptr),
-             "Problem writing to FS file '%s' : %s", m_filename.c_str(),
-             Hypertable::Protocol::string_format_message(event_ptr).c_str());
-        HT_THROWF(event_ptr->error,
-                  "Problem writing to FS file '%s'", m_filename.c_str());
-      }
-      m_outstanding_appends--;
-    }
-
-    if (!HT_IO_ALIGNED(zbuf.fill())) {
-      memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
-      zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
-    }
-
-    size_t zlen = zbuf.fill();
-    StaticBuffer send_buf(zbuf);
-
-    try { m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler); }
-    catch (Exception &e) {
-      HT_THROW2F(e.code(), e, "Problem writing to FS file '%s'",
-                 m_filename.c_str());
-    }
-    m_outstanding_appends++;
-    m_offset += zlen;
+    add_data_block();
     m_key_compressor->reset();
   }
 
@@ -526,27 +589,23 @@ void CellStoreV7::add(const Key &key, const ByteString value) {
   m_buffer.add_unchecked(value.ptr, value_len);
 
   if (m_bloom_filter_mode != BLOOM_FILTER_DISABLED) {
-    if (m_trailer.total_entries < m_max_approx_items) {
-      m_bloom_filter_items->insert(key.row, key.row_len);
-
-      if (m_bloom_filter_mode == BLOOM_FILTER_ROWS_COLS)
-        m_bloom_filter_items->insert(key.row, key.row_len + 2);
-
-      if (m_trailer.total_entries == m_max_approx_items - 1) {
-        m_trailer.filter_items_estimate = (size_t)(((double)m_max_entries
-            / (double)m_max_approx_items) * m_bloom_filter_items->size());
-        if (m_trailer.filter_items_estimate == 0)
-          m_trailer.filter_items_estimate = 1;
-        create_bloom_filter(true);
-      }
+    size_t len = key.row_len;
+    if (m_bloom_filter_mode == BLOOM_FILTER_ROW_PREFIX)
+      len = bloom_filter_prefix_length(key.row, key.row_len, 0);
+
+    // Cells are added in key order, so repeated items are adjacent
+    bool new_item = m_trailer.total_entries == 0 ||
+      len != m_last_bloom_item.length() ||
+      memcmp(key.row, m_last_bloom_item.data(), len);
+    if (new_item) {
+      m_last_bloom_item.assign(key.row, len);
+      add_bloom_filter_item(key.row, len);
     }
-    else {
-      assert(!m_bloom_filter_items && m_bloom_filter);
-
-      m_bloom_filter->insert(key.row);
 
-      if (m_bloom_filter_mode == BLOOM_FILTER_ROWS_COLS)
-        m_bloom_filter->insert(key.row, key.row_len + 2);
+    if (m_bloom_filter_mode == BLOOM_FILTER_ROWS_COLS &&
+        (new_item || key.column_family_code != m_last_bloom_family)) {
+      m_last_bloom_family = key.column_family_code;
+      add_bloom_filter_item(key.row, key.row_len + 2);
     }
   }
 
@@ -562,35 +621,15 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
   StaticBuffer send_buf;
   int64_t index_memory = 0;
 
-  if (m_buffer.fill() > 0) {
-    BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DATA_BLOCK_MAGIC);
-
-    m_index_builder.add_entry(m_key_compressor, m_offset);
+  if (m_buffer.fill() > 0)
+    add_data_block();
 
-    m_uncompressed_data += (float)m_buffer.fill();
-    m_compressor->deflate(m_buffer, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
-    m_compressed_data += (float)zbuf.fill();
-
-    if (!HT_IO_ALIGNED(zbuf.fill())) {
-      memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
-      zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
-    }
-    zlen = zbuf.fill();
-    send_buf = zbuf;
-
-    if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
-      if (!m_sync_handler.wait_for_reply(event_ptr))
-        HT_THROWF(Protocol::response_code(event_ptr),
-                  "Problem finalizing CellStore file '%s' : %s",
-                  m_filename.c_str(),
-                  Protocol::string_format_message(event_ptr).c_str());
-      m_outstanding_appends--;
-    }
-
-    m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler);
+  if (m_dictionary_size)
+    train_compression_dictionary();
 
-    m_outstanding_appends++;
-    m_offset += zlen;
+  if (m_block_compressor) {
+    write_compressed_blocks(0);
+    m_block_compressor.reset();
   }
 
   m_key_compressor = 0;
@@ -654,6 +693,29 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
   m_outstanding_appends++;
   m_offset += zlen;
 
+  /**
+   * Write compression dictionary (stored uncompressed between the variable
+   * index and the filter so it is read along with the index)
+   */
+  if (m_trailer.flags & CellStoreTrailerV7::COMPRESSION_DICTIONARY) {
+    BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DICTIONARY_BLOCK_MAGIC);
+    DynamicBuffer dbuf(0, false);
+    dbuf.base = (uint8_t *)m_compression_dictionary.data();
+    dbuf.ptr = dbuf.base + m_compression_dictionary.size();
+    unique_ptr<BlockCompressionCodec>
+      codec(CompressorFactory::create_block_codec(BlockCompressionCodec::NONE));
+    codec->deflate(dbuf, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
+    if (!HT_IO_ALIGNED(zbuf.fill())) {
+      memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
+      zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
+    }
+    zlen = zbuf.fill();
+    send_buf = zbuf;
+    m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler);
+    m_outstanding_appends++;
+    m_offset += zlen;
+  }
+
   // write filter_offset
   m_trailer.filter_offset = m_offset;
 
@@ -803,8 +865,169 @@ void CellStoreV7::finalize(TableIdentifier *table_identifier) {
 }
 
 
+void CellStoreV7::add_data_block() {
+
+  if (m_block_compressor || m_dictionary_size) {
+    CellStoreBlockCompressor::BlockPtr block =
+      make_unique<CellStoreBlockCompressor::Block>(BLOCK_HEADER_VERSION,
+                                                   DATA_BLOCK_MAGIC);
+    // Index entry is added once the block offset is known
+    block->tag.reserve(m_key_compressor->length_uncompressed());
+    m_key_compressor->write_uncompressed(block->tag.base);
+    block->tag.ptr += m_key_compressor->length_uncompressed();
+    block->input.reserve(m_buffer.fill());
+    block->input.add_unchecked(m_buffer.base, m_buffer.fill());
+    m_buffer.clear();
+    if (m_dictionary_size) {
+      m_dictionary_sample_bytes += block->input.fill();
+      m_dictionary_samples.push_back(move(block));
+      if (m_dictionary_sample_bytes >= DICTIONARY_SAMPLE_RATIO*m_dictionary_size)
+        train_compression_dictionary();
+      return;
+    }
+    add_block(move(block));
+    return;
+  }
+
+  BlockHeaderCellStore header(BLOCK_HEADER_VERSION, DATA_BLOCK_MAGIC);
+  DynamicBuffer zbuf;
+
+  m_index_builder.add_entry(m_key_compressor, m_offset);
+
+  m_compressor->deflate(m_buffer, zbuf, header, HT_DIRECT_IO_ALIGNMENT);
+  write_data_block(zbuf, m_buffer.fill());
+  m_buffer.clear();
+  update_uncompressed_blocksize();
+}
+
+
+void CellStoreV7::add_block(CellStoreBlockCompressor::BlockPtr block) {
+  if (m_block_compressor) {
+    m_block_compressor->add(move(block));
+    update_uncompressed_blocksize();
+    // Bound the number of blocks held in memory
+    write_compressed_blocks(2*m_block_compressor->workers());
+    return;
+  }
+  m_index_builder.add_entry(block->tag.base, block->tag.fill(), m_offset);
+  m_compressor->deflate(block->input, block->output, block->header,
+                        HT_DIRECT_IO_ALIGNMENT);
+  write_data_block(block->output, block->input.fill());
+  update_uncompressed_blocksize();
+}
+
+
+void CellStoreV7::update_uncompressed_blocksize() {
+  if (++m_uncounted_blocks <= BLOCKSIZE_FEEDBACK_LAG)
+    return;
+
+  // Oldest uncounted block may still be compressing
+  if (m_written_block_lengths.empty())
+    write_compressed_blocks(m_block_compressor->outstanding() - 1);
+  HT_ASSERT(!m_written_block_lengths.empty());
+
+  m_counted_uncompressed += m_written_block_lengths.front().first;
+  m_counted_compressed += m_written_block_lengths.front().second;
+  m_written_block_lengths.pop_front();
+  m_uncounted_blocks--;
+
+  m_uncompressed_blocksize =
+    (int64_t)(((uint64_t)m_trailer.blocksize * m_counted_uncompressed) /
+              m_counted_compressed);
+}
+
+
+void CellStoreV7::train_compression_dictionary() {
+  DynamicBuffer samples(m_dictionary_sample_bytes);
+  vector<size_t> sample_sizes;
+
+  for (auto &block : m_dictionary_samples) {
+    samples.add_unchecked(block->input.base, block->input.fill());
+    sample_sizes.push_back(block->input.fill());
+  }
+
+  m_compression_dictionary =
+    BlockCompressionCodecZstd::train_dictionary(samples, sample_sizes,
+                                                m_dictionary_size);
+  if (!m_compression_dictionary.empty()) {
+    dynamic_cast<BlockCompressionCodecZstd *>(m_compressor)->set_dictionary(m_compression_dictionary);
+    if (m_block_compressor)
+      m_block_compressor->set_dictionary(m_compression_dictionary);
+    m_trailer.flags |= CellStoreTrailerV7::COMPRESSION_DICTIONARY;
+  }
+
+  m_dictionary_size = 0;
+  m_dictionary_sample_bytes = 0;
+  samples.free();
+
+  vector<CellStoreBlockCompressor::BlockPtr> blocks;
+  blocks.swap(m_dictionary_samples);
+  for (auto &block : blocks)
+    add_block(move(block));
+}
+
+
+void CellStoreV7::write_compressed_blocks(size_t max_outstanding) {
+  CellStoreBlockCompressor::BlockPtr block;
+  bool wait = m_block_compressor->outstanding() > max_outstanding;
+  while (m_block_compressor->next(block, wait)) {
+    m_index_builder.add_entry(block->tag.base, block->tag.fill(), m_offset);
+    write_data_block(block->output, block->header.get_data_length());
+    wait = m_block_compressor->outstanding() > max_outstanding;
+  }
+}
+
+
+void CellStoreV7::write_data_block(DynamicBuffer &zbuf,
+                                   size_t uncompressed_length) {
+  EventPtr event_ptr;
+
+  m_uncompressed_data += (float)uncompressed_length;
+  m_compressed_data += (float)zbuf.fill();
+  m_written_block_lengths.push_back(make_pair(uncompressed_length,
+                                              zbuf.fill()));
+
+  if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
+    if (!m_sync_handler.wait_for_reply(event_ptr)) {
+      if (event_ptr->type == Event::MESSAGE)
+        HT_THROWF(Hypertable::Protocol::response_code(event_ptr),
+           "Problem writing to FS file '%s' : %s", m_filename.c_str(),
+           Hypertable::Protocol::string_format_message(event_ptr).c_str());
+      HT_THROWF(event_ptr->error,
+                "Problem writing to FS file '%s'", m_filename.c_str());
+    }
+    m_outstanding_appends--;
+  }
+
+  if (!HT_IO_ALIGNED(zbuf.fill())) {
+    memset(zbuf.ptr, 0, HT_IO_ALIGNMENT_PADDING(zbuf.fill()));
+    zbuf.ptr += HT_IO_ALIGNMENT_PADDING(zbuf.fill());
+  }
+
+  size_t zlen = zbuf.fill();
+  StaticBuffer send_buf(zbuf);
+
+  try { m_filesys->append(m_fd, send_buf, Filesystem::Flags::NONE, &m_sync_handler); }
+  catch (Exception &e) {
+    HT_THROW2F(e.code(), e, "Problem writing to FS file '%s'",
+               m_filename.c_str());
+  }
+  m_outstanding_appends++;
+  m_offset += zlen;
+}
+
+
 void CellStoreV7::IndexBuilder::add_entry(KeyCompressorPtr &key_compressor,
                                           int64_t offset) {
+  size_t key_len = key_compressor->length_uncompressed();
+  m_variable.ensure(key_len);
+  key_compressor->write_uncompressed(m_variable.ptr);
+  add_entry(m_variable.ptr, key_len, offset);
+}
+
+
+void CellStoreV7::IndexBuilder::add_entry(const uint8_t *key, size_t key_len,
+                                          int64_t offset) {
 
   // switch to 64-bit offsets if offset being added is >= 2^32
   if (!m_bigint && offset >= 4294967296LL) {
@@ -823,10 +1046,10 @@ void CellStoreV7::IndexBuilder::add_entry(KeyCompressorPtr &key_compressor,
     m_bigint = true;
   }
 
-  // Add key to variable buffer
-  size_t key_len = key_compressor->length_uncompressed();
+  // Add key to variable buffer (may already be in place)
   m_variable.ensure(key_len);
-  key_compressor->write_uncompressed(m_variable.ptr);
+  if (key != m_variable.ptr)
+    memcpy(m_variable.ptr, key, key_len);
   m_variable.ptr += key_len;
 
     // Serialize offset into fix index buffer
@@ -878,6 +1101,10 @@ CellStoreV7::open(const String &fname, const String &start_row,
 
   /** Sanity check trailer **/
   HT_ASSERT(m_trailer.version == 7);
+  if (m_trailer.block_header_version > BlockHeaderCellStore::LatestVersion)
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Unsupported block header "
+              "version %u in CellStore '%s'",
+              (unsigned)m_trailer.block_header_version, m_filename.c_str());
 
   if (m_trailer.flags & CellStoreTrailerV7::INDEX_64BIT)
     m_64bit_index = true;
@@ -931,10 +1158,39 @@ CellStoreV7::rescope(const String &start_row, const String &end_row) {
 
 
 
+void CellStoreV7::load_compression_dictionary(const uint8_t *buf, size_t len) {
+  BlockHeaderCellStore header(m_trailer.block_header_version);
+  const uint8_t *ptr = buf;
+  size_t remaining = len;
+
+  // Dictionary block follows the (padded) variable index block
+  header.decode(&ptr, &remaining);
+  size_t var_index_length = header.encoded_length() + header.get_data_zlength();
+  var_index_length += HT_IO_ALIGNMENT_PADDING(var_index_length);
+  if (var_index_length >= len)
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE, "Missing compression "
+              "dictionary in CellStore '%s'", m_filename.c_str());
+
+  DynamicBuffer input(0, false);
+  DynamicBuffer output;
+  input.base = (uint8_t *)buf + var_index_length;
+  input.ptr = (uint8_t *)buf + len;
+
+  unique_ptr<BlockCompressionCodec>
+    codec(CompressorFactory::create_block_codec(BlockCompressionCodec::NONE));
+  codec->inflate(input, output, header);
+
+  if (!header.check_magic(DICTIONARY_BLOCK_MAGIC))
+    HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, m_filename);
+
+  m_compression_dictionary.assign((const char *)output.base, output.fill());
+}
+
+
 void CellStoreV7::load_block_index() {
   int64_t amount, index_amount;
   int64_t len = 0;
-  BlockHeaderCellStore header(BLOCK_HEADER_VERSION);
+  BlockHeaderCellStore header(m_trailer.block_header_version);
   SerializedKey key;
   bool inflating_fixed=true;
   bool second_try = false;
@@ -957,6 +1213,17 @@ void CellStoreV7::load_block_index() {
       HT_THROWF(Error::FSBROKER_IO_ERROR, "Error loading index for "
                 "CellStore '%s' : tried to read %lld but only got %lld",
                 m_filename.c_str(), (Lld)amount, (Lld)len);
+
+    /** load compression dictionary, needed to inflate index **/
+    if ((m_trailer.flags & CellStoreTrailerV7::COMPRESSION_DICTIONARY) &&
+        m_compression_dictionary.empty()) {
+      int64_t var_index_start =
+        m_trailer.var_index_offset - m_trailer.fix_index_offset;
+      load_compression_dictionary(buf.base + var_index_start,
+                                  index_amount - var_index_start);
+      compressor.reset(create_block_compression_codec());
+    }
+
     /** inflate fixed index **/
     buf.ptr += (m_trailer.var_index_offset - m_trailer.fix_index_offset);
     compressor->inflate(buf, m_index_builder.fixed_buf(), header);
@@ -1036,6 +1303,20 @@ bool CellStoreV7::may_contain(ScanContext *scan_ctx) {
   else if (m_trailer.filter_length == 0) // bloom filter is empty
     return false;
 
+  // A prefix filter only helps if every row in the scan has the same prefix
+  size_t prefix_len = 0;
+  if (m_bloom_filter_mode == BLOOM_FILTER_ROW_PREFIX) {
+    bool complete;
+    prefix_len = bloom_filter_prefix_length(scan_ctx->start_row.data(),
+                                            scan_ctx->start_row.size(),
+                                            &complete);
+    if (!scan_ctx->single_row &&
+        !(complete && scan_ctx->end_row.compare(0, prefix_len,
+                                                scan_ctx->start_row,
+                                                0, prefix_len) == 0))
+      return true;
+  }
+
   {
     lock_guard<mutex> lock(m_mutex);
     if (m_bloom_filter == 0)
@@ -1075,6 +1356,10 @@ bool CellStoreV7::may_contain(ScanContext *scan_ctx) {
         }
       }
       return false;
+    case BLOOM_FILTER_ROW_PREFIX:
+      m_index_stats.bloom_filter_access_counter = ++Global::access_counter;
+      return m_bloom_filter->may_contain(scan_ctx->start_row.data(),
+                                         prefix_len);
     default:
       HT_ASSERT(!"unpossible bloom filter mode!");
     }
@@ -1096,5 +1381,5 @@ void CellStoreV7::display_block_info() {
 
 
 uint16_t CellStoreV7::block_header_format() {
-  return BLOCK_HEADER_VERSION;
+  return m_trailer.block_header_version;
 }
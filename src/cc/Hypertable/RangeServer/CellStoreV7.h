@@ -29,6 +29,7 @@
 #define Hypertable_RangeServer_CellStoreV7_h
 
 #include "CellStore.h"
+#include "CellStoreBlockCompressor.h"
 #include "CellStoreBlockIndexArray.h"
 #include "CellStoreTrailerV7.h"
 #include "KeyCompressor.h"
@@ -42,8 +43,10 @@
 #include <Common/BloomFilterWithChecksum.h>
 #include <Common/DynamicBuffer.h>
 
+#include <deque>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Hypertable {
@@ -64,6 +67,7 @@ namespace Hypertable {
     public:
       IndexBuilder() : m_bigint(false) { }
       void add_entry(KeyCompressorPtr &key_compressor, int64_t offset);
+      void add_entry(const uint8_t *key, size_t key_len, int64_t offset);
       DynamicBuffer &fixed_buf() { return m_fixed; }
       DynamicBuffer &variable_buf() { return m_variable; }
       bool big_int() { return m_bigint; }
@@ -154,9 +158,79 @@ namespace Hypertable {
   protected:
     void create_bloom_filter(bool is_approx = false);
     void load_bloom_filter();
+
+    /// Returns bloom filter encoding recorded in #m_trailer.
+    /// @return Bloom filter bit layout
+    BloomFilterWithChecksum::Encoding bloom_filter_encoding() const {
+      return (m_trailer.flags & CellStoreTrailerV7::BLOOM_FILTER_BLOCKED) ?
+        BloomFilterWithChecksum::BLOCKED : BloomFilterWithChecksum::STANDARD;
+    }
+
+    /// Adds item to bloom filter.
+    /// Items are held in #m_bloom_filter_items so the filter can be sized
+    /// from the exact number of items when the CellStore is finalized.  If
+    /// the held items grow too large, the filter is created early, sized
+    /// from an estimate.
+    /// @param item Pointer to item
+    /// @param len Length of item
+    void add_bloom_filter_item(const void *item, size_t len);
+
+    /// Computes length of row key prefix for BLOOM_FILTER_ROW_PREFIX mode.
+    /// The prefix is either the first <i>n</i> bytes of the row or the row up
+    /// to and including the first delimiter, as recorded in #m_trailer.  Rows
+    /// shorter than the prefix length, or without a delimiter, are their own
+    /// prefix.
+    /// @param row Row key
+    /// @param row_len Length of row key
+    /// @param complete Set to <i>false</i> if row is its own prefix because
+    /// it is too short or has no delimiter
+    /// @return Length of row key prefix
+    size_t bloom_filter_prefix_length(const char *row, size_t row_len,
+                                      bool *complete);
     void load_block_index();
     void load_replaced_files();
 
+    /// Compresses and writes (or queues for compression) #m_buffer as the
+    /// next data block
+    void add_data_block();
+
+    /// Writes blocks finished by #m_block_compressor in order.
+    /// Waits for blocks to finish while more than
+    /// <code>max_outstanding</code> are outstanding.
+    /// @param max_outstanding Maximum number of blocks left outstanding
+    void write_compressed_blocks(size_t max_outstanding);
+
+    /// Appends compressed data block to file and updates compression stats.
+    /// Records the block's lengths in #m_written_block_lengths for
+    /// update_uncompressed_blocksize().
+    /// @param zbuf Compressed block (padded to I/O alignment by this call)
+    /// @param uncompressed_length Uncompressed length of block
+    void write_data_block(DynamicBuffer &zbuf, size_t uncompressed_length);
+
+    /// Compresses and writes (or queues for compression) a data block.
+    /// @param block Uncompressed block with index key in <code>tag</code>
+    void add_block(CellStoreBlockCompressor::BlockPtr block);
+
+    /// Updates #m_uncompressed_blocksize after a data block is submitted.
+    /// The uncompressed block size is derived from the compression ratio of
+    /// all blocks but the last <code>BLOCKSIZE_FEEDBACK_LAG</code> submitted,
+    /// so block boundaries are the same whether blocks are compressed inline
+    /// or by any number of workers.  Waits for the block that enters the
+    /// ratio to be compressed if it has not been written yet.
+    void update_uncompressed_blocksize();
+
+    /// Trains compression dictionary from sampled blocks and writes them.
+    /// Trains a dictionary from the blocks buffered in
+    /// #m_dictionary_samples, installs it in #m_compressor and
+    /// #m_block_compressor, and then writes the buffered blocks.  If training
+    /// fails, the blocks are compressed without a dictionary.
+    void train_compression_dictionary();
+
+    /// Loads compression dictionary block.
+    /// @param buf Buffer holding the dictionary block
+    /// @param len Length of <code>buf</code>
+    void load_compression_dictionary(const uint8_t *buf, size_t len);
+
     typedef BlobHashSet<> BloomFilterItems;
 
     Filesystem *m_filesys;
@@ -166,6 +240,7 @@ namespace Hypertable {
     bool m_64bit_index {};
     CellStoreTrailerV7 m_trailer;
     BlockCompressionCodec *m_compressor {};
+    std::unique_ptr<CellStoreBlockCompressor> m_block_compressor;
     DynamicBuffer m_buffer;
     IndexBuilder m_index_builder;
     DispatchHandlerSynchronizer m_sync_handler;
@@ -177,10 +252,35 @@ namespace Hypertable {
     float m_uncompressed_data {};
     float m_compressed_data {};
     int64_t m_uncompressed_blocksize {};
+
+    /// Uncompressed and compressed lengths of written data blocks not yet
+    /// counted in #m_uncompressed_blocksize
+    std::deque<std::pair<size_t, size_t>> m_written_block_lengths;
+
+    /// Number of submitted data blocks not yet counted in
+    /// #m_uncompressed_blocksize
+    size_t m_uncounted_blocks {};
+
+    /// Uncompressed bytes of data blocks counted in #m_uncompressed_blocksize
+    uint64_t m_counted_uncompressed {};
+
+    /// Compressed bytes of data blocks counted in #m_uncompressed_blocksize
+    uint64_t m_counted_compressed {};
+
     BlockCompressionCodec::Args m_compressor_args;
     size_t m_max_entries {};
     BloomFilterMode m_bloom_filter_mode {BLOOM_FILTER_DISABLED};
     BloomFilterItems *m_bloom_filter_items {};
+
+    /// Approximate memory held by #m_bloom_filter_items
+    size_t m_bloom_filter_items_bytes {};
+
+    /// Most recent bloom filter row (or row prefix) added
+    std::string m_last_bloom_item;
+
+    /// Column family of most recent row+column bloom filter item added
+    int m_last_bloom_family {-1};
+
     int64_t m_max_approx_items {};
     float m_bloom_bits_per_item {};
     float m_filter_false_positive_prob {};
@@ -189,6 +289,18 @@ namespace Hypertable {
     int64_t *m_column_ttl {};
     bool m_replaced_files_loaded {};
 
+    /// Compression dictionary (zstd)
+    std::string m_compression_dictionary;
+
+    /// Requested compression dictionary size, 0 once trained or if disabled
+    size_t m_dictionary_size {};
+
+    /// Data blocks buffered as dictionary training samples
+    std::vector<CellStoreBlockCompressor::BlockPtr> m_dictionary_samples;
+
+    /// Number of uncompressed bytes in #m_dictionary_samples
+    size_t m_dictionary_sample_bytes {};
+
     // Member that require mutex protection
 
     /// Bloom filter
@@ -32,53 +32,140 @@ using namespace std;
 
 atomic<int> FileBlockCache::ms_next_file_id {0};
 
+namespace {
+  /// Returns portion <code>i</code> of <code>amount</code> split into
+  /// <code>n</code> parts, giving the remainder to the first part.
+  int64_t split(int64_t amount, size_t i, size_t n) {
+    return (amount / (int64_t)n) + ((i == 0) ? (amount % (int64_t)n) : 0);
+  }
+}
+
+FileBlockCache::FileBlockCache(int64_t min_memory, int64_t max_memory,
+                               bool compressed, size_t shard_count,
+                               int32_t protected_percentage,
+                               int64_t min_shard_memory)
+  : m_protected_percentage(protected_percentage), m_compressed(compressed) {
+  HT_ASSERT(min_memory <= max_memory);
+  HT_ASSERT(protected_percentage >= 0 && protected_percentage < 100);
+  // A block larger than the shard limit can never be cached, so don't split
+  // the cache into shards smaller than min_shard_memory
+  if (min_shard_memory > 0 &&
+      (int64_t)shard_count > max_memory / min_shard_memory)
+    shard_count = (size_t)(max_memory / min_shard_memory);
+  if (shard_count == 0)
+    shard_count = 1;
+  m_shards.reserve(shard_count);
+  for (size_t i=0; i<shard_count; i++)
+    m_shards.push_back(make_unique<Shard>(split(min_memory, i, shard_count),
+                                          split(max_memory, i, shard_count)));
+}
+
 FileBlockCache::~FileBlockCache() {
-  lock_guard<mutex> lock(m_mutex);
-  for (BlockCache::const_iterator iter = m_cache.begin();
-       iter != m_cache.end(); ++iter)
-    if (!iter->event)
-      delete [] (*iter).block;
-  m_cache.clear();
+  for (auto &shard : m_shards) {
+    lock_guard<mutex> lock(shard->mutex);
+    for (BlockCache *segment : { &shard->probation, &shard->protect }) {
+      for (BlockCache::const_iterator iter = segment->begin();
+           iter != segment->end(); ++iter)
+        if (!iter->event)
+          delete [] (*iter).block;
+      segment->clear();
+    }
+  }
 }
 
 bool
 FileBlockCache::checkout(int file_id, uint64_t file_offset, uint8_t **blockp,
                          uint32_t *lengthp) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  lock_guard<mutex> lock(shard.mutex);
   HashIndex::iterator iter;
 
-  m_accesses++;
+  shard.accesses++;
 
-  if ((iter = hash_index.find(make_key(file_id, file_offset))) == hash_index.end())
-    return false;
+  HashIndex &protected_index = shard.protect.get<1>();
+  if ((iter = protected_index.find(key)) == protected_index.end()) {
+    HashIndex &probation_index = shard.probation.get<1>();
+    if ((iter = probation_index.find(key)) == probation_index.end())
+      return false;
 
-  BlockCacheEntry entry = *iter;
-  entry.ref_count++;
+    // Second access, promote to protected segment
+    BlockCacheEntry entry = *iter;
+    entry.ref_count++;
+    probation_index.erase(iter);
 
-  hash_index.erase(iter);
+    pair<Sequence::iterator, bool> insert_result = shard.protect.push_back(entry);
+    assert(insert_result.second);
 
-  pair<Sequence::iterator, bool> insert_result = m_cache.push_back(entry);
-  assert(insert_result.second);
+    *blockp = (*insert_result.first).block;
+    *lengthp = (*insert_result.first).length;
+
+    shard.protected_bytes += entry.length;
+    balance_protected(shard);
+  }
+  else {
+    BlockCacheEntry entry = *iter;
+    entry.ref_count++;
+
+    protected_index.erase(iter);
 
-  *blockp = (*insert_result.first).block;
-  *lengthp = (*insert_result.first).length;
+    pair<Sequence::iterator, bool> insert_result = shard.protect.push_back(entry);
+    assert(insert_result.second);
 
-  m_hits++;
+    *blockp = (*insert_result.first).block;
+    *lengthp = (*insert_result.first).length;
+  }
+
+  shard.hits++;
   return true;
 }
 
 
 void FileBlockCache::checkin(int file_id, uint64_t file_offset) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  lock_guard<mutex> lock(shard.mutex);
+  HashIndex &protected_index = shard.protect.get<1>();
   HashIndex::iterator iter;
 
-  iter = hash_index.find(make_key(file_id, file_offset));
+  if ((iter = protected_index.find(key)) != protected_index.end()) {
+    assert((*iter).ref_count > 0);
+    protected_index.modify(iter, DecrementRefCount());
+    return;
+  }
+
+  HashIndex &probation_index = shard.probation.get<1>();
 
-  assert(iter != hash_index.end() && (*iter).ref_count > 0);
+  iter = probation_index.find(key);
 
-  hash_index.modify(iter, DecrementRefCount());
+  assert(iter != probation_index.end() && (*iter).ref_count > 0);
+
+  probation_index.modify(iter, DecrementRefCount());
+}
+
+
+bool FileBlockCache::pin(int file_id, uint64_t file_offset, uint8_t **blockp,
+                         uint32_t *lengthp) {
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  lock_guard<mutex> lock(shard.mutex);
+  HashIndex::iterator iter;
+
+  HashIndex &protected_index = shard.protect.get<1>();
+  if ((iter = protected_index.find(key)) == protected_index.end()) {
+    HashIndex &probation_index = shard.probation.get<1>();
+    if ((iter = probation_index.find(key)) == probation_index.end())
+      return false;
+    probation_index.modify(iter, IncrementRefCount());
+  }
+  else
+    protected_index.modify(iter, IncrementRefCount());
+
+  if (blockp)
+    *blockp = (*iter).block;
+  if (lengthp)
+    *lengthp = (*iter).length;
+  return true;
 }
 
 
@@ -86,19 +173,22 @@ bool
 FileBlockCache::insert(int file_id, uint64_t file_offset,
 		       uint8_t *block, uint32_t length,
                        const EventPtr &event, bool checkout) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  lock_guard<mutex> lock(shard.mutex);
+  HashIndex &hash_index = shard.probation.get<1>();
 
-  if (hash_index.find(make_key(file_id, file_offset)) != hash_index.end())
+  if (hash_index.find(key) != hash_index.end() ||
+      shard.protect.get<1>().find(key) != shard.protect.get<1>().end())
     return false;
 
-  if (m_available < length)
-    make_room(length);
+  if (shard.available < length)
+    make_room(shard, length);
 
-  if (m_available < length) {
-    if ((length-m_available) <= (m_max_memory-m_limit)) {
-      m_limit += (length-m_available);
-      m_available += (length-m_available);
+  if (shard.available < length) {
+    if ((length-shard.available) <= (shard.max_memory-shard.limit)) {
+      shard.limit += (length-shard.available);
+      shard.available += (length-shard.available);
     }
     else
       return false;
@@ -109,23 +199,25 @@ FileBlockCache::insert(int file_id, uint64_t file_offset,
   entry.length = length;
   entry.ref_count = checkout ? 1 : 0;
 
-  pair<Sequence::iterator, bool> insert_result = m_cache.push_back(entry);
+  pair<Sequence::iterator, bool> insert_result = shard.probation.push_back(entry);
   assert(insert_result.second);
   (void)insert_result;
 
-  m_available -= length;
+  shard.available -= length;
 
   return true;
 }
 
 
 bool FileBlockCache::contains(int file_id, uint64_t file_offset) {
-  lock_guard<mutex> lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
-  m_accesses++;
-
-  if (hash_index.find(make_key(file_id, file_offset)) != hash_index.end()) {
-    m_hits++;
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  lock_guard<mutex> lock(shard.mutex);
+  shard.accesses++;
+
+  if (shard.probation.get<1>().find(key) != shard.probation.get<1>().end() ||
+      shard.protect.get<1>().find(key) != shard.protect.get<1>().end()) {
+    shard.hits++;
     return true;
   }
   else
@@ -134,42 +226,114 @@ bool FileBlockCache::contains(int file_id, uint64_t file_offset) {
 
 
 void FileBlockCache::increase_limit(int64_t amount) {
-  lock_guard<mutex> lock(m_mutex);
-  int64_t adjusted_amount = amount;
-  if ((m_max_memory-m_limit) < amount)
-    adjusted_amount = m_max_memory - m_limit;
-  m_limit += adjusted_amount;
-  m_available += adjusted_amount;
+  for (size_t i=0; i<m_shards.size(); i++) {
+    Shard &shard = *m_shards[i];
+    lock_guard<mutex> lock(shard.mutex);
+    int64_t adjusted_amount = split(amount, i, m_shards.size());
+    if ((shard.max_memory-shard.limit) < adjusted_amount)
+      adjusted_amount = shard.max_memory - shard.limit;
+    shard.limit += adjusted_amount;
+    shard.available += adjusted_amount;
+  }
 }
 
 
 int64_t FileBlockCache::decrease_limit(int64_t amount) {
-  lock_guard<mutex> lock(m_mutex);
   int64_t memory_freed = 0;
-  if (m_available < amount) {
-    if (amount > (m_limit - m_min_memory))
-      amount = m_limit - m_min_memory;
-    memory_freed = make_room(amount);
-    if (m_available < amount)
-      amount = m_available;
-  }
-  m_available -= amount;
-  m_limit -= amount;
+  for (size_t i=0; i<m_shards.size(); i++) {
+    Shard &shard = *m_shards[i];
+    lock_guard<mutex> lock(shard.mutex);
+    memory_freed += decrease_limit(shard, split(amount, i, m_shards.size()));
+  }
   return memory_freed;
 }
 
 
-int64_t FileBlockCache::make_room(int64_t amount) {
-  BlockCache::iterator iter = m_cache.begin();
+int64_t FileBlockCache::decrease_limit(Shard &shard, int64_t amount) {
+  int64_t memory_freed = 0;
+  if (shard.available < amount) {
+    if (amount > (shard.limit - shard.min_memory))
+      amount = shard.limit - shard.min_memory;
+    memory_freed = make_room(shard, amount);
+    if (shard.available < amount)
+      amount = shard.available;
+  }
+  shard.available -= amount;
+  shard.limit -= amount;
+  balance_protected(shard);
+  return memory_freed;
+}
+
+
+int64_t FileBlockCache::get_limit() {
+  int64_t limit = 0;
+  for (auto &shard : m_shards) {
+    lock_guard<mutex> lock(shard->mutex);
+    limit += shard->limit;
+  }
+  return limit;
+}
+
+
+void FileBlockCache::cap_memory_use() {
+  for (auto &shard : m_shards) {
+    lock_guard<mutex> lock(shard->mutex);
+    int64_t memory_used = shard->limit - shard->available;
+    if (memory_used > shard->min_memory) {
+      shard->limit -= shard->available;
+      shard->available = 0;
+    }
+    else {
+      shard->limit = shard->min_memory;
+      shard->available = shard->limit - memory_used;
+    }
+    balance_protected(*shard);
+  }
+}
+
+
+int64_t FileBlockCache::memory_used() {
+  int64_t memory_used = 0;
+  for (auto &shard : m_shards) {
+    lock_guard<mutex> lock(shard->mutex);
+    memory_used += shard->limit - shard->available;
+  }
+  return memory_used;
+}
+
+
+int64_t FileBlockCache::available() {
+  int64_t available = 0;
+  for (auto &shard : m_shards) {
+    lock_guard<mutex> lock(shard->mutex);
+    available += shard->available;
+  }
+  return available;
+}
+
+
+int64_t FileBlockCache::make_room(Shard &shard, int64_t amount) {
+  int64_t amount_freed = make_room(shard, shard.probation, amount);
+  if (shard.available < amount)
+    amount_freed += make_room(shard, shard.protect, amount);
+  return amount_freed;
+}
+
+
+int64_t FileBlockCache::make_room(Shard &shard, BlockCache &segment,
+                                  int64_t amount) {
+  BlockCache::iterator iter = segment.begin();
   int64_t amount_freed = 0;
-  while (iter != m_cache.end()) {
+  while (iter != segment.end()) {
     if ((*iter).ref_count == 0) {
-      m_available += (*iter).length;
+      shard.available += (*iter).length;
       amount_freed += (*iter).length;
+      if (&segment == &shard.protect)
+        shard.protected_bytes -= (*iter).length;
       if (!iter->event)
         delete [] iter->block;
-      iter = m_cache.erase(iter);
-      if (m_available >= amount)
+      iter = segment.erase(iter);
+      if (shard.available >= amount)
 	break;
     }
     else
@@ -178,11 +342,37 @@ int64_t FileBlockCache::make_room(int64_t amount) {
   return amount_freed;
 }
 
+
+void FileBlockCache::balance_protected(Shard &shard) {
+  int64_t protected_limit = (shard.limit * m_protected_percentage) / 100;
+  while (shard.protected_bytes > protected_limit && !shard.protect.empty()) {
+    BlockCacheEntry entry = shard.protect.front();
+    shard.protect.pop_front();
+    shard.protected_bytes -= entry.length;
+    pair<Sequence::iterator, bool> insert_result = shard.probation.push_back(entry);
+    assert(insert_result.second);
+    (void)insert_result;
+  }
+}
+
 void FileBlockCache::get_stats(uint64_t *max_memoryp, uint64_t *available_memoryp,
                                uint64_t *accessesp, uint64_t *hitsp) {
-  lock_guard<mutex> lock(m_mutex);
-  *max_memoryp = m_limit;
-  *available_memoryp = m_available;
-  *accessesp = m_accesses;
-  *hitsp = m_hits;
+  *max_memoryp = *available_memoryp = *accessesp = *hitsp = 0;
+  for (auto &shard : m_shards) {
+    lock_guard<mutex> lock(shard->mutex);
+    *max_memoryp += shard->limit;
+    *available_memoryp += shard->available;
+    *accessesp += shard->accesses;
+    *hitsp += shard->hits;
+  }
+}
+
+void FileBlockCache::get_shard_stats(size_t shard, uint64_t *accessesp,
+                                     uint64_t *hitsp,
+                                     int64_t *protected_bytesp) {
+  HT_ASSERT(shard < m_shards.size());
+  lock_guard<mutex> lock(m_shards[shard]->mutex);
+  *accessesp = m_shards[shard]->accesses;
+  *hitsp = m_shards[shard]->hits;
+  *protected_bytesp = m_shards[shard]->protected_bytes;
 }
@@ -32,20 +32,41 @@
 #include <boost/multi_index/sequenced_index.hpp>
 
 #include <atomic>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace Hypertable {
   using namespace boost::multi_index;
 
+  /// Block cache for CellStore blocks.
+  /// The cache is split into a configurable number of shards, selected by a
+  /// hash of the block key, each with its own mutex, memory budget, and
+  /// statistics.  Each shard implements a segmented LRU policy: newly
+  /// inserted blocks enter a <i>probationary</i> segment and are promoted
+  /// to a <i>protected</i> segment when they are accessed again.  Eviction
+  /// takes blocks from the probationary segment first, so a large scan that
+  /// touches each block once can not flush the blocks that are being
+  /// re-read.  When the protected percentage is zero, each shard behaves as
+  /// a plain LRU cache.
   class FileBlockCache {
 
     static std::atomic<int> ms_next_file_id;
 
   public:
-    FileBlockCache(int64_t min_memory, int64_t max_memory, bool compressed)
-      : m_min_memory(min_memory), m_max_memory(max_memory), m_limit(max_memory),
-	m_available(max_memory), m_accesses(0), m_hits(0), m_compressed(compressed)
-    { HT_ASSERT(min_memory <= max_memory); }
+
+    /// Constructor.
+    /// @param min_memory Minimum size of cache
+    /// @param max_memory Maximum size of cache
+    /// @param compressed Flag indicating if cache holds compressed blocks
+    /// @param shard_count Number of independently locked shards
+    /// @param protected_percentage Percentage of each shard's limit that
+    /// may be occupied by blocks that have been accessed more than once
+    /// @param min_shard_memory Minimum maximum size of a shard; the shard
+    /// count is reduced so that each shard can hold blocks of this size
+    FileBlockCache(int64_t min_memory, int64_t max_memory, bool compressed,
+                   size_t shard_count=1, int32_t protected_percentage=0,
+                   int64_t min_shard_memory=0);
     ~FileBlockCache();
 
     bool compressed() { return m_compressed; }
@@ -53,6 +74,25 @@ namespace Hypertable {
     bool checkout(int file_id, uint64_t file_offset, uint8_t **blockp,
                   uint32_t *lengthp);
     void checkin(int file_id, uint64_t file_offset);
+
+    /// Adds a reference to a cached block without counting it as an access.
+    /// Unlike checkout(), the block is not promoted or moved within its
+    /// segment, so holding extra references to a block does not change its
+    /// eviction order.
+    /// @param file_id File ID of block
+    /// @param file_offset Offset of block within file
+    /// @param blockp Address of variable to hold block pointer, or 0
+    /// @param lengthp Address of variable to hold block length, or 0
+    /// @return <i>true</i> if block was pinned, <i>false</i> if it is not cached
+    bool pin(int file_id, uint64_t file_offset, uint8_t **blockp=0,
+             uint32_t *lengthp=0);
+
+    /// Releases a reference added with pin().
+    /// @param file_id File ID of block
+    /// @param file_offset Offset of block within file
+    void unpin(int file_id, uint64_t file_offset) {
+      checkin(file_id, file_offset);
+    }
     bool insert(int file_id, uint64_t file_offset,
 		uint8_t *block, uint32_t length, 
                 const EventPtr &event, bool checkout);
@@ -70,46 +110,41 @@ namespace Hypertable {
      */
     int64_t decrease_limit(int64_t amount);
 
-    int64_t get_limit() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      return m_limit;
-    }
+    int64_t get_limit();
 
     /**
      * Sets limit to memory currently used, it will not reduce the limit
      * below min_memory
      */
-    void cap_memory_use() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      int64_t memory_used = m_limit - m_available;
-      if (memory_used > m_min_memory) {
-        m_limit -= m_available;
-        m_available = 0;
-      }
-      else {
-        m_limit = m_min_memory;
-        m_available = m_limit - memory_used;
-      }
-    }
+    void cap_memory_use();
 
-    int64_t memory_used() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      return (int64_t)(m_limit - m_available);
-    }
+    int64_t memory_used();
 
-    int64_t available() {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      return m_available;
-    }
+    int64_t available();
+
+    /// Returns number of shards.
+    /// @return Number of shards
+    size_t shard_count() { return m_shards.size(); }
 
     static int get_next_file_id() {
       return ++ms_next_file_id;
     }
+
+    /// Gets cache statistics.
+    /// The access and hit counts are the sums of the per-shard counters.
     void get_stats(uint64_t *max_memoryp, uint64_t *available_memoryp,
                    uint64_t *accessesp, uint64_t *hitsp);
-  private:
 
-    int64_t make_room(int64_t amount);
+    /// Gets statistics for a single shard.
+    /// @param shard Shard number
+    /// @param accessesp Address of variable to hold access count
+    /// @param hitsp Address of variable to hold hit count
+    /// @param protected_bytesp Address of variable to hold size of protected
+    /// segment
+    void get_shard_stats(size_t shard, uint64_t *accessesp, uint64_t *hitsp,
+                         int64_t *protected_bytesp);
+
+  private:
 
     inline static int64_t make_key(int file_id, uint64_t file_offset) {
       HT_ASSERT(file_id < 268435456LL);        // Can't be larger than 2^28
@@ -132,6 +167,12 @@ namespace Hypertable {
       int64_t key() const { return FileBlockCache::make_key(file_id, file_offset); }
     };
 
+    struct IncrementRefCount {
+      void operator()(BlockCacheEntry &entry) {
+        entry.ref_count++;
+      }
+    };
+
     struct DecrementRefCount {
       void operator()(BlockCacheEntry &entry) {
         entry.ref_count--;
@@ -156,14 +197,59 @@ namespace Hypertable {
     typedef BlockCache::nth_index<0>::type Sequence;
     typedef BlockCache::nth_index<1>::type HashIndex;
 
-    std::mutex m_mutex;
-    BlockCache    m_cache;
-    int64_t      m_min_memory;
-    int64_t      m_max_memory;
-    int64_t      m_limit;
-    int64_t      m_available;
-    uint64_t     m_accesses;
-    uint64_t     m_hits;
+    /// Cache shard.
+    class Shard {
+    public:
+      Shard(int64_t min, int64_t max)
+        : min_memory(min), max_memory(max), limit(max), available(max) { }
+
+      /// %Mutex serializing access to shard
+      std::mutex mutex;
+
+      /// Blocks accessed once, in LRU order
+      BlockCache probation;
+
+      /// Blocks accessed more than once, in LRU order
+      BlockCache protect;
+
+      int64_t min_memory;
+      int64_t max_memory;
+      int64_t limit;
+      int64_t available;
+
+      /// Bytes held in #protect
+      int64_t protected_bytes {};
+
+      uint64_t accesses {};
+      uint64_t hits {};
+    };
+
+    /// Returns shard holding <code>key</code>.
+    Shard &get_shard(int64_t key) {
+      // Mix bits so blocks at nearby offsets spread across shards
+      uint64_t h = (uint64_t)key;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return *m_shards[h % m_shards.size()];
+    }
+
+    int64_t make_room(Shard &shard, int64_t amount);
+
+    int64_t make_room(Shard &shard, BlockCache &segment, int64_t amount);
+
+    int64_t decrease_limit(Shard &shard, int64_t amount);
+
+    /// Demotes protected blocks to the probationary segment until the
+    /// protected segment is within its share of the shard limit
+    void balance_protected(Shard &shard);
+
+    /// Cache shards
+    std::vector<std::unique_ptr<Shard>> m_shards;
+
+    /// Percentage of shard limit available to protected segment
+    int32_t m_protected_percentage;
+
     bool         m_compressed;
   };
 
@@ -22,17 +22,34 @@
 #include "Common/Compat.h"
 #include "FillScanBlock.h"
 
-namespace Hypertable {
-
-  bool
-  FillScanBlock(MergeScannerRangePtr &scanner, DynamicBuffer &dbuf,
-                uint32_t *cell_count, int64_t buffer_size) {
+#include <vector>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Value to be sent in place rather than copied into the scan block
+  struct Splice {
+    /// Offset in copied data at which value belongs
+    size_t offset;
+    /// Serialized value
+    const uint8_t *base;
+    /// Length of serialized value
+    size_t length;
+  };
+
+  bool fill_scan_block(MergeScannerRangePtr &scanner, DynamicBuffer &dbuf,
+                       uint32_t *cell_count, int64_t buffer_size,
+                       size_t zero_copy_threshold, GatherBuffer *gather,
+                       vector<Splice> &splices) {
     Key key;
     ByteString value;
     size_t value_len;
     bool more = true;
     size_t limit = buffer_size;
     size_t remaining = buffer_size;
+    size_t spliced = 0;
     uint8_t *ptr;
     ScanContext *scan_context = scanner->scan_context();
     bool keys_only = scan_context->spec->keys_only;
@@ -100,6 +117,16 @@ namespace Hypertable {
 
         if (counter)
           dbuf.add_unchecked(counter_value.base, value_len);
+        else if (gather && value_len >= zero_copy_threshold) {
+          shared_ptr<void> pin = scanner->pin_value();
+          if (pin) {
+            gather->add_pin(pin);
+            splices.push_back({dbuf.fill(), value.ptr, value_len});
+            spliced += value_len;
+          }
+          else
+            dbuf.add_unchecked(value.ptr, value_len);
+        }
         else
           dbuf.add_unchecked(value.ptr, value_len);
 
@@ -116,9 +143,46 @@ namespace Hypertable {
     }
 
     ptr = dbuf.base;
-    Serialization::encode_i32(&ptr, dbuf.fill() - 4);
+    Serialization::encode_i32(&ptr, (dbuf.fill() - 4) + spliced);
 
     return more;
   }
 
 }
+
+bool Hypertable::FillScanBlock(MergeScannerRangePtr &scanner,
+                               DynamicBuffer &dbuf, uint32_t *cell_count,
+                               int64_t buffer_size) {
+  vector<Splice> splices;
+  return fill_scan_block(scanner, dbuf, cell_count, buffer_size, 0, nullptr,
+                         splices);
+}
+
+bool Hypertable::FillScanBlock(MergeScannerRangePtr &scanner,
+                               GatherBufferPtr &gather, uint32_t *cell_count,
+                               int64_t buffer_size,
+                               size_t zero_copy_threshold) {
+  DynamicBuffer dbuf;
+  vector<Splice> splices;
+
+  gather = make_shared<GatherBuffer>();
+
+  bool more = fill_scan_block(scanner, dbuf, cell_count, buffer_size,
+                              zero_copy_threshold,
+                              zero_copy_threshold ? gather.get() : nullptr,
+                              splices);
+
+  // Interleave copied data with values sent in place
+  size_t fill;
+  uint8_t *base = dbuf.release(&fill);
+  size_t offset = 0;
+  for (auto &splice : splices) {
+    gather->add(base + offset, splice.offset - offset);
+    gather->add(splice.base, splice.length);
+    offset = splice.offset;
+  }
+  gather->add(base + offset, fill - offset);
+  gather->add_pin(shared_ptr<void>(base, [](void *p) { delete [] (uint8_t *)p; }));
+
+  return more;
+}
@@ -30,6 +30,8 @@
 
 #include <Hypertable/RangeServer/MergeScannerRange.h>
 
+#include <AsyncComm/GatherBuffer.h>
+
 #include <Common/DynamicBuffer.h>
 
 namespace Hypertable {
@@ -54,6 +56,27 @@ namespace Hypertable {
   bool FillScanBlock(MergeScannerRangePtr &scanner, DynamicBuffer &dbuf,
                      uint32_t *cell_count, int64_t buffer_size);
 
+  /// Fills a block of scan results, referencing large values in place.
+  /// Produces the same scan block as the DynamicBuffer version of this
+  /// function, but as a list of segments.  Keys and values smaller than
+  /// <code>zero_copy_threshold</code> are copied into a buffer owned by
+  /// <code>gather</code>, while larger values are referenced directly in
+  /// the memory of the scanner that produced them (e.g. a block cache block
+  /// or cell cache), which is pinned by <code>gather</code> until it is
+  /// destroyed.  Values whose memory can't be pinned are copied.
+  /// @param scanner Scanner frome which results are to be obtained
+  /// @param gather Set to segments holding encoded results
+  /// @param cell_count Address of variable to hold number of cells in the scan
+  /// block.
+  /// @param buffer_size Target size of scan block
+  /// @param zero_copy_threshold Minimum size of value to reference in place,
+  /// 0 to copy all values
+  /// @return <i>true</i> if there are more results to be pulled from the
+  /// scanner when this function returns, <i>false</i> otherwise.
+  bool FillScanBlock(MergeScannerRangePtr &scanner, GatherBufferPtr &gather,
+                     uint32_t *cell_count, int64_t buffer_size,
+                     size_t zero_copy_threshold);
+
   /// @}
 
 }
@@ -24,6 +24,8 @@
 
 #include "Global.h"
 
+#include <Common/md5.h>
+
 using namespace Hypertable;
 using namespace Hyperspace;
 
@@ -45,7 +47,7 @@ namespace Hypertable {
   bool                   Global::row_size_unlimited = false;
   bool                   Global::ignore_cells_with_clock_skew = false;
   bool                   Global::range_initialization_complete = false;
-  CommitLogPtr           Global::user_log;
+  std::vector<CommitLogPtr> Global::user_logs;
   CommitLogPtr           Global::system_log;
   CommitLogPtr           Global::metadata_log;
   CommitLogPtr           Global::root_log;
@@ -67,6 +69,9 @@ namespace Hypertable {
   int64_t                Global::log_prune_threshold_max = 0;
   int64_t                Global::cellstore_target_size_min = 0;
   int64_t                Global::cellstore_target_size_max = 0;
+  bool                   Global::cellstore_block_index_prefix_layout = false;
+  CellStoreCompressionPool *Global::cellstore_compression_pool = 0;
+  int32_t                Global::cellstore_prefetch_blocks = 0;
   int64_t                Global::memory_limit = 0;
   int64_t                Global::memory_limit_ensure_unused = 0;
   int64_t                Global::memory_limit_ensure_unused_current = 0;
@@ -119,4 +124,13 @@ namespace Hypertable {
     return Global::ranges;
   }
 
+  size_t Global::user_lane(const char *table_id, const char *end_row) {
+    // Keyed by range so that the ranges of a busy table spread over the
+    // lanes while all updates to one range go through one lane
+    if (Global::user_logs.size() <= 1)
+      return 0;
+    uint64_t hash = (uint64_t)md5_hash(table_id) * 31 + (uint64_t)md5_hash(end_row);
+    return (size_t)(hash % Global::user_logs.size());
+  }
+
 }
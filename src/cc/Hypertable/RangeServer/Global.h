@@ -42,6 +42,7 @@
 #include "Hypertable/Lib/RangeSpec.h"
 #include "Hypertable/Lib/TableIdentifier.h"
 
+#include "CellStoreCompressionPool.h"
 #include "FileBlockCache.h"
 #include "LoadStatistics.h"
 #include "LocationInitializer.h"
@@ -74,7 +75,7 @@ namespace Hypertable {
     static bool           verbose;
     static bool           row_size_unlimited;
     static bool           ignore_cells_with_clock_skew;
-    static CommitLogPtr user_log;
+    static std::vector<CommitLogPtr> user_logs;
     static CommitLogPtr system_log;
     static CommitLogPtr metadata_log;
     static CommitLogPtr root_log;
@@ -96,6 +97,9 @@ namespace Hypertable {
     static int64_t        log_prune_threshold_max;
     static int64_t        cellstore_target_size_min;
     static int64_t        cellstore_target_size_max;
+    static bool           cellstore_block_index_prefix_layout;
+    static CellStoreCompressionPool *cellstore_compression_pool;
+    static int32_t        cellstore_prefetch_blocks;
     static int64_t        memory_limit;
     // amount of unused physical memory to achieve according
     // to the configuration
@@ -120,6 +124,7 @@ namespace Hypertable {
     static bool immovable_range_set_contains(const TableIdentifier &table, const RangeSpec &spec);
     static void set_ranges(RangesPtr &r);
     static RangesPtr get_ranges();
+    static size_t user_lane(const char *table_id, const char *end_row);
   };
 
 } // namespace Hypertable
@@ -21,12 +21,16 @@
 #include <Common/Compat.h>
 #include "GroupCommit.h"
 
+#include <Hypertable/RangeServer/Global.h>
 #include <Hypertable/RangeServer/RangeServer.h>
 #include <Hypertable/RangeServer/UpdateRecTable.h>
 #include <Hypertable/RangeServer/UpdateRequest.h>
 
 #include <Common/Config.h>
 
+#include <algorithm>
+#include <chrono>
+
 using namespace Hypertable;
 using namespace Hypertable::Config;
 using namespace std;
@@ -34,18 +38,21 @@ using namespace std;
 GroupCommit::GroupCommit(Apps::RangeServer *range_server) : m_range_server(range_server) {
 
   m_commit_interval = get_i32("Hypertable.RangeServer.CommitInterval");
+  m_max_batch_size = get_i64("Hypertable.RangeServer.UpdateCoalesceLimit");
 
 }
 
 
-void
+ClockT::time_point
 GroupCommit::add(EventPtr &event, uint64_t cluster_id, SchemaPtr &schema,
                  const TableIdentifier &table, uint32_t count,
                  StaticBuffer &buffer, uint32_t flags) {
   lock_guard<mutex> lock(m_mutex);
   UpdateRequest *request = new UpdateRequest();
   auto expire_time = event->deadline();
+  auto now = ClockT::now();
   ClusterTableIdPair key = std::make_pair(cluster_id, table);
+  UpdateRecTable *tu;
 
   key.second.id = m_flyweight_strings.get(table.id);
 
@@ -53,27 +60,48 @@ GroupCommit::add(EventPtr &event, uint64_t cluster_id, SchemaPtr &schema,
   request->count = count;
   request->event = event;
 
+  ArrivalStats &arrivals = m_arrivals[key];
+  if (arrivals.last_arrival != ClockT::time_point()) {
+    int64_t interval =
+      chrono::duration_cast<chrono::microseconds>(now - arrivals.last_arrival).count();
+    arrivals.interval =
+      arrivals.interval ? (3*arrivals.interval + interval) / 4 : interval;
+  }
+  arrivals.last_arrival = now;
+
   auto iter = m_table_map.find(key);
   if (iter == m_table_map.end()) {
-
-    UpdateRecTable *tu = new UpdateRecTable();
+    tu = new UpdateRecTable();
     tu->cluster_id = cluster_id;
     tu->id = key.second;
     tu->commit_interval = schema->get_group_commit_interval();
-    tu->commit_iteration = (tu->commit_interval+(m_commit_interval-1)) / m_commit_interval;
+    tu->commit_delay = choose_delay(arrivals, tu->commit_interval);
+    tu->commit_time = now + chrono::microseconds(tu->commit_delay);
     tu->total_count = count;
     tu->total_buffer_size = buffer.size;
     tu->expire_time = expire_time;
     tu->requests.push_back(request);
-    m_table_map[key] = tu;
-    return;
+    iter = m_table_map.insert(make_pair(key, tu)).first;
+  }
+  else {
+    tu = (*iter).second;
+    if (expire_time > tu->expire_time)
+      tu->expire_time = expire_time;
+    tu->total_count += count;
+    tu->total_buffer_size += buffer.size;
+    tu->requests.push_back(request);
+  }
+
+  // Waiting would only add latency or batch is already large enough
+  if (tu->commit_delay == 0 || tu->total_buffer_size >= m_max_batch_size) {
+    std::vector<UpdateRecTable *> updates;
+    updates.push_back(tu);
+    m_table_map.erase(iter);
+    commit(updates);
+    return ClockT::time_point();
   }
 
-  if (expire_time > (*iter).second->expire_time)
-    (*iter).second->expire_time = expire_time;
-  (*iter).second->total_count += count;
-  (*iter).second->total_buffer_size += buffer.size;
-  (*iter).second->requests.push_back(request);
+  return tu->commit_time;
 }
 
 
@@ -81,16 +109,14 @@ GroupCommit::add(EventPtr &event, uint64_t cluster_id, SchemaPtr &schema,
 void GroupCommit::trigger() {
   lock_guard<mutex> lock(m_mutex);
   std::vector<UpdateRecTable *> updates;
-  ClockT::time_point expire_time;
+  auto now = ClockT::now();
 
   m_counter++;
 
   auto iter = m_table_map.begin();
   while (iter != m_table_map.end()) {
-    if ((m_counter % (*iter).second->commit_iteration) == 0) {
+    if (now >= (*iter).second->commit_time) {
       auto remove_iter = iter;
-      if (iter->second->expire_time > expire_time)
-	expire_time = iter->second->expire_time;
       ++iter;
       updates.push_back((*remove_iter).second);
       m_table_map.erase(remove_iter);
@@ -100,6 +126,64 @@ void GroupCommit::trigger() {
   }
 
   if (!updates.empty())
-    m_range_server->batch_update(updates, expire_time);
+    commit(updates);
+
+  // Periodically forget tables that have stopped receiving updates
+  if ((m_counter % 1000) == 0) {
+    auto arrivals_iter = m_arrivals.begin();
+    while (arrivals_iter != m_arrivals.end()) {
+      if (now - arrivals_iter->second.last_arrival > chrono::minutes(10) &&
+          m_table_map.count(arrivals_iter->first) == 0)
+        arrivals_iter = m_arrivals.erase(arrivals_iter);
+      else
+        ++arrivals_iter;
+    }
+  }
+
+}
+
+
+uint32_t GroupCommit::trigger_interval() {
+  lock_guard<mutex> lock(m_mutex);
+  auto now = ClockT::now();
+  int64_t interval = m_commit_interval;
+
+  for (auto &entry : m_table_map) {
+    int64_t remaining =
+      chrono::duration_cast<chrono::milliseconds>(entry.second->commit_time - now).count();
+    interval = std::min(interval, remaining);
+  }
+
+  return (uint32_t)std::max(interval, (int64_t)1);
+}
+
+
+int64_t GroupCommit::choose_delay(ArrivalStats &arrivals,
+                                  uint32_t max_interval) {
+  int64_t max_delay = (int64_t)max_interval * 1000;
+  int64_t sync_latency = Global::load_statistics->sync_latency();
+
+  // No syncs timed yet, assume they take the whole interval
+  if (sync_latency == 0)
+    sync_latency = max_delay;
+
+  // Fewer than one more update expected during a sync
+  if (arrivals.interval && arrivals.interval >= sync_latency)
+    return 0;
+
+  return std::min(sync_latency, max_delay);
+}
+
+
+void GroupCommit::commit(std::vector<UpdateRecTable *> &updates) {
+  ClockT::time_point expire_time;
+
+  for (auto tu : updates) {
+    if (tu->expire_time > expire_time)
+      expire_time = tu->expire_time;
+    Global::load_statistics->add_group_commit_batch(tu->requests.size(),
+                                                    tu->commit_delay);
+  }
 
+  m_range_server->batch_update(updates, expire_time);
 }
@@ -25,10 +25,13 @@
 #include "GroupCommitInterface.h"
 #include "RangeServer.h"
 
+#include <AsyncComm/Clock.h>
+
 #include <Common/FlyweightString.h>
 
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace Hypertable {
 
@@ -56,21 +59,72 @@ namespace Hypertable {
   };
 
   /// Group commit manager.
+  /// Updates are queued per table and committed as a batch after a delay that
+  /// adapts to the load.  Each table tracks a moving average of the time
+  /// between arriving updates, which is compared against the moving average
+  /// of commit log sync latency (see LoadStatistics::sync_latency()).  Until
+  /// a sync has been timed, the latency is taken to be the table's group
+  /// commit interval.  If fewer than one more update is expected to arrive
+  /// during a sync, waiting would only add latency, so the batch is committed
+  /// immediately.
+  /// Otherwise the batch is held for about one sync latency, so that batches
+  /// are committed as fast as the log can sync them, but never longer than
+  /// the table's group commit interval.  Batches that reach
+  /// <code>Hypertable.RangeServer.UpdateCoalesceLimit</code> bytes are
+  /// committed without further delay.
   class GroupCommit : public GroupCommitInterface {
 
   public:
 
     /// Constructor.
     /// Initializes #m_commit_interval to value of
-    /// <code>Hypertable.RangeServer.CommitInterval</code> property.
+    /// <code>Hypertable.RangeServer.CommitInterval</code> property and
+    /// #m_max_batch_size to value of
+    /// <code>Hypertable.RangeServer.UpdateCoalesceLimit</code> property.
     /// @param range_server Pointer to RangeServer object
     GroupCommit(Apps::RangeServer *range_server);
-    virtual void add(EventPtr &event, uint64_t cluster_id, SchemaPtr &schema,
-                     const TableIdentifier &table, uint32_t count,
-                     StaticBuffer &buffer, uint32_t flags);
+
+    /// Adds a batch of updates to the group commit queue.
+    /// Commits the table's queued updates right away if the delay chosen for
+    /// them is zero or they have reached #m_max_batch_size bytes.
+    /// @return Commit time of the table's queued updates, or
+    /// <code>ClockT::time_point()</code> if they were committed
+    virtual ClockT::time_point add(EventPtr &event, uint64_t cluster_id,
+                                   SchemaPtr &schema,
+                                   const TableIdentifier &table,
+                                   uint32_t count, StaticBuffer &buffer,
+                                   uint32_t flags);
+
+    /// Commits queued updates whose commit time has arrived.
     virtual void trigger();
 
+    /// Returns time until the earliest queued commit time.
+    /// @return Milliseconds until earliest commit time, between 1 and
+    /// #m_commit_interval
+    virtual uint32_t trigger_interval();
+
   private:
+
+    /// Update arrival statistics for a table.
+    struct ArrivalStats {
+      /// Time of most recent arrival
+      ClockT::time_point last_arrival;
+      /// Moving average of time between arrivals in microseconds
+      int64_t interval {};
+    };
+
+    /// Chooses delay for a new batch of updates.
+    /// @param arrivals Arrival statistics for table
+    /// @param max_interval Table's group commit interval in milliseconds
+    /// @return Delay in microseconds
+    int64_t choose_delay(ArrivalStats &arrivals, uint32_t max_interval);
+
+    /// Commits batches of updates.
+    /// Records group commit statistics for each batch and hands the batches
+    /// to the update pipeline.  Must be called with #m_mutex locked.
+    /// @param updates Batches to commit
+    void commit(std::vector<UpdateRecTable *> &updates);
+
     /// %Mutex to serialize concurrent access
     std::mutex m_mutex;
     /// Pointer to RangeServer
@@ -78,12 +132,18 @@ namespace Hypertable {
     /// Cached copy of <code>Hypertable.RangeServer.CommitInterval</code>
     /// property
     uint32_t m_commit_interval {};
+    /// Cached copy of <code>Hypertable.RangeServer.UpdateCoalesceLimit</code>
+    /// property
+    uint64_t m_max_batch_size {};
     /// Trigger iteration counter
     int m_counter {};
     /// %String cache for holding table IDs
     FlyweightString m_flyweight_strings;
 
     std::map<ClusterTableIdPair, UpdateRecTable *, lt_ctip> m_table_map;
+
+    /// Arrival statistics for each table
+    std::map<ClusterTableIdPair, ArrivalStats, lt_ctip> m_arrivals;
   };
   /// @}
 }
@@ -30,6 +30,7 @@
 #include <Hypertable/Lib/Schema.h>
 #include <Hypertable/Lib/TableIdentifier.h>
 
+#include <AsyncComm/Clock.h>
 #include <AsyncComm/Event.h>
 
 #include <Common/StaticBuffer.h>
@@ -54,12 +55,20 @@ namespace Hypertable {
   public:
 
     /// Adds a batch of updates to the group commit queue.
-    virtual void add(EventPtr &event, uint64_t cluster_id, SchemaPtr &schema,
-                     const TableIdentifier &table, uint32_t count,
-                     StaticBuffer &buffer, uint32_t flags) = 0;
+    /// @return Time at which the queued updates are due to be committed, or
+    /// <code>ClockT::time_point()</code> if they were committed right away
+    virtual ClockT::time_point add(EventPtr &event, uint64_t cluster_id,
+                                   SchemaPtr &schema,
+                                   const TableIdentifier &table,
+                                   uint32_t count, StaticBuffer &buffer,
+                                   uint32_t flags) = 0;
 
     /// Processes queued updates that are ready to be committed.
     virtual void trigger() = 0;
+
+    /// Returns time until trigger() should next be called.
+    /// @return Milliseconds until next trigger
+    virtual uint32_t trigger_interval() = 0;
   };
 
   /// Smart pointer to GroupCommitInterface
@@ -36,14 +36,18 @@ using namespace Hypertable::Config;
 using namespace std;
 
 GroupCommitTimerHandler::GroupCommitTimerHandler(Comm *comm, Apps::RangeServer *range_server,
-                                                 ApplicationQueuePtr &app_queue) 
-  : m_comm(comm), m_range_server(range_server), m_app_queue(app_queue) {
+                                                 GroupCommitInterfacePtr &group_commit,
+                                                 ApplicationQueuePtr &app_queue)
+  : m_comm(comm), m_range_server(range_server), m_group_commit(group_commit),
+    m_app_queue(app_queue) {
   m_commit_interval = get_i32("Hypertable.RangeServer.CommitInterval");
 }
 
 void GroupCommitTimerHandler::start() {
+  lock_guard<mutex> lock(m_mutex);
   int error;
-  if ((error = m_comm->set_timer(m_commit_interval, shared_from_this())) != Error::OK)
+  m_next_tick = ClockT::now() + chrono::milliseconds(m_commit_interval);
+  if ((error = m_comm->set_timer_absolute(m_next_tick, shared_from_this())) != Error::OK)
     HT_FATALF("Problem setting timer - %s", Error::get_text(error));
 }
 
@@ -57,7 +61,27 @@ void GroupCommitTimerHandler::handle(Hypertable::EventPtr &event_ptr) {
 
   m_app_queue->add( new Request::Handler::GroupCommit(m_range_server) );
 
-  if ((error = m_comm->set_timer(m_commit_interval, shared_from_this())) != Error::OK)
+  // Fire again when the earliest queued batch is due.  Drop any timer set by
+  // schedule() that raced with this one so only one stays armed.
+  uint32_t interval = m_group_commit->trigger_interval();
+
+  m_comm->cancel_timer(shared_from_this());
+  m_next_tick = ClockT::now() + chrono::milliseconds(interval);
+  if ((error = m_comm->set_timer_absolute(m_next_tick, shared_from_this())) != Error::OK)
+    HT_FATALF("Problem setting timer - %s", Error::get_text(error));
+}
+
+
+void GroupCommitTimerHandler::schedule(ClockT::time_point commit_time) {
+  lock_guard<mutex> lock(m_mutex);
+  int error;
+
+  if (m_shutdown || commit_time >= m_next_tick)
+    return;
+
+  m_comm->cancel_timer(shared_from_this());
+  m_next_tick = commit_time;
+  if ((error = m_comm->set_timer_absolute(m_next_tick, shared_from_this())) != Error::OK)
     HT_FATALF("Problem setting timer - %s", Error::get_text(error));
 }
 
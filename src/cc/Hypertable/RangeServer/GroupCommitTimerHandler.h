@@ -23,9 +23,12 @@
 #define Hypertable_RangeServer_GroupCommitTimerHandler_h
 
 #include <AsyncComm/ApplicationQueue.h>
+#include <AsyncComm/Clock.h>
 #include <AsyncComm/Comm.h>
 #include <AsyncComm/DispatchHandler.h>
 
+#include "GroupCommitInterface.h"
+
 #include <memory>
 #include <mutex>
 
@@ -38,17 +41,30 @@ namespace Hypertable {
   class GroupCommitTimerHandler : public DispatchHandler {
 
   public:
-    GroupCommitTimerHandler(Comm *comm, Apps::RangeServer *range_server, ApplicationQueuePtr &app_queue);
+    GroupCommitTimerHandler(Comm *comm, Apps::RangeServer *range_server,
+                            GroupCommitInterfacePtr &group_commit,
+                            ApplicationQueuePtr &app_queue);
     void start();
     virtual void handle(Hypertable::EventPtr &event_ptr);
+
+    /// Makes timer fire no later than <code>commit_time</code>.
+    /// Called when group commit queues updates with a commit time earlier
+    /// than the armed tick, so that a shorter delay chosen for them takes
+    /// effect right away.
+    /// @param commit_time Commit time of queued updates
+    void schedule(ClockT::time_point commit_time);
+
     void shutdown();
 
   private:
     std::mutex m_mutex;
     Comm *m_comm {};
     Apps::RangeServer *m_range_server {};
+    GroupCommitInterfacePtr m_group_commit;
     ApplicationQueuePtr m_app_queue;
     int32_t m_commit_interval {};
+    /// Time at which the armed timer fires
+    ClockT::time_point m_next_tick;
     bool m_shutdown {};
   };
 
@@ -31,6 +31,7 @@
 #include <Common/Logger.h>
 #include <Common/Time.h>
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <mutex>
@@ -67,6 +68,10 @@ namespace Hypertable {
         period_millis = 0;
         compactions_major = compactions_minor =
           compactions_merging = compactions_gc = 0;
+        sync_samples = 0;
+        sync_micros = 0;
+        group_commit_batches = group_commit_updates = 0;
+        group_commit_delay_micros = 0;
       }
       uint32_t scan_count;     //!< Scan count
       uint32_t cells_scanned;  //!< Cells scanned
@@ -86,6 +91,11 @@ namespace Hypertable {
       int32_t compactions_minor;
       int32_t compactions_merging;
       int32_t compactions_gc;
+      uint32_t sync_samples;   //!< Number of timed commit log syncs
+      uint64_t sync_micros;    //!< Total time spent in timed syncs
+      uint32_t group_commit_batches;  //!< Group commit batches flushed
+      uint32_t group_commit_updates;  //!< Update requests in flushed batches
+      uint64_t group_commit_delay_micros;  //!< Total delay chosen for batches
     };
 
     /** Constructor.
@@ -150,6 +160,36 @@ namespace Hypertable {
       m_running.sync_count += syncs;
     }
 
+    /** Records time taken by a commit log sync.
+     * Adds <code>micros</code> to the #m_running statistics bundle and
+     * folds it into the sync latency moving average returned by
+     * sync_latency().
+     * @param micros Sync time in microseconds
+     */
+    void add_sync_time(int64_t micros) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running.sync_samples++;
+      m_running.sync_micros += micros;
+      int64_t latency = m_sync_latency;
+      m_sync_latency = latency ? (3*latency + micros) / 4 : micros;
+    }
+
+    /** Returns moving average of commit log sync latency.
+     * @return Sync latency in microseconds, 0 if no syncs have been timed
+     */
+    int64_t sync_latency() const { return m_sync_latency; }
+
+    /** Records a batch of updates flushed by group commit.
+     * @param updates Number of update requests in batch
+     * @param delay_micros Delay chosen for batch in microseconds
+     */
+    void add_group_commit_batch(uint32_t updates, int64_t delay_micros) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_running.group_commit_batches++;
+      m_running.group_commit_updates += updates;
+      m_running.group_commit_delay_micros += delay_micros;
+    }
+
     void increment_compactions_major() {
       std::lock_guard<std::mutex> lock(m_mutex);
       m_running.compactions_major++;
@@ -236,6 +276,9 @@ namespace Hypertable {
 
     // Computed statistics for last completed time period
     Bundle m_computed;
+
+    // Moving average of commit log sync latency in microseconds
+    std::atomic<int64_t> m_sync_latency {};
   };
 
   /// Shared smart pointer to LoadStatistics
@@ -0,0 +1,318 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for LogReplayer.
+/// This file contains type definitions for LogReplayer, a class that
+/// replays commit log blocks using a pool of decompression threads and a
+/// pool of apply threads.
+
+#include <Common/Compat.h>
+
+#include "LogReplayer.h"
+
+#include <Hypertable/Lib/BlockCompressionCodec.h>
+#include <Hypertable/Lib/CompressorFactory.h>
+#include <Hypertable/Lib/LegacyDecoder.h>
+
+#include <Common/Logger.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Decodes table identifier at start of block, falling back to the
+  /// legacy encoding
+  void decode_table_id(const uint8_t **bufp, size_t *remainp,
+                       TableIdentifier *tid) {
+    const uint8_t *buf_saved = *bufp;
+    size_t remain_saved = *remainp;
+    try {
+      tid->decode(bufp, remainp);
+    }
+    catch (Exception &e) {
+      if (e.code() != Error::PROTOCOL_ERROR)
+        throw;
+      *bufp = buf_saved;
+      *remainp = remain_saved;
+      legacy_decode(bufp, remainp, tid);
+    }
+  }
+
+}
+
+
+LogReplayer::LogReplayer(Router *router, size_t threads)
+  : m_router(router), m_apply_cond(threads), m_apply_queue(threads) {
+  HT_ASSERT(threads > 0);
+  // Enough blocks to keep every decoder busy while appliers catch up
+  m_max_outstanding = threads * 4;
+  for (size_t i=0; i<threads; i++)
+    m_threads.push_back(thread(&LogReplayer::decoder, this));
+  for (size_t i=0; i<threads; i++)
+    m_threads.push_back(thread(&LogReplayer::applier, this, i));
+}
+
+
+LogReplayer::~LogReplayer() {
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_shutdown = true;
+    m_decode_cond.notify_all();
+    for (auto &cond : m_apply_cond)
+      cond.notify_all();
+  }
+  for (auto &t : m_threads)
+    t.join();
+}
+
+
+void LogReplayer::add(DynamicBuffer &zblock,
+                      const BlockHeaderCommitLog &header) {
+  BlockPtr block = make_shared<Block>();
+  block->header = header;
+
+  // Take over compressed block memory
+  block->zblock.base = zblock.base;
+  block->zblock.ptr = zblock.ptr;
+  block->zblock.mark = zblock.mark;
+  block->zblock.size = zblock.size;
+  block->zblock.own = zblock.own;
+  zblock.base = zblock.ptr = zblock.mark = 0;
+  zblock.size = 0;
+
+  unique_lock<mutex> lock(m_mutex);
+  m_space_cond.wait(lock, [this]() {
+      return m_error || m_outstanding < m_max_outstanding; });
+  if (m_error)
+    HT_THROW2(m_error->code(), *m_error, "Replaying commit log block");
+  m_outstanding++;
+  m_decode_queue.push_back(block.get());
+  m_blocks.push_back(move(block));
+  m_decode_cond.notify_one();
+}
+
+
+void LogReplayer::finish() {
+  unique_lock<mutex> lock(m_mutex);
+  m_space_cond.wait(lock, [this]() { return m_error || m_outstanding == 0; });
+  if (m_error)
+    HT_THROW2(m_error->code(), *m_error, "Replaying commit log block");
+}
+
+
+size_t LogReplayer::replay(CommitLogReader *log_reader) {
+  BlockHeaderCommitLog header;
+  DynamicBuffer zblock;
+  size_t block_count = 0;
+
+  while (log_reader->next_compressed(zblock, &header)) {
+    add(zblock, header);
+    block_count++;
+  }
+  finish();
+  return block_count;
+}
+
+
+void LogReplayer::decoder() {
+  unordered_map<uint16_t, BlockCompressionCodecPtr> codecs;
+  Block *block;
+
+  while (true) {
+    {
+      unique_lock<mutex> lock(m_mutex);
+      m_decode_cond.wait(lock, [this]() {
+          return m_shutdown || !m_decode_queue.empty(); });
+      if (m_shutdown)
+        return;
+      block = m_decode_queue.front();
+      m_decode_queue.pop_front();
+    }
+
+    bool inflated = false;
+    try {
+      uint16_t ztype = block->header.get_compression_type();
+      if (ztype >= BlockCompressionCodec::COMPRESSION_TYPE_LIMIT)
+        HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE,
+                  "Invalid compression type '%d'", (int)ztype);
+      BlockCompressionCodecPtr &codec = codecs[ztype];
+      if (!codec)
+        codec.reset(CompressorFactory::create_block_codec((BlockCompressionCodec::Type)ztype));
+      codec->inflate(block->zblock, block->data, block->header);
+      inflated = true;
+    }
+    catch (Exception &e) {
+      // Same as sequential replay, skip blocks that fail to inflate
+      HT_ERRORF("Inflate error in commit log block with revision %lld "
+                "(block len = %lld) - %s",
+                (Lld)block->header.get_revision(),
+                (Lld)block->zblock.fill(), Error::get_text(e.code()));
+    }
+    block->zblock.free();
+
+    try {
+      if (inflated)
+        partition(block);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      lock_guard<mutex> lock(m_mutex);
+      set_error(e);
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    block->done = true;
+    if (block == m_blocks.front().get())
+      dispatch();
+  }
+}
+
+
+void LogReplayer::partition(Block *block) {
+  TableIdentifier table_id;
+  Key key;
+  SerializedKey skey;
+  ByteString value;
+  String start_row, end_row;
+  Run run;
+  bool have_run = false;
+  const uint8_t *ptr = block->data.base;
+  const uint8_t *end = block->data.ptr;
+  size_t len = block->data.fill();
+
+  decode_table_id(&ptr, &len, &table_id);
+
+  while (ptr < end) {
+    const uint8_t *cell = ptr;
+
+    // extract the key
+    skey.ptr = ptr;
+    key.load(skey);
+    ptr += skey.length();
+    if (ptr > end)
+      HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
+    // extract the value
+    value.ptr = ptr;
+    ptr += value.length();
+    if (ptr > end)
+      HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
+
+    if (have_run) {
+      if (start_row.compare(key.row) < 0 && end_row.compare(key.row) >= 0) {
+        run.end = ptr;
+        run.cells++;
+        continue;
+      }
+      block->runs.push_back(run);
+      have_run = false;
+    }
+
+    if (!m_router->find(table_id, key.row, run.target, start_row, end_row))
+      continue;
+
+    run.base = cell;
+    run.end = ptr;
+    run.cells = 1;
+    have_run = true;
+  }
+
+  if (have_run)
+    block->runs.push_back(run);
+}
+
+
+void LogReplayer::dispatch() {
+  while (!m_blocks.empty() && m_blocks.front()->done) {
+    BlockPtr block = move(m_blocks.front());
+    m_blocks.pop_front();
+    if (block->runs.empty()) {
+      m_outstanding--;
+      m_space_cond.notify_all();
+      continue;
+    }
+    block->pending = block->runs.size();
+    for (size_t i=0; i<block->runs.size(); i++) {
+      // Spread targets over appliers; a target always maps to one applier
+      uintptr_t h = reinterpret_cast<uintptr_t>(block->runs[i].target.get());
+      h ^= h >> 17;
+      size_t shard = (h >> 4) % m_apply_queue.size();
+      m_apply_queue[shard].push_back({block, i});
+      m_apply_cond[shard].notify_one();
+    }
+  }
+}
+
+
+void LogReplayer::applier(size_t shard) {
+  Key key;
+  SerializedKey skey;
+  ByteString value;
+
+  while (true) {
+    Work work;
+    {
+      unique_lock<mutex> lock(m_mutex);
+      m_apply_cond[shard].wait(lock, [this, shard]() {
+          return m_shutdown || !m_apply_queue[shard].empty(); });
+      if (m_shutdown)
+        return;
+      work = move(m_apply_queue[shard].front());
+      m_apply_queue[shard].pop_front();
+    }
+
+    Run &run = work.block->runs[work.run];
+    try {
+      lock_guard<Target> lock(*run.target);
+      for (const uint8_t *ptr = run.base; ptr < run.end; ) {
+        skey.ptr = ptr;
+        key.load(skey);
+        ptr += skey.length();
+        value.ptr = ptr;
+        ptr += value.length();
+        run.target->add(key, value);
+      }
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      lock_guard<mutex> lock(m_mutex);
+      set_error(e);
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    m_cells += run.cells;
+    if (--work.block->pending == 0) {
+      m_outstanding--;
+      m_space_cond.notify_all();
+    }
+  }
+}
+
+
+void LogReplayer::set_error(const Exception &e) {
+  if (!m_error)
+    m_error.reset(new Exception(e));
+  m_space_cond.notify_all();
+}
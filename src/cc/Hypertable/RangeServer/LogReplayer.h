@@ -0,0 +1,244 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for LogReplayer.
+/// This file contains type declarations for LogReplayer, a class that
+/// replays commit log blocks using a pool of decompression threads and a
+/// pool of apply threads.
+
+#ifndef Hypertable_RangeServer_LogReplayer_h
+#define Hypertable_RangeServer_LogReplayer_h
+
+#include <Hypertable/Lib/BlockHeaderCommitLog.h>
+#include <Hypertable/Lib/CommitLogReader.h>
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/TableIdentifier.h>
+
+#include <Common/ByteString.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Error.h>
+#include <Common/String.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Replays commit log blocks in parallel.
+  /// Compressed blocks are read sequentially by the caller and handed to a
+  /// pool of decoder threads, each owning its own decompression codecs.  A
+  /// decoder inflates a block and splits its cells into runs of consecutive
+  /// cells that belong to the same Target, as located by the Router.  Runs
+  /// are then dispatched, in log order, to a pool of applier threads.  Every
+  /// target is always applied to by the same applier thread, so cells for any
+  /// one target are added in exactly the order they appear in the log, while
+  /// different targets are applied to concurrently.
+  class LogReplayer {
+  public:
+
+    /// Destination of replayed cells (e.g. a Range).
+    class Target {
+    public:
+      virtual ~Target() { }
+      /// Locks target before a run of cells is added.
+      virtual void lock() { }
+      /// Unlocks target after a run of cells is added.
+      virtual void unlock() { }
+      /// Adds replayed cell.
+      /// @param key Cell key
+      /// @param value Cell value
+      virtual void add(const Key &key, const ByteString value) = 0;
+    };
+
+    /// Smart pointer to Target
+    typedef std::shared_ptr<Target> TargetPtr;
+
+    /// Locates replay targets.
+    /// find() is called concurrently from the decoder threads and must be
+    /// thread safe.  It should return the same Target object for every row
+    /// that maps to the same destination.
+    class Router {
+    public:
+      virtual ~Router() { }
+      /// Finds target containing row.
+      /// @param table %Table identifier
+      /// @param row Row key
+      /// @param target Set to target containing <code>row</code>
+      /// @param start_row Set to (exclusive) start row of target
+      /// @param end_row Set to (inclusive) end row of target
+      /// @return <i>true</i> if target was found, <i>false</i> if cells for
+      /// <code>row</code> should be skipped
+      virtual bool find(const TableIdentifier &table, const char *row,
+                        TargetPtr &target, String &start_row,
+                        String &end_row) = 0;
+    };
+
+    /// Constructor.
+    /// Starts <code>threads</code> decoder threads and <code>threads</code>
+    /// applier threads.
+    /// @param router Router used to locate targets
+    /// @param threads Number of decoder and applier threads
+    LogReplayer(Router *router, size_t threads);
+
+    /// Destructor.
+    /// Stops the threads and discards any blocks not yet applied.
+    ~LogReplayer();
+
+    /// Submits compressed block for replay.
+    /// Takes ownership of the memory held by <code>zblock</code>.  Blocks
+    /// until the number of outstanding blocks drops below the limit.
+    /// @param zblock Compressed block, header included
+    /// @param header Block header
+    /// @throws Exception if a previously submitted block failed to replay
+    void add(DynamicBuffer &zblock, const BlockHeaderCommitLog &header);
+
+    /// Waits for all submitted blocks to be applied.
+    /// @throws Exception First error raised by a decoder or applier thread
+    void finish();
+
+    /// Replays all remaining blocks of a commit log.
+    /// @param log_reader Commit log reader
+    /// @return Number of blocks replayed
+    size_t replay(CommitLogReader *log_reader);
+
+    /// Returns number of cells applied so far.
+    /// @return Number of cells applied
+    size_t cells() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_cells;
+    }
+
+  private:
+
+    /// Run of consecutive cells of a block that belong to one target
+    struct Run {
+      /// Target of cells
+      TargetPtr target;
+      /// Start of first serialized cell
+      const uint8_t *base;
+      /// End of last serialized cell
+      const uint8_t *end;
+      /// Number of cells in run
+      size_t cells;
+    };
+
+    /// Block being replayed
+    struct Block {
+      /// Block header
+      BlockHeaderCommitLog header;
+      /// Compressed block
+      DynamicBuffer zblock;
+      /// Decompressed block
+      DynamicBuffer data;
+      /// Runs of cells, in block order
+      std::vector<Run> runs;
+      /// Runs not yet applied
+      size_t pending {};
+      /// Set to <i>true</i> once decoded
+      bool done {};
+    };
+
+    /// Smart pointer to Block
+    typedef std::shared_ptr<Block> BlockPtr;
+
+    /// Unit of work for an applier thread
+    struct Work {
+      /// Block holding run (keeps block data alive)
+      BlockPtr block;
+      /// Index of run within block
+      size_t run;
+    };
+
+    /// Decoder thread loop
+    void decoder();
+
+    /// Applier thread loop.
+    /// @param shard Index of applier thread
+    void applier(size_t shard);
+
+    /// Splits decoded block into runs.
+    /// @param block Decoded block
+    void partition(Block *block);
+
+    /// Dispatches decoded blocks at head of #m_blocks to applier threads.
+    /// Must be called with #m_mutex locked.
+    void dispatch();
+
+    /// Records first error and wakes up waiters.
+    /// Must be called with #m_mutex locked.
+    /// @param e Exception
+    void set_error(const Exception &e);
+
+    /// Router used to locate targets
+    Router *m_router;
+
+    /// %Mutex protecting members
+    std::mutex m_mutex;
+
+    /// Signals decoders that a block was added or shutdown was requested
+    std::condition_variable m_decode_cond;
+
+    /// Signals add() and finish() that a block was fully applied
+    std::condition_variable m_space_cond;
+
+    /// Signals each applier that work was queued or shutdown was requested
+    std::vector<std::condition_variable> m_apply_cond;
+
+    /// Decoded or decoding blocks not yet dispatched, in log order
+    std::deque<BlockPtr> m_blocks;
+
+    /// Blocks waiting for a decoder
+    std::deque<Block *> m_decode_queue;
+
+    /// Per-applier work queues
+    std::vector<std::deque<Work>> m_apply_queue;
+
+    /// Decoder and applier threads
+    std::vector<std::thread> m_threads;
+
+    /// Blocks submitted but not fully applied
+    size_t m_outstanding {};
+
+    /// Limit on #m_outstanding
+    size_t m_max_outstanding {};
+
+    /// Number of cells applied
+    size_t m_cells {};
+
+    /// First error encountered by a decoder or applier thread
+    std::unique_ptr<Exception> m_error;
+
+    /// Set to <i>true</i> to stop the threads
+    bool m_shutdown {};
+  };
+
+  /// @}
+}
+
+#endif // Hypertable_RangeServer_LogReplayer_h
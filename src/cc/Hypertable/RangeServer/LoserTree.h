@@ -0,0 +1,206 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Declarations for LoserTree.
+/// This file contains type declarations for LoserTree, a tournament tree
+/// used to merge the sorted output of several scanners.
+
+#ifndef Hypertable_RangeServer_LoserTree_h
+#define Hypertable_RangeServer_LoserTree_h
+
+#include <Common/Logger.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Hypertable {
+
+  /// @addtogroup RangeServer
+  /// @{
+
+  /// Tournament (loser) tree for k-way merging.
+  /// Each input is a leaf holding that input's current element.  Every
+  /// internal node records the loser of the match played there and the
+  /// overall winner (the smallest element) is kept separately, so after the
+  /// winning input advances, replace_top() only replays the matches on the
+  /// path from its leaf to the root: one comparison per level, compared to
+  /// about two per level for a binary heap pop followed by a push.
+  ///
+  /// When the same input wins twice in a row, the tree also remembers the
+  /// best of the losers on the winner's path (the runner-up).  While the
+  /// winning input keeps producing elements no greater than the runner-up,
+  /// replace_top() needs a single comparison, which makes long runs from
+  /// one input (e.g. a CellStore that does not overlap the others) cheap.
+  /// @tparam T Element type
+  /// @tparam LessT Strict weak ordering of <code>T</code>
+  template <typename T, typename LessT>
+  class LoserTree {
+  public:
+
+    /// Removes all inputs.
+    void clear() {
+      m_leaves.clear();
+      m_losers.clear();
+      m_winner = m_runner_up = NONE;
+    }
+
+    /// Adds input with its first element.
+    /// Inputs must all be added before build() is called.
+    /// @param value First element of input
+    void add(const T &value) {
+      m_leaves.push_back(Leaf(value));
+    }
+
+    /// Plays initial tournament.
+    void build() {
+      size_t k = m_leaves.size();
+      m_runner_up = NONE;
+      if (k == 0) {
+        m_winner = NONE;
+        return;
+      }
+      m_losers.resize(k);
+      std::vector<size_t> winners(2*k);
+      for (size_t i=0; i<k; i++)
+        winners[k+i] = i;
+      for (size_t j=k-1; j>0; j--) {
+        size_t a = winners[2*j], b = winners[2*j+1];
+        if (less(b, a))
+          std::swap(a, b);
+        winners[j] = a;
+        m_losers[j] = b;
+      }
+      m_winner = winners[1];
+    }
+
+    /// Checks if all inputs are exhausted.
+    /// @return <i>true</i> if no elements remain, <i>false</i> otherwise
+    bool empty() const {
+      return m_winner == NONE || m_leaves[m_winner].done;
+    }
+
+    /// Returns smallest element.
+    /// @return Smallest element
+    const T &top() const {
+      HT_ASSERT(!empty());
+      return m_leaves[m_winner].value;
+    }
+
+    /// Replaces smallest element with next element from same input.
+    /// @param value Next element of input that produced top()
+    void replace_top(const T &value) {
+      size_t leaf = m_winner;
+      m_leaves[leaf].value = value;
+      if (m_runner_up != NONE) {
+        if (!less(m_runner_up, leaf))
+          return;
+        m_runner_up = NONE;
+        replay(leaf);
+        return;
+      }
+      replay(leaf);
+      if (m_winner == leaf)
+        find_runner_up();
+    }
+
+    /// Removes smallest element; its input is exhausted.
+    void pop() {
+      size_t leaf = m_winner;
+      m_leaves[leaf].done = true;
+      m_runner_up = NONE;
+      replay(leaf);
+    }
+
+    /// Returns number of inputs.
+    /// @return Number of inputs, including exhausted ones
+    size_t size() const { return m_leaves.size(); }
+
+  private:
+
+    /// Input state
+    struct Leaf {
+      Leaf(const T &v) : value(v) { }
+      /// Current element
+      T value;
+      /// Set to <i>true</i> when input is exhausted
+      bool done {};
+    };
+
+    /// Compares two leaves; exhausted leaves are greater than all others
+    bool less(size_t a, size_t b) const {
+      if (m_leaves[a].done)
+        return false;
+      if (m_leaves[b].done)
+        return true;
+      return m_less(m_leaves[a].value, m_leaves[b].value);
+    }
+
+    /// Replays matches on path from <code>leaf</code> to root
+    void replay(size_t leaf) {
+      size_t winner = leaf;
+      for (size_t j=(m_leaves.size()+leaf)/2; j>0; j/=2) {
+        if (less(m_losers[j], winner))
+          std::swap(m_losers[j], winner);
+      }
+      m_winner = winner;
+    }
+
+    /// Sets #m_runner_up to best loser on path of #m_winner
+    void find_runner_up() {
+      size_t j = (m_leaves.size()+m_winner)/2;
+      if (j == 0)
+        return;
+      size_t best = m_losers[j];
+      for (j/=2; j>0; j/=2) {
+        if (less(m_losers[j], best))
+          best = m_losers[j];
+      }
+      // If every other input is exhausted, best is an exhausted leaf which
+      // never beats the winner
+      m_runner_up = best;
+    }
+
+    /// Leaf index meaning "none"
+    static const size_t NONE = (size_t)-1;
+
+    /// Inputs
+    std::vector<Leaf> m_leaves;
+
+    /// Loser of match at each internal node (1 .. size()-1)
+    std::vector<size_t> m_losers;
+
+    /// Leaf holding smallest element
+    size_t m_winner {NONE};
+
+    /// Best loser on path of #m_winner, or NONE if not tracked
+    size_t m_runner_up {NONE};
+
+    /// Comparison function
+    LessT m_less;
+  };
+
+  /// @}
+
+}
+
+#endif // Hypertable_RangeServer_LoserTree_h
@@ -224,6 +224,16 @@ MaintenancePrioritizer::schedule_splits_and_relinquishes(std::vector<RangeData>
   return memory_state.need_more();
 }
 
+void
+MaintenancePrioritizer::split_by_lane(std::vector<RangeData> &range_data,
+                                      std::vector<std::vector<RangeData>> &lanes) {
+  lanes.clear();
+  lanes.resize(Global::user_logs.size());
+  for (auto &rd : range_data)
+    lanes[Global::user_lane(rd.data->table_id, rd.range->end_row().c_str())].push_back(rd);
+}
+
+
 bool
 MaintenancePrioritizer::schedule_necessary_compactions(std::vector<RangeData> &range_data,
                  CommitLogPtr &log, int64_t prune_threshold, MemoryState &memory_state,
@@ -74,6 +74,12 @@ namespace Hypertable {
                             MemoryState &memory_state,
                             int32_t &priority, String *trace);
 
+    /// Splits USER ranges by update lane.
+    /// @param range_data USER ranges
+    /// @param lanes Set to ranges of each lane (see Global::user_lane())
+    void split_by_lane(std::vector<RangeData> &range_data,
+                       std::vector<std::vector<RangeData>> &lanes);
+
     bool purge_shadow_caches(std::vector<RangeData> &range_data,
                              MemoryState &memory_state,
                              int32_t &priority, String *trace);
@@ -93,9 +93,16 @@ MaintenancePrioritizerLogCleanup::prioritize(std::vector<RangeData> &range_data,
    * Assign priority for USER ranges
    */
 
-  if (!range_data_user.empty())
-    assign_priorities(range_data_user, Global::user_log, prune_threshold,
-                      memory_state, priority, trace);
+  if (!range_data_user.empty()) {
+    // Each lane's commit log is pruned separately
+    std::vector<std::vector<RangeData>> range_data_lanes;
+    split_by_lane(range_data_user, range_data_lanes);
+    for (size_t lane=0; lane<range_data_lanes.size(); lane++) {
+      if (!range_data_lanes[lane].empty())
+        assign_priorities(range_data_lanes[lane], Global::user_logs[lane],
+                          prune_threshold, memory_state, priority, trace);
+    }
+  }
 
   if (m_uninitialized_ranges_seen == false)
     m_initialization_complete = true;
@@ -109,9 +109,14 @@ MaintenancePrioritizerLowMemory::prioritize(std::vector<RangeData> &range_data,
     assign_priorities_user(range_data_user, load_stats, memory_state,
                            priority, trace);
 
-    schedule_necessary_compactions(range_data_user, Global::user_log,
-                                   prune_threshold, memory_state, priority,
-                                   trace);
+    std::vector<std::vector<RangeData>> range_data_lanes;
+    split_by_lane(range_data_user, range_data_lanes);
+    for (size_t lane=0; lane<range_data_lanes.size(); lane++) {
+      if (!range_data_lanes[lane].empty())
+        schedule_necessary_compactions(range_data_lanes[lane],
+                                       Global::user_logs[lane], prune_threshold,
+                                       memory_state, priority, trace);
+    }
 
     schedule_initialization_operations(range_data_user, priority);
   }
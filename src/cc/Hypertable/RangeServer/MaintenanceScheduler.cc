@@ -327,8 +327,10 @@ void MaintenanceScheduler::schedule() {
     if (Global::system_log)
       Global::system_log->purge(revision_system, remove_ok_logs, removed_logs, &trace_str);
 
-    if (Global::user_log)
-      Global::user_log->purge(revision_user, remove_ok_logs, removed_logs, &trace_str);
+    for (auto &log : Global::user_logs) {
+      if (log)
+        log->purge(revision_user, remove_ok_logs, removed_logs, &trace_str);
+    }
 
     // Remove logs that were removed from the MetaLogEntityRemoveOkLogs entity
     if (!removed_logs.empty()) {
@@ -101,23 +101,20 @@ void MergeScannerAccessGroup::forward() {
 
   sstate = m_queue.top();
 
-  // while the queue is not empty: pop the top element, forward it, 
-  // re-insert it back into the queue
+  // while the queue is not empty: forward the top element's scanner
+  // and replay it with its next cell
   while (true) {
     while (true) {
-      m_queue.pop();
-
       // In some cases the forward might already be done and so the 
       // scanner shdn't be forwarded again. For example you know a counter 
       // is done only after forwarding to the 1st post counter cell or 
       // reaching the end of the scan.
-      if (m_no_forward)
+      if (m_no_forward) {
         m_no_forward = false;
+        advance(sstate, false);
+      }
       else
-        sstate.scanner->forward();
-
-      if (sstate.scanner->get(sstate.key, sstate.value))
-        m_queue.push(sstate);
+        advance(sstate);
 
       if (m_queue.empty()) {
         // scan ended on a counter
@@ -378,6 +375,12 @@ bool MergeScannerAccessGroup::get(Key &key, ByteString &value) {
 }
 
 
+std::shared_ptr<void> MergeScannerAccessGroup::pin_value() {
+  if (m_done || m_no_forward || m_queue.empty())
+    return std::shared_ptr<void>();
+  return m_queue.top().scanner->pin_value();
+}
+
 
 int64_t MergeScannerAccessGroup::get_disk_read() {
   int64_t amount = m_disk_read;
@@ -392,15 +395,16 @@ void MergeScannerAccessGroup::initialize() {
 
   assert(!m_initialized);
 
-  while (!m_queue.empty())
-    m_queue.pop();
+  m_queue.clear();
 
   for (size_t i=0; i<m_scanners.size(); i++) {
     if (m_scanners[i]->get(sstate.key, sstate.value)) {
       sstate.scanner = m_scanners[i].get();
-      m_queue.push(sstate);
+      set_prefix(sstate);
+      m_queue.add(sstate);
     }
   }
+  m_queue.build();
 
   bool counter;
   int64_t cell_cutoff, cur_bytes = 0;
@@ -428,10 +432,7 @@ void MergeScannerAccessGroup::initialize() {
         || (sstate.key.timestamp < m_start_timestamp)) {
       if (m_index_updater && sstate.key.flag == FLAG_INSERT)
         purge_from_index(sstate.key, sstate.value);
-      m_queue.pop();
-      sstate.scanner->forward();
-      if (sstate.scanner->get(sstate.key, sstate.value))
-        m_queue.push(sstate);
+      advance(sstate);
       continue;
     }
     else if (sstate.key.flag == FLAG_DELETE_ROW) {
@@ -472,10 +473,7 @@ void MergeScannerAccessGroup::initialize() {
             && (!m_return_deletes || sstate.key.flag == FLAG_INSERT))) {
         if (m_index_updater && sstate.key.flag == FLAG_INSERT)
           purge_from_index(sstate.key, sstate.value);
-        m_queue.pop();
-        sstate.scanner->forward();
-        if (sstate.scanner->get(sstate.key, sstate.value))
-          m_queue.push(sstate);
+        advance(sstate);
         continue;
       }
 
@@ -501,10 +499,7 @@ void MergeScannerAccessGroup::initialize() {
       if (m_revs_limit && m_revs_count > m_revs_limit && !counter) {
         if (m_index_updater && sstate.key.flag == FLAG_INSERT)
           purge_from_index(sstate.key, sstate.value);
-        m_queue.pop();
-        sstate.scanner->forward();
-        if (sstate.scanner->get(sstate.key, sstate.value))
-          m_queue.push(sstate);
+        advance(sstate);
         continue;
       }
 
@@ -515,10 +510,7 @@ void MergeScannerAccessGroup::initialize() {
             && (cmp = strcmp(*m_scan_context->rowset.begin(), sstate.key.row)) < 0)
           m_scan_context->rowset.erase(m_scan_context->rowset.begin());
         if (cmp > 0) {
-          m_queue.pop();
-          sstate.scanner->forward();
-          if (sstate.scanner->get(sstate.key, sstate.value))
-            m_queue.push(sstate);
+          advance(sstate);
           continue;
         }
       }
@@ -527,20 +519,14 @@ void MergeScannerAccessGroup::initialize() {
       if (!cp.matches(sstate.key.column_qualifier,
                       (size_t)sstate.key.column_qualifier_len,
                       (const char *)value, value_len)) {
-        m_queue.pop();
-        sstate.scanner->forward();
-        if (sstate.scanner->get(sstate.key, sstate.value))
-          m_queue.push(sstate);
+        advance(sstate);
         continue;
       }
       // row regexp
       if (m_scan_context->row_regexp)
         if (!RE2::PartialMatch(sstate.key.row, 
             *(m_scan_context->row_regexp))) {
-          m_queue.pop();
-          sstate.scanner->forward();
-          if (sstate.scanner->get(sstate.key, sstate.value))
-            m_queue.push(sstate);
+          advance(sstate);
           continue;
         }
       // filter by value regexp last since its probly the most expensive
@@ -548,10 +534,7 @@ void MergeScannerAccessGroup::initialize() {
         value_len = sstate.value.decode_length(&value);
         if (!RE2::PartialMatch(re2::StringPiece((const char *)value, value_len),
                                *(m_scan_context->value_regexp))) {
-          m_queue.pop();
-          sstate.scanner->forward();
-          if (sstate.scanner->get(sstate.key, sstate.value))
-            m_queue.push(sstate);
+          advance(sstate);
           continue;
         }
       }
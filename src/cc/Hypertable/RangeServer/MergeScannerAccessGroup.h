@@ -30,13 +30,13 @@
 #include "CellListScanner.h"
 #include "CellStoreReleaseCallback.h"
 #include "IndexUpdater.h"
+#include "LoserTree.h"
 #include "ScanContext.h"
 
 #include <Common/ByteString.h>
 #include <Common/DynamicBuffer.h>
 
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 #include <set>
@@ -95,14 +95,42 @@ namespace Hypertable {
       CellListScanner *scanner;
       Key key;
       ByteString value;
+      /// Row prefix of #key (see SerializedKey::row_prefix())
+      uint64_t prefix;
     };
 
     struct LtScannerState {
       bool operator()(const ScannerState &ss1, const ScannerState &ss2) const {
-        return ss1.key.serial > ss2.key.serial;
+        // Most comparisons are decided by the cached row prefix
+        if (ss1.prefix != ss2.prefix)
+          return ss1.prefix < ss2.prefix;
+        return ss1.key.serial < ss2.key.serial;
       }
     };
 
+    /// Caches row prefix of scanner's current key.
+    /// @param sstate Scanner state
+    void set_prefix(ScannerState &sstate) {
+      sstate.prefix =
+        SerializedKey::row_prefix((const uint8_t *)sstate.key.row);
+    }
+
+    /// Advances scanner at top of #m_queue and replays merge.
+    /// If the scanner has another cell, it replaces the top of #m_queue,
+    /// otherwise the scanner is removed from the merge.
+    /// @param sstate Copy of top of #m_queue
+    /// @param forward If <i>false</i>, the scanner has already been forwarded
+    void advance(ScannerState &sstate, bool forward=true) {
+      if (forward)
+        sstate.scanner->forward();
+      if (sstate.scanner->get(sstate.key, sstate.value)) {
+        set_prefix(sstate);
+        m_queue.replace_top(sstate);
+      }
+      else
+        m_queue.pop();
+    }
+
   public:
 
     enum Flags {
@@ -130,6 +158,15 @@ namespace Hypertable {
 
     bool get(Key &key, ByteString &value);
 
+    /// Returns reference that keeps memory of current value valid.
+    /// Delegates to the scanner that supplied the current cell.  Aggregated
+    /// counter values live in a buffer owned by this object and are not
+    /// pinned.
+    /// @see CellListScanner::pin_value()
+    /// @return Reference to memory holding current value, or empty pointer
+    /// if the value can't be pinned
+    std::shared_ptr<void> pin_value();
+
     uint32_t get_flags() { return m_flags; }
 
     void install_release_callback(CellStoreReleaseCallback &cb) {
@@ -318,8 +355,8 @@ namespace Hypertable {
     bool m_initialized {};
 
     std::vector<CellListScannerPtr>  m_scanners;
-    std::priority_queue<ScannerState, std::vector<ScannerState>,
-        LtScannerState> m_queue;
+    /// Merge of scanners' current cells
+    LoserTree<ScannerState, LtScannerState> m_queue;
 
 
     int64_t m_bytes_input {};
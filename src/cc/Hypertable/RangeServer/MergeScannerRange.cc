@@ -97,18 +97,14 @@ forward:
     return;
   sstate = m_queue.top();
 
-  // while the queue is not empty: pop the top element, forward it
-  // and then re-insert it back into the queue
+  // while the queue is not empty: forward the top element's scanner
+  // and replay it with its next cell
   while (true) {
     bool new_row = false;
     bool new_cf = false;
     bool new_cq = false;
 
-    m_queue.pop();
-
-    sstate.scanner->forward();
-    if (sstate.scanner->get(sstate.key, sstate.value))
-      m_queue.push(sstate);
+    advance(sstate);
 
     // empty queue? return to caller
     if (m_queue.empty())
@@ -248,20 +244,28 @@ bool MergeScannerRange::get(Key &key, ByteString &value) {
 }
 
 
+std::shared_ptr<void> MergeScannerRange::pin_value() {
+  if (m_done || m_queue.empty())
+    return std::shared_ptr<void>();
+  return m_queue.top().scanner->pin_value();
+}
+
+
 void MergeScannerRange::initialize() {
   ScannerState sstate;
 
   assert(!m_initialized);
 
-  while (!m_queue.empty())
-    m_queue.pop();
+  m_queue.clear();
 
   for (size_t i=0; i<m_scanners.size(); i++) {
     if (m_scanners[i]->get(sstate.key, sstate.value)) {
       sstate.scanner = m_scanners[i];
-      m_queue.push(sstate);
+      set_prefix(sstate);
+      m_queue.add(sstate);
     }
   }
+  m_queue.build();
 
   if (m_queue.empty())
     return;
@@ -29,12 +29,12 @@
 
 #include <Hypertable/RangeServer/MergeScannerAccessGroup.h>
 #include <Hypertable/RangeServer/IndexUpdater.h>
+#include <Hypertable/RangeServer/LoserTree.h>
 
 #include <Common/ByteString.h>
 #include <Common/DynamicBuffer.h>
 
 #include <memory>
-#include <queue>
 #include <set>
 #include <string>
 #include <vector>
@@ -62,6 +62,13 @@ namespace Hypertable {
 
     bool get(Key &key, ByteString &value);
 
+    /// Returns reference that keeps memory of current value valid.
+    /// Delegates to the access group scanner that supplied the current cell.
+    /// @see CellListScanner::pin_value()
+    /// @return Reference to memory holding current value, or empty pointer
+    /// if the value can't be pinned
+    std::shared_ptr<void> pin_value();
+
     int32_t get_skipped_cells() { return m_cell_skipped; }
 
     int32_t get_skipped_rows() { return m_row_skipped; }
@@ -100,17 +107,45 @@ namespace Hypertable {
       MergeScannerAccessGroup *scanner;
       Key key;
       ByteString value;
+      /// Row prefix of #key (see SerializedKey::row_prefix())
+      uint64_t prefix;
     };
 
     struct LtScannerState {
       bool operator()(const ScannerState &ss1, const ScannerState &ss2) const {
-        return ss1.key.serial > ss2.key.serial;
+        // Most comparisons are decided by the cached row prefix
+        if (ss1.prefix != ss2.prefix)
+          return ss1.prefix < ss2.prefix;
+        return ss1.key.serial < ss2.key.serial;
       }
     };
 
+    /// Caches row prefix of scanner's current key.
+    /// @param sstate Scanner state
+    void set_prefix(ScannerState &sstate) {
+      sstate.prefix =
+        SerializedKey::row_prefix((const uint8_t *)sstate.key.row);
+    }
+
+    /// Advances scanner at top of #m_queue and replays merge.
+    /// If the scanner has another cell, it replaces the top of #m_queue,
+    /// otherwise the scanner is removed from the merge.
+    /// @param sstate Copy of top of #m_queue
+    /// @param forward If <i>false</i>, the scanner has already been forwarded
+    void advance(ScannerState &sstate, bool forward=true) {
+      if (forward)
+        sstate.scanner->forward();
+      if (sstate.scanner->get(sstate.key, sstate.value)) {
+        set_prefix(sstate);
+        m_queue.replace_top(sstate);
+      }
+      else
+        m_queue.pop();
+    }
+
     std::vector<MergeScannerAccessGroup *>  m_scanners;
-    std::priority_queue<ScannerState, std::vector<ScannerState>,
-                        LtScannerState> m_queue;
+    /// Merge of scanners' current cells
+    LoserTree<ScannerState, LtScannerState> m_queue;
 
     /// Scan context
     ScanContextPtr m_scan_context;
@@ -34,6 +34,7 @@
 #include <Hypertable/RangeServer/HyperspaceTableCache.h>
 #include <Hypertable/RangeServer/IndexUpdater.h>
 #include <Hypertable/RangeServer/LocationInitializer.h>
+#include <Hypertable/RangeServer/LogReplayer.h>
 #include <Hypertable/RangeServer/MaintenanceQueue.h>
 #include <Hypertable/RangeServer/MaintenanceScheduler.h>
 #include <Hypertable/RangeServer/MaintenanceTaskCompaction.h>
@@ -59,6 +60,7 @@
 #include <Hypertable/Lib/RangeServerRecovery/ReceiverPlan.h>
 
 #include <FsBroker/Lib/Client.h>
+#include <FsBroker/Lib/LocalFilesystem.h>
 
 #include <Common/FailureInducer.h>
 #include <Common/FileUtils.h>
@@ -143,8 +145,17 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
   Global::enable_shadow_cache = cfg.get_bool("AccessGroup.ShadowCache");
   Global::cellstore_target_size_min = cfg.get_i64("CellStore.TargetSize.Minimum");
   Global::cellstore_target_size_max = cfg.get_i64("CellStore.TargetSize.Maximum");
+  Global::cellstore_block_index_prefix_layout =
+    cfg.get_bool("CellStore.BlockIndex.PrefixLayout");
+  if (cfg.get_i32("CellStore.CompressionWorkers") > 0)
+    Global::cellstore_compression_pool =
+      new CellStoreCompressionPool(cfg.get_i32("CellStore.CompressionWorkers"));
+  Global::cellstore_prefetch_blocks = cfg.get_i32("CellStore.PrefetchBlocks");
   Global::pseudo_tables = PseudoTables::instance();
   m_scanner_buffer_size = cfg.get_i64("Scanner.BufferSize");
+  m_scanner_zero_copy_threshold = cfg.get_i32("Scanner.ZeroCopyThreshold");
+  m_replay_threads = std::max(cfg.get_i32("CommitLog.ReplayThreads"), 1);
+  Global::user_logs.resize(std::max(cfg.get_i32("UpdatePipeline.UserLanes"), 1));
   port = cfg.get_i16("Port");
 
   m_control_file_check_interval = cfg.get_i32("ControlFile.CheckInterval");
@@ -243,7 +254,10 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
 
   if (block_cache_max > 0)
     Global::block_cache = new FileBlockCache(block_cache_min, block_cache_max,
-                        cfg.get_bool("BlockCache.Compressed"));
+                        cfg.get_bool("BlockCache.Compressed"),
+                        cfg.get_i32("BlockCache.Shards"),
+                        cfg.get_i32("BlockCache.ProtectedPercentage"),
+                        cfg.get_i64("BlockCache.MinShardMemory"));
 
   int64_t query_cache_memory = cfg.get_i64("QueryCache.MaxMemory");
   if (query_cache_memory > 0) {
@@ -258,7 +272,7 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
 
   Global::memory_tracker = new MemoryTracker(Global::block_cache, m_query_cache);
 
-  FsBroker::Lib::ClientPtr dfsclient = std::make_shared<FsBroker::Lib::Client>(conn_mgr, props);
+  FsBroker::Lib::ClientPtr dfsclient;
 
   int dfs_timeout;
   if (props->has("FsBroker.Timeout"))
@@ -266,10 +280,19 @@ Apps::RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_
   else
     dfs_timeout = props->get_i32("Hypertable.Request.Timeout");
 
-  if (!dfsclient->wait_for_connection(dfs_timeout))
-    HT_THROW(Error::REQUEST_TIMEOUT, "connecting to FS Broker");
+  /**
+   * Access local broker files directly, bypassing the broker round trip
+   */
+  if (props->get_bool("FsBroker.Local.InProcess"))
+    Global::dfs = std::make_shared<FsBroker::Lib::LocalFilesystem>(props);
+  else {
+    dfsclient = std::make_shared<FsBroker::Lib::Client>(conn_mgr, props);
 
-  Global::dfs = dfsclient;
+    if (!dfsclient->wait_for_connection(dfs_timeout))
+      HT_THROW(Error::REQUEST_TIMEOUT, "connecting to FS Broker");
+
+    Global::dfs = dfsclient;
+  }
 
   m_log_roll_limit = cfg.get_i64("CommitLog.RollLimit");
 
@@ -421,7 +444,8 @@ void Apps::RangeServer::shutdown() {
       m_group_commit_timer_handler->shutdown();
 
     // Kill update pipelines
-    m_update_pipeline_user->shutdown();
+    for (auto &pipeline : m_update_pipeline_user)
+      pipeline->shutdown();
     if (m_update_pipeline_system)
       m_update_pipeline_system->shutdown();
     if (m_update_pipeline_metadata)
@@ -445,9 +469,9 @@ void Apps::RangeServer::shutdown() {
       Global::system_log->close();
       //Global::system_log.reset();
     }
-    if (Global::user_log) {
-      Global::user_log->close();
-      //Global::user_log.reset();
+    for (auto &log : Global::user_logs) {
+      if (log)
+        log->close();
     }
 
     /*
@@ -877,12 +901,7 @@ void Apps::RangeServer::local_recover() {
 
       m_context->live_map->merge(&replay_map);
 
-      Global::user_log = make_shared<CommitLog>(Global::log_dfs, Global::log_dir
-                                       + "/user", m_props, user_log_reader.get(), false);
-
-      m_update_pipeline_user =
-        make_shared<UpdatePipeline>(m_context, m_query_cache, m_timer_handler,
-                                    Global::user_log, m_log_flush_method_user);
+      create_user_lanes(user_log_reader);
 
       m_log_replay_barrier->set_user_complete();
 
@@ -923,13 +942,8 @@ void Apps::RangeServer::local_recover() {
                                       Global::system_log, m_log_flush_method_user);
       }
 
-      Global::user_log = make_shared<CommitLog>(Global::log_dfs, Global::log_dir
-          + "/user", m_props, user_log_reader.get(), false);
+      create_user_lanes(user_log_reader);
 
-      m_update_pipeline_user =
-        make_shared<UpdatePipeline>(m_context, m_query_cache, m_timer_handler,
-                                    Global::user_log, m_log_flush_method_user);
-      
       Global::rsml_writer =
         make_shared<MetaLog::Writer>(Global::log_dfs, rsml_definition,
                                      Global::log_dir + "/" + rsml_definition->name(),
@@ -1049,82 +1063,76 @@ Apps::RangeServer::replay_load_range(TableInfoMap &replay_map,
 }
 
 
-void Apps::RangeServer::replay_log(TableInfoMap &replay_map,
-                             CommitLogReaderPtr &log_reader) {
-  BlockHeaderCommitLog header;
-  TableIdentifier table_id;
-  TableInfoPtr table_info;
-  Key key;
-  SerializedKey skey;
-  ByteString value;
-  RangePtr range;
-  String start_row, end_row;
-  unsigned long block_count = 0;
-  uint8_t *base;
-  size_t len;
+namespace {
 
-  while (log_reader->next((const uint8_t **)&base, &len, &header)) {
+  /// Replays cells into a range
+  class RangeReplayTarget : public LogReplayer::Target {
+  public:
+    RangeReplayTarget(RangePtr &range) : m_range(range) { }
+    void lock() override { m_range->lock(); }
+    void unlock() override { m_range->unlock(); }
+    void add(const Key &key, const ByteString value) override {
+      m_range->add(key, value);
+    }
+  private:
+    RangePtr m_range;
+  };
 
-    const uint8_t *ptr = base;
-    const uint8_t *end = base + len;
+  /// Routes replayed cells to the ranges of a replay map
+  class RangeReplayRouter : public LogReplayer::Router {
+  public:
+    RangeReplayRouter(TableInfoMap &replay_map) : m_replay_map(replay_map) { }
+    bool find(const TableIdentifier &table, const char *row,
+              LogReplayer::TargetPtr &target, String &start_row,
+              String &end_row) override {
+      TableInfoPtr table_info;
+      RangePtr range;
+      if (!m_replay_map.lookup(table.id, table_info) ||
+          !table_info->find_containing_range(row, range, start_row, end_row))
+        return false;
+      lock_guard<mutex> lock(m_mutex);
+      LogReplayer::TargetPtr &range_target = m_targets[range.get()];
+      if (!range_target)
+        range_target = make_shared<RangeReplayTarget>(range);
+      target = range_target;
+      return true;
+    }
+  private:
+    TableInfoMap &m_replay_map;
+    mutex m_mutex;
+    unordered_map<Range *, LogReplayer::TargetPtr> m_targets;
+  };
 
-    decode_table_id(&ptr, &len, &table_id);
+}
 
-    // Fetch table info
-    if (!replay_map.lookup(table_id.id, table_info))
-      continue;
+void Apps::RangeServer::replay_log(TableInfoMap &replay_map,
+                             CommitLogReaderPtr &log_reader) {
+  RangeReplayRouter router(replay_map);
+  LogReplayer replayer(&router, m_replay_threads);
+  size_t block_count = replayer.replay(log_reader.get());
 
-    bool pair_loaded = false;
-
-    while (ptr < end) {
-
-      if (!pair_loaded) {
-        // extract the key
-        skey.ptr = ptr;
-        key.load(skey);
-        ptr += skey.length();
-        if (ptr > end)
-          HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
-        // extract the value
-        value.ptr = ptr;
-        ptr += value.length();
-        if (ptr > end)
-          HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
-        pair_loaded = true;
-      }
-
-      while (pair_loaded) {
-        if (!table_info->find_containing_range(key.row, range, start_row, end_row)) {
-          pair_loaded = false;
-          continue;
-        }
-        lock_guard<Range> lock(*range);
-        do {
-          range->add(key, value);
-          if (ptr == end) {
-            pair_loaded = false;
-            break;
-          }
-          // extract the key
-          skey.ptr = ptr;
-          key.load(skey);
-          ptr += skey.length();
-          if (ptr > end)
-            HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
-          // extract the value
-          value.ptr = ptr;
-          ptr += value.length();
-          if (ptr > end)
-            HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
-        } while (start_row.compare(key.row) < 0 && end_row.compare(key.row) >= 0);
-      }
+  HT_INFOF("Replayed %lu blocks (%lu cells) of updates from '%s'",
+           (Lu)block_count, (Lu)replayer.cells(),
+           log_reader->get_log_dir().c_str());
+}
 
-    }
-    block_count++;
-  }
+void Apps::RangeServer::create_user_lanes(CommitLogReaderPtr &log_reader) {
+  uint32_t lanes = (uint32_t)Global::user_logs.size();
 
-  HT_INFOF("Replayed %lu blocks of updates from '%s'", block_count,
-           log_reader->get_log_dir().c_str());
+  // Lane 0 takes over the replayed fragments of every lane
+  for (uint32_t lane=0; lane<lanes; lane++)
+    Global::user_logs[lane] =
+      make_shared<CommitLog>(Global::log_dfs, Global::log_dir + "/user",
+                             m_props, lane ? nullptr : log_reader.get(),
+                             false, lane, lanes);
+
+  for (auto &log : Global::user_logs)
+    m_update_pipeline_user.push_back(
+      make_shared<UpdatePipeline>(m_context, m_query_cache, m_timer_handler,
+                                  log, m_log_flush_method_user));
+
+  if (lanes > 1)
+    HT_INFOF("Writing USER updates through %u update lanes", (unsigned)lanes);
 }
 
 void
@@ -1525,8 +1533,15 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
     decrement_needed = false;
 
     uint32_t cell_count {};
+    bool use_query_cache = cache_key && m_query_cache && !table.is_metadata();
+    GatherBufferPtr gather;
 
-    more = FillScanBlock(scanner, rbuf, &cell_count, m_scanner_buffer_size);
+    // Results destined for the query cache must be contiguous
+    if (use_query_cache)
+      more = FillScanBlock(scanner, rbuf, &cell_count, m_scanner_buffer_size);
+    else
+      more = FillScanBlock(scanner, gather, &cell_count, m_scanner_buffer_size,
+                           m_scanner_zero_copy_threshold);
 
     profile_data.cells_scanned = scanner->get_input_cells();
     profile_data.cells_returned = scanner->get_output_cells();
@@ -1572,7 +1587,7 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
     /**
      *  Send back data
      */
-    if (cache_key && m_query_cache && !table.is_metadata() && !more) {
+    if (use_query_cache && !more) {
       const char *cache_row_key = scan_spec.cache_key();
       char *row_key_ptr, *tablename_ptr;
       uint8_t *buffer = new uint8_t [ rbuf.fill() + strlen(cache_row_key) + strlen(table.id) + 2 ];
@@ -1589,6 +1604,12 @@ Apps::RangeServer::create_scanner(Response::Callback::CreateScanner *cb,
         HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
       }
     }
+    else if (gather) {
+      if ((error = cb->response(id, skipped_rows, skipped_cells, more,
+                                profile_data, gather)) != Error::OK) {
+        HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+      }
+    }
     else {
       StaticBuffer ext(rbuf);
       if ((error = cb->response(id, skipped_rows, skipped_cells, more,
@@ -1627,7 +1648,7 @@ Apps::RangeServer::fetch_scanblock(Response::Callback::CreateScanner *cb,
   MergeScannerRangePtr scanner;
   RangePtr range;
   bool more = true;
-  DynamicBuffer rbuf;
+  GatherBufferPtr gather;
   TableInfoPtr table_info;
   TableIdentifierManaged scanner_table;
   SchemaPtr schema;
@@ -1660,7 +1681,8 @@ Apps::RangeServer::fetch_scanblock(Response::Callback::CreateScanner *cb,
 
     uint32_t cell_count {};
 
-    more = FillScanBlock(scanner, rbuf, &cell_count, m_scanner_buffer_size);
+    more = FillScanBlock(scanner, gather, &cell_count, m_scanner_buffer_size,
+                         m_scanner_zero_copy_threshold);
 
     profile_data.cells_scanned = scanner->get_input_cells();
     profile_data.cells_returned = scanner->get_output_cells();
@@ -1699,13 +1721,13 @@ Apps::RangeServer::fetch_scanblock(Response::Callback::CreateScanner *cb,
      *  Send back data
      */
     {
-      StaticBuffer ext(rbuf);
-      error = cb->response(scanner_id, 0, 0, more, profile_data, ext);
+      size_t length = gather->length();
+      error = cb->response(scanner_id, 0, 0, more, profile_data, gather);
       if (error != Error::OK)
         HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
 
       HT_DEBUGF("Successfully fetched %u bytes (%lld k/v pairs) of scan data",
-                ext.size-4, (Lld)output_cells);
+                (unsigned)length-4, (Lld)output_cells);
     }
 
   }
@@ -2061,15 +2083,16 @@ Apps::RangeServer::commit_log_sync(ResponseCallback *cb,
 
     table_update_vector.push_back(table_update);
 
-    UpdateContext *uc = new UpdateContext(table_update_vector, cb->event()->deadline());
-
     if (table.is_user())
-      m_update_pipeline_user->add(uc);
-    else if (table.is_metadata())
-      m_update_pipeline_metadata->add(uc);
+      add_user_updates(table_update_vector, cb->event()->deadline());
     else {
-      HT_ASSERT(table.is_system());
-      m_update_pipeline_system->add(uc);
+      UpdateContext *uc = new UpdateContext(table_update_vector, cb->event()->deadline());
+      if (table.is_metadata())
+        m_update_pipeline_metadata->add(uc);
+      else {
+        HT_ASSERT(table.is_system());
+        m_update_pipeline_system->add(uc);
+      }
     }
 
   }
@@ -2130,15 +2153,16 @@ Apps::RangeServer::update(Response::Callback::Update *cb, uint64_t cluster_id,
 
   table_update_vector.push_back(table_update);
 
-  UpdateContext *uc = new UpdateContext(table_update_vector, table_update->expire_time);
-
   if (table.is_user())
-    m_update_pipeline_user->add(uc);
-  else if (table.is_metadata())
-    m_update_pipeline_metadata->add(uc);
+    add_user_updates(table_update_vector, table_update->expire_time);
   else {
-    HT_ASSERT(table.is_system());
-    m_update_pipeline_system->add(uc);
+    UpdateContext *uc = new UpdateContext(table_update_vector, table_update->expire_time);
+    if (table.is_metadata())
+      m_update_pipeline_metadata->add(uc);
+    else {
+      HT_ASSERT(table.is_system());
+      m_update_pipeline_system->add(uc);
+    }
   }
 
 }
@@ -2146,8 +2170,176 @@ Apps::RangeServer::update(Response::Callback::Update *cb, uint64_t cluster_id,
 void
 Apps::RangeServer::batch_update(std::vector<UpdateRecTable *> &updates,
                                 ClockT::time_point expire_time) {
-  UpdateContext *uc = new UpdateContext(updates, expire_time);
-  m_update_pipeline_user->add(uc);
+  add_user_updates(updates, expire_time);
+}
+
+
+void
+Apps::RangeServer::add_user_updates(std::vector<UpdateRecTable *> &updates,
+                                    ClockT::time_point expire_time) {
+  size_t lanes = m_update_pipeline_user.size();
+
+  if (lanes == 1) {
+    UpdateContext *uc = new UpdateContext(updates, expire_time);
+    m_update_pipeline_user[0]->add(uc);
+    return;
+  }
+
+  vector<vector<UpdateRecTable *>> lane_updates(lanes);
+  for (UpdateRecTable *update : updates) {
+    vector<UpdateRecTable *> lane_tables(lanes);
+    for (UpdateRequest *request : update->requests)
+      split_user_update(update, request, lane_tables);
+    update->requests.clear();
+    for (size_t lane=0; lane<lanes; lane++) {
+      if (lane_tables[lane])
+        lane_updates[lane].push_back(lane_tables[lane]);
+    }
+    delete update;
+  }
+
+  for (size_t lane=0; lane<lanes; lane++) {
+    if (!lane_updates[lane].empty()) {
+      UpdateContext *uc = new UpdateContext(lane_updates[lane], expire_time);
+      m_update_pipeline_user[lane]->add(uc);
+    }
+  }
+}
+
+
+namespace {
+
+  /// Returns update for <code>lane</code>, creating it from
+  /// <code>update</code> if necessary.
+  UpdateRecTable *lane_table(UpdateRecTable *update,
+                             vector<UpdateRecTable *> &lane_tables,
+                             size_t lane) {
+    if (lane_tables[lane] == 0) {
+      UpdateRecTable *lane_update = new UpdateRecTable();
+      lane_update->cluster_id = update->cluster_id;
+      lane_update->id = update->id;
+      lane_update->expire_time = update->expire_time;
+      lane_update->table_info = update->table_info;
+      lane_update->flags = update->flags;
+      lane_update->commit_interval = update->commit_interval;
+      lane_update->commit_time = update->commit_time;
+      lane_update->commit_delay = update->commit_delay;
+      lane_tables[lane] = lane_update;
+    }
+    return lane_tables[lane];
+  }
+
+  void add_request(UpdateRecTable *lane_update, UpdateRequest *request) {
+    lane_update->requests.push_back(request);
+    lane_update->total_count += request->count;
+    lane_update->total_buffer_size += request->buffer.size;
+  }
+
+}
+
+
+void
+Apps::RangeServer::split_user_update(UpdateRecTable *update,
+                                     UpdateRequest *request,
+                                     vector<UpdateRecTable *> &lane_tables) {
+  size_t lanes = lane_tables.size();
+
+  // A request without cells syncs the log, so every lane has to see it
+  if (request->buffer.size == 0) {
+    auto parts = make_shared<UpdateRequestParts>(lanes);
+    for (size_t lane=0; lane<lanes; lane++) {
+      UpdateRequest *part = new UpdateRequest();
+      part->event = request->event;
+      part->parts = parts;
+      add_request(lane_table(update, lane_tables, lane), part);
+    }
+    delete request;
+    return;
+  }
+
+  TableInfoPtr table_info = update->table_info;
+  if (!table_info)
+    m_context->live_map->lookup(update->id.id, table_info);
+
+  vector<vector<UpdateSegment>> segments(lanes);
+  vector<uint32_t> sizes(lanes);
+  vector<uint32_t> counts(lanes);
+  String start_row, end_row;
+  RangePtr range;
+  bool have_range {};
+  size_t lane {};
+  uint32_t total_count {};
+  SerializedKey key;
+  const uint8_t *mod = request->buffer.base;
+  const uint8_t *mod_end = request->buffer.base + request->buffer.size;
+
+  while (mod < mod_end) {
+    key.ptr = mod;
+    const char *row = key.row();
+    uint32_t count = 1;
+
+    if (*row == 0) {
+      // Corrupt buffer, leave the rest for the pipeline to reject
+      key.ptr = mod_end;
+      count = (request->count > total_count) ? request->count - total_count : 0;
+    }
+    else {
+      if (!have_range || strcmp(row, start_row.c_str()) <= 0 ||
+          strcmp(row, end_row.c_str()) > 0) {
+        // Cells outside of any range stay with the preceding cells
+        have_range = table_info &&
+          table_info->find_containing_range(row, range, start_row, end_row);
+        if (have_range)
+          lane = Global::user_lane(update->id.id, end_row.c_str());
+      }
+      key.next(); // skip key
+      key.next(); // skip value
+    }
+
+    uint32_t offset = mod - request->buffer.base;
+    uint32_t len = key.ptr - mod;
+    vector<UpdateSegment> &lane_segments = segments[lane];
+    if (!lane_segments.empty() &&
+        lane_segments.back().original_offset + lane_segments.back().len == offset)
+      lane_segments.back().len += len;
+    else
+      lane_segments.push_back({sizes[lane], offset, len});
+    sizes[lane] += len;
+    counts[lane] += count;
+    total_count += count;
+    mod = key.ptr;
+  }
+
+  size_t parts_needed = 0;
+  for (size_t i=0; i<lanes; i++) {
+    if (!segments[i].empty()) {
+      lane = i;
+      parts_needed++;
+    }
+  }
+
+  if (parts_needed == 1) {
+    add_request(lane_table(update, lane_tables, lane), request);
+    return;
+  }
+
+  auto parts = make_shared<UpdateRequestParts>(parts_needed);
+  for (size_t i=0; i<lanes; i++) {
+    if (segments[i].empty())
+      continue;
+    UpdateRequest *part = new UpdateRequest();
+    StaticBuffer buffer(sizes[i]);
+    for (auto &segment : segments[i])
+      memcpy(buffer.base + segment.offset,
+             request->buffer.base + segment.original_offset, segment.len);
+    part->buffer = buffer;
+    part->count = counts[i];
+    part->event = request->event;
+    part->parts = parts;
+    part->segments.swap(segments[i]);
+    add_request(lane_table(update, lane_tables, i), part);
+  }
+  delete request;
 }
 
 
@@ -2284,8 +2476,10 @@ void Apps::RangeServer::dump(ResponseCallback *cb, const char *outfile,
     if (Global::system_log)
       Global::system_log->get_stats("SYSTEM", str);
 
-    if (Global::user_log)
-      Global::user_log->get_stats("USER", str);
+    for (size_t lane=0; lane<Global::user_logs.size(); lane++) {
+      if (Global::user_logs[lane])
+        Global::user_logs[lane]->get_stats(lane ? format("USER.%u", (unsigned)lane) : "USER", str);
+    }
 
     out << str;
 
@@ -2800,6 +2994,26 @@ void
 
   m_ganglia_collector->update("requestBacklog",(int32_t)m_app_queue->backlog());
 
+  if (load_stats.sync_samples)
+    m_ganglia_collector->update("syncLatency",
+                                ((float)load_stats.sync_micros /
+                                 load_stats.sync_samples) / 1000.0);
+  else
+    m_ganglia_collector->update("syncLatency", (float)0.0);
+
+  if (load_stats.group_commit_batches) {
+    m_ganglia_collector->update("groupCommit.interval",
+                                ((float)load_stats.group_commit_delay_micros /
+                                 load_stats.group_commit_batches) / 1000.0);
+    m_ganglia_collector->update("groupCommit.batchSize",
+                                (float)load_stats.group_commit_updates /
+                                load_stats.group_commit_batches);
+  }
+  else {
+    m_ganglia_collector->update("groupCommit.interval", (float)0.0);
+    m_ganglia_collector->update("groupCommit.batchSize", (float)0.0);
+  }
+
   try {
     m_ganglia_collector->publish();
   }
@@ -3327,7 +3541,7 @@ void Apps::RangeServer::phantom_prepare_ranges(ResponseCallback *cb, int64_t op_
         }
       }
       else
-        log = Global::user_log;
+        log = Global::user_logs[Global::user_lane(rr.table.id, rr.range.end_row)];
 
       CommitLogReaderPtr phantom_log = phantom_range->get_phantom_log();
       HT_ASSERT(phantom_log && log);
@@ -3725,8 +3939,11 @@ Apps::RangeServer::group_commit_add(EventPtr &event, uint64_t cluster_id,
   if (!m_group_commit) {
     m_group_commit = std::make_shared<GroupCommit>(this);
     HT_ASSERT(!m_group_commit_timer_handler);
-    m_group_commit_timer_handler = make_shared<GroupCommitTimerHandler>(m_context->comm, this, m_app_queue);
+    m_group_commit_timer_handler = make_shared<GroupCommitTimerHandler>(m_context->comm, this, m_group_commit, m_app_queue);
     m_group_commit_timer_handler->start();
   }
-  m_group_commit->add(event, cluster_id, schema, table, count, buffer, flags);
+  ClockT::time_point commit_time =
+    m_group_commit->add(event, cluster_id, schema, table, count, buffer, flags);
+  if (commit_time != ClockT::time_point())
+    m_group_commit_timer_handler->schedule(commit_time);
 }
@@ -235,11 +235,36 @@ namespace Apps {
                            MetaLogEntityRangePtr &range_entity);
     void replay_log(TableInfoMap &replay_map, CommitLogReaderPtr &log_reader);
 
+    /// Creates commit log and update pipeline of each USER update lane.
+    /// @param log_reader Reader of replayed USER commit log, or nullptr
+    void create_user_lanes(CommitLogReaderPtr &log_reader);
+
     void verify_schema(TableInfoPtr &, uint32_t generation, const TableSchemaMap *table_schemas=0);
 
     bool live(const vector<QualifiedRangeSpec> &ranges);
     bool live(const QualifiedRangeSpec &spec);
 
+    /// Adds USER table updates to the update pipelines of their lanes.
+    /// Each request is added to the lane of the ranges its cells belong to
+    /// (see Global::user_lane()).  A request with cells in more than one
+    /// lane is split with split_user_update().
+    /// @param updates USER table updates
+    /// @param expire_time Expiration time of updates
+    void add_user_updates(std::vector<UpdateRecTable *> &updates,
+                          ClockT::time_point expire_time);
+
+    /// Assigns update request to lanes.
+    /// If all cells of <code>request</code> belong to ranges of one lane, the
+    /// request is added to that lane's update.  Otherwise it is replaced
+    /// by one part per lane, holding copies of the lane's cells, that share
+    /// an UpdateRequestParts object so that the client gets one response.
+    /// A request without cells is a log sync and is sent to every lane.
+    /// @param update Update that holds <code>request</code>
+    /// @param request Request to assign
+    /// @param lane_tables Per-lane updates, created on demand
+    void split_user_update(UpdateRecTable *update, UpdateRequest *request,
+                           std::vector<UpdateRecTable *> &lane_tables);
+
     void group_commit_add(EventPtr &event, uint64_t cluster_id,
                           SchemaPtr &schema, const TableIdentifier &table,
                           uint32_t count, StaticBuffer &buffer, uint32_t flags);
@@ -265,8 +290,9 @@ namespace Apps {
     /// Update pipeline for other (non-METADATA) system tables
     UpdatePipelinePtr m_update_pipeline_system;
 
-    /// Update pipeline for USER tables
-    UpdatePipelinePtr m_update_pipeline_user;
+    /// Update pipelines for USER tables, one per update lane
+    /// (see Global::user_lane())
+    std::vector<UpdatePipelinePtr> m_update_pipeline_user;
 
     /// Flush method for METADATA commit log updates
     Filesystem::Flags m_log_flush_method_meta {};
@@ -328,6 +354,8 @@ namespace Apps {
     GroupCommitTimerHandlerPtr m_group_commit_timer_handler;
     QueryCachePtr m_query_cache;
     int64_t m_scanner_buffer_size {};
+    size_t m_scanner_zero_copy_threshold {};
+    size_t m_replay_threads {};
     time_t m_last_metrics_update {};
     time_t m_next_metrics_update {};
     double m_loadavg_accum {};
@@ -24,6 +24,7 @@
 
 #include <Hypertable/Lib/ProfileDataScanner.h>
 
+#include <AsyncComm/GatherBuffer.h>
 #include <AsyncComm/ResponseCallback.h>
 
 #include <boost/shared_array.hpp>
@@ -48,6 +49,10 @@ namespace Callback {
     int response(int32_t id, int32_t skipped_rows, int32_t skipped_cells,
                  bool more, ProfileDataScanner &profile_data,
                  boost::shared_array<uint8_t> &ext_buffer, uint32_t ext_len);
+
+    int response(int32_t id, int32_t skipped_rows, int32_t skipped_cells,
+                 bool more, ProfileDataScanner &profile_data,
+                 GatherBufferPtr &gather);
   };
 
   /// @}
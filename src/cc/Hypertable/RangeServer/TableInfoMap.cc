@@ -119,7 +119,7 @@ void TableInfoMap::promote_staged_range(const TableIdentifier &table, RangePtr &
       else if (table.is_system())
         log = Global::system_log;
       else
-        log = Global::user_log;
+        log = Global::user_logs[Global::user_lane(table.id, range->end_row().c_str())];
 
       range->replay_transfer_log(commit_log_reader.get());
 
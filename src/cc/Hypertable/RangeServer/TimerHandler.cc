@@ -106,7 +106,7 @@ void TimerHandler::maintenance_scheduled_notify() {
   m_last_schedule = std::chrono::steady_clock::now();
 
   if (m_range_server->replay_finished()) {
-    if (Global::user_log && Global::user_log->size()>m_userlog_size_threshold) {
+    if (user_log_too_large()) {
       if (!m_app_queue_paused)
         pause_app_queue();
     }
@@ -162,7 +162,7 @@ void TimerHandler::handle(Hypertable::EventPtr &event) {
     }
     else {
       m_low_memory_mode = false;
-      if (Global::user_log && Global::user_log->size()>m_userlog_size_threshold)
+      if (user_log_too_large())
         pause_app_queue();
     }
   }
@@ -229,6 +229,14 @@ void TimerHandler::restart_app_queue() {
   m_range_server->write_profile_data(ss.str());
 }
 
+bool TimerHandler::user_log_too_large() {
+  for (auto &log : Global::user_logs) {
+    if (log && log->size() > m_userlog_size_threshold)
+      return true;
+  }
+  return false;
+}
+
 bool TimerHandler::low_memory() {
   int64_t memory_used = Global::memory_tracker->balance();
   bool low_physical_memory = false;
@@ -220,6 +220,11 @@ namespace Hypertable {
     /// Checks for low memory.
     /// @return <i>true</i> if low on memory, <i>false</i> otherwise.
     bool low_memory();
+
+    /// Checks for too much unpruned USER commit log.
+    /// @return <i>true</i> if any USER commit log lane is larger than
+    /// #m_userlog_size_threshold, <i>false</i> otherwise.
+    bool user_log_too_large();
   };
 
   /// Smart pointer to TimerHandler
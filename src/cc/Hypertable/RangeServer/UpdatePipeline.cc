@@ -21,7 +21,7 @@
 
 /// @file
 /// Definitions for UpdatePipeline.
-/// This file contains type definitions for UpdatePipeline, a three-staged,
+/// This file contains type definitions for UpdatePipeline, a four-staged,
 /// multithreaded update pipeline.
 
 #include <Common/Compat.h>
@@ -58,8 +58,9 @@ UpdatePipeline::UpdatePipeline(ContextPtr &context, QueryCachePtr &query_cache,
   m_maintenance_pause_interval = m_context->props->get_i32("Hypertable.RangeServer.Testing.MaintenanceNeeded.PauseInterval");
   m_update_delay = m_context->props->get_i32("Hypertable.RangeServer.UpdateDelay", 0);
   m_max_clock_skew = m_context->props->get_i32("Hypertable.RangeServer.ClockSkew.Max");
-  m_threads.reserve(3);
+  m_threads.reserve(4);
   m_threads.push_back( thread(&UpdatePipeline::qualify_and_transform, this) );
+  m_threads.push_back( thread(&UpdatePipeline::compress, this) );
   m_threads.push_back( thread(&UpdatePipeline::commit, this) );
   m_threads.push_back( thread(&UpdatePipeline::add_and_respond, this) );
 }
@@ -75,6 +76,7 @@ void UpdatePipeline::add(UpdateContext *uc) {
 void UpdatePipeline::shutdown() {
   m_shutdown = true;
   m_qualify_queue_cond.notify_all();
+  m_compress_queue_cond.notify_all();
   m_commit_queue_cond.notify_all();
   m_response_queue_cond.notify_all();
   for (std::thread &t : m_threads)
@@ -503,12 +505,56 @@ void UpdatePipeline::qualify_and_transform() {
 
     uc->last_revision = m_last_revision;
 
+    // Enqueue update
+    {
+      lock_guard<std::mutex> lock(m_compress_queue_mutex);
+      m_compress_queue.push_back(uc);
+      m_compress_queue_cond.notify_all();
+      m_commit_queue_count++;
+    }
+  }
+}
+
+void UpdatePipeline::compress() {
+  UpdateContext *uc;
+  int error = Error::OK;
+
+  while (true) {
+
+    // Dequeue next update
+    {
+      unique_lock<std::mutex> lock(m_compress_queue_mutex);
+      m_compress_queue_cond.wait(lock, [this](){
+          return !m_compress_queue.empty() || m_shutdown; });
+      if (m_shutdown)
+        return;
+      uc = m_compress_queue.front();
+      m_compress_queue.pop_front();
+    }
+
+    // Compress valid (go) mutations into commit log blocks
+    for (UpdateRecTable *table_update : uc->updates) {
+      if (table_update->error == Error::OK &&
+          (table_update->flags & Lib::RangeServer::Protocol::UPDATE_FLAG_NO_LOG) == 0 &&
+          table_update->go_buf.ptr > table_update->go_buf.mark) {
+        if ((error = m_log->compress_block(ClusterId::get(), table_update->go_buf,
+                                           uc->last_revision,
+                                           table_update->go_zblock)) != Error::OK) {
+          table_update->error_msg = format("Problem compressing %d bytes for commit log (%s) - %s",
+                                           (int)table_update->go_buf.fill(),
+                                           m_log->get_log_dir().c_str(),
+                                           Error::get_text(error));
+          HT_ERRORF("%s", table_update->error_msg.c_str());
+          table_update->error = error;
+        }
+      }
+    }
+
     // Enqueue update
     {
       lock_guard<std::mutex> lock(m_commit_queue_mutex);
       m_commit_queue.push_back(uc);
       m_commit_queue_cond.notify_all();
-      m_commit_queue_count++;
     }
   }
 }
@@ -577,11 +623,10 @@ void UpdatePipeline::commit() {
       if ((table_update->flags & NO_LOG_SYNC_FLAGS) == 0)
         log_needs_syncing = true;
 
-      // Commit valid (go) mutations
-      if ((table_update->flags & Lib::RangeServer::Protocol::UPDATE_FLAG_NO_LOG) == 0 &&
-          table_update->go_buf.ptr > table_update->go_buf.mark) {
+      // Commit valid (go) mutations, compressed in previous stage
+      if (table_update->go_zblock.fill()) {
 
-        if ((error = m_log->write(ClusterId::get(), table_update->go_buf, uc->last_revision, Filesystem::Flags::NONE)) != Error::OK) {
+        if ((error = m_log->append_block(table_update->go_zblock, uc->last_revision)) != Error::OK) {
           table_update->error_msg = format("Problem writing %d bytes to commit log (%s) - %s",
                                            (int)table_update->go_buf.fill(),
                                            m_log->get_log_dir().c_str(),
@@ -605,8 +650,31 @@ void UpdatePipeline::commit() {
     else if (!coalesce_queue.empty())
       do_sync = true;
 
+    coalesce_queue.push_back(uc);
+
+    auto sync_start = chrono::steady_clock::now();
+
+    // Wait for outstanding appends.  A failed append cannot be recovered by
+    // syncing, so fail every update in the group that wrote to the log.
+    if ((error = m_log->wait_for_appends()) != Error::OK) {
+      HT_ERRORF("Problem appending to commit log (%s) - %s",
+                m_log->get_log_dir().c_str(), Error::get_text(error));
+      for (UpdateContext *failed_uc : coalesce_queue) {
+        for (UpdateRecTable *table_update : failed_uc->updates) {
+          if (table_update->error == Error::OK &&
+              (table_update->flags & Lib::RangeServer::Protocol::UPDATE_FLAG_NO_LOG) == 0 &&
+              table_update->go_buf.ptr > table_update->go_buf.mark) {
+            table_update->error = error;
+            table_update->error_msg = format("Problem writing %d bytes to commit log (%s) - %s",
+                                             (int)table_update->go_buf.fill(),
+                                             m_log->get_log_dir().c_str(),
+                                             Error::get_text(error));
+          }
+        }
+      }
+    }
     // Now sync the commit log if needed
-    if (do_sync) {
+    else if (do_sync) {
       size_t retry_count {};
       uc->total_syncs++;
 
@@ -631,12 +699,15 @@ void UpdatePipeline::commit() {
         else
           break;
       }
+
+      // Record time to get group onto stable storage, for group commit
+      if (error == Error::OK && m_flags != Filesystem::Flags::NONE)
+        Global::load_statistics->add_sync_time(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - sync_start).count());
     }
 
     // Enqueue update
     {
       lock_guard<std::mutex> lock(m_response_queue_mutex);
-      coalesce_queue.push_back(uc);
       while (!coalesce_queue.empty()) {
         uc = coalesce_queue.front();
         coalesce_queue.pop_front();
@@ -651,7 +722,6 @@ void UpdatePipeline::commit() {
 void UpdatePipeline::add_and_respond() {
   UpdateContext *uc;
   SerializedKey key;
-  int error = Error::OK;
 
   while (true) {
 
@@ -764,46 +834,18 @@ void UpdatePipeline::add_and_respond() {
       }
 
       for (UpdateRequest *request : table_update->requests) {
-	Response::Callback::Update cb(m_context->comm, request->event);
-
-        if (table_update->error != Error::OK) {
-          if ((error = cb.error(table_update->error, table_update->error_msg)) != Error::OK)
-            HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
-          continue;
-        }
-
-        if (request->error == Error::OK) {
-          /**
-           * Send back response
-           */
-          if (!request->send_back_vector.empty()) {
-            StaticBuffer ext(new uint8_t [request->send_back_vector.size() * 16],
-                             request->send_back_vector.size() * 16);
-            uint8_t *ptr = ext.base;
-            for (size_t i=0; i<request->send_back_vector.size(); i++) {
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].error);
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].count);
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].offset);
-              Serialization::encode_i32(&ptr, request->send_back_vector[i].len);
-              /*
-                HT_INFOF("Sending back error %x, count %d, offset %d, len %d, table id %s",
-                request->send_back_vector[i].error, request->send_back_vector[i].count,
-                request->send_back_vector[i].offset, request->send_back_vector[i].len,
-                table_update->id.id);
-              */
-            }
-            if ((error = cb.response(ext)) != Error::OK)
-              HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
-          }
-          else {
-            if ((error = cb.response_ok()) != Error::OK)
-              HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
-          }
-        }
-        else {
-          if ((error = cb.error(request->error, "")) != Error::OK)
-            HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+        int32_t error = table_update->error;
+        const std::string &error_msg = table_update->error_msg;
+        if (error == Error::OK)
+          error = request->error;
+        if (request->parts) {
+          if (request->parts->add(request, error, error_msg))
+            respond(request->event, request->parts->error,
+                    request->parts->error_msg,
+                    request->parts->send_back_vector);
         }
+        else
+          respond(request->event, error, error_msg, request->send_back_vector);
       }
 
     }
@@ -823,6 +865,40 @@ void UpdatePipeline::add_and_respond() {
 }
 
 
+void UpdatePipeline::respond(EventPtr &event, int32_t error,
+                             const std::string &error_msg,
+                             std::vector<SendBackRec> &send_back_vector) {
+  Response::Callback::Update cb(m_context->comm, event);
+
+  if (error != Error::OK) {
+    if ((error = cb.error(error, error_msg)) != Error::OK)
+      HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+    return;
+  }
+
+  /**
+   * Send back response
+   */
+  if (!send_back_vector.empty()) {
+    StaticBuffer ext(new uint8_t [send_back_vector.size() * 16],
+                     send_back_vector.size() * 16);
+    uint8_t *ptr = ext.base;
+    for (size_t i=0; i<send_back_vector.size(); i++) {
+      Serialization::encode_i32(&ptr, send_back_vector[i].error);
+      Serialization::encode_i32(&ptr, send_back_vector[i].count);
+      Serialization::encode_i32(&ptr, send_back_vector[i].offset);
+      Serialization::encode_i32(&ptr, send_back_vector[i].len);
+    }
+    if ((error = cb.response(ext)) != Error::OK)
+      HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+  }
+  else {
+    if ((error = cb.response_ok()) != Error::OK)
+      HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+  }
+}
+
+
 void
 UpdatePipeline::transform_key(ByteString &bskey, DynamicBuffer *dest_bufp,
                               int64_t auto_revision, int64_t *revisionp,
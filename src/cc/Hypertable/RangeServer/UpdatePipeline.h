@@ -21,7 +21,7 @@
 
 /// @file
 /// Declarations for UpdatePipeline.
-/// This file contains type declarations for UpdatePipeline, a three-staged,
+/// This file contains type declarations for UpdatePipeline, a four-staged,
 /// multithreaded update pipeline.
 
 #ifndef Hypertable_RangeServer_UpdatePipeline_h
@@ -38,6 +38,7 @@
 #include <Common/DynamicBuffer.h>
 #include <Common/Filesystem.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
@@ -48,7 +49,7 @@ namespace Hypertable {
   /// @addtogroup RangeServer
   /// @{
 
-  /// Three-staged, multithreaded update pipeline.
+  /// Four-staged, multithreaded update pipeline.
   class UpdatePipeline {
   public:
 
@@ -63,9 +64,9 @@ namespace Hypertable {
     ///     <code>Hypertable.RangeServer.UpdateDelay</code> property.
     ///   - Sets #m_max_clock_skew to the value of the
     ///     <code>Hypertable.RangeServer.ClockSkew.Max</code> property.
-    ///   - Creates and starts the three pipeline threads using
-    ///     qualify_and_transform(), commit(), and add_and_respond() as the
-    ///     thread functions, respectively.
+    ///   - Creates and starts the four pipeline threads using
+    ///     qualify_and_transform(), compress(), commit(), and
+    ///     add_and_respond() as the thread functions, respectively.
     /// @param context %Range server context
     /// @param query_cache Query cache
     /// @param timer_handler Timer handler
@@ -79,7 +80,7 @@ namespace Hypertable {
     void add(UpdateContext *uc);
 
     /// Shuts down the pipeline
-    /// Sets #m_shutdown to <i>true</i>, signals the three pipeline condition
+    /// Sets #m_shutdown to <i>true</i>, signals the four pipeline condition
     /// variables, and performs a join on each pipeline thread.
     void shutdown();
 
@@ -93,31 +94,52 @@ namespace Hypertable {
     ///     this range server.
     ///   - Transforms each key with a call to transform_key().
     ///   - Buffers the key/value pairs for downstream processing.
-    ///   - Adds the UpdateContext objects to #m_commit_queue and signals
-    ///     #m_commit_queue_cond.
+    ///   - Adds the UpdateContext objects to #m_compress_queue and signals
+    ///     #m_compress_queue_cond.
     void qualify_and_transform();
 
     /// Thread function for stage 2 of update pipeline.
+    /// For each UpdateContext object on the input queue #m_compress_queue,
+    /// this function compresses the key/value pairs destined for the commit
+    /// log into a commit log block with CommitLog::compress_block() and then
+    /// adds the UpdateContext object to #m_commit_queue and signals
+    /// #m_commit_queue_cond.  This allows compression of the next batch of
+    /// updates to overlap the commit log round trips of the current one.
+    void compress();
+
+    /// Thread function for stage 3 of update pipeline.
     /// For each UpdateContext object on the input queue #m_commit_queue, this
     /// function does the following:
-    ///   - Writes the key/value pairs that were buffered in the previous stage
-    ///     to the appropriate
-    ///     commit log (or transfer log) <b>without</b> calling sync().
+    ///   - Writes the transferring key/value pairs that were buffered in
+    ///     stage 1 to the appropriate transfer log.
+    ///   - Issues an asynchronous append of the block compressed in the
+    ///     previous stage to the commit log <b>without</b> calling sync().
     ///   - Once either #m_update_coalesce_limit amount of updates has been
-    ///     collected or when #m_qualify_queue becomes empty, sync() is called
-    ///     on the commit (or transfer) log.
-    ///   - Adds the UpdateContext objects to #m_response_queue and signals
-    ///     #m_response_queue_cond.
+    ///     collected or when no more updates are queued, waits for the
+    ///     outstanding appends and calls sync() on the commit log.
+    ///   - Adds the UpdateContext objects to #m_response_queue, in the
+    ///     order they were received, and signals #m_response_queue_cond.
     void commit();
 
-    /// Thread function for stage 3 of update pipeline.
+    /// Thread function for stage 4 of update pipeline.
     /// For each UpdateContext object on the input queue #m_response_queue, this
     /// function does the following:
     ///   - Adds the key/value pairs that were commited in the previous state to
     ///     their appropriate ranges
-    ///   - Sends back a response to the originating requests
+    ///   - Sends back a response to the originating requests.  Requests
+    ///     split across lanes are answered once, by the last part to get here
+    ///     (see UpdateRequestParts)
     void add_and_respond();
 
+    /// Sends response to update request.
+    /// @param event Event of originating request
+    /// @param error Error code that applies to entire request
+    /// @param error_msg Error message accompanying <code>error</code>
+    /// @param send_back_vector Key/value pairs rejected due to error
+    void respond(EventPtr &event, int32_t error,
+                 const std::string &error_msg,
+                 std::vector<SendBackRec> &send_back_vector);
+
     void transform_key(ByteString &bskey, DynamicBuffer *dest_bufp,
                        int64_t revision, int64_t *revisionp,
                        bool timeorder_desc);
@@ -144,24 +166,33 @@ namespace Hypertable {
     std::list<UpdateContext *> m_qualify_queue;
 
     /// %Mutex protecting stage 2 input queue
-    std::mutex m_commit_queue_mutex;
+    std::mutex m_compress_queue_mutex;
 
     /// Condition variable signaling addition to stage 2 input queue
+    std::condition_variable m_compress_queue_cond;
+
+    /// Stage 2 input queue
+    std::list<UpdateContext *> m_compress_queue;
+
+    /// %Mutex protecting stage 3 input queue
+    std::mutex m_commit_queue_mutex;
+
+    /// Condition variable signaling addition to stage 3 input queue
     std::condition_variable m_commit_queue_cond;
 
-    /// Count of objects in stage 2 input queue
-    int32_t m_commit_queue_count {};
+    /// Count of objects in stage 2 and stage 3 input queues
+    std::atomic<int32_t> m_commit_queue_count {};
 
-    /// Stage 2 input queue
+    /// Stage 3 input queue
     std::list<UpdateContext *> m_commit_queue;
 
-    /// %Mutex protecting stage 3 input queue
+    /// %Mutex protecting stage 4 input queue
     std::mutex m_response_queue_mutex;
 
-    /// Condition variable signaling addition to stage 3 input queue
+    /// Condition variable signaling addition to stage 4 input queue
     std::condition_variable m_response_queue_cond;
 
-    /// Stage 3 input queue
+    /// Stage 4 input queue
     std::list<UpdateContext *> m_response_queue;
 
     /// Update pipeline threads
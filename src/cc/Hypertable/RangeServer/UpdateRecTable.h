@@ -64,13 +64,18 @@ namespace Hypertable {
     TableInfoPtr table_info;
     std::unordered_map<Range *, UpdateRecRangeList *> range_map;
     DynamicBuffer go_buf;
+    /// Commit log block compressed from <code>go_buf</code>
+    DynamicBuffer go_zblock;
     uint64_t total_count {};
     uint64_t total_buffer_size {};
     std::string error_msg;
     int32_t error {};
     uint32_t flags {};
     uint32_t commit_interval {};
-    uint32_t commit_iteration {};
+    /// Time at which group commit commits these updates
+    ClockT::time_point commit_time;
+    /// Delay (microseconds) chosen by group commit for these updates
+    int64_t commit_delay {};
     uint32_t transfer_count {};
     uint32_t total_added {};
   };
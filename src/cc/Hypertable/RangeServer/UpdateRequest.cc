@@ -0,0 +1,97 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/// @file
+/// Definitions for UpdateRequestParts.
+/// This file contains type definitions for UpdateRequestParts, a class that
+/// combines the responses of an update request split across update pipeline
+/// lanes.
+
+#include <Common/Compat.h>
+
+#include "UpdateRequest.h"
+
+#include <Common/ByteString.h>
+#include <Common/Error.h>
+
+#include <algorithm>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /// Returns number of key/value pairs in <code>[ptr, end)</code>.
+  uint32_t count_cells(const uint8_t *ptr, const uint8_t *end) {
+    ByteString bs(ptr);
+    uint32_t count = 0;
+    while (bs.ptr < end) {
+      bs.next(); // skip key
+      bs.next(); // skip value
+      count++;
+    }
+    return count;
+  }
+
+}
+
+bool UpdateRequestParts::add(UpdateRequest *part, int32_t error,
+                             const string &error_msg) {
+  lock_guard<mutex> lock(m_mutex);
+
+  if (error != Error::OK) {
+    if (this->error == Error::OK) {
+      this->error = error;
+      this->error_msg = error_msg;
+    }
+  }
+  else {
+    // Translate rejected runs back to the original buffer, one record per
+    // segment they overlap
+    for (auto &rec : part->send_back_vector) {
+      uint32_t rec_end = rec.offset + rec.len;
+      for (auto &segment : part->segments) {
+        uint32_t lo = std::max(rec.offset, segment.offset);
+        uint32_t hi = std::min(rec_end, segment.offset + segment.len);
+        if (lo >= hi)
+          continue;
+        SendBackRec translated;
+        translated.error = rec.error;
+        translated.offset = segment.original_offset + (lo - segment.offset);
+        translated.len = hi - lo;
+        if (lo == rec.offset && hi == rec_end)
+          translated.count = rec.count;
+        else
+          translated.count = count_cells(part->buffer.base + lo,
+                                         part->buffer.base + hi);
+        send_back_vector.push_back(translated);
+      }
+    }
+  }
+
+  if (--m_outstanding > 0)
+    return false;
+
+  sort(send_back_vector.begin(), send_back_vector.end(),
+       [](const SendBackRec &a, const SendBackRec &b) {
+         return a.offset < b.offset; });
+  return true;
+}
@@ -22,7 +22,8 @@
 /// @file
 /// Declarations for UpdateRequest.
 /// This file contains type declarations for UpdateRequest, a class representing
-/// a client update request.
+/// a client update request, and UpdateRequestParts, a class that combines the
+/// responses of a request split across update pipeline lanes.
 
 #ifndef Hypertable_RangeServer_UpdateRequest_h
 #define Hypertable_RangeServer_UpdateRequest_h
@@ -31,6 +32,9 @@
 
 #include <Common/StaticBuffer.h>
 
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace Hypertable {
@@ -50,6 +54,59 @@ namespace Hypertable {
     uint32_t len;
   };
 
+  /// Maps a run of key/value pairs in a split update buffer back to the
+  /// original buffer.
+  struct UpdateSegment {
+    /// Byte offset of run within split buffer
+    uint32_t offset;
+    /// Byte offset of run within original buffer
+    uint32_t original_offset;
+    /// Length (in bytes) of run
+    uint32_t len;
+  };
+
+  class UpdateRequest;
+
+  /// Combines responses of an update request split across lanes.
+  /// When the cells of a USER table update request belong to ranges in
+  /// different update pipeline lanes (see Global::user_lane()), the request
+  /// is split into one UpdateRequest per lane, all sharing one object of this
+  /// class.  As each lane finishes its part, add() records the part's error
+  /// or its rejected key/value pairs, translated back to offsets within the
+  /// original buffer, and the last part sends the single response.
+  class UpdateRequestParts {
+  public:
+
+    /// Constructor.
+    /// @param count Number of parts
+    UpdateRequestParts(size_t count) : m_outstanding(count) { }
+
+    /// Adds outcome of a part.
+    /// @param part Part of split request
+    /// @param error Error code that applies to entire part
+    /// @param error_msg Error message accompanying <code>error</code>
+    /// @return <i>true</i> if this was the last outstanding part, in which
+    /// case #error, #error_msg and #send_back_vector hold the combined result
+    bool add(UpdateRequest *part, int32_t error, const std::string &error_msg);
+
+    /// First error that applies to an entire part
+    int32_t error {};
+
+    /// Message accompanying #error
+    std::string error_msg;
+
+    /// Rejected key/value pairs of all parts, in original buffer offsets
+    std::vector<SendBackRec> send_back_vector;
+
+  private:
+
+    /// %Mutex serializing add()
+    std::mutex m_mutex;
+
+    /// Number of parts that have not been added
+    size_t m_outstanding;
+  };
+
   /// Holds client update request and error state.
   class UpdateRequest {
   public:
@@ -63,6 +120,11 @@ namespace Hypertable {
     std::vector<SendBackRec> send_back_vector;
     /// Error code that applies to entire buffer
     uint32_t error {};
+    /// Shared response state if this is part of a split request
+    std::shared_ptr<UpdateRequestParts> parts;
+    /// Runs of #buffer and their offsets within the original buffer, if
+    /// this is part of a split request
+    std::vector<UpdateSegment> segments;
   };
 
   /// @}
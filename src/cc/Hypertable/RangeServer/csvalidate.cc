@@ -240,10 +240,19 @@ namespace {
       quick_exit(EXIT_FAILURE);
     }
 
+    if ((BloomFilterMode)bloom_filter_mode == BLOOM_FILTER_ROW_PREFIX) {
+      cout << "Unsupported bloom filter type (BLOOM_FILTER_ROW_PREFIX)" << endl;
+      quick_exit(EXIT_FAILURE);
+    }
+
     HT_ASSERT((BloomFilterMode)bloom_filter_mode == BLOOM_FILTER_ROWS);
 
+    uint32_t flags = boost::any_cast<uint32_t>(state.trailer->get("flags"));
     state.bloom_filter = new BloomFilterWithChecksum(filter_items_actual, filter_items_actual,
-                                                     filter_length, bloom_filter_hash_count);
+                                                     filter_length, bloom_filter_hash_count,
+                                                     (flags & CellStoreTrailerV7::BLOOM_FILTER_BLOCKED) ?
+                                                     BloomFilterWithChecksum::BLOCKED :
+                                                     BloomFilterWithChecksum::STANDARD);
     memcpy(state.bloom_filter->base(), state.base+filter_offset, state.bloom_filter->total_size());
     try {
       state.bloom_filter->validate(state.fname);
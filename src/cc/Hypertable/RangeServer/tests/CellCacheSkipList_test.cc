@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellCacheAllocator.h>
+#include <Hypertable/RangeServer/CellCacheSkipList.h>
+#include <Hypertable/RangeServer/Global.h>
+#include <Hypertable/RangeServer/MemoryTracker.h>
+
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Stopwatch.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+struct MyPolicy : Config::Policy {
+  static void init_options() {
+    cmdline_desc("Usage: %s [Options] [<num_items>]\nOptions").add_options()
+      ("readers", i32()->default_value(4),
+       "number of concurrent scan threads")
+      ("seed", i32()->default_value(1234), "random seed")
+      ;
+    cmdline_hidden_desc().add_options()
+      ("items,n", i32()->default_value(200*K), "number of items")
+      ;
+    cmdline_positional_desc().add("items", -1);
+  }
+};
+
+typedef Meta::list<MyPolicy, DefaultPolicy> Policies;
+
+typedef pair<const SerializedKey, uint32_t> Value;
+typedef CellCacheAllocator<Value> Alloc;
+typedef map<const SerializedKey, uint32_t,
+            std::less<const SerializedKey>, Alloc> CellMap;
+
+#define SCAN_BATCH 1024
+
+#define MEASURE(_label_, _code_, _n_) do { \
+  Stopwatch w; _code_; w.stop(); \
+  cout << _label_ <<": "<< (_n_) / w.elapsed() <<"/s" << endl; \
+} while (0)
+
+/// Copies serialized key into arena, as CellCache::add does
+SerializedKey copy_key(CellCacheArena &arena, const uint8_t *key) {
+  const uint8_t *ptr = key;
+  size_t len = Serialization::decode_vi32(&ptr);
+  len += ptr - key;
+  uint8_t *copy = arena.alloc(len);
+  memcpy(copy, key, len);
+  return SerializedKey(copy);
+}
+
+struct CellCacheSkipListTest {
+  DynamicBuffer buf;
+  vector<size_t> offsets;
+
+  CellCacheSkipListTest(int nitems) {
+    char row[32];
+    // create_key_and_append() grows the buffer to the exact size needed
+    buf.reserve(nitems * 64);
+    for (int i=0; i<nitems; i++) {
+      sprintf(row, "%016lx", (unsigned long)random());
+      offsets.push_back(buf.fill());
+      create_key_and_append(buf, FLAG_INSERT, row, (i%4)+1, "qualifier",
+                            (int64_t)i, (int64_t)i);
+    }
+  }
+
+  const uint8_t *key(size_t i) { return buf.base + offsets[i]; }
+
+  size_t check_order(CellCacheSkipList &skiplist) {
+    size_t count = 0;
+    SerializedKey last;
+    for (auto iter = skiplist.begin(); iter != skiplist.end(); ++iter) {
+      if (count)
+        HT_ASSERT(last < (*iter).first);
+      last = (*iter).first;
+      count++;
+    }
+    return count;
+  }
+
+  void verify() {
+    CellCacheArena arena;
+    CellCacheSkipList skiplist(arena);
+    CellMap cell_map((std::less<const SerializedKey>()), Alloc(arena));
+
+    for (size_t i=0; i<offsets.size(); i++) {
+      SerializedKey k(key(i));
+      bool inserted = skiplist.insert(CellCacheSkipList::value_type(k, i)).second;
+      HT_ASSERT(inserted == cell_map.insert(Value(k, i)).second);
+      // duplicate inserts are rejected
+      HT_ASSERT(!skiplist.insert(CellCacheSkipList::value_type(k, i)).second);
+    }
+    HT_ASSERT(skiplist.size() == cell_map.size());
+
+    auto map_iter = cell_map.begin();
+    for (auto iter = skiplist.begin(); iter != skiplist.end();
+         ++iter, ++map_iter)
+      HT_ASSERT((*iter).first == map_iter->first &&
+                (*iter).second == map_iter->second);
+    HT_ASSERT(map_iter == cell_map.end());
+
+    for (size_t i=0; i<offsets.size(); i += 7) {
+      SerializedKey k(key(i));
+      auto map_iter = cell_map.lower_bound(k);
+      auto iter = skiplist.lower_bound(k);
+      HT_ASSERT((*iter).first == map_iter->first);
+    }
+    cout << "verified " << skiplist.size() << " keys" << endl;
+  }
+
+  void run_map(int nreaders) {
+    CellCacheArena arena;
+    CellMap cell_map((std::less<const SerializedKey>()), Alloc(arena));
+    mutex mtx;
+    size_t n = offsets.size();
+
+    cout << "std::map" << endl;
+
+    MEASURE("  insert", for (size_t i=0; i<n; ++i)
+      cell_map.insert(Value(copy_key(arena, key(i)), 0)), n);
+
+    size_t count = 0;
+    MEASURE("  scan", for (auto &v : cell_map) if (v.second == 0) ++count, n);
+    HT_ASSERT(count == n);
+
+    // Readers scan under the mutex in batches, as CellCacheScanner used to
+    CellCacheArena arena2;
+    CellMap cell_map2((std::less<const SerializedKey>()), Alloc(arena2));
+    atomic<bool> done(false);
+    atomic<size_t> scanned(0);
+    vector<thread> readers;
+    Stopwatch w;
+    for (int r=0; r<nreaders; r++)
+      readers.push_back(thread([&]() {
+            CellMap::iterator iter;
+            bool started = false;
+            while (!done) {
+              lock_guard<mutex> lock(mtx);
+              if (!started || iter == cell_map2.end()) {
+                iter = cell_map2.begin();
+                started = true;
+              }
+              for (size_t i=0; i<SCAN_BATCH && iter != cell_map2.end();
+                   ++i, ++iter)
+                ++scanned;
+            }
+          }));
+    for (size_t i=0; i<n; ++i) {
+      lock_guard<mutex> lock(mtx);
+      cell_map2.insert(Value(copy_key(arena2, key(i)), 0));
+    }
+    w.stop();
+    done = true;
+    for (auto &t : readers)
+      t.join();
+    cout << "  insert with " << nreaders << " scanners: " << n / w.elapsed()
+         << "/s, scanned " << scanned / w.elapsed() << " cells/s" << endl;
+  }
+
+  void run_skiplist(int nreaders) {
+    CellCacheArena arena;
+    CellCacheSkipList skiplist(arena);
+    size_t n = offsets.size();
+
+    cout << "CellCacheSkipList" << endl;
+
+    MEASURE("  insert", for (size_t i=0; i<n; ++i)
+      skiplist.insert(CellCacheSkipList::value_type(copy_key(arena, key(i)), 0)),
+      n);
+
+    size_t count = 0;
+    MEASURE("  scan", for (auto iter = skiplist.begin();
+                           iter != skiplist.end(); ++iter)
+              if ((*iter).second == 0) ++count, n);
+    HT_ASSERT(count == n);
+
+    // Writer holds the mutex, readers scan without it
+    CellCacheArena arena2;
+    CellCacheSkipList skiplist2(arena2);
+    mutex mtx;
+    atomic<bool> done(false);
+    atomic<size_t> scanned(0);
+    vector<thread> readers;
+    Stopwatch w;
+    for (int r=0; r<nreaders; r++)
+      readers.push_back(thread([&]() {
+            while (!done)
+              scanned += check_order(skiplist2);
+          }));
+    for (size_t i=0; i<n; ++i) {
+      lock_guard<mutex> lock(mtx);
+      skiplist2.insert(CellCacheSkipList::value_type(copy_key(arena2, key(i)), 0));
+    }
+    w.stop();
+    done = true;
+    for (auto &t : readers)
+      t.join();
+    HT_ASSERT(check_order(skiplist2) == n);
+    cout << "  insert with " << nreaders << " scanners: " << n / w.elapsed()
+         << "/s, scanned " << scanned / w.elapsed() << " cells/s" << endl;
+  }
+};
+
+} // local namespace
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    srandom(get_i32("seed"));
+
+    CellCacheSkipListTest test(get_i32("items"));
+
+    test.verify();
+    test.run_map(get_i32("readers"));
+    test.run_skiplist(get_i32("readers"));
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
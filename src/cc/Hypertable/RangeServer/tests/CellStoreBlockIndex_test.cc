@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/CellStoreBlockIndexArray.h>
+
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Stopwatch.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+struct MyPolicy : Config::Policy {
+  static void init_options() {
+    cmdline_desc("Usage: %s [Options] [<num_blocks>]\nOptions").add_options()
+      ("lookups", i32()->default_value(1000000), "number of lookups to time")
+      ("seed", i32()->default_value(1234), "random seed")
+      ;
+    cmdline_hidden_desc().add_options()
+      ("blocks,n", i32()->default_value(300000), "number of index entries")
+      ;
+    cmdline_positional_desc().add("blocks", -1);
+  }
+};
+
+typedef Meta::list<MyPolicy, DefaultPolicy> Policies;
+
+typedef CellStoreBlockIndexArray<int64_t> IndexT;
+
+struct BlockIndexTest {
+  DynamicBuffer keys;
+  vector<size_t> offsets;
+  DynamicBuffer probes;
+  vector<size_t> probe_offsets;
+
+  /// Generates <code>nblocks</code> sorted index keys with rows formed by
+  /// appending a random suffix to <code>row_prefix</code>, plus probe keys
+  /// that are a mix of exact index keys and keys falling between them
+  BlockIndexTest(int nblocks, int nprobes, const string &row_prefix) {
+    set<string> rows;
+    char buf[32];
+    while ((int)rows.size() < nblocks) {
+      sprintf(buf, "%08lx%08lx", (unsigned long)random(),
+              (unsigned long)random());
+      rows.insert(row_prefix + buf);
+    }
+    // create_key_and_append() grows the buffer to the exact size needed
+    keys.reserve(nblocks * (row_prefix.length() + 48));
+    for (auto &row : rows) {
+      offsets.push_back(keys.fill());
+      create_key_and_append(keys, FLAG_INSERT, row.c_str(), 1, "qualifier",
+                            (int64_t)0, (int64_t)0);
+    }
+    probes.reserve(nprobes * (row_prefix.length() + 48));
+    vector<string> sorted(rows.begin(), rows.end());
+    for (int i=0; i<nprobes; i++) {
+      string row = sorted[random() % sorted.size()];
+      if (i & 1)
+        row += "x";
+      probe_offsets.push_back(probes.fill());
+      create_key_and_append(probes, FLAG_INSERT, row.c_str(), 1, "qualifier",
+                            (int64_t)0, (int64_t)0);
+    }
+  }
+
+  void load(IndexT &index, bool prefix_layout) {
+    DynamicBuffer fixed(offsets.size() * sizeof(int64_t));
+    DynamicBuffer variable(keys.fill());
+    for (size_t i=0; i<offsets.size(); i++) {
+      int64_t offset = (int64_t)i * 65536;
+      fixed.add_unchecked(&offset, sizeof(offset));
+    }
+    variable.add_unchecked(keys.base, keys.fill());
+    index.set_prefix_layout(prefix_layout);
+    index.load(fixed, variable, (int64_t)offsets.size() * 65536);
+  }
+
+  SerializedKey probe(size_t i) {
+    return SerializedKey(probes.base + probe_offsets[i]);
+  }
+
+  /// Returns block offset referenced by <code>iter</code>, or -1 for end
+  int64_t offset(IndexT &index, IndexT::iterator iter) {
+    return iter == index.end() ? -1 : iter.value();
+  }
+
+  void verify(IndexT &array, IndexT &tree) {
+    for (size_t i=0; i<probe_offsets.size(); i++) {
+      HT_ASSERT(offset(array, array.lower_bound(probe(i))) ==
+                offset(tree, tree.lower_bound(probe(i))));
+      HT_ASSERT(offset(array, array.upper_bound(probe(i))) ==
+                offset(tree, tree.upper_bound(probe(i))));
+    }
+    // Keys before the first and after the last entry
+    DynamicBuffer buf;
+    create_key_and_append(buf, FLAG_INSERT, "", 1, "", (int64_t)0, (int64_t)0);
+    HT_ASSERT(tree.lower_bound(SerializedKey(buf.base)) == tree.begin());
+    buf.clear();
+    create_key_and_append(buf, FLAG_INSERT, "\xff\xff", 1, "", (int64_t)0,
+                          (int64_t)0);
+    HT_ASSERT(tree.lower_bound(SerializedKey(buf.base)) == tree.end());
+    HT_ASSERT(tree.upper_bound(SerializedKey(buf.base)) == tree.end());
+  }
+
+  double time_lookups(IndexT &index, int64_t *checksum) {
+    size_t n = probe_offsets.size();
+    int64_t sum = 0;
+    Stopwatch w;
+    for (size_t i=0; i<n; i++) {
+      IndexT::iterator iter = index.lower_bound(probe(i));
+      if (iter != index.end())
+        sum += iter.value();
+    }
+    w.stop();
+    *checksum = sum;
+    return (w.elapsed() * 1e9) / n;
+  }
+
+  void run(const string &label) {
+    IndexT array, tree;
+    load(array, false);
+    load(tree, true);
+
+    verify(array, tree);
+
+    int64_t array_sum, tree_sum;
+    double array_ns = time_lookups(array, &array_sum);
+    double tree_ns = time_lookups(tree, &tree_sum);
+    HT_ASSERT(array_sum == tree_sum);
+
+    cout << label << " (" << offsets.size() << " blocks)" << endl;
+    cout << "  sorted array:  " << array_ns << " ns/op, "
+         << array.memory_used() << " bytes" << endl;
+    cout << "  prefix layout: " << tree_ns << " ns/op, "
+         << tree.memory_used() << " bytes" << endl;
+  }
+};
+
+} // local namespace
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    srandom(get_i32("seed"));
+
+    {
+      BlockIndexTest test(get_i32("blocks"), get_i32("lookups"), "");
+      test.run("distinct prefixes");
+    }
+
+    // Every row shares a common prefix, which the prefix layout skips
+    {
+      BlockIndexTest test(get_i32("blocks"), get_i32("lookups"), "com.acme/");
+      test.run("shared prefix");
+    }
+
+    // Index small enough to stay in cache
+    {
+      BlockIndexTest test(get_i32("blocks")/100, get_i32("lookups"), "");
+      test.run("small index");
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
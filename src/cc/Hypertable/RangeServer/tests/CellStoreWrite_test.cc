@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include "../CellStoreFactory.h"
+#include "../CellStoreTrailerV7.h"
+#include "../CellStoreV7.h"
+#include "../Global.h"
+
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/Schema.h>
+
+#include <FsBroker/Lib/Client.h>
+
+#include <AsyncComm/ConnectionManager.h>
+#include <AsyncComm/ReactorFactory.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/InetAddr.h>
+#include <Common/Stopwatch.h>
+#include <Common/System.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+struct MyPolicy : Config::Policy {
+  static void init_options() {
+    cmdline_desc("Usage: %s [Options]\n\n"
+                 "Writes a CellStore with an increasing number of block\n"
+                 "compression workers, reports the write throughput and\n"
+                 "checks that every store written is byte-identical.\n\n"
+                 "Options").add_options()
+      ("cells", i32()->default_value(1000000), "number of cells to write")
+      ("compressor", str()->default_value("zlib --best"),
+       "block compression codec")
+      ("max-workers", i32()->default_value(4),
+       "maximum number of compression workers")
+      ("prefix-length", i32()->default_value(0),
+       "use a row prefix bloom filter with this prefix length and check "
+       "that it rules out absent prefixes (0 = row bloom filter)")
+      ("seed", i32()->default_value(1234), "random seed")
+      ;
+  }
+};
+
+typedef Meta::list<MyPolicy, DefaultPolicy> Policies;
+
+const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+struct CellStoreWriteTest {
+  DynamicBuffer keys;
+  vector<Key> keyv;
+  DynamicBuffer values;
+  vector<ByteString> valuev;
+  size_t input_bytes {};
+  /// Contents of first store written
+  String reference;
+
+  /// Generates <code>ncells</code> sorted cells with semi-compressible values
+  CellStoreWriteTest(int ncells) {
+    char row[32];
+    uint8_t value[128];
+    // create_key_and_append() grows the buffer to the exact size needed
+    keys.reserve(ncells * 64);
+    values.reserve(ncells * (sizeof(value) + 2));
+    for (int i=0; i<ncells; i++) {
+      sprintf(row, "row%012d", i);
+      size_t offset = keys.fill();
+      create_key_and_append(keys, FLAG_INSERT, row, 1, "qualifier",
+                            (int64_t)i+1, (int64_t)i+1);
+      keyv.push_back(Key(SerializedKey(keys.base + offset)));
+      for (size_t j=0; j<sizeof(value); j++)
+        value[j] = (random() % 4) ? 'a' + (j % 26) : (uint8_t)random();
+      offset = values.fill();
+      append_as_byte_string(values, value, sizeof(value));
+      valuev.push_back(ByteString(values.base + offset));
+      input_bytes += keyv.back().length + valuev.back().length();
+    }
+  }
+
+  void run(const String &csname, int workers) {
+    TableIdentifier table_id("0");
+    PropertiesPtr cs_props = make_shared<Properties>();
+    int prefix_length = get_i32("prefix-length");
+    if (prefix_length)
+      AccessGroupOptions::parse_bloom_filter(
+          format("prefix --prefix-length %d", prefix_length), cs_props);
+    else
+      AccessGroupOptions::parse_bloom_filter("rows", cs_props);
+    cs_props->set("compressor", get_str("compressor"));
+    SchemaPtr schema(Schema::new_instance(schema_str));
+
+    CellStorePtr cs = make_shared<CellStoreV7>(Global::dfs.get(), schema);
+    Stopwatch w;
+    cs->create(csname.c_str(), keyv.size(), cs_props, &table_id);
+    for (size_t i=0; i<keyv.size(); i++)
+      cs->add(keyv[i], valuev[i]);
+    cs->finalize(&table_id);
+    w.stop();
+
+    cout << "workers=" << workers << ": "
+         << (input_bytes / w.elapsed()) / (1024*1024) << " MB/s, "
+         << cs->get_total_entries() << " cells, "
+         << cs->compression_ratio() << " ratio" << endl;
+
+    // Read back and make sure every cell is there
+    cs = CellStoreFactory::open(csname, "", Key::END_ROW_MARKER);
+    ScanContextPtr scan_ctx = make_shared<ScanContext>(schema);
+    CellListScannerPtr scanner = cs->create_scanner(scan_ctx.get());
+    Key key;
+    ByteString value;
+    size_t count = 0;
+    while (scanner->get(key, value)) {
+      HT_ASSERT(strcmp(key.row, keyv[count].row) == 0);
+      HT_ASSERT(value.length() == valuev[count].length());
+      count++;
+      scanner->forward();
+    }
+    HT_ASSERT(count == keyv.size());
+
+    // Block boundaries must not depend on the number of workers
+    String contents = read_store(csname);
+    if (reference.empty())
+      reference = contents;
+    else
+      HT_ASSERT(contents == reference);
+
+    if (prefix_length)
+      check_prefix_filter(cs, schema, prefix_length);
+  }
+
+  /// Reads CellStore file with the creation time in its trailer cleared
+  String read_store(const String &csname) {
+    int64_t length = Global::dfs->length(csname);
+    String contents(length, '\0');
+    int fd = Global::dfs->open(csname, 0);
+    for (int64_t offset=0; offset<length; ) {
+      size_t nread = Global::dfs->read(fd, &contents[offset], length-offset);
+      HT_ASSERT(nread > 0);
+      offset += nread;
+    }
+    Global::dfs->close(fd);
+
+    CellStoreTrailerV7 trailer;
+    uint8_t *base = (uint8_t *)&contents[length - trailer.size()];
+    trailer.deserialize(base);
+    trailer.create_time = 0;
+    trailer.serialize(base);
+    return contents;
+  }
+
+  /// Checks that scans confined to one row prefix only match stores that
+  /// contain the prefix
+  void check_prefix_filter(CellStorePtr &cs, SchemaPtr &schema,
+                           int prefix_length) {
+    RangeSpec range;
+    range.start_row = "";
+    range.end_row = Key::END_ROW_MARKER;
+    ScanSpecBuilder ssbuilder;
+    size_t ruled_out = 0, false_positives = 0, checked = 0;
+
+    for (size_t i=0; i<keyv.size(); i += 997) {
+      String prefix(keyv[i].row, prefix_length);
+      for (int pass=0; pass<2; pass++) {
+        // Second pass checks a prefix that is not in the store
+        if (pass == 1)
+          prefix[0] = 'x';
+        ssbuilder.clear();
+        ssbuilder.add_row_interval(prefix, true, prefix + "\xff", true);
+        ScanContextPtr scan_ctx =
+          make_shared<ScanContext>(TIMESTAMP_MAX, &ssbuilder.get(), &range,
+                                   schema);
+        bool maybe = cs->may_contain(scan_ctx.get());
+        if (pass == 0)
+          HT_ASSERT(maybe);
+        else if (maybe)
+          false_positives++;
+        else
+          ruled_out++;
+      }
+      checked++;
+    }
+    // Allow for the false positive rate
+    HT_ASSERT(false_positives <= checked / 10);
+
+    // Scans spanning several prefixes cannot be ruled out
+    ssbuilder.clear();
+    ssbuilder.add_row_interval("x", true, "y", true);
+    ScanContextPtr scan_ctx =
+      make_shared<ScanContext>(TIMESTAMP_MAX, &ssbuilder.get(), &range, schema);
+    HT_ASSERT(cs->may_contain(scan_ctx.get()));
+
+    cout << "prefix bloom filter: " << ruled_out << " of " << checked
+         << " absent prefixes ruled out" << endl;
+  }
+};
+
+} // local namespace
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    System::initialize(System::locate_install_dir(argv[0]));
+    ReactorFactory::initialize(2);
+
+    srandom(get_i32("seed"));
+
+    struct sockaddr_in addr;
+    InetAddr::initialize(&addr, "localhost", get_i16("FsBroker.Port"));
+
+    ConnectionManagerPtr conn_mgr = make_shared<ConnectionManager>();
+    FsBroker::Lib::ClientPtr client =
+      make_shared<FsBroker::Lib::Client>(conn_mgr, addr, 15000);
+
+    Global::dfs = client;
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to DFS");
+      return 1;
+    }
+
+    Global::memory_tracker = new MemoryTracker(0, 0);
+
+    String testdir = "/CellStoreWrite_test";
+    client->mkdirs(testdir);
+
+    CellStoreWriteTest test(get_i32("cells"));
+
+    int max_workers = get_i32("max-workers");
+    test.run(testdir + "/cs0", 0);
+    for (int workers=1; workers<=max_workers; workers *= 2) {
+      CellStoreCompressionPool pool(workers);
+      Global::cellstore_compression_pool = &pool;
+      test.run(testdir + format("/cs%d", workers), workers);
+      Global::cellstore_compression_pool = 0;
+    }
+
+    // Stores written at the same time share the pool
+    if (max_workers > 0) {
+      CellStoreCompressionPool pool(max_workers);
+      Global::cellstore_compression_pool = &pool;
+      thread writer([&test, &testdir, max_workers]() {
+          test.run(testdir + "/shared1", max_workers);
+        });
+      test.run(testdir + "/shared0", max_workers);
+      writer.join();
+      Global::cellstore_compression_pool = 0;
+    }
+
+    client->rmdir(testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
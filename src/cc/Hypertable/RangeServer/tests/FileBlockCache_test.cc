@@ -73,6 +73,109 @@ namespace {
 #define MAX_FILE_ID 10
 #define MAX_FILE_OFFSET 100
 
+namespace {
+
+  /// Verifies that a sharded, segmented cache keeps a re-read working set
+  /// cached while a large scan streams through it
+  bool test_scan_resistance() {
+    const uint32_t block_size = 1000;
+    const int working_set = 100;
+    FileBlockCache cache(0, 400 * block_size, false, 4, 80);
+    uint8_t *block;
+    uint32_t length;
+
+    HT_ASSERT(cache.shard_count() == 4);
+
+    // Load and re-read working set (file 1) so it gets promoted
+    for (int i=0; i<working_set; i++) {
+      HT_ASSERT(cache.insert(1, i, new uint8_t [block_size], block_size,
+                             EventPtr(), false));
+      HT_ASSERT(cache.checkout(1, i, &block, &length));
+      cache.checkin(1, i);
+    }
+
+    // Scan (file 2) touches many more blocks than fit in the cache, once each
+    for (int i=0; i<10000; i++) {
+      if (!cache.checkout(2, i, &block, &length))
+        cache.insert(2, i, new uint8_t [block_size], block_size,
+                     EventPtr(), false);
+      else
+        cache.checkin(2, i);
+    }
+
+    for (int i=0; i<working_set; i++) {
+      if (!cache.contains(1, i)) {
+        HT_ERRORF("Working set block %d evicted by scan", i);
+        return false;
+      }
+    }
+
+    uint64_t max_memory, available, accesses, hits, total_accesses = 0;
+    uint64_t shard_accesses, shard_hits;
+    int64_t protected_bytes;
+    cache.get_stats(&max_memory, &available, &accesses, &hits);
+    for (size_t i=0; i<cache.shard_count(); i++) {
+      cache.get_shard_stats(i, &shard_accesses, &shard_hits, &protected_bytes);
+      total_accesses += shard_accesses;
+    }
+    HT_ASSERT(total_accesses == accesses);
+    HT_ASSERT(max_memory - available <= 400 * block_size);
+    return true;
+  }
+
+  /// Verifies that the shard count is reduced so that blocks of the minimum
+  /// shard size can still be cached
+  bool test_min_shard_memory() {
+    const uint32_t block_size = 300000;
+    FileBlockCache cache(0, 1000000, false, 16, 80, 400000);
+
+    HT_ASSERT(cache.shard_count() == 2);
+
+    for (int i=0; i<8; i++) {
+      if (!cache.insert(1, i, new uint8_t [block_size], block_size,
+                        EventPtr(), false)) {
+        HT_ERRORF("Block %d (%u bytes) not cacheable", i, block_size);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Verifies that pinning a block holds it in the cache without promoting
+  /// it to the protected segment
+  bool test_pin() {
+    const uint32_t block_size = 1000;
+    FileBlockCache cache(0, 10 * block_size, false, 1, 50);
+    uint64_t accesses, hits;
+    int64_t protected_bytes;
+    uint8_t *block;
+    uint32_t length;
+
+    HT_ASSERT(!cache.pin(1, 0));
+    HT_ASSERT(cache.insert(1, 0, new uint8_t [block_size], block_size,
+                           EventPtr(), false));
+    HT_ASSERT(cache.pin(1, 0, &block, &length) && length == block_size);
+
+    for (int i=1; i<=20; i++)
+      cache.insert(2, i, new uint8_t [block_size], block_size,
+                   EventPtr(), false);
+
+    cache.get_shard_stats(0, &accesses, &hits, &protected_bytes);
+    if (!cache.contains(1, 0) || protected_bytes != 0) {
+      HT_ERROR("Pinned block evicted or promoted");
+      return false;
+    }
+
+    cache.unpin(1, 0);
+    HT_ASSERT(cache.checkout(1, 0, &block, &length));
+    cache.checkin(1, 0);
+    cache.get_shard_stats(0, &accesses, &hits, &protected_bytes);
+    HT_ASSERT(protected_bytes == block_size);
+    return true;
+  }
+
+}
+
 int main(int argc, char **argv) {
   FileBlockCache *cache;
   vector<BufferRecord> input_data;
@@ -176,5 +279,14 @@ int main(int argc, char **argv) {
 
   delete cache;
 
+  if (!test_scan_resistance())
+    return 1;
+
+  if (!test_min_shard_memory())
+    return 1;
+
+  if (!test_pin())
+    return 1;
+
   return 0;
 }
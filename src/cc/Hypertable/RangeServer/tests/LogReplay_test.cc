@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include "../CellCache.h"
+#include "../LogReplayer.h"
+
+#include <Hypertable/Lib/CommitLog.h>
+#include <Hypertable/Lib/CompressorFactory.h>
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Stopwatch.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+struct MyPolicy : Config::Policy {
+  static void init_options() {
+    cmdline_desc("Usage: %s [Options]\n\n"
+                 "Replays a synthetic commit log into CellCaches with an\n"
+                 "increasing number of replay threads, checks that cells for\n"
+                 "each range arrive in log order and reports the replay\n"
+                 "throughput.\n\n"
+                 "Options").add_options()
+      ("block-cells", i32()->default_value(2000),
+       "number of cells per commit log block")
+      ("cells", i32()->default_value(1000000), "number of cells to replay")
+      ("compressor", str()->default_value("quicklz"),
+       "commit log block compression codec")
+      ("max-threads", i32()->default_value(8),
+       "maximum number of replay threads")
+      ("ranges", i32()->default_value(64), "number of ranges")
+      ("seed", i32()->default_value(1234), "random seed")
+      ;
+  }
+};
+
+typedef Meta::list<MyPolicy, DefaultPolicy> Policies;
+
+const char *row_format = "row%010d";
+
+/// Range stand-in that checks cells arrive in revision order
+class CacheTarget : public LogReplayer::Target {
+public:
+  void add(const Key &key, const ByteString value) override {
+    HT_ASSERT(key.revision > last_revision);
+    last_revision = key.revision;
+    cache.add(key, value);
+    count++;
+  }
+  CellCache cache;
+  int64_t last_revision {};
+  size_t count {};
+};
+
+/// Maps row numbers onto equally sized ranges
+class CacheRouter : public LogReplayer::Router {
+public:
+  CacheRouter(int rows, int ranges) : m_span(rows / ranges) {
+    for (int i=0; i<ranges; i++)
+      targets.push_back(make_shared<CacheTarget>());
+  }
+  bool find(const TableIdentifier &table, const char *row,
+            LogReplayer::TargetPtr &target, String &start_row,
+            String &end_row) override {
+    int i = min(atoi(row + 3) / m_span, (int)targets.size() - 1);
+    target = targets[i];
+    start_row = i ? format(row_format, i*m_span - 1) : String();
+    end_row = (i+1 == (int)targets.size()) ? String(Key::END_ROW_MARKER)
+      : format(row_format, (i+1)*m_span - 1);
+    return true;
+  }
+  vector<shared_ptr<CacheTarget>> targets;
+private:
+  int m_span;
+};
+
+struct LogReplayTest {
+  vector<unique_ptr<DynamicBuffer>> blocks;
+  vector<BlockHeaderCommitLog> headers;
+  vector<size_t> expected;
+  size_t input_bytes {};
+  int cells;
+  int ranges;
+
+  /// Generates compressed commit log blocks with increasing revisions and
+  /// rows scattered over all ranges
+  LogReplayTest(int ncells, int nranges, int block_cells)
+    : cells(ncells), ranges(nranges) {
+    unique_ptr<BlockCompressionCodec>
+      codec(CompressorFactory::create_block_codec(get_str("compressor")));
+    TableIdentifier table_id("3");
+    DynamicBuffer buf;
+    char row[32];
+    uint8_t value[64];
+    int64_t revision = 0;
+    int span = cells / ranges;
+
+    expected.resize(ranges);
+    for (int i=0; i<cells; ) {
+      buf.clear();
+      buf.reserve(table_id.encoded_length());
+      table_id.encode(&buf.ptr);
+      for (int j=0; j<block_cells && i<cells; j++, i++) {
+        int n = random() % cells;
+        expected[min(n / span, ranges - 1)]++;
+        sprintf(row, row_format, n);
+        revision++;
+        create_key_and_append(buf, FLAG_INSERT, row, 1, "qualifier",
+                              revision, revision);
+        for (size_t k=0; k<sizeof(value); k++)
+          value[k] = (random() % 4) ? 'a' + (k % 26) : (uint8_t)random();
+        append_as_byte_string(buf, value, sizeof(value));
+      }
+      input_bytes += buf.fill();
+      BlockHeaderCommitLog header(CommitLog::MAGIC_DATA, revision, 0);
+      blocks.push_back(unique_ptr<DynamicBuffer>(new DynamicBuffer()));
+      codec->deflate(buf, *blocks.back(), header);
+      headers.push_back(header);
+    }
+  }
+
+  void run(int threads) {
+    CacheRouter router(cells, ranges);
+
+    // add() takes over block memory, so replay copies
+    vector<unique_ptr<DynamicBuffer>> zblocks;
+    for (auto &block : blocks) {
+      zblocks.push_back(unique_ptr<DynamicBuffer>(new DynamicBuffer(block->fill())));
+      zblocks.back()->add_unchecked(block->base, block->fill());
+    }
+
+    Stopwatch w;
+    size_t cells_applied;
+    {
+      LogReplayer replayer(&router, threads);
+      for (size_t i=0; i<zblocks.size(); i++)
+        replayer.add(*zblocks[i], headers[i]);
+      replayer.finish();
+      cells_applied = replayer.cells();
+    }
+    w.stop();
+
+    HT_ASSERT(cells_applied == (size_t)cells);
+    for (int i=0; i<ranges; i++)
+      HT_ASSERT(router.targets[i]->count == expected[i]);
+
+    cout << "threads=" << threads << ": "
+         << (input_bytes / w.elapsed()) / (1024*1024) << " MB/s, "
+         << (size_t)(cells / w.elapsed()) << " cells/s" << endl;
+  }
+};
+
+} // local namespace
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    srandom(get_i32("seed"));
+
+    LogReplayTest test(get_i32("cells"), get_i32("ranges"),
+                       get_i32("block-cells"));
+
+    int max_threads = get_i32("max-threads");
+    for (int threads=1; threads<=max_threads; threads *= 2)
+      test.run(threads);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/LoserTree.h>
+
+#include <Hypertable/Lib/Key.h>
+
+#include <Common/DynamicBuffer.h>
+#include <Common/Init.h>
+#include <Common/Stopwatch.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+struct MyPolicy : Config::Policy {
+  static void init_options() {
+    cmdline_desc("Usage: %s [Options]\n\n"
+                 "Merges sorted key streams with a binary heap and with a\n"
+                 "loser tree, as MergeScannerAccessGroup and\n"
+                 "MergeScannerRange do, and reports the merge throughput.\n\n"
+                 "Options").add_options()
+      ("cells", i32()->default_value(1000000), "number of cells to merge")
+      ("run-length", i32()->default_value(1000),
+       "number of consecutive cells from one input in \"runs\" mode")
+      ("seed", i32()->default_value(1234), "random seed")
+      ;
+  }
+};
+
+typedef Meta::list<MyPolicy, DefaultPolicy> Policies;
+
+/// Current key of one input, as in MergeScannerAccessGroup::ScannerState
+struct Cursor {
+  SerializedKey key;
+  uint64_t prefix;
+  size_t input;
+  size_t pos;
+};
+
+struct LtCursor {
+  bool operator()(const Cursor &c1, const Cursor &c2) const {
+    if (c1.prefix != c2.prefix)
+      return c1.prefix < c2.prefix;
+    return c1.key < c2.key;
+  }
+};
+
+/// std::priority_queue keeps the largest element on top
+struct GtCursor {
+  bool operator()(const Cursor &c1, const Cursor &c2) const {
+    return LtCursor()(c2, c1);
+  }
+};
+
+struct MergeScannerTest {
+  DynamicBuffer buf;
+  vector<const uint8_t *> keys;
+  vector<vector<const uint8_t *>> inputs;
+
+  MergeScannerTest(int ncells) {
+    char row[32];
+    // create_key_and_append() grows the buffer to the exact size needed
+    buf.reserve(ncells * 64);
+    vector<size_t> offsets;
+    for (int i=0; i<ncells; i++) {
+      // Common row prefix, so some comparisons fall through to the key
+      sprintf(row, "user%08d/%04d", i / 4, i % 4);
+      offsets.push_back(buf.fill());
+      create_key_and_append(buf, FLAG_INSERT, row, 1, "qualifier",
+                            (int64_t)i, (int64_t)i);
+    }
+    for (auto offset : offsets)
+      keys.push_back(buf.base + offset);
+  }
+
+  /// Deals sorted keys out to <code>k</code> inputs, switching to a random
+  /// input every <code>run_length</code> keys
+  void distribute(size_t k, size_t run_length) {
+    inputs.clear();
+    inputs.resize(k);
+    size_t input = 0;
+    for (size_t i=0; i<keys.size(); i++) {
+      if (i % run_length == 0)
+        input = random() % k;
+      inputs[input].push_back(keys[i]);
+    }
+  }
+
+  bool next(Cursor &cursor) {
+    if (++cursor.pos == inputs[cursor.input].size())
+      return false;
+    set(cursor);
+    return true;
+  }
+
+  void set(Cursor &cursor) {
+    cursor.key.ptr = inputs[cursor.input][cursor.pos];
+    cursor.prefix = SerializedKey::row_prefix((const uint8_t *)cursor.key.row());
+  }
+
+  size_t merge_heap(vector<const uint8_t *> &output) {
+    priority_queue<Cursor, vector<Cursor>, GtCursor> queue;
+    for (size_t i=0; i<inputs.size(); i++) {
+      if (inputs[i].empty())
+        continue;
+      Cursor cursor {SerializedKey(), 0, i, 0};
+      set(cursor);
+      queue.push(cursor);
+    }
+    size_t count = 0;
+    while (!queue.empty()) {
+      Cursor cursor = queue.top();
+      output[count++] = cursor.key.ptr;
+      queue.pop();
+      if (next(cursor))
+        queue.push(cursor);
+    }
+    return count;
+  }
+
+  size_t merge_loser_tree(vector<const uint8_t *> &output) {
+    LoserTree<Cursor, LtCursor> tree;
+    for (size_t i=0; i<inputs.size(); i++) {
+      if (inputs[i].empty())
+        continue;
+      Cursor cursor {SerializedKey(), 0, i, 0};
+      set(cursor);
+      tree.add(cursor);
+    }
+    tree.build();
+    size_t count = 0;
+    while (!tree.empty()) {
+      Cursor cursor = tree.top();
+      output[count++] = cursor.key.ptr;
+      if (next(cursor))
+        tree.replace_top(cursor);
+      else
+        tree.pop();
+    }
+    return count;
+  }
+
+  void verify(const vector<const uint8_t *> &output) {
+    for (size_t i=0; i<keys.size(); i++)
+      HT_ASSERT(output[i] == keys[i]);
+  }
+
+  void run(size_t k, size_t run_length, const char *label) {
+    vector<const uint8_t *> output(keys.size());
+    distribute(k, run_length);
+
+    Stopwatch w;
+    HT_ASSERT(merge_heap(output) == keys.size());
+    w.stop();
+    verify(output);
+    double heap_rate = keys.size() / w.elapsed();
+
+    fill(output.begin(), output.end(), (const uint8_t *)0);
+    w.reset();
+    w.start();
+    HT_ASSERT(merge_loser_tree(output) == keys.size());
+    w.stop();
+    verify(output);
+    double tree_rate = keys.size() / w.elapsed();
+
+    cout << "k=" << k << " " << label << ": heap " << heap_rate
+         << "/s, loser tree " << tree_rate << "/s ("
+         << tree_rate / heap_rate << "x)" << endl;
+  }
+};
+
+/// Checks LoserTree against a sort for small, uneven inputs
+void verify_small() {
+  for (size_t k=1; k<=9; k++) {
+    for (int iteration=0; iteration<100; iteration++) {
+      vector<vector<int>> inputs(k);
+      vector<int> expected;
+      for (auto &input : inputs) {
+        size_t n = random() % 8;
+        for (size_t i=0; i<n; i++)
+          input.push_back(random() % 16);
+        sort(input.begin(), input.end());
+        expected.insert(expected.end(), input.begin(), input.end());
+      }
+      sort(expected.begin(), expected.end());
+
+      typedef pair<int, size_t> Item;
+      LoserTree<Item, std::less<Item>> tree;
+      vector<size_t> pos(k, 0);
+      // Empty inputs are skipped, as the merge scanners do
+      for (size_t i=0; i<k; i++)
+        if (!inputs[i].empty())
+          tree.add(Item(inputs[i][0], i));
+      tree.build();
+      vector<int> output;
+      while (!tree.empty()) {
+        Item item = tree.top();
+        output.push_back(item.first);
+        if (++pos[item.second] < inputs[item.second].size())
+          tree.replace_top(Item(inputs[item.second][pos[item.second]],
+                                item.second));
+        else
+          tree.pop();
+      }
+      HT_ASSERT(output == expected);
+    }
+  }
+  cout << "verified loser tree merge" << endl;
+}
+
+} // local namespace
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    srandom(get_i32("seed"));
+
+    verify_small();
+
+    MergeScannerTest test(get_i32("cells"));
+
+    size_t run_length = get_i32("run-length");
+    for (size_t k : { 2, 8, 32 }) {
+      test.run(k, 1, "interleaved");
+      test.run(k, run_length, "runs");
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
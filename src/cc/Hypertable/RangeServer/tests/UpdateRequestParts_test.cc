@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hypertable/RangeServer/UpdateRequest.h>
+
+#include <Common/ByteString.h>
+#include <Common/DynamicBuffer.h>
+#include <Common/Error.h>
+#include <Common/Logger.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  // Every cell is a 4 byte key and a 1 byte value, 7 bytes serialized
+  const uint32_t CELL_SIZE = 7;
+
+  /// Builds part holding <code>cells</code> of a split request.
+  void make_part(UpdateRequest &part, std::shared_ptr<UpdateRequestParts> &parts,
+                 const vector<int> &cells) {
+    DynamicBuffer buf;
+    for (int cell : cells) {
+      char key[5];
+      sprintf(key, "row%d", cell);
+      append_as_byte_string(buf, key, 4);
+      append_as_byte_string(buf, "v", 1);
+      uint32_t offset = buf.fill() - CELL_SIZE;
+      uint32_t original_offset = cell * CELL_SIZE;
+      if (!part.segments.empty() &&
+          part.segments.back().original_offset + part.segments.back().len == original_offset)
+        part.segments.back().len += CELL_SIZE;
+      else
+        part.segments.push_back({offset, original_offset, CELL_SIZE});
+    }
+    StaticBuffer buffer(buf);
+    part.buffer = buffer;
+    part.count = cells.size();
+    part.parts = parts;
+  }
+
+  void test_send_back() {
+    auto parts = make_shared<UpdateRequestParts>(2);
+    UpdateRequest part0, part1;
+
+    // Cells 0-5 of the original request, split over two lanes
+    make_part(part0, parts, {0, 1, 4});
+    make_part(part1, parts, {2, 3, 5});
+
+    // Cells 1 and 4 are adjacent in part 0 but not in the original buffer
+    part0.send_back_vector.push_back({Error::RANGESERVER_OUT_OF_RANGE, 2,
+                                      CELL_SIZE, 2*CELL_SIZE});
+    part1.send_back_vector.push_back({Error::RANGESERVER_OUT_OF_RANGE, 1,
+                                      2*CELL_SIZE, CELL_SIZE});
+
+    HT_ASSERT(!parts->add(&part1, Error::OK, ""));
+    HT_ASSERT(parts->add(&part0, Error::OK, ""));
+    HT_ASSERT(parts->error == Error::OK);
+
+    vector<SendBackRec> &send_back = parts->send_back_vector;
+    HT_ASSERT(send_back.size() == 3);
+    HT_ASSERT(send_back[0].offset == 1*CELL_SIZE && send_back[0].len == CELL_SIZE &&
+              send_back[0].count == 1);
+    HT_ASSERT(send_back[1].offset == 4*CELL_SIZE && send_back[1].len == CELL_SIZE &&
+              send_back[1].count == 1);
+    HT_ASSERT(send_back[2].offset == 5*CELL_SIZE && send_back[2].len == CELL_SIZE &&
+              send_back[2].count == 1);
+  }
+
+  void test_error() {
+    auto parts = make_shared<UpdateRequestParts>(3);
+    UpdateRequest part0, part1, part2;
+
+    make_part(part0, parts, {0});
+    make_part(part1, parts, {1});
+    make_part(part2, parts, {2});
+
+    HT_ASSERT(!parts->add(&part0, Error::OK, ""));
+    HT_ASSERT(!parts->add(&part1, Error::RANGESERVER_CLOCK_SKEW, ""));
+    HT_ASSERT(parts->add(&part2, Error::TABLE_NOT_FOUND, "1"));
+    HT_ASSERT(parts->error == Error::RANGESERVER_CLOCK_SKEW);
+  }
+
+}
+
+int main(int argc, char **argv) {
+
+  test_send_back();
+  test_error();
+
+  cout << "SUCCESS" << endl;
+
+  return 0;
+}
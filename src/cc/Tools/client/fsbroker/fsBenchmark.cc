@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <FsBroker/Lib/Client.h>
+#include <FsBroker/Lib/Config.h>
+
+#include <AsyncComm/Config.h>
+#include <AsyncComm/ConnectionManager.h>
+#include <AsyncComm/DispatchHandler.h>
+#include <AsyncComm/Protocol.h>
+#include <AsyncComm/ReactorFactory.h>
+
+#include <Common/Error.h>
+#include <Common/InetAddr.h>
+#include <Common/Init.h>
+#include <Common/Logger.h>
+#include <Common/StaticBuffer.h>
+#include <Common/System.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+  const char *usage =
+    "\n"
+    "Usage: fsBenchmark [options]\n\n"
+    "  This program measures FS broker pread and append IOPS and latency\n"
+    "  under concurrent load.  It writes a test file through the broker,\n"
+    "  then keeps --outstanding random block preads in flight until\n"
+    "  --requests have completed, and then does the same with appends to\n"
+    "  --outstanding separate files.\n\n"
+    "Options"
+    ;
+
+  struct AppPolicy : Policy {
+    static void init_options() {
+      cmdline_desc(usage).add_options()
+        ("block-size", i32()->default_value(65536), "Size of each pread and "
+         "append")
+        ("file-blocks", i32()->default_value(4096), "Size of test file in "
+         "blocks")
+        ("outstanding", i32()->default_value(32), "Number of requests kept "
+         "in flight")
+        ("requests", i32()->default_value(20000), "Number of requests in "
+         "each phase")
+        ("directio", "Open files for direct i/o (takes effect if the broker "
+         "has direct i/o enabled)")
+        ("sync", "Sync each append")
+        ;
+    }
+  };
+
+  typedef Meta::list<AppPolicy, FsClientPolicy, DefaultCommPolicy> Policies;
+
+  typedef chrono::steady_clock ClockT;
+
+  /// Shared state of a benchmark phase
+  class Phase {
+  public:
+    Phase(int requests) : remaining(requests) { }
+
+    /// Claims next request; returns <i>false</i> when there are none left
+    bool claim() {
+      lock_guard<mutex> lock(m_mutex);
+      if (remaining == 0)
+        return false;
+      remaining--;
+      return true;
+    }
+
+    void complete(int64_t latency_us, int error) {
+      lock_guard<mutex> lock(m_mutex);
+      if (error != Error::OK && first_error == Error::OK)
+        first_error = error;
+      latencies.push_back(latency_us);
+    }
+
+    void finish() {
+      lock_guard<mutex> lock(m_mutex);
+      if (--active == 0)
+        m_cond.notify_all();
+    }
+
+    void wait() {
+      unique_lock<mutex> lock(m_mutex);
+      m_cond.wait(lock, [this](){ return active == 0; });
+    }
+
+    void report(const char *name, ClockT::duration elapsed) {
+      sort(latencies.begin(), latencies.end());
+      size_t n = latencies.size();
+      double secs = chrono::duration<double>(elapsed).count();
+      int64_t sum = 0;
+      for (auto latency : latencies)
+        sum += latency;
+      cout << name << ": " << n << " requests in " << secs << " s, "
+           << (int64_t)(n / secs) << " IOPS, latency usec avg "
+           << (n ? sum / (int64_t)n : 0)
+           << " p50 " << (n ? latencies[n / 2] : 0)
+           << " p99 " << (n ? latencies[(n * 99) / 100] : 0)
+           << " max " << (n ? latencies[n - 1] : 0) << endl;
+      if (first_error != Error::OK)
+        cout << name << ": error - " << Error::get_text(first_error) << endl;
+    }
+
+    int remaining;
+    int active {};
+    int first_error {Error::OK};
+    vector<int64_t> latencies;
+
+  private:
+    mutex m_mutex;
+    condition_variable m_cond;
+  };
+
+  /// Issues one request at a time, issuing the next when the response
+  /// to the previous one arrives
+  class Issuer : public DispatchHandler {
+  public:
+    Issuer(FsBroker::Lib::Client *client, Phase *phase, int fd, bool pread,
+           size_t block_size, int file_blocks, bool sync)
+      : m_client(client), m_phase(phase), m_fd(fd), m_pread(pread),
+        m_block_size(block_size), m_file_blocks(file_blocks), m_sync(sync),
+        m_random(getpid() + fd) { }
+
+    void issue() {
+      if (!m_phase->claim()) {
+        m_phase->finish();
+        return;
+      }
+      m_start = ClockT::now();
+      if (m_pread) {
+        uint64_t offset = (uint64_t)(rand_r(&m_random) % m_file_blocks)
+          * m_block_size;
+        m_client->pread(m_fd, m_block_size, offset, false, this);
+      }
+      else {
+        StaticBuffer buf(m_block_size, (size_t)HT_DIRECT_IO_ALIGNMENT);
+        memset(buf.base, 'x', m_block_size);
+        m_client->append(m_fd, buf, m_sync ? Filesystem::Flags::SYNC :
+                         Filesystem::Flags::NONE, this);
+      }
+    }
+
+    void handle(EventPtr &event) override {
+      int error = (event->type == Event::MESSAGE) ?
+        Protocol::response_code(event) : event->error;
+      auto latency = ClockT::now() - m_start;
+      m_phase->complete(
+        chrono::duration_cast<chrono::microseconds>(latency).count(), error);
+      issue();
+    }
+
+  private:
+    FsBroker::Lib::Client *m_client;
+    Phase *m_phase;
+    int m_fd;
+    bool m_pread;
+    size_t m_block_size;
+    int m_file_blocks;
+    bool m_sync;
+    unsigned m_random;
+    ClockT::time_point m_start;
+  };
+
+  void run_phase(const char *name, FsBroker::Lib::Client *client,
+                 vector<int> &fds, bool pread, size_t block_size,
+                 int file_blocks, int requests, bool sync) {
+    Phase phase(requests);
+    vector<unique_ptr<Issuer>> issuers;
+
+    phase.active = fds.size();
+    for (int fd : fds)
+      issuers.push_back(unique_ptr<Issuer>(new Issuer(client, &phase, fd,
+                                                      pread, block_size,
+                                                      file_blocks, sync)));
+    auto start = ClockT::now();
+    for (auto &issuer : issuers)
+      issuer->issue();
+    phase.wait();
+    phase.report(name, ClockT::now() - start);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    size_t block_size = get_i32("block-size");
+    int file_blocks = get_i32("file-blocks");
+    int outstanding = get_i32("outstanding");
+    int requests = get_i32("requests");
+    bool sync = has("sync");
+    uint32_t open_flags = has("directio") ? Filesystem::OPEN_FLAG_DIRECTIO : 0;
+
+    ConnectionManagerPtr conn_mgr = make_shared<ConnectionManager>();
+    FsBroker::Lib::ClientPtr client =
+      make_shared<FsBroker::Lib::Client>(conn_mgr, properties);
+
+    if (!client->wait_for_connection(15000)) {
+      HT_ERROR("Unable to connect to FS broker");
+      return 1;
+    }
+
+    string testdir = format("/fsBenchmark%d", (int)getpid());
+    client->mkdirs(testdir);
+
+    // Write the pread test file
+    string fname = testdir + "/blocks";
+    int fd = client->create(fname, Filesystem::OPEN_FLAG_OVERWRITE, -1, -1, -1);
+    for (int i=0; i<file_blocks; i++) {
+      StaticBuffer buf(block_size, (size_t)HT_DIRECT_IO_ALIGNMENT);
+      memset(buf.base, 'a' + (i % 26), block_size);
+      client->append(fd, buf);
+    }
+    client->close(fd);
+
+    // One descriptor per outstanding request, as with concurrent scanners
+    vector<int> fds;
+    for (int i=0; i<outstanding; i++)
+      fds.push_back(client->open(fname, open_flags));
+    run_phase("pread", client.get(), fds, true, block_size, file_blocks,
+              requests, false);
+    for (int fd : fds)
+      client->close(fd);
+
+    fds.clear();
+    for (int i=0; i<outstanding; i++)
+      fds.push_back(client->create(format("%s/append%d", testdir.c_str(), i),
+                                   open_flags |
+                                   Filesystem::OPEN_FLAG_OVERWRITE, -1, -1,
+                                   -1));
+    run_phase(sync ? "append (sync)" : "append", client.get(), fds, false,
+              block_size, file_blocks, requests, sync);
+    for (int fd : fds)
+      client->close(fd);
+
+    client->rmdir(testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
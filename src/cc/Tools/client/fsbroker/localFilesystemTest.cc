@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <FsBroker/Lib/Client.h>
+#include <FsBroker/Lib/LocalFilesystem.h>
+
+#include <AsyncComm/Config.h>
+#include <AsyncComm/ConnectionManager.h>
+#include <AsyncComm/DispatchHandlerSynchronizer.h>
+#include <AsyncComm/ReactorFactory.h>
+
+#include <Common/Config.h>
+#include <Common/Error.h>
+#include <Common/InetAddr.h>
+#include <Common/Init.h>
+#include <Common/Logger.h>
+#include <Common/StaticBuffer.h>
+#include <Common/System.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+  const char *usage =
+    "\n"
+    "Usage: localFilesystemTest [options]\n\n"
+    "  This program tests the in-process local filesystem by writing a\n"
+    "  file under a private root directory and reading it back with the\n"
+    "  synchronous, asynchronous and vectored read methods.  It then\n"
+    "  reports the average latency of random 64KB block reads.  With\n"
+    "  --compare-broker, vectored reads are also checked and the same\n"
+    "  reads are timed through the FS broker listening on\n"
+    "  localhost:FsBroker.Port, which must be a local broker.\n\n"
+    "Options"
+    ;
+
+  struct AppPolicy : Policy {
+    static void init_options() {
+      cmdline_desc(usage).add_options()
+        ("compare-broker", "Also time block reads through the FS broker")
+        ;
+    }
+  };
+
+  typedef Meta::list<AppPolicy, DefaultCommPolicy> Policies;
+
+  const size_t TEST_BLOCK_SIZE = 65536;
+  const size_t FILE_BLOCKS = 64;
+  const int LATENCY_READS = 2000;
+
+  void fill_block(uint8_t *buf, size_t block) {
+    for (size_t i=0; i<TEST_BLOCK_SIZE; i++)
+      buf[i] = (uint8_t)((block * 131 + i) % 251);
+  }
+
+  void check_block(const uint8_t *buf, size_t block) {
+    uint8_t expected[TEST_BLOCK_SIZE];
+    fill_block(expected, block);
+    HT_ASSERT(memcmp(buf, expected, TEST_BLOCK_SIZE) == 0);
+  }
+
+  void write_file(Filesystem *fs, const string &fname) {
+    int fd = fs->create(fname, Filesystem::OPEN_FLAG_OVERWRITE, -1, -1, -1);
+    for (size_t i=0; i<FILE_BLOCKS; i++) {
+      StaticBuffer buf(TEST_BLOCK_SIZE);
+      fill_block(buf.base, i);
+      fs->append(fd, buf, i+1 == FILE_BLOCKS ? Filesystem::Flags::SYNC :
+                 Filesystem::Flags::NONE);
+    }
+    fs->close(fd);
+    HT_ASSERT(fs->length(fname) == (int64_t)(TEST_BLOCK_SIZE * FILE_BLOCKS));
+  }
+
+  void test_read(Filesystem *fs, const string &fname) {
+    uint8_t buf[TEST_BLOCK_SIZE];
+    DispatchHandlerSynchronizer sync_handler;
+    EventPtr event;
+    const void *data;
+    uint64_t offset;
+    uint32_t length;
+
+    int fd = fs->open(fname, 0);
+
+    // sequential synchronous reads
+    for (size_t i=0; i<FILE_BLOCKS; i++) {
+      HT_ASSERT(fs->read(fd, buf, TEST_BLOCK_SIZE) == TEST_BLOCK_SIZE);
+      check_block(buf, i);
+    }
+    HT_ASSERT(fs->read(fd, buf, TEST_BLOCK_SIZE) == 0);
+
+    // asynchronous pread, as done by the cell store block loader
+    for (size_t i=FILE_BLOCKS; i>0; i--) {
+      fs->pread(fd, TEST_BLOCK_SIZE, (i-1) * TEST_BLOCK_SIZE, true,
+                &sync_handler);
+      HT_ASSERT(sync_handler.wait_for_reply(event));
+      fs->decode_response_pread(event, &data, &offset, &length);
+      HT_ASSERT(offset == (i-1) * TEST_BLOCK_SIZE && length == TEST_BLOCK_SIZE);
+      check_block((const uint8_t *)data, i-1);
+    }
+
+    // asynchronous read
+    fs->seek(fd, TEST_BLOCK_SIZE);
+    fs->read(fd, TEST_BLOCK_SIZE, &sync_handler);
+    HT_ASSERT(sync_handler.wait_for_reply(event));
+    fs->decode_response_read(event, &data, &offset, &length);
+    HT_ASSERT(offset == TEST_BLOCK_SIZE && length == TEST_BLOCK_SIZE);
+    check_block((const uint8_t *)data, 1);
+
+    // reading past the end is an error
+    fs->pread(fd, TEST_BLOCK_SIZE, FILE_BLOCKS * TEST_BLOCK_SIZE, true,
+              &sync_handler);
+    HT_ASSERT(!sync_handler.wait_for_reply(event));
+    try {
+      fs->decode_response_pread(event, &data, &offset, &length);
+      HT_ASSERT(!"pread past end of file succeeded");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::FSBROKER_IO_ERROR);
+    }
+
+    fs->close(fd);
+
+    // buffered read of a range
+    fd = fs->open_buffered(fname, 0, TEST_BLOCK_SIZE, 2, 2*TEST_BLOCK_SIZE,
+                           4*TEST_BLOCK_SIZE);
+    HT_ASSERT(fs->read(fd, buf, TEST_BLOCK_SIZE) == TEST_BLOCK_SIZE);
+    check_block(buf, 2);
+    HT_ASSERT(fs->read(fd, buf, TEST_BLOCK_SIZE) == TEST_BLOCK_SIZE);
+    check_block(buf, 3);
+    HT_ASSERT(fs->read(fd, buf, TEST_BLOCK_SIZE) == 0);
+    fs->close(fd);
+
+    try {
+      fs->read(fd, buf, TEST_BLOCK_SIZE);
+      HT_ASSERT(!"read of closed file succeeded");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::FSBROKER_BAD_FILE_HANDLE);
+    }
+  }
+
+  void test_preadv(Filesystem *fs, const string &fname) {
+    DispatchHandlerSynchronizer sync_handler;
+    EventPtr event;
+    vector<Filesystem::Extent> extents;
+    size_t blocks[] = { 1, 2, 3, 7, 5, FILE_BLOCKS-1 };
+
+    int fd = fs->open(fname, 0);
+
+    // adjacent and out of order extents, the last one reaching past EOF
+    for (size_t block : blocks)
+      extents.push_back(Filesystem::Extent(block * TEST_BLOCK_SIZE,
+                                           TEST_BLOCK_SIZE));
+    extents.back().length = 2 * TEST_BLOCK_SIZE;
+
+    fs->preadv(fd, extents, true, &sync_handler);
+    HT_ASSERT(sync_handler.wait_for_reply(event));
+    fs->decode_response_preadv(event, extents);
+    HT_ASSERT(extents.size() == sizeof(blocks)/sizeof(size_t));
+    for (size_t i=0; i<extents.size(); i++) {
+      HT_ASSERT(extents[i].offset == blocks[i] * TEST_BLOCK_SIZE);
+      HT_ASSERT(extents[i].length == TEST_BLOCK_SIZE);
+      check_block((const uint8_t *)extents[i].data, blocks[i]);
+    }
+
+    fs->close(fd);
+  }
+
+  void test_namespace(Filesystem *fs, const string &testdir) {
+    vector<Filesystem::Dirent> listing;
+
+    fs->mkdirs(testdir + "/mydir");
+    fs->rename(testdir + "/blocks", testdir + "/blocks.renamed");
+    HT_ASSERT(!fs->exists(testdir + "/blocks"));
+    HT_ASSERT(fs->exists(testdir + "/blocks.renamed"));
+
+    fs->readdir(testdir, listing);
+    sort(listing.begin(), listing.end());
+    HT_ASSERT(listing.size() == 2);
+    HT_ASSERT(listing[0].name == "blocks.renamed" && !listing[0].is_dir &&
+              listing[0].length == TEST_BLOCK_SIZE * FILE_BLOCKS);
+    HT_ASSERT(listing[1].name == "mydir" && listing[1].is_dir);
+
+    fs->remove(testdir + "/blocks.renamed");
+    fs->remove(testdir + "/blocks.renamed");
+    try {
+      fs->remove(testdir + "/blocks.renamed", false);
+      HT_ASSERT(!"remove of missing file succeeded");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::FSBROKER_BAD_FILENAME);
+    }
+    fs->rmdir(testdir);
+    HT_ASSERT(!fs->exists(testdir));
+  }
+
+  /// Returns average latency in microseconds of random block preads
+  double time_block_reads(Filesystem *fs, const string &fname) {
+    DispatchHandlerSynchronizer sync_handler;
+    EventPtr event;
+    const void *data;
+    uint64_t offset;
+    uint32_t length;
+
+    int fd = fs->open(fname, 0);
+    srandom(1);
+    auto start = chrono::steady_clock::now();
+    for (int i=0; i<LATENCY_READS; i++) {
+      fs->pread(fd, TEST_BLOCK_SIZE,
+                (random() % FILE_BLOCKS) * TEST_BLOCK_SIZE, true,
+                &sync_handler);
+      HT_ASSERT(sync_handler.wait_for_reply(event));
+      fs->decode_response_pread(event, &data, &offset, &length);
+    }
+    auto elapsed = chrono::steady_clock::now() - start;
+    fs->close(fd);
+    return (double)chrono::duration_cast<chrono::microseconds>(elapsed).count()
+      / LATENCY_READS;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  try {
+    init_with_policies<Policies>(argc, argv);
+
+    bool compare_broker = has("compare-broker");
+
+    System::initialize(argv[0]);
+
+    if (!compare_broker)
+      properties->set("FsBroker.Local.Root",
+                      (boost::filesystem::current_path() / "fsroot").string());
+
+    FsBroker::Lib::LocalFilesystem fs(properties);
+    string testdir = format("/localFilesystemTest%d", (int)getpid());
+    string fname = testdir + "/blocks";
+
+    fs.mkdirs(testdir);
+    write_file(&fs, fname);
+    test_read(&fs, fname);
+    test_preadv(&fs, fname);
+
+    double latency = time_block_reads(&fs, fname);
+    cout << "in-process block read latency: " << latency << " usec" << endl;
+
+    if (compare_broker) {
+      struct sockaddr_in addr;
+      uint16_t port = properties->get_i16("FsBroker.Port");
+
+      ReactorFactory::initialize(2);
+      InetAddr::initialize(&addr, "localhost", port);
+
+      ConnectionManagerPtr conn_mgr = make_shared<ConnectionManager>();
+      FsBroker::Lib::ClientPtr client =
+        make_shared<FsBroker::Lib::Client>(conn_mgr, addr, 15000);
+
+      if (!client->wait_for_connection(15000)) {
+        HT_ERROR("Unable to connect to FS broker");
+        return 1;
+      }
+
+      test_preadv(client.get(), fname);
+
+      latency = time_block_reads(client.get(), fname);
+      cout << "FS broker block read latency: " << latency << " usec" << endl;
+    }
+
+    test_namespace(&fs, testdir);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+  catch (...) {
+    HT_ERROR_OUT << "unexpected exception caught" << HT_END;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hyperspace/Config.h>
+#include <Hyperspace/Session.h>
+
+#include <AsyncComm/Comm.h>
+#include <AsyncComm/Config.h>
+
+#include <Common/Error.h>
+#include <Common/Init.h>
+#include <Common/Logger.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace Hyperspace;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+  const char *usage =
+    "\n"
+    "Usage: hsCacheBenchmark [options]\n\n"
+    "  This program measures how many requests the Hyperspace client-side\n"
+    "  cache saves for attributes read by pathname, the way table schemas\n"
+    "  and namespace ids are read.  It creates --nodes files with an\n"
+    "  attribute and reads the attributes --reads times round-robin, first\n"
+    "  with a session that has the cache disabled and then with one that\n"
+    "  has it enabled, and reports the requests sent to the master by each.\n"
+    "  It then checks that the cached session sees an attribute change made\n"
+    "  by another session and that its watch handles do not prevent another\n"
+    "  session from removing a file.\n\n"
+    "Options"
+    ;
+
+  struct AppPolicy : Policy {
+    static void init_options() {
+      cmdline_desc(usage).add_options()
+        ("nodes", i32()->default_value(100), "Number of files to read")
+        ("reads", i32()->default_value(100000), "Number of attribute reads "
+         "in each phase")
+        ("timeout", i32()->default_value(10000), "Timeout in milliseconds "
+         "for connecting to Hyperspace")
+        ;
+    }
+  };
+
+  typedef Meta::list<AppPolicy, HyperspaceClientPolicy, DefaultCommPolicy>
+    Policies;
+
+  typedef chrono::steady_clock ClockT;
+
+  SessionPtr connect(bool cache_enabled) {
+    properties->set("Hyperspace.Client.Cache.Enable", cache_enabled);
+    SessionPtr session = make_shared<Session>(Comm::instance(), properties);
+    if (!session->wait_for_connection(get_i32("timeout"))) {
+      cout << "Unable to connect to Hyperspace" << endl;
+      quick_exit(EXIT_FAILURE);
+    }
+    return session;
+  }
+
+  String node_name(const String &dir, int i) {
+    return format("%s/%d", dir.c_str(), i);
+  }
+
+  /// Reads the attribute of every file round-robin and reports the
+  /// requests the session sent to the master
+  void run(const char *name, SessionPtr &session, const String &dir,
+           int nodes, int reads) {
+    uint64_t requests_before, requests_after, hits_before, hits_after;
+    DynamicBuffer value;
+
+    session->get_request_stats(&requests_before, &hits_before);
+    auto start = ClockT::now();
+    for (int i=0; i<reads; i++) {
+      session->attr_get(node_name(dir, i % nodes), "value", value);
+      HT_ASSERT(atoi((const char *)value.base) == i % nodes);
+    }
+    double secs = chrono::duration<double>(ClockT::now() - start).count();
+    session->get_request_stats(&requests_after, &hits_after);
+
+    uint64_t requests = requests_after - requests_before;
+    cout << name << ": " << reads << " reads in " << secs << " s, "
+         << (int64_t)(reads / secs) << " reads/s, " << requests
+         << " requests to master (" << (double)requests / reads
+         << " per read), " << (hits_after - hits_before) << " cache hits"
+         << endl;
+  }
+
+}
+
+int main(int argc, char **argv) {
+  init_with_policies<Policies>(argc, argv);
+
+  int nodes = get_i32("nodes");
+  int reads = get_i32("reads");
+  String dir = format("/hsCacheBenchmark-%d", (int)getpid());
+  HandleCallbackPtr null_callback;
+
+  try {
+    SessionPtr writer = connect(false);
+
+    writer->mkdirs(dir);
+    for (int i=0; i<nodes; i++) {
+      String value = format("%d", i);
+      vector<Attribute> attrs;
+      attrs.push_back(Attribute("value", value.c_str(), value.length()));
+      writer->close(writer->create(node_name(dir, i), OPEN_FLAG_READ,
+                                   null_callback, attrs));
+    }
+
+    SessionPtr uncached = connect(false);
+    run("cache disabled", uncached, dir, nodes, reads);
+
+    SessionPtr cached = connect(true);
+    run("cache enabled", cached, dir, nodes, reads);
+
+    // Changes by other sessions are seen through the watch handles
+    DynamicBuffer value;
+    writer->attr_set(node_name(dir, 0), "value", "42", 2);
+    cached->attr_get(node_name(dir, 0), "value", value);
+    HT_ASSERT(!strcmp((const char *)value.base, "42"));
+
+    // Watch handles do not keep files from being removed
+    for (int i=0; i<nodes; i++)
+      writer->unlink(node_name(dir, i));
+    writer->unlink(dir);
+    try {
+      cached->attr_get(node_name(dir, 0), "value", value);
+      HT_ASSERT(!"attribute of removed file read");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::HYPERSPACE_FILE_NOT_FOUND);
+    }
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    quick_exit(EXIT_FAILURE);
+  }
+
+  cout << "SUCCESS" << endl;
+  quick_exit(EXIT_SUCCESS);
+}
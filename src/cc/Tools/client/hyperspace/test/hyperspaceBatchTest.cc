@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2007-2015 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <Common/Compat.h>
+
+#include <Hyperspace/Config.h>
+#include <Hyperspace/Session.h>
+
+#include <AsyncComm/Comm.h>
+#include <AsyncComm/Config.h>
+
+#include <Common/Error.h>
+#include <Common/InetAddr.h>
+#include <Common/Init.h>
+#include <Common/Logger.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+}
+
+using namespace Hypertable;
+using namespace Hyperspace;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+  const char *usage =
+    "\n"
+    "Usage: hyperspaceBatchTest [options]\n\n"
+    "  This program tests batch requests against a Hyperspace master.  It\n"
+    "  launches a Hyperspace server configured to use ./hsroot as its root\n"
+    "  directory and checks per-operation results, ATTR_INCR values and\n"
+    "  that a batch with a failing operation has no effect.\n\n"
+    "Options"
+    ;
+
+  struct AppPolicy : Policy {
+    static void init_options() {
+      cmdline_desc(usage);
+    }
+  };
+
+  typedef Meta::list<AppPolicy, HyperspaceClientPolicy, DefaultCommPolicy>
+    Policies;
+
+  const uint32_t CREATE_FLAGS =
+    OPEN_FLAG_READ|OPEN_FLAG_WRITE|OPEN_FLAG_CREATE|OPEN_FLAG_EXCL;
+
+  String get_attr(SessionPtr &session, const String &name,
+                  const String &attr) {
+    DynamicBuffer value;
+    session->attr_get(name, attr, value);
+    return String((const char *)value.base, value.fill());
+  }
+
+  /// Checks that all operations of a successful batch take effect and that
+  /// ATTR_INCR returns pre-incremented values
+  void test_commit(SessionPtr &session) {
+    std::vector<BatchOperation> ops;
+    std::vector<BatchResult> results;
+    std::vector<Attribute> dir_attrs, file_attrs;
+
+    dir_attrs.push_back(Attribute("counter", "7", 1));
+    file_attrs.push_back(Attribute("x", "1", 1));
+
+    ops.push_back(BatchOperation(BatchOperation::MKDIR, "/batch", dir_attrs));
+    ops.push_back(BatchOperation(BatchOperation::ATTR_INCR, "/batch",
+                                 "counter"));
+    ops.push_back(BatchOperation(BatchOperation::ATTR_INCR, "/batch",
+                                 "counter"));
+    ops.push_back(BatchOperation(BatchOperation::ATTR_SET, "/batch/file",
+                                 file_attrs, CREATE_FLAGS));
+    ops.push_back(BatchOperation(BatchOperation::MKDIRS, "/batch/a/b"));
+
+    session->batch(ops, results);
+
+    HT_ASSERT(results.size() == ops.size());
+    for (const auto &result : results)
+      HT_ASSERT(result.error == Error::OK);
+    HT_ASSERT(results[1].value == 7);
+    HT_ASSERT(results[2].value == 8);
+
+    HT_ASSERT(get_attr(session, "/batch", "counter") == "9");
+    HT_ASSERT(get_attr(session, "/batch/file", "x") == "1");
+    HT_ASSERT(session->exists("/batch/a/b"));
+  }
+
+  /// Checks that a failing operation aborts the whole batch and is
+  /// reported in the last result
+  void test_abort(SessionPtr &session) {
+    std::vector<BatchOperation> ops;
+    std::vector<BatchResult> results;
+    std::vector<Attribute> file_attrs;
+
+    file_attrs.push_back(Attribute("x", "2", 1));
+
+    ops.push_back(BatchOperation(BatchOperation::MKDIR, "/batch/new"));
+    ops.push_back(BatchOperation(BatchOperation::ATTR_INCR, "/batch",
+                                 "counter"));
+    ops.push_back(BatchOperation(BatchOperation::ATTR_SET, "/batch/file",
+                                 file_attrs, CREATE_FLAGS));
+    ops.push_back(BatchOperation(BatchOperation::UNLINK, "/batch/a/b"));
+
+    try {
+      session->batch(ops, results);
+      HT_ASSERT(!"batch with failing operation succeeded");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::HYPERSPACE_FILE_EXISTS);
+    }
+
+    // Operations after the failing one are not executed
+    HT_ASSERT(results.size() == 3);
+    HT_ASSERT(results[0].error == Error::OK);
+    HT_ASSERT(results[1].error == Error::OK && results[1].value == 9);
+    HT_ASSERT(results[2].error == Error::HYPERSPACE_FILE_EXISTS);
+
+    // Nothing took effect
+    HT_ASSERT(!session->exists("/batch/new"));
+    HT_ASSERT(get_attr(session, "/batch", "counter") == "9");
+    HT_ASSERT(get_attr(session, "/batch/file", "x") == "1");
+    HT_ASSERT(session->exists("/batch/a/b"));
+
+    // Missing attribute
+    ops.clear();
+    ops.push_back(BatchOperation(BatchOperation::ATTR_INCR, "/batch",
+                                 "missing"));
+    try {
+      session->batch(ops, results);
+      HT_ASSERT(!"increment of missing attribute succeeded");
+    }
+    catch (Exception &e) {
+      HT_ASSERT(e.code() == Error::HYPERSPACE_ATTR_NOT_FOUND);
+    }
+    HT_ASSERT(results.size() == 1 &&
+              results[0].error == Error::HYPERSPACE_ATTR_NOT_FOUND);
+  }
+
+  /// Checks that a batch removes nodes read (and so watched) by the session
+  void test_unlink(SessionPtr &session) {
+    std::vector<BatchOperation> ops;
+    std::vector<BatchResult> results;
+
+    ops.push_back(BatchOperation(BatchOperation::UNLINK, "/batch/a/b"));
+    ops.push_back(BatchOperation(BatchOperation::UNLINK, "/batch/a"));
+    ops.push_back(BatchOperation(BatchOperation::UNLINK, "/batch/file"));
+    ops.push_back(BatchOperation(BatchOperation::UNLINK, "/batch"));
+
+    session->batch(ops, results);
+
+    HT_ASSERT(results.size() == ops.size());
+    HT_ASSERT(!session->exists("/batch"));
+  }
+
+}
+
+int main(int argc, char **argv) {
+  std::vector<const char *> master_args;
+  String hyperspace_replica_port_arg;
+  pid_t master_pid;
+
+  init_with_policies<Policies>(argc, argv);
+
+  InetAddr inet_addr(INADDR_ANY, 48122);
+  Comm::instance()->find_available_tcp_port(inet_addr);
+  uint16_t port = ntohs(inet_addr.sin_port);
+  hyperspace_replica_port_arg = format("--Hyperspace.Replica.Port=%d",
+                                       (int)port);
+
+  if (system("/bin/rm -rf ./hsroot") != 0 ||
+      system("mkdir -p ./hsroot") != 0) {
+    HT_ERROR("Unable to create ./hsroot directory");
+    quick_exit(EXIT_FAILURE);
+  }
+
+  master_args.push_back("htHyperspace");
+  master_args.push_back("--config=./hyperspaceTest.cfg");
+  master_args.push_back(hyperspace_replica_port_arg.c_str());
+  master_args.push_back((const char *)0);
+
+  unlink("./htHyperspace");
+  HT_ASSERT(link("../../../Hyperspace/htHyperspace", "./htHyperspace") == 0);
+
+  if ((master_pid = fork()) == 0) {
+    int outfd = open("hyperspaceBatchTest.out", O_CREAT|O_TRUNC|O_WRONLY,
+                     0644);
+    if (outfd < 0) {
+      perror("open");
+      exit(EXIT_FAILURE);
+    }
+    dup2(outfd, 1);
+    dup2(outfd, 2);
+    execv("./htHyperspace", (char * const *)&master_args[0]);
+    perror("execv");
+    exit(EXIT_FAILURE);
+  }
+
+  int exit_status = EXIT_SUCCESS;
+
+  try {
+    properties->set("Hyperspace.Replica.Port", port);
+    SessionPtr session = make_shared<Session>(Comm::instance(), properties);
+    if (!session->wait_for_connection(30000))
+      HT_THROW(Error::REQUEST_TIMEOUT, "connecting to Hyperspace");
+
+    test_commit(session);
+    test_abort(session);
+    test_unlink(session);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    exit_status = EXIT_FAILURE;
+  }
+
+  kill(master_pid, SIGKILL);
+  waitpid(master_pid, 0, 0);
+
+  if (exit_status == EXIT_SUCCESS)
+    cout << "SUCCESS" << endl;
+  quick_exit(exit_status);
+}
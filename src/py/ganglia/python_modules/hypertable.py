@@ -785,6 +785,39 @@ def metric_init(params):
              'groups': 'hypertable RangeServer'}
         descriptors.append(d);
 
+        d = {'name': 'ht.rangeserver.syncLatency',
+             'call_back': metric_callback,
+             'time_max': 90,
+             'value_type': 'float',
+             'units': 'ms',
+             'slope': 'both',
+             'format': '%f',
+             'description': 'Commit log sync latency',
+             'groups': 'hypertable RangeServer'}
+        descriptors.append(d);
+
+        d = {'name': 'ht.rangeserver.groupCommit.interval',
+             'call_back': metric_callback,
+             'time_max': 90,
+             'value_type': 'float',
+             'units': 'ms',
+             'slope': 'both',
+             'format': '%f',
+             'description': 'Group commit interval',
+             'groups': 'hypertable RangeServer'}
+        descriptors.append(d);
+
+        d = {'name': 'ht.rangeserver.groupCommit.batchSize',
+             'call_back': metric_callback,
+             'time_max': 90,
+             'value_type': 'float',
+             'units': 'updates',
+             'slope': 'both',
+             'format': '%f',
+             'description': 'Group commit batch size',
+             'groups': 'hypertable RangeServer'}
+        descriptors.append(d);
+
     ##
     ## ThriftBroker metrics
     ##